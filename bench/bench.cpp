@@ -0,0 +1,133 @@
+///
+/// @file   bench.cpp
+/// @brief  Fixed-workload microbenchmarks for the primesieve
+///         kernels: EratSmall/EratMedium/EratBig cross-off,
+///         PrimeGenerator::fill, popcount and iterator
+///         throughput. Results are printed as CSV (one line per
+///         benchmark with ns/op and GB/s) so CI jobs can track
+///         performance trends across releases.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/PrimeSieve.hpp>
+#include <primesieve/types.hpp>
+
+#include <stdint.h>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+namespace {
+
+double getTime()
+{
+  auto now = chrono::steady_clock::now();
+  return chrono::duration<double>(now.time_since_epoch()).count();
+}
+
+/// Print one CSV line, @ops is the number of processed
+/// items (numbers, primes or words), @bytes the memory
+/// traffic caused by the workload
+///
+void report(const char* name,
+            uint64_t ops,
+            uint64_t bytes,
+            double seconds)
+{
+  double nsPerOp = seconds * 1e9 / ops;
+  double gbPerSec = bytes / seconds / 1e9;
+  printf("%s,%llu,%.6f,%.3f,%.3f\n",
+         name,
+         (unsigned long long) ops,
+         seconds,
+         nsPerOp,
+         gbPerSec);
+}
+
+/// Sieve [start, start + dist] single-threaded. The start
+/// offset selects the dominant cross-off algorithm:
+/// EratSmall near 0, EratMedium near 10^13,
+/// EratBig near 10^16
+///
+void benchCrossOff(const char* name, uint64_t start)
+{
+  uint64_t dist = 1000000000ull;
+  PrimeSieve ps;
+
+  double time = getTime();
+  ps.countPrimes(start, start + dist);
+  double seconds = getTime() - time;
+
+  // 8 bits per 30 numbers
+  report(name, dist, dist / 30, seconds);
+}
+
+void benchFill()
+{
+  uint64_t stop = 100000000ull;
+  vector<uint64_t> primes;
+  primes.reserve(prime_count_approx(0, stop));
+
+  double time = getTime();
+  generate_primes(0, stop, &primes);
+  double seconds = getTime() - time;
+
+  report("fill", primes.size(), primes.size() * 8, seconds);
+}
+
+void benchPopcount()
+{
+  // 8 megabytes, larger than most L2 caches
+  uint64_t size = 1 << 20;
+  uint64_t iters = 100;
+  vector<uint64_t> data(size, 0x5555555555555555ull);
+  uint64_t count = 0;
+
+  double time = getTime();
+  for (uint64_t i = 0; i < iters; i++)
+    count += popcount(data.data(), size);
+  double seconds = getTime() - time;
+
+  if (count != iters * size * 32)
+    printf("popcount,ERROR\n");
+  else
+    report("popcount", size * iters, size * iters * 8, seconds);
+}
+
+void benchIterator()
+{
+  uint64_t stop = 100000000ull;
+  uint64_t count = 0;
+  primesieve::iterator it;
+
+  double time = getTime();
+  while (it.next_prime() < stop)
+    count++;
+  double seconds = getTime() - time;
+
+  report("iterator", count, count * 8, seconds);
+}
+
+} // namespace
+
+int main()
+{
+  printf("benchmark,ops,seconds,ns_per_op,gb_per_s\n");
+
+  benchCrossOff("erat_small", 0);
+  benchCrossOff("erat_medium", 10000000000000ull);
+  benchCrossOff("erat_big", 10000000000000000ull);
+  benchFill();
+  benchPopcount();
+  benchIterator();
+
+  return 0;
+}
@@ -0,0 +1,296 @@
+///
+/// @file   regression.cpp
+/// @brief  End-to-end throughput regression harness. Runs a fixed
+///         matrix of workloads (counting at large offsets,
+///         iterator streaming, nth_prime, printing to /dev/null)
+///         at pinned thread counts and compares the best-of-N
+///         timings against a per-host baseline file. Exits
+///         non-zero if a workload regressed beyond the noise
+///         tolerance, so CI catches e.g. a bucket size or
+///         compiler change slowing one of the cross-off
+///         algorithms. The correctness tests in test/ cannot
+///         catch such regressions.
+///
+/// Usage: primesieve-regression [baselineFile] [--update]
+///                              [--runs=N] [--tolerance=T]
+///
+/// The first run on a host records its baseline and passes,
+/// subsequent runs compare against it. --update rewrites the
+/// host's baseline with the current timings (run it after an
+/// intended performance change).
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/ParallelSieve.hpp>
+
+#include <stdint.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+  #define HAS_DEVNULL
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+using namespace std;
+using namespace primesieve;
+
+namespace {
+
+/// Best-of-N runs per workload: the minimum is robust
+/// against scheduling noise, the tolerance absorbs the rest
+int runs = 3;
+
+/// A workload regressed if its best time exceeds
+/// baseline * (1 + tolerance) + 5 milliseconds. The
+/// absolute floor keeps sub-second workloads from
+/// failing on timer and cache warm-up jitter
+double tolerance = 0.10;
+const double absoluteFloor = 0.005;
+
+/// volatile sink, keeps the workload
+/// results from being optimized away
+volatile uint64_t sink = 0;
+
+double getTime()
+{
+  auto now = chrono::steady_clock::now();
+  return chrono::duration<double>(now.time_since_epoch()).count();
+}
+
+/// The baseline file stores one line per host and workload
+/// (host,workload,seconds), hosts share the file e.g. via
+/// the repository without overwriting each other's timings
+///
+string getHostname()
+{
+#if defined(HAS_DEVNULL)
+  char buffer[256];
+  if (gethostname(buffer, sizeof(buffer)) == 0)
+  {
+    buffer[sizeof(buffer) - 1] = '\0';
+    return buffer;
+  }
+#else
+  const char* name = getenv("COMPUTERNAME");
+  if (name)
+    return name;
+#endif
+  return "unknown-host";
+}
+
+void countAt(uint64_t start, uint64_t dist, int threads)
+{
+  set_num_threads(threads);
+  sink += count_primes(start, start + dist);
+}
+
+void iteratorStream(uint64_t stop)
+{
+  primesieve::iterator it;
+  uint64_t count = 0;
+  while (it.next_prime() < stop)
+    count++;
+  sink += count;
+}
+
+void nthPrime(uint64_t n)
+{
+  set_num_threads(ParallelSieve::getMaxThreads());
+  sink += nth_prime(n);
+}
+
+#if defined(HAS_DEVNULL)
+
+/// Print the primes with stdout redirected to /dev/null,
+/// which benchmarks the PrintPrimes decode and formatting
+/// path without the terminal's throughput
+///
+void printDevNull(uint64_t stop)
+{
+  cout.flush();
+  fflush(stdout);
+  int saved = dup(1);
+  int devNull = open("/dev/null", O_WRONLY);
+  dup2(devNull, 1);
+
+  print_primes(0, stop);
+
+  cout.flush();
+  fflush(stdout);
+  dup2(saved, 1);
+  close(saved);
+  close(devNull);
+}
+
+#endif
+
+struct Workload
+{
+  const char* name;
+  void (*run)();
+};
+
+/// The fixed workload matrix. The count workloads pin the
+/// start offset so each exercises a different dominant
+/// cross-off algorithm (EratSmall/EratMedium/EratBig), and
+/// pin the thread count so a scheduling change does not
+/// masquerade as a sieving change
+///
+const Workload workloads[] =
+{
+  { "count_1e12_t1",   []{ countAt(1000000000000ull, 500000000, 1); } },
+  { "count_1e12_tmax", []{ countAt(1000000000000ull, 500000000, ParallelSieve::getMaxThreads()); } },
+  { "count_1e15_tmax", []{ countAt(1000000000000000ull, 200000000, ParallelSieve::getMaxThreads()); } },
+  { "count_1e17_tmax", []{ countAt(100000000000000000ull, 100000000, ParallelSieve::getMaxThreads()); } },
+  { "iterator_t1",     []{ iteratorStream(100000000); } },
+  { "nth_prime_tmax",  []{ nthPrime(100000000); } },
+#if defined(HAS_DEVNULL)
+  { "print_devnull",   []{ printDevNull(10000000); } },
+#endif
+};
+
+double bestOf(const Workload& workload)
+{
+  double best = 0;
+
+  for (int i = 0; i < runs; i++)
+  {
+    double time = getTime();
+    workload.run();
+    double seconds = getTime() - time;
+    if (i == 0 || seconds < best)
+      best = seconds;
+  }
+
+  return best;
+}
+
+/// host -> (workload -> seconds)
+using baseline_t = map<string, map<string, double>>;
+
+baseline_t readBaseline(const string& filePath)
+{
+  baseline_t baseline;
+  ifstream file(filePath);
+  string line;
+
+  while (getline(file, line))
+  {
+    size_t comma1 = line.find(',');
+    size_t comma2 = line.find(',', comma1 + 1);
+    if (comma1 == string::npos ||
+        comma2 == string::npos)
+      continue;
+
+    string host = line.substr(0, comma1);
+    string name = line.substr(comma1 + 1, comma2 - comma1 - 1);
+    double seconds = atof(line.c_str() + comma2 + 1);
+    baseline[host][name] = seconds;
+  }
+
+  return baseline;
+}
+
+void writeBaseline(const string& filePath, const baseline_t& baseline)
+{
+  ofstream file(filePath, ofstream::trunc);
+
+  for (const auto& host : baseline)
+    for (const auto& entry : host.second)
+      file << host.first << ',' << entry.first << ',' << entry.second << '\n';
+
+  if (!file)
+    cerr << "WARNING: cannot write baseline file: " << filePath << endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  string filePath = "primesieve-regression.baseline";
+  bool update = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--update") == 0)
+      update = true;
+    else if (strncmp(argv[i], "--runs=", 7) == 0)
+      runs = atoi(argv[i] + 7);
+    else if (strncmp(argv[i], "--tolerance=", 12) == 0)
+      tolerance = atof(argv[i] + 12);
+    else
+      filePath = argv[i];
+  }
+
+  string host = getHostname();
+  baseline_t baseline = readBaseline(filePath);
+  auto& hostBaseline = baseline[host];
+  bool newEntries = false;
+  int regressions = 0;
+
+  printf("host: %s, runs: %d, tolerance: %.0f%%\n",
+         host.c_str(), runs, tolerance * 100);
+  printf("%-16s %10s %10s %8s  %s\n",
+         "workload", "seconds", "baseline", "delta", "status");
+
+  for (const Workload& workload : workloads)
+  {
+    double seconds = bestOf(workload);
+    auto iter = hostBaseline.find(workload.name);
+
+    if (iter == hostBaseline.end())
+    {
+      // first run on this host, record the baseline
+      hostBaseline[workload.name] = seconds;
+      newEntries = true;
+      printf("%-16s %10.3f %10s %8s  NEW\n",
+             workload.name, seconds, "-", "-");
+      continue;
+    }
+
+    double base = iter->second;
+    double delta = (seconds - base) * 100.0 / base;
+    const char* status = "OK";
+
+    if (seconds > base * (1.0 + tolerance) + absoluteFloor)
+    {
+      status = "REGRESSION";
+      regressions++;
+    }
+    else if (seconds * (1.0 + tolerance) + absoluteFloor < base)
+      status = "FASTER (--update to rebase)";
+
+    if (update)
+      hostBaseline[workload.name] = seconds;
+
+    printf("%-16s %10.3f %10.3f %+7.1f%%  %s\n",
+           workload.name, seconds, base, delta, status);
+  }
+
+  if (update || newEntries)
+    writeBaseline(filePath, baseline);
+
+  if (regressions > 0)
+  {
+    printf("%d workload(s) regressed beyond the %.0f%% tolerance!\n",
+           regressions, tolerance * 100);
+    return 1;
+  }
+
+  printf("No performance regressions detected.\n");
+  return 0;
+}
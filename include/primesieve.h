@@ -16,6 +16,21 @@
 #define PRIMESIEVE_VERSION_MAJOR 7
 #define PRIMESIEVE_VERSION_MINOR 0
 
+/**
+ * The *_noexcept() functions are declared noexcept for C++
+ * callers: no exception ever escapes them, they report errors
+ * via their int return value (0 = success) instead of an
+ * error sentinel, so call sites compile without unwind code
+ * e.g. in -fno-exceptions builds.
+ */
+#ifndef PRIMESIEVE_NOEXCEPT
+  #ifdef __cplusplus
+    #define PRIMESIEVE_NOEXCEPT noexcept
+  #else
+    #define PRIMESIEVE_NOEXCEPT
+  #endif
+#endif
+
 #include <primesieve/iterator.h>
 
 #include <stdint.h>
@@ -75,6 +90,36 @@ void* primesieve_generate_primes(uint64_t start, uint64_t stop, size_t* size, in
  */
 void* primesieve_generate_n_primes(uint64_t n, uint64_t start, int type);
 
+/**
+ * Approximation of the number of primes inside [start, stop]
+ * that is guaranteed to be >= the actual prime count. Use it
+ * to size a buffer for primesieve_generate_primes_buffer().
+ */
+size_t primesieve_count_approx(uint64_t start, uint64_t stop);
+
+/**
+ * Generate the primes inside the interval [start, stop]
+ * directly into the caller owned buffer, no memory is
+ * allocated and no primesieve_free() call is needed. Use
+ * primesieve_count_approx() to size the buffer.
+ * @param buffer    Buffer for @capacity primes of @type.
+ * @param capacity  Number of primes the buffer can hold.
+ * @param type      The type of the primes to generate, e.g. INT_PRIMES.
+ * @return The number of primes written to the buffer, or
+ *         SIZE_MAX if an error occurs (errno is set to EDOM),
+ *         e.g. if the buffer is too small.
+ */
+size_t primesieve_generate_primes_buffer(uint64_t start, uint64_t stop, void* buffer, size_t capacity, int type);
+
+/**
+ * Same as primesieve_generate_primes_buffer() but with a
+ * status code return: the number of generated primes is
+ * stored in *size.
+ * @return 0 on success, non-zero if an error occurs,
+ *         e.g. if the buffer is too small.
+ */
+int primesieve_generate_primes_buffer_noexcept(uint64_t start, uint64_t stop, void* buffer, size_t capacity, int type, size_t* size) PRIMESIEVE_NOEXCEPT;
+
 /**
  * Find the nth prime.
  * By default all CPU cores are used, use
@@ -87,13 +132,71 @@ void* primesieve_generate_n_primes(uint64_t n, uint64_t start, int type);
 uint64_t primesieve_nth_prime(int64_t n, uint64_t start);
 
 /**
- * Count the primes within the interval [start, stop]. 
+ * Same as primesieve_nth_prime() but with a status code
+ * return: the nth prime is stored in *prime.
+ * @return 0 on success, non-zero if an error occurs.
+ */
+int primesieve_nth_prime_noexcept(int64_t n, uint64_t start, uint64_t* prime) PRIMESIEVE_NOEXCEPT;
+
+/**
+ * Count the primes within the interval [start, stop].
  * By default all CPU cores are used, use
  * primesieve_set_num_threads(int threads) to change the
  * number of threads.
  */
 uint64_t primesieve_count_primes(uint64_t start, uint64_t stop);
 
+/**
+ * Same as primesieve_count_primes() but with a status code
+ * return: the prime count is stored in *count.
+ * @return 0 on success, non-zero if an error occurs.
+ */
+int primesieve_count_primes_noexcept(uint64_t start, uint64_t stop, uint64_t* count) PRIMESIEVE_NOEXCEPT;
+
+/**
+ * Handle of an asynchronous operation, see
+ * primesieve_count_primes_async().
+ */
+typedef struct primesieve_async primesieve_async;
+
+/**
+ * Completion callback of an asynchronous operation, invoked
+ * on a background thread when the operation finishes.
+ * @param count      The result, only valid if status is 0.
+ * @param status     0 = success, 1 = error, 2 = cancelled.
+ * @param user_data  The pointer passed to the *_async() call.
+ */
+typedef void (*primesieve_async_callback)(uint64_t count, int status, void* user_data);
+
+/**
+ * Count the primes within the interval [start, stop] on a
+ * background thread, the calling thread returns immediately.
+ * The callback is invoked exactly once when counting
+ * finishes (also on error and after cancellation). The
+ * returned handle must be released with
+ * primesieve_async_wait().
+ * @return Handle of the operation, NULL if the operation
+ *         could not be started (errno is set to EDOM).
+ */
+primesieve_async* primesieve_count_primes_async(uint64_t start, uint64_t stop, primesieve_async_callback callback, void* user_data);
+
+/**
+ * Request cancellation of an asynchronous operation: the
+ * sieving threads stop at the next segment boundary and the
+ * completion callback is invoked with status = 2. Returns
+ * immediately without waiting.
+ */
+void primesieve_async_cancel(primesieve_async* async);
+
+/**
+ * Wait until the asynchronous operation has finished (and
+ * its completion callback has returned), then free the
+ * handle. Every handle must be released with this function.
+ * @return Final status: 0 = success, 1 = error,
+ *         2 = cancelled.
+ */
+int primesieve_async_wait(primesieve_async* async);
+
 /**
  * Count the twin primes within the interval [start, stop]. 
  * By default all CPU cores are used, use
@@ -198,6 +301,34 @@ void primesieve_set_sieve_size(int sieve_size);
  */
 void primesieve_set_num_threads(int num_threads);
 
+/**
+ * Runtime tuning parameters, the defaults match the compile
+ * time constants in primesieve/config.hpp. See the C++
+ * primesieve::Tuning struct for the parameter preconditions.
+ */
+typedef struct
+{
+  double factor_eratsmall;
+  double factor_eratmedium;
+  uint64_t bytes_per_alloc;
+  uint64_t min_cache_iterator;
+  uint64_t max_cache_iterator;
+  uint64_t min_thread_distance;
+} primesieve_tuning;
+
+/**
+ * Set the runtime tuning parameters, e.g. to load a per CPU
+ * model tuning profile at startup without rebuilding. Must be
+ * called before sieving starts, if any value is invalid no
+ * parameter is changed and errno is set to EDOM.
+ */
+void primesieve_set_tuning(const primesieve_tuning* tuning);
+
+/**
+ * Get the current runtime tuning parameters.
+ */
+void primesieve_get_tuning(primesieve_tuning* tuning);
+
 /**
  * Deallocate a primes array created using the
  * primesieve_generate_primes() or primesieve_generate_n_primes()
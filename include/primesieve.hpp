@@ -18,10 +18,14 @@
 #define PRIMESIEVE_VERSION_MINOR 0
 
 #include <primesieve/iterator.hpp>
+#include <primesieve/primes_range.hpp>
 #include <primesieve/primesieve_error.hpp>
 #include <primesieve/StorePrimes.hpp>
 
 #include <stdint.h>
+#include <cstddef>
+#include <functional>
+#include <utility>
 #include <vector>
 #include <string>
 
@@ -62,6 +66,109 @@ inline void generate_n_primes(uint64_t n, uint64_t start, std::vector<T>* primes
     store_n_primes(n, start, *primes);
 }
 
+/// Store the primes within the interval [start, stop] in the
+/// primes vector using multiple threads. The primes are stored
+/// in ascending order like generate_primes().
+/// By default all CPU cores are used, use
+/// primesieve::set_num_threads(int threads) to change the
+/// number of threads.
+///
+void generate_primes_parallel(uint64_t start, uint64_t stop, std::vector<uint64_t>* primes);
+
+/// Store the first members of the prime k-tuplets inside the
+/// interval [start, stop] in the kTuplets vector, in ascending
+/// order. @k: 2 = twin primes, 3 = prime triplets, ...
+/// 6 = prime sextuplets; other values throw a primesieve_error.
+/// The k-tuplets are extracted directly from the raw sieve
+/// bytes using multiple threads, use
+/// primesieve::set_num_threads(int threads) to change the
+/// number of threads.
+///
+void generate_ktuplets(int k, uint64_t start, uint64_t stop, std::vector<uint64_t>* kTuplets);
+
+/// Generate the primes within the interval [start, stop]
+/// into the caller provided buffer without any memory
+/// allocation. Whenever fewer than 64 free slots remain
+/// (and once for the final partial block) the callback is
+/// invoked with the buffer and the number of primes in it.
+/// @capacity: buffer size in primes, must be >= 64.
+///
+void generate_primes_buffered(uint64_t start,
+                              uint64_t stop,
+                              uint64_t* buffer,
+                              std::size_t capacity,
+                              const std::function<void(const uint64_t*, std::size_t)>& callback);
+
+/// Sieve the interval [start, stop] and invoke the callback
+/// once per sieved segment with a zero-copy view of the raw
+/// sieve array: callback(low, sieve, size). The sieve array
+/// uses 8 bits for 30 numbers: bit j of sieve[i] is set if
+/// low + i * 30 + {7, 11, 13, 17, 19, 23, 29, 31}[j] is
+/// prime, with low % 30 == 0. Bits corresponding to numbers
+/// outside [start, stop] are 0 and the primes 2, 3 and 5
+/// are not representable in this layout. The sieve array is
+/// only valid for the duration of the callback.
+///
+void sieve_segments(uint64_t start,
+                    uint64_t stop,
+                    const std::function<void(uint64_t low, const uint8_t* sieve, std::size_t size)>& callback);
+
+/// Store the primes within the interval [start, stop] into a
+/// compact on-disk prime store file: delta-encoded blocks of
+/// primes plus a sparse index. The file can be read back with
+/// the PrimeFile class (primesieve/PrimeFile.hpp) which
+/// memory-maps it, so regenerating the same primes across jobs
+/// is replaced by instant random access to the cached file.
+///
+void store_primes_file(uint64_t start, uint64_t stop, const std::string& filePath);
+
+/// Generate the primes within the interval [start, stop]
+/// into a file of raw 64-bit primes (native byte order, no
+/// header). The primes are decoded directly into a
+/// memory-mapped window of the file with periodic msync, so
+/// even a prime table far larger than RAM streams to disk
+/// at constant memory usage, without the intermediate
+/// vector and copy of generate_primes() + write().
+/// @return the number of primes written.
+///
+uint64_t generate_primes_file(uint64_t start, uint64_t stop, const std::string& filePath);
+
+/// Store the sieving primes needed to sieve up to stop (all
+/// primes inside [7, sqrt(stop)]) together with their
+/// precomputed first multiple reciprocals into a binary
+/// snapshot file. Jobs with a fixed upper bound regenerate
+/// the identical sieving primes at every process start,
+/// loading the snapshot with set_sieving_primes_file()
+/// replaces that deterministic recomputation by a
+/// memory-mapping whose pages are shared across processes
+/// on the same machine.
+///
+void store_sieving_primes_file(uint64_t stop, const std::string& filePath);
+
+/// Memory-map a sieving prime snapshot file written by
+/// store_sieving_primes_file() and use its tables in all
+/// subsequent sieving (count_primes(), nth_prime(),
+/// PrimeSieve, ParallelSieve) whose sqrt(stop) the snapshot
+/// covers. Larger ranges fall back to generating the sieving
+/// primes as usual. Pass an empty string to stop using the
+/// snapshot. Throws a primesieve_error if the file cannot be
+/// opened or has an invalid format.
+///
+void set_sieving_primes_file(const std::string& filePath);
+
+/// Partition the interval [start, stop] into (at most) parts
+/// non-overlapping subintervals [first, second] that cover
+/// [start, stop] without gaps. The subinterval borders are
+/// aligned the same way as primesieve's internal thread
+/// chunks, so no prime k-tuplet (twin primes, prime
+/// triplets, ...) straddles a border: sieving the
+/// subintervals independently (e.g. on different machines)
+/// and summing their counts yields exactly the counts of
+/// sieving [start, stop] in one run.
+///
+std::vector<std::pair<uint64_t, uint64_t>>
+  partition_range(uint64_t start, uint64_t stop, uint64_t parts);
+
 /// Find the nth prime.
 /// By default all CPU cores are used, use
 /// primesieve::set_num_threads(int threads) to change the
@@ -79,6 +186,97 @@ uint64_t nth_prime(int64_t n, uint64_t start = 0);
 ///
 uint64_t count_primes(uint64_t start, uint64_t stop);
 
+/// Count the primes p ≡ a (mod q) within the interval
+/// [start, stop], i.e. pi(x; q, a) style prime counts in
+/// arithmetic progressions. The residue class is counted
+/// directly on the sieve bitmap with precomputed per byte
+/// count tables, so the cost is that of sieving the interval
+/// once instead of materializing all primes and filtering
+/// them by modulus. The count tables grow linearly with q,
+/// hence moduli above a few thousand fall back to filtering
+/// the generated primes (same result, more memory friendly).
+/// @pre q > 0 (a is reduced mod q).
+///
+uint64_t count_primes_mod(uint64_t start, uint64_t stop, uint64_t q, uint64_t a);
+
+/// Count the primes within the interval [start, stop] with
+/// 128-bit bounds, e.g. for counting the primes inside a
+/// window just above 2^64. Both bounds are passed split into
+/// their high and low 64-bit halves, i.e.
+/// start = startHi * 2^64 + startLo. The window is sieved in
+/// 64-bit offset coordinates, hence (stop - start) must be
+/// smaller than 2^64 - 5*10^11. If stop < 2^64 the query is
+/// delegated to count_primes(). Requires a compiler with
+/// unsigned __int128 support (GCC, Clang), otherwise a
+/// primesieve_error is thrown for stop >= 2^64.
+///
+uint64_t count_primes_128(uint64_t startHi,
+                          uint64_t startLo,
+                          uint64_t stopHi,
+                          uint64_t stopLo);
+
+/// Sum the primes within the interval [start, stop].
+/// The sum is computed from the sieve array without
+/// decoding the individual primes and in parallel, by
+/// default all CPU cores are used (see set_num_threads).
+/// The sum is computed modulo 2^64, it wraps around once
+/// the prime sum exceeds 2^64 - 1 (stop > ~3 * 10^10).
+///
+uint64_t sum_primes(uint64_t start, uint64_t stop);
+
+/// Fold the primes within the interval [start, stop]:
+/// acc = block(acc, primes, size) is invoked with blocks
+/// of consecutive primes, starting from acc = init. The
+/// range is sieved in parallel, the per-thread partial
+/// results are combined in range order using merge(a, b).
+/// For correct results with multiple threads block and
+/// merge must describe an associative reduction with init
+/// as its identity element (e.g. init = 0, block sums
+/// p % m over the primes, merge adds).
+///
+uint64_t reduce_primes(uint64_t start,
+                       uint64_t stop,
+                       uint64_t init,
+                       const std::function<uint64_t(uint64_t acc, const uint64_t* primes, std::size_t size)>& block,
+                       const std::function<uint64_t(uint64_t a, uint64_t b)>& merge);
+
+/// Prime gap statistics of an interval,
+/// see prime_gaps().
+///
+struct PrimeGaps
+{
+  /// Largest gap between consecutive primes
+  /// within [start, stop]
+  uint64_t maxGap = 0;
+  /// Prime starting the largest gap
+  uint64_t maxGapStart = 0;
+  /// histogram[g] = number of gaps of size g
+  std::vector<uint64_t> histogram;
+  /// Gap records in range order as (prime starting the gap,
+  /// gap) pairs, each gap is larger than every gap before it
+  std::vector<std::pair<uint64_t, uint64_t>> records;
+};
+
+/// Collect the prime gap statistics of the interval
+/// [start, stop]: the largest gap, the histogram of all gaps
+/// and the gap records (first occurrence of each new maximal
+/// gap). Only gaps between primes that are both inside
+/// [start, stop] are counted. The gaps are read directly off
+/// the sieve array bits which is much faster than iterating
+/// the primes, by default all CPU cores are used (see
+/// set_num_threads).
+///
+PrimeGaps prime_gaps(uint64_t start, uint64_t stop);
+
+/// Count the primes in multiple half-open intervals
+/// [first, second) using a single sieving pass over the
+/// union of the intervals. Much faster than calling
+/// count_primes() per interval when many intervals share
+/// one big range.
+/// @return the prime count of each interval, in input order.
+///
+std::vector<uint64_t> count_primes_intervals(const std::vector<std::pair<uint64_t, uint64_t>>& intervals);
+
 /// Count the twin primes within the interval [start, stop].
 /// By default all CPU cores are used, use
 /// primesieve::set_num_threads(int threads) to change the
@@ -169,6 +367,110 @@ void set_sieve_size(int sieve_size);
 ///
 void set_num_threads(int num_threads);
 
+/// Allocation hook: returns a pointer to @bytes bytes of
+/// memory suitable for any object type, or null on failure.
+using allocator_t = void* (*)(std::size_t bytes);
+
+/// Deallocation hook: frees memory returned by the matching
+/// allocation hook. @bytes is the size that was allocated,
+/// so size aware pool allocators need no per allocation
+/// headers.
+using deallocator_t = void (*)(void* ptr, std::size_t bytes);
+
+/// Install a custom allocator for primesieve's large internal
+/// allocations: the sieve arrays (also those of
+/// primesieve::iterator) and EratBig's bucket chunks, so the
+/// sieve can run out of e.g. a pinned memory or hugepage
+/// backed pool instead of the global heap. Must be called
+/// before sieving starts: deallocations always go through the
+/// currently installed hooks and the internal bucket pools
+/// keep memory alive across calls (it is returned through the
+/// hooks at process exit, so every allocation is eventually
+/// paired with a deallocation). Pass null for both
+/// parameters to restore the default (operator new). Passing
+/// only one null hook throws a primesieve_error.
+///
+void set_allocator(allocator_t alloc, deallocator_t dealloc);
+
+/// Runtime tuning parameters, the defaults match the compile
+/// time constants in primesieve/config.hpp. See config.hpp
+/// for a detailed description of each parameter.
+///
+struct Tuning
+{
+  /// Sieving primes <= (L1 cache size * factorEratSmall)
+  /// are processed in EratSmall objects.
+  /// @pre factorEratSmall >= 0 && <= 3.
+  double factorEratSmall;
+  /// Sieving primes <= (sieve size * factorEratMedium)
+  /// are processed in EratMedium objects.
+  /// @pre factorEratMedium >= 0 && <= 5.
+  double factorEratMedium;
+  /// EratBig allocates bucket memory in chunks of
+  /// bytesPerAlloc bytes.
+  /// @pre bytesPerAlloc >= 2^20.
+  uint64_t bytesPerAlloc;
+  /// primesieve::iterator caches at least
+  /// minCacheIterator bytes of primes.
+  /// @pre minCacheIterator >= 2^16 && <= maxCacheIterator.
+  uint64_t minCacheIterator;
+  /// primesieve::iterator maximum cache size in bytes.
+  uint64_t maxCacheIterator;
+  /// Each thread sieves at least a distance of
+  /// minThreadDistance to reduce initialization overhead.
+  /// @pre minThreadDistance >= 100.
+  uint64_t minThreadDistance;
+  /// Experimental: if set to 2 each segment is sieved by
+  /// 2 threads (EratMedium pipelined ahead of EratSmall).
+  /// @pre threadsPerSegment == 1 || == 2.
+  int threadsPerSegment;
+};
+
+/// Set the runtime tuning parameters, e.g. to load a per CPU
+/// model tuning profile at startup without rebuilding. Must be
+/// called before sieving starts, invalid values throw a
+/// primesieve_error.
+///
+void set_tuning(const Tuning& tuning);
+
+/// Get the current runtime tuning parameters.
+/// If the PRIMESIEVE_TUNE_FILE environment variable points
+/// to a profile file written by save_tuning() the profile
+/// is loaded automatically (once, before sieving starts),
+/// explicit set_tuning() and set_sieve_size() calls take
+/// precedence over the profile.
+///
+Tuning get_tuning();
+
+/// Benchmark the local CPU and return the best performing
+/// tuning parameters: the sieve size and the
+/// factorEratSmall/factorEratMedium crossover points are
+/// measured by timing single-threaded sieving runs, the best
+/// sieve size is applied directly via set_sieve_size(). The
+/// returned tuning is not applied, pass it to set_tuning()
+/// and persist it with save_tuning().
+/// @param dist  sieving distance per measurement, larger
+///              values are more accurate but slower.
+///
+Tuning calibrate_tuning(uint64_t dist = 100000000ull);
+
+/// Write the current tuning parameters and sieve size to a
+/// profile file (atomically). Point the PRIMESIEVE_TUNE_FILE
+/// environment variable to this file to load the profile
+/// automatically in subsequent runs.
+///
+void save_tuning(const std::string& filePath);
+
+/// Enable/disable transparent huge page backing for large
+/// internal allocations (sieve array, bucket memory).
+/// Enabled by default, huge pages are only a hint to the OS
+/// and allocations transparently fall back to regular pages.
+///
+void set_huge_pages(bool enable);
+
+/// Check whether transparent huge pages are enabled.
+bool get_huge_pages();
+
 /// Get the primesieve version number, in the form “i.j”.
 std::string primesieve_version();
 
@@ -0,0 +1,72 @@
+///
+/// @file  AsyncSievingPrimes.hpp
+/// @brief Streams the sieving primes in ascending order from
+///        a producer thread so that their generation overlaps
+///        with the consumer's main sieving.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef ASYNCSIEVINGPRIMES_HPP
+#define ASYNCSIEVINGPRIMES_HPP
+
+#include "SievingPrimes.hpp"
+
+#include <stdint.h>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace primesieve {
+
+class Erat;
+class PreSieve;
+
+/// Drop-in replacement for SievingPrimes. When sqrt(stop) is
+/// large the sieving primes are generated on a producer
+/// thread and handed to the consumer in blocks through a
+/// bounded queue, below the threshold the producer thread is
+/// skipped and next() simply forwards to SievingPrimes.
+///
+class AsyncSievingPrimes
+{
+public:
+  AsyncSievingPrimes(Erat* erat, PreSieve& preSieve);
+  ~AsyncSievingPrimes();
+  uint64_t next();
+private:
+  SievingPrimes sievingPrimes_;
+  std::thread producer_;
+  std::mutex lock_;
+  std::condition_variable pending_;
+  std::condition_variable drained_;
+  std::deque<std::vector<uint64_t>> queue_;
+  /// Block currently consumed by next()
+  std::vector<uint64_t> block_;
+  std::size_t index_ = 0;
+  bool async_ = false;
+  bool stop_ = false;
+  uint64_t nextBlock();
+  void producerThread(Erat* erat, PreSieve* preSieve);
+};
+
+inline uint64_t AsyncSievingPrimes::next()
+{
+  if (!async_)
+    return sievingPrimes_.next();
+
+  if (index_ < block_.size())
+    return block_[index_++];
+
+  return nextBlock();
+}
+
+} // namespace
+
+#endif
@@ -0,0 +1,46 @@
+///
+/// @file   BucketPool.hpp
+/// @brief  Pool allocator for the Bucket memory of EratBig.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef BUCKETPOOL_HPP
+#define BUCKETPOOL_HPP
+
+#include "Bucket.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace primesieve {
+
+/// BucketPool hands out bucket memory in large chunks and
+/// recycles retired chunks instead of returning them to the
+/// system allocator. Each thread first serves requests from
+/// its own free list and falls back to a shared global pool,
+/// this avoids allocator contention when many ParallelSieve
+/// threads sieve concurrently.
+///
+class BucketPool
+{
+public:
+  /// Number of buckets per chunk, derived from the
+  /// bytesPerAlloc tuning parameter. Latched at first use
+  /// because the pool recycles chunks of this fixed size.
+  ///
+  static std::size_t chunkBuckets();
+
+  /// Get a chunk of chunkBuckets() uninitialized buckets
+  static Bucket* getChunk();
+
+  /// Return the chunks to the pool for bulk recycling
+  static void freeChunks(std::vector<Bucket*>& chunks);
+};
+
+} // namespace
+
+#endif
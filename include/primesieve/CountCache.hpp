@@ -0,0 +1,46 @@
+///
+/// @file  CountCache.hpp
+/// @brief The CountCache memoizes prime counts of aligned 10^9
+///        blocks in a file shared across runs, so that jobs
+///        repeatedly counting overlapping subranges only sieve
+///        the block boundary residuals.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef COUNTCACHE_HPP
+#define COUNTCACHE_HPP
+
+#include <stdint.h>
+#include <map>
+#include <mutex>
+
+namespace primesieve {
+
+class CountCache
+{
+public:
+  static CountCache& getInstance();
+  /// true if the PRIMESIEVE_COUNT_FILE
+  /// environment variable is set
+  static bool enabled();
+  /// Distance covered by one cached block
+  static uint64_t distance();
+  /// Count the primes inside [start, stop]
+  uint64_t countPrimes(uint64_t start, uint64_t stop);
+private:
+  std::mutex lock_;
+  /// counts_[i] = number of primes inside
+  /// [i * distance(), (i + 1) * distance() - 1]
+  std::map<uint64_t, uint64_t> counts_;
+  bool loaded_ = false;
+  void load();
+  void save() const;
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,49 @@
+///
+/// @file  CountIntervals.hpp
+/// @brief The CountIntervals class counts the primes in many
+///        intervals using a single sieving pass over their union.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef COUNTINTERVALS_HPP
+#define COUNTINTERVALS_HPP
+
+#include "Erat.hpp"
+#include "PreSieve.hpp"
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+namespace primesieve {
+
+/// Sieves [start, stop] once and records the prefix prime
+/// count at each of the sorted boundary points, from which
+/// the caller derives the count of any interval by
+/// subtracting two prefix counts
+///
+class CountIntervals : public Erat
+{
+public:
+  CountIntervals(uint64_t start, uint64_t stop, const std::vector<uint64_t>& points);
+  void sieve();
+  const std::vector<uint64_t>& getCounts() const { return counts_; }
+private:
+  PreSieve preSieve_;
+  /// Sorted boundary points, counts_[i] = number of
+  /// primes inside [start, points_[i]]
+  const std::vector<uint64_t>& points_;
+  std::vector<uint64_t> counts_;
+  std::size_t index_ = 0;
+  uint64_t count_ = 0;
+  uint64_t low_ = 0;
+  void updateCounts(uint64_t prevCount);
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,55 @@
+///
+/// @file  CountResidues.hpp
+/// @brief The CountResidues class counts the primes congruent to
+///        a (mod q) directly on the sieve bitmap, without
+///        materializing the primes.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef COUNTRESIDUES_HPP
+#define COUNTRESIDUES_HPP
+
+#include "Erat.hpp"
+#include "PreSieve.hpp"
+#include "types.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+namespace primesieve {
+
+/// Sieves [start, stop] once and counts the primes ≡ a (mod q)
+/// using per byte count tables: each sieve byte covers 8
+/// numbers whose residues mod q only depend on the byte's base
+/// (base ≡ r mod q), so the bits of the wanted residue class
+/// are selected with a precomputed mask per r and counted with
+/// a single table lookup per byte (analogous to the k-tuplet
+/// counting tables in PrintPrimes)
+///
+class CountResidues : public Erat
+{
+public:
+  CountResidues(uint64_t start, uint64_t stop, uint64_t q, uint64_t a);
+  void sieve();
+  uint64_t getCount() const { return count_; }
+private:
+  PreSieve preSieve_;
+  /// Modulus of the residue class
+  uint64_t q_;
+  uint64_t count_ = 0;
+  uint64_t low_ = 0;
+  /// residueCounts_[r * 256 + byte] = number of 1 bits in
+  /// byte whose numbers are ≡ a (mod q) given the byte's
+  /// base is ≡ r (mod q)
+  std::vector<byte_t> residueCounts_;
+  void initCounts(uint64_t a);
+  void countSegment();
+};
+
+} // namespace
+
+#endif
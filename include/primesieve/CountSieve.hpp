@@ -0,0 +1,41 @@
+///
+/// @file  CountSieve.hpp
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef COUNTSIEVE_HPP
+#define COUNTSIEVE_HPP
+
+#include "Erat.hpp"
+#include "PreSieve.hpp"
+#include "PrimeSieve.hpp"
+
+#include <stdint.h>
+
+namespace primesieve {
+
+/// CountSieve is used when the caller only counts primes
+/// (no printing, no prime k-tuplets). The primes are counted
+/// while sieving via Erat's fused count, so the per segment
+/// work is just the cross-off passes: unlike PrintPrimes no
+/// writer thread infrastructure, k-tuplet count tables or
+/// print buffers are carried along.
+///
+class CountSieve : public Erat
+{
+public:
+  CountSieve(PrimeSieve&);
+  void sieve();
+private:
+  PreSieve preSieve_;
+  /// Reference to the associated PrimeSieve object
+  PrimeSieve& ps_;
+};
+
+} // namespace
+
+#endif
@@ -1,6 +1,8 @@
 ///
 /// @file  CpuInfo.hpp
-/// @brief Get the CPUs' cache sizes in bytes
+/// @brief Get the CPUs' cache sizes in bytes. The detection
+///        runs lazily on first use, the global cpuInfo object
+///        does no work before main().
 ///
 /// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
 ///
@@ -13,26 +15,61 @@
 
 #include <cstddef>
 #include <string>
+#include <vector>
 
 namespace primesieve {
 
 class CpuInfo
 {
 public:
-  CpuInfo();
   bool hasL1Cache() const;
   bool hasL2Cache() const;
   bool privateL2Cache() const;
+  bool hasAVX2() const;
+  bool hasAVX512() const;
+  bool hasAVX512VPOPCNT() const;
+  bool hasBMI2() const;
+  bool hasNEON() const;
+  bool hasHybridCores() const;
   std::string getError() const;
   std::size_t l1CacheSize() const;
   std::size_t l2CacheSize() const;
+  std::size_t l2Sharing() const;
+  std::size_t threadsPerCore() const;
+  std::size_t numaNodes() const;
+  std::size_t currentNumaNode() const;
+  const std::vector<std::size_t>& numaNodeCpus(std::size_t node) const;
 
 private:
-  std::size_t l1CacheSize_;
-  std::size_t l2CacheSize_;
-  bool privateL2Cache_;
-  std::string error_;
-  void init();
+  /// Detected CPU topology. It is created lazily on first
+  /// use (thread-safe magic static) so that no sysfs/sysctl
+  /// files are read before main() or in runs that never
+  /// query the CPU topology, see CpuInfo.cpp
+  ///
+  struct CpuData
+  {
+    std::size_t l1CacheSize_ = 0;
+    std::size_t l2CacheSize_ = 0;
+    std::size_t l2Sharing_ = 0;
+    std::size_t threadsPerCore_ = 0;
+    std::vector<std::vector<std::size_t>> numaNodeCpus_;
+    bool privateL2Cache_ = false;
+    bool avx2_ = false;
+    bool avx512_ = false;
+    bool avx512vpopcnt_ = false;
+    bool bmi2_ = false;
+    bool neon_ = false;
+    bool hybrid_ = false;
+    std::string error_;
+    CpuData();
+    void initCache();
+    void initNuma();
+    void initIsa();
+    bool initCpuid();
+    bool loadFile(const char* path);
+    void saveFile(const char* path) const;
+  };
+  static const CpuData& data();
 };
 
 // Singleton
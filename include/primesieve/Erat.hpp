@@ -13,11 +13,11 @@
 #include "EratSmall.hpp"
 #include "EratMedium.hpp"
 #include "EratBig.hpp"
+#include "SieveStats.hpp"
 #include "types.hpp"
 
 #include <stdint.h>
 #include <array>
-#include <memory>
 
 namespace primesieve {
 
@@ -34,7 +34,14 @@ class Erat
 public:
   uint64_t getSieveSize() const;
   uint64_t getStop() const;
+  const SieveStats& getStats() const { return stats_; }
+  /// Largest number up to which the segment loop has
+  /// finished sieving, used to report where a cancelled
+  /// run stopped, see PrimeSieve::getStoppedAt()
+  uint64_t getSievedHigh() const;
 protected:
+  /// Per-phase wall time of this Erat object
+  SieveStats stats_;
   /// Sieve primes >= start_
   uint64_t start_ = 0;
   /// Sieve primes <= stop_
@@ -47,29 +54,46 @@ protected:
   uint64_t segmentHigh_ = 0;
   /// Sieve of Eratosthenes array
   byte_t* sieve_ = nullptr;
+  /// If non-null the 1 bits of each segment are counted
+  /// while sieving (during the last cross-off pass) instead
+  /// of requiring a second pass over the sieve array
+  uint64_t* fusedCount_ = nullptr;
   PreSieve* preSieve_;
+  uint64_t maxPreSieve_;
+  uint64_t maxEratSmall_;
+  uint64_t maxEratMedium_;
+  EratSmall eratSmall_;
+  EratMedium eratMedium_;
+  EratBig eratBig_;
   Erat();
   Erat(uint64_t, uint64_t);
   virtual ~Erat();
-  void init(uint64_t, uint64_t, uint64_t, PreSieve&);
+  void init(uint64_t, uint64_t, uint64_t, PreSieve&, uint64_t = 0);
   void addSievingPrime(uint64_t);
+  void addSievingPrime(uint64_t, const PrimeReciprocal&);
   void sieveSegment();
   bool hasNextSegment() const;
+  uint64_t countSieve(uint64_t, uint64_t) const;
   static uint64_t nextPrime(uint64_t*, uint64_t);
 private:
   static const std::array<uint64_t, 64> bruijnBitValues_;
-  uint64_t maxPreSieve_;
-  uint64_t maxEratSmall_;
-  uint64_t maxEratMedium_;
-  std::unique_ptr<byte_t[]> deleter_;
-  EratSmall eratSmall_;
-  EratMedium eratMedium_;
-  EratBig eratBig_;
+  static const std::array<uint64_t, 64> bitValues_;
+  /// Stripe size (in bytes) of the experimental
+  /// 2-thread pipelined cross-off mode
+  uint64_t stripeSize_ = 0;
+  /// Experimental 2-thread pipelined cross-off mode,
+  /// see Tuning::threadsPerSegment
+  bool pipelined_ = false;
+  /// Sieve memory from allocBytes() (allocator.hpp),
+  /// freed with its size in ~Erat()
+  byte_t* sieveAlloc_ = nullptr;
+  uint64_t sieveAllocBytes_ = 0;
   static uint64_t byteRemainder(uint64_t);
   void initSieve(uint64_t);
-  void initErat();
+  void initErat(uint64_t);
   void preSieve();
   void crossOff();
+  void crossOffPipelined();
   void sieveLastSegment();
 };
 
@@ -78,6 +102,14 @@ private:
 ///
 inline uint64_t Erat::nextPrime(uint64_t* bits, uint64_t low)
 {
+#if defined(__GNUC__) || \
+    defined(__clang__)
+  // compiles to a single tzcnt/bsf instruction
+  uint64_t bitValue = bitValues_[__builtin_ctzll(*bits)];
+  uint64_t prime = low + bitValue;
+  *bits &= *bits - 1;
+  return prime;
+#else
   // calculate bitValues_[bitScanForward(*bits)]
   // using a custom De Bruijn bitscan
   uint64_t debruijn = 0x3F08A4C6ACB9DBDull;
@@ -86,6 +118,7 @@ inline uint64_t Erat::nextPrime(uint64_t* bits, uint64_t low)
   uint64_t prime = low + bitValue;
   *bits &= mask;
   return prime;
+#endif
 }
 
 inline void Erat::addSievingPrime(uint64_t prime)
@@ -95,6 +128,16 @@ inline void Erat::addSievingPrime(uint64_t prime)
   else /* (prime > maxPreSieve) */ eratSmall_.addSievingPrime(prime, segmentLow_);
 }
 
+/// Add a sieving prime using its precomputed shared
+/// reciprocal, see PrimeReciprocal in Wheel.hpp
+///
+inline void Erat::addSievingPrime(uint64_t prime, const PrimeReciprocal& recip)
+{
+       if (prime > maxEratMedium_)   eratBig_.addSievingPrime(prime, segmentLow_, recip);
+  else if (prime > maxEratSmall_) eratMedium_.addSievingPrime(prime, segmentLow_, recip);
+  else /* (prime > maxPreSieve) */ eratSmall_.addSievingPrime(prime, segmentLow_, recip);
+}
+
 inline uint64_t Erat::getStop() const
 {
   return stop_;
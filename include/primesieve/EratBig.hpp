@@ -11,11 +11,11 @@
 #define ERATBIG_HPP
 
 #include "Bucket.hpp"
+#include "BucketPool.hpp"
 #include "Wheel.hpp"
 #include "types.hpp"
 
 #include <stdint.h>
-#include <memory>
 #include <vector>
 
 namespace primesieve {
@@ -27,6 +27,7 @@ namespace primesieve {
 class EratBig : public Wheel210_t
 {
 public:
+  ~EratBig();
   void init(uint64_t, uint64_t, uint64_t);
   void crossOff(byte_t*);
   bool enabled() const { return enabled_; }
@@ -34,16 +35,53 @@ private:
   uint64_t maxPrime_;
   uint64_t log2SieveSize_;
   uint64_t moduloSieveSize_;
+  /// Sieving primes <= hotMaxPrime_ are stored in the
+  /// dense hot_ array instead of the bucket lists
+  uint64_t hotMaxPrime_ = 0;
+  /// Sieving primes with a multiple every 1 to 2 segments,
+  /// processed linearly once per segment. They are stored
+  /// as a structure of arrays: hotIndexes_[i] holds the
+  /// packed multipleIndex and wheelIndex (same layout as
+  /// SievingPrime::indexes_) and hotPrimes_[i] the sieving
+  /// prime. The multipleIndex is relative to the current
+  /// segment and may point beyond it (into the next
+  /// segment). The separate indexes array allows testing
+  /// 8 multipleIndexes with a single vector load and
+  /// halves the bytes touched when a prime's multiple is
+  /// outside the current segment.
+  std::vector<uint32_t> hotIndexes_;
+  std::vector<uint32_t> hotPrimes_;
   /// Vector of bucket lists, holds the sieving primes
+  /// whose next multiple lies within the next superSpan_
+  /// segments (or within all segments if superSpan_ = 0)
   std::vector<Bucket*> lists_;
+  /// Number of segments per supersegment (0 = single
+  /// level). Chosen so that a multipleIndex relative to
+  /// the first segment of a supersegment still fits into
+  /// SievingPrime's 23 index bits.
+  uint64_t superSpan_ = 0;
+  /// Index of the segment currently being sieved
+  uint64_t currentSegment_ = 0;
+  /// 2nd-level bucket lists (used circularly), one per
+  /// supersegment. Sieving primes whose next multiple lies
+  /// beyond the lists_ window are parked here and only
+  /// distributed into lists_ once their supersegment
+  /// begins, so the number of resident bucket lists no
+  /// longer grows with the total segment count.
+  std::vector<Bucket*> superLists_;
   /// List of empty buckets
   Bucket* stock_;
-  /// Pointers of the allocated buckets
-  std::vector<std::unique_ptr<Bucket[]>> memory_;
+  /// Bucket chunks acquired from BucketPool
+  std::vector<Bucket*> chunks_;
   bool enabled_ = false;
   void init(uint64_t);
+  Bucket* getEmptyBucket();
   void pushBucket(uint64_t);
+  void pushSuperBucket(uint64_t);
   void storeSievingPrime(uint64_t, uint64_t, uint64_t);
+  void storeSuper(uint64_t, uint64_t, uint64_t);
+  void unpackSuper();
+  void crossOffHot(byte_t*);
   void crossOff(byte_t*, SievingPrime*, SievingPrime*);
   static void moveBucket(Bucket&, Bucket*&);
 };
@@ -23,7 +23,7 @@ namespace primesieve {
 /// of Eratosthenes optimized for medium sieving primes that
 /// have a few multiples per segment
 ///
-class EratMedium : public Wheel210_t
+class EratMedium : public Wheel30_t
 {
 public:
   void init(uint64_t, uint64_t, uint64_t);
@@ -28,15 +28,29 @@ class EratSmall : public Wheel30_t
 public:
   static uint64_t getL1Size(uint64_t);
   void init(uint64_t, uint64_t, uint64_t);
-  void crossOff(byte_t*, uint64_t);
+  void crossOff(byte_t*, uint64_t, uint64_t* count = nullptr);
   bool enabled() const { return enabled_; }
 private:
+  /// The multiples of the smallest sieving primes are
+  /// crossed-off using precomputed byte patterns that
+  /// repeat every prime bytes
+  struct PatternPrime
+  {
+    uint64_t prime;
+    uint64_t phase;
+    uint64_t offset;
+  };
   uint64_t maxPrime_;
   uint64_t l1Size_;
   std::vector<SievingPrime> primes_;
+  std::vector<PatternPrime> patternPrimes_;
+  std::vector<byte_t> patterns_;
   bool enabled_ = false;
+  bool hasPatternCandidates_ = false;
   void storeSievingPrime(uint64_t, uint64_t, uint64_t);
   void crossOff(byte_t*, byte_t*);
+  void crossOffPatterns(byte_t*, byte_t*);
+  void migratePatternPrimes();
 };
 
 } // namespace
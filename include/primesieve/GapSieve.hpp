@@ -0,0 +1,61 @@
+///
+/// @file  GapSieve.hpp
+/// @brief The GapSieve class collects prime gap statistics
+///        (maximal gap, gap histogram, gap records) directly
+///        from the sieve array.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef GAPSIEVE_HPP
+#define GAPSIEVE_HPP
+
+#include "Erat.hpp"
+#include "PreSieve.hpp"
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace primesieve {
+
+/// Sieves [start, stop] once and scans the sieve array of
+/// each segment word by word: the gap between two
+/// consecutive primes is read off their bit positions, empty
+/// 64-bit words (covering 240 numbers each) are skipped with
+/// a single compare. The chunk boundary data (first and last
+/// prime) allows stitching the statistics of adjacent chunks
+/// sieved by different threads
+///
+class GapSieve : public Erat
+{
+public:
+  GapSieve(uint64_t start, uint64_t stop);
+  void sieve();
+  /// First prime inside [start, stop], 0 if there is none
+  uint64_t firstPrime() const { return firstPrime_; }
+  /// Last prime inside [start, stop], 0 if there is none
+  uint64_t lastPrime() const { return prevPrime_; }
+  /// histogram[g] = number of gaps of size g
+  const std::vector<uint64_t>& histogram() const { return histogram_; }
+  /// Gap records in range order: (prime starting the gap, gap),
+  /// each gap is larger than every gap before it
+  const std::vector<std::pair<uint64_t, uint64_t>>& records() const { return records_; }
+private:
+  PreSieve preSieve_;
+  uint64_t firstPrime_ = 0;
+  uint64_t prevPrime_ = 0;
+  uint64_t maxGap_ = 0;
+  uint64_t low_ = 0;
+  std::vector<uint64_t> histogram_;
+  std::vector<std::pair<uint64_t, uint64_t>> records_;
+  void scanSegment();
+  void recordPrime(uint64_t prime);
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,52 @@
+///
+/// @file  MappedFile.hpp
+/// @brief RAII wrapper around a read-only memory-mapped file,
+///        shared by the on-disk readers (PrimeFile,
+///        SievingPrimesFile). On platforms without mmap the
+///        file is read into a heap buffer instead. The
+///        destructor releases the mapping and the file
+///        descriptor, also when a reader's constructor throws
+///        during format validation.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace primesieve {
+
+class MappedFile
+{
+public:
+  /// Open and memory-map the file, throws a primesieve_error
+  /// if the file cannot be opened, mapped or is smaller than
+  /// @minBytes. @name describes the file format and is used
+  /// in the exception messages, e.g. "prime store file"
+  MappedFile(const std::string& filePath,
+             std::size_t minBytes,
+             const std::string& name);
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  const unsigned char* base() const { return base_; }
+  std::size_t size() const { return fileSize_; }
+private:
+  const unsigned char* base_ = nullptr;
+  void* map_ = nullptr;
+  std::size_t fileSize_ = 0;
+  int fd_ = -1;
+  /// Used if memory-mapping is not available
+  std::vector<unsigned char> buffer_;
+};
+
+} // namespace
+
+#endif
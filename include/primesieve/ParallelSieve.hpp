@@ -14,41 +14,45 @@
 
 #include "PrimeSieve.hpp"
 #include <stdint.h>
-#include <mutex>
+#include <atomic>
 
 namespace primesieve {
 
 class ParallelSieve : public PrimeSieve
 {
 public:
-  /// Used for inter-process communication with the
-  /// primesieve GUI application.
-  struct SharedMemory
-  {
-    uint64_t start;
-    uint64_t stop;
-    uint64_t counts[6];
-    double status;
-    double seconds;
-    int flags;
-    int sieveSize;
-    int threads;
-  };
   ParallelSieve();
   virtual ~ParallelSieve() { }
-  void init(SharedMemory&);
   static int getMaxThreads();
-  int getNumThreads() const;
+  virtual int getNumThreads() const;
   int idealNumThreads() const;
+  /// Benchmark a few candidate thread counts on small
+  /// subranges of [start_, stop_] and set the fastest one,
+  /// see ParallelSieve.cpp. Returns the chosen thread count.
+  int calibrateNumThreads();
   void setNumThreads(int numThreads);
   using PrimeSieve::sieve;
   virtual void sieve();
+  /// Align n to modulo (30 + 2) to prevent prime k-tuplet
+  /// (twin primes, prime triplets) gaps. Used to align the
+  /// thread chunk borders and the subrange borders of
+  /// partition_range(), see primesieve.hpp.
+  static uint64_t align(uint64_t n, uint64_t stop);
 private:
-  std::mutex lock_;
-  SharedMemory* shm_;
+  /// Status state shared by all worker threads, padded
+  /// to its own cache line so that the updateStatus()
+  /// writes do not invalidate the read-mostly members
+  /// (numThreads_, flags, stop_, ...) around it
+  struct alignas(64) SharedStatus
+  {
+    /// Sum of processed segments of all threads
+    std::atomic<uint64_t> processed;
+    /// Last status percent value printed
+    std::atomic<int> printedPercent;
+  };
+  SharedStatus shared_;
   int numThreads_;
-  uint64_t getThreadDistance(int) const;
-  uint64_t align(uint64_t) const;
+  uint64_t getChunkDistance(uint64_t, int) const;
   virtual bool updateStatus(uint64_t, bool);
 };
 
@@ -0,0 +1,42 @@
+///
+/// @file  PiTable.hpp
+/// @brief The PiTable caches pi(x) at fixed checkpoints so that
+///        repeated prime counting queries only need to sieve the
+///        residual subrange above the largest checkpoint.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef PITABLE_HPP
+#define PITABLE_HPP
+
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+namespace primesieve {
+
+class PiTable
+{
+public:
+  static PiTable& getInstance();
+  /// Distance between two checkpoints
+  static uint64_t distance();
+  /// Count the primes <= stop
+  uint64_t pi(uint64_t stop);
+private:
+  std::mutex lock_;
+  /// pi_[i] = number of primes <= (i + 1) * distance()
+  std::vector<uint64_t> pi_;
+  bool loaded_ = false;
+  void load();
+  void save() const;
+  void extend(uint64_t checkpoints);
+};
+
+} // namespace
+
+#endif
@@ -13,18 +13,19 @@
 #include "types.hpp"
 
 #include <stdint.h>
-#include <memory>
 
 namespace primesieve {
 
 /// PreSieve objects are used to pre-sieve multiples of small primes
 /// e.g. <= 19 to speed up the sieve of Eratosthenes. The idea is to
-/// allocate an array (buffer_) and remove the multiples of small
-/// primes from it at initialization. Then whilst sieving, the
-/// buffer_ array is copied to the sieve array at the beginning of
-/// each new segment to pre-sieve the multiples of small
-/// primes <= maxPrime_. Pre-sieving speeds up my sieve of Eratosthenes
-/// implementation by about 20 percent when sieving < 10^10.
+/// remove the multiples of small primes from an array (buffer_) at
+/// initialization. Then whilst sieving, the buffer_ array is copied
+/// to the sieve array at the beginning of each new segment to
+/// pre-sieve the multiples of small primes <= maxPrime_. The
+/// buffers are built once per process and shared read-only by all
+/// PreSieve objects, see PreSieve.cpp. Pre-sieving speeds up my
+/// sieve of Eratosthenes implementation by about 20 percent when
+/// sieving < 10^10.
 ///
 /// <b> Memory Usage </b>
 ///
@@ -46,9 +47,11 @@ private:
   uint64_t maxPrime_;
   uint64_t primeProduct_;
   uint64_t size_;
-  byte_t* buffer_;
-  std::unique_ptr<byte_t[]> deleter_;
-  void init();
+  /// Shared read-only buffers from the process-wide
+  /// cache, see PreSieve.cpp
+  const byte_t* buffer_;
+  const byte_t* extendedBuffer_ = nullptr;
+  void applyExtended(byte_t*, uint64_t, uint64_t) const;
 };
 
 } // namespace
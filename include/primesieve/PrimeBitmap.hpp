@@ -0,0 +1,95 @@
+///
+/// @file  PrimeBitmap.hpp
+/// @brief The PrimeBitmap class stores a prime indicator bitmap
+///        in compressed hybrid containers, built directly from
+///        the sieve array without decoding the primes. The
+///        bitmaps can be saved to disk and intersected, which
+///        is both smaller and faster than storing the primes
+///        as uint64_t lists.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef PRIMEBITMAP_HPP
+#define PRIMEBITMAP_HPP
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace primesieve {
+
+/// The numbers are split into fixed windows of 122880
+/// numbers (4096 sieve bytes, 8 bits per 30 numbers):
+/// windows without primes are not stored at all, sparse
+/// windows store their 16-bit bit positions (array
+/// container) and dense windows store the raw sieve bytes
+/// (bitmap container). Intersections combine the bitmaps
+/// container by container.
+///
+class PrimeBitmap
+{
+public:
+  /// Sieve the primes inside [start, stop]
+  /// into a compressed bitmap
+  static PrimeBitmap sieve(uint64_t start, uint64_t stop);
+  /// Load a bitmap written by save(), throws a
+  /// primesieve_error if the file cannot be opened
+  /// or has an invalid format
+  static PrimeBitmap load(const std::string& filePath);
+  void save(const std::string& filePath) const;
+  /// Lower bound of the bitmap's interval
+  uint64_t start() const { return start_; }
+  /// Upper bound of the bitmap's interval
+  uint64_t stop() const { return stop_; }
+  /// Number of primes in the bitmap
+  uint64_t count() const;
+  bool contains(uint64_t n) const;
+  /// Keep only the primes that are also contained in
+  /// other, the interval shrinks to the overlap of
+  /// both intervals
+  void intersect(const PrimeBitmap& other);
+  /// Append the primes in the bitmap to the primes vector
+  void decode(std::vector<uint64_t>& primes) const;
+  /// Compressed size in bytes
+  uint64_t byteSize() const;
+private:
+  enum ContainerType : uint8_t
+  {
+    ARRAY = 0,
+    BITMAP = 1
+  };
+
+  struct Container
+  {
+    /// First number of the window,
+    /// multiple of 122880
+    uint64_t low = 0;
+    /// Number of primes in the window
+    uint32_t count = 0;
+    uint8_t type = ARRAY;
+    /// ARRAY: sorted bit positions of the primes
+    std::vector<uint16_t> bits;
+    /// BITMAP: the window's raw sieve bytes
+    std::vector<uint8_t> bytes;
+  };
+
+  uint64_t start_ = 0;
+  uint64_t stop_ = 0;
+  /// The primes 2, 3 and 5 are not representable in
+  /// the sieve byte layout, bits 0..2 flag them
+  uint8_t smallMask_ = 0;
+  /// Sorted by low, windows without primes are omitted
+  std::vector<Container> containers_;
+
+  static Container makeContainer(uint64_t low, const uint8_t* window);
+  const Container* findContainer(uint64_t low) const;
+};
+
+} // namespace
+
+#endif
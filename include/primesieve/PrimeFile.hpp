@@ -0,0 +1,70 @@
+///
+/// @file  PrimeFile.hpp
+/// @brief The PrimeFile class reads primes from a compact on-disk
+///        prime store file generated by store_primes_file(). The
+///        file contains delta-encoded blocks of primes plus a
+///        sparse index and is memory-mapped, so random access
+///        over cached ranges is instant and the pages are shared
+///        across processes on the same machine.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef PRIMEFILE_HPP
+#define PRIMEFILE_HPP
+
+#include "MappedFile.hpp"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace primesieve {
+
+class PrimeFile
+{
+public:
+  /// Open and memory-map a prime store file,
+  /// throws a primesieve_error if the file cannot
+  /// be opened or has an invalid format
+  PrimeFile(const std::string& filePath);
+  PrimeFile(const PrimeFile&) = delete;
+  PrimeFile& operator=(const PrimeFile&) = delete;
+  /// Lower bound of the stored interval
+  uint64_t start() const { return start_; }
+  /// Upper bound of the stored interval
+  uint64_t stop() const { return stop_; }
+  /// Number of primes in the file
+  uint64_t count() const { return count_; }
+  /// Position the iterator at the first prime >= start
+  void jumpTo(uint64_t start);
+  /// Get the next prime, returns 0 once all
+  /// primes in the file have been iterated
+  uint64_t nextPrime();
+  /// Append the primes inside [start, stop] to the primes vector
+  void read(uint64_t start, uint64_t stop, std::vector<uint64_t>& primes);
+private:
+  MappedFile file_;
+  uint64_t start_ = 0;
+  uint64_t stop_ = 0;
+  uint64_t count_ = 0;
+  uint64_t numBlocks_ = 0;
+  /// First prime of each block
+  const unsigned char* index_ = nullptr;
+  /// Delta-encoded prime blocks
+  const unsigned char* blocks_ = nullptr;
+  /// Iterator state
+  uint64_t block_ = 0;
+  uint64_t indexInBlock_ = 0;
+  uint64_t prime_ = 0;
+  uint64_t blockSize(uint64_t block) const;
+  uint64_t blockAnchor(uint64_t block) const;
+  uint64_t findBlock(uint64_t start) const;
+};
+
+} // namespace
+
+#endif
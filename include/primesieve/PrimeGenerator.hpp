@@ -18,19 +18,96 @@
 #include "Erat.hpp"
 #include "PreSieve.hpp"
 #include "littleendian_cast.hpp"
+#include "pmath.hpp"
 #include "SievingPrimes.hpp"
 
 #include <stdint.h>
-#include <array>
+#include <cstddef>
 #include <vector>
 
 namespace primesieve {
 
+/// Table of all primes below 2^16, generated at compile time
+/// like the wheel tables (Wheel.hpp) so that it ends up in
+/// the read-only data segment. Iterators over ranges below
+/// 2^16 are served entirely from this table and never
+/// construct any sieve state
+///
+struct SmallPrimes
+{
+  // PrimePi(2^16) = 6542
+  uint16_t primes[6542];
+
+  static constexpr std::size_t size() { return 6542; }
+  const uint16_t* begin() const { return primes; }
+  const uint16_t* end() const { return primes + size(); }
+  uint16_t back() const { return primes[size() - 1]; }
+  uint16_t operator[](std::size_t i) const { return primes[i]; }
+};
+
+constexpr SmallPrimes generateSmallPrimes()
+{
+  SmallPrimes table {};
+  bool composite[65536] = { false };
+
+  for (int i = 3; i * i < 65536; i += 2)
+    if (!composite[i])
+      for (int j = i * i; j < 65536; j += i * 2)
+        composite[j] = true;
+
+  std::size_t size = 0;
+  table.primes[size++] = 2;
+  for (int i = 3; i < 65536; i += 2)
+    if (!composite[i])
+      table.primes[size++] = (uint16_t) i;
+
+  return table;
+}
+
+extern const SmallPrimes smallPrimes;
+
 class PrimeGenerator : public Erat
 {
 public:
   PrimeGenerator(uint64_t start, uint64_t stop);
-  void fill(std::vector<uint64_t>&);
+
+  /// Fill the vector with the primes inside [start, stop].
+  /// T may be uint32_t (requires stop < 2^32) which halves
+  /// the memory traffic of the output vector.
+  ///
+  template <typename T>
+  void fill(std::vector<T>&);
+
+  /// Fill the caller provided buffer with the next primes
+  /// inside [start, stop], stops when fewer than 64 free
+  /// slots remain (one sieve word decodes up to 64 primes).
+  /// @capacity: must be >= 64.
+  ///
+  void fillBuffer(uint64_t* buffer,
+                  std::size_t capacity,
+                  std::size_t* size);
+
+  /// Sum the primes inside [start, stop] modulo 2^64.
+  /// The sieve array bytes are summed via lookup tables
+  /// without decoding the individual primes, see
+  /// PrimeGenerator.cpp.
+  ///
+  uint64_t sum();
+
+  /// Use a read-only table of precomputed sieving primes
+  /// (all primes inside [7, sqrt(stop)]) instead of
+  /// regenerating them, see iterator.cpp
+  ///
+  void setSievingPrimes(const std::vector<uint64_t>* sharedPrimes);
+
+  /// Find the kth prime inside [start, stop], counts 64
+  /// primes at a time using popcount and only decodes bits
+  /// inside the sieve word containing the kth prime.
+  /// @return the kth prime, or 0 if the interval contains
+  ///         fewer than *k primes (*k is decremented by
+  ///         the number of primes skipped).
+  ///
+  uint64_t nthPrime(uint64_t* k);
 
   bool finished() const
   {
@@ -42,21 +119,24 @@ public:
     return smallPrimes.back();
   }
 
-  void fill(std::vector<uint64_t>& primes,
+  template <typename T>
+  void fill(std::vector<T>& primes,
             std::size_t* size)
   {
     if (sieveIdx_ >= sieveSize_)
       if (!sieveSegment(primes, size))
         return;
 
-    std::size_t i = 0;
     uint64_t bits = littleendian_cast<uint64_t>(&sieve_[sieveIdx_]);
     sieveIdx_ += 8;
 
-    for (; bits != 0; i++)
-      primes[i] = nextPrime(&bits, low_);
+    // decode all of the word's primes using the bit
+    // count instead of testing (bits != 0) per prime
+    std::size_t count = popcnt64(bits);
+    for (std::size_t i = 0; i < count; i++)
+      primes[i] = (T) nextPrime(&bits, low_);
 
-    *size = i;
+    *size = count;
     low_ += 8 * 30;
   }
 private:
@@ -65,17 +145,27 @@ private:
   uint64_t prime_ = 0;
   PreSieve preSieve_;
   SievingPrimes sievingPrimes_;
+  const std::vector<uint64_t>* sharedPrimes_ = nullptr;
+  std::size_t sharedIdx_ = 0;
   bool isInit_ = false;
   bool finished_ = false;
-  static const std::array<uint64_t, 64> smallPrimes;
-  static const std::array<uint8_t, 312> primePi;
+  /// Primes inside [start, stop] that are served from the
+  /// small primes table, smallPrimes[smallIdx_] is the next
+  /// one. Serving may span multiple calls if the table part
+  /// of the range exceeds the output buffer
+  std::size_t smallIdx_ = 0;
+  std::size_t smallStopIdx_ = 0;
   std::size_t getStartIdx() const;
   std::size_t getStopIdx() const;
   void init();
-  void init(std::vector<uint64_t>&);
-  void init(std::vector<uint64_t>&, std::size_t*);
-  bool sieveSegment(std::vector<uint64_t>&);
-  bool sieveSegment(std::vector<uint64_t>&, std::size_t*);
+  template <typename T>
+  void init(std::vector<T>&);
+  template <typename T>
+  void init(std::vector<T>&, std::size_t*);
+  template <typename T>
+  bool sieveSegment(std::vector<T>&);
+  template <typename T>
+  bool sieveSegment(std::vector<T>&, std::size_t*);
   void sieveSegment();
 };
 
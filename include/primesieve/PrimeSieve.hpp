@@ -13,11 +13,21 @@
 #ifndef PRIMESIEVE_CLASS_HPP
 #define PRIMESIEVE_CLASS_HPP
 
+#include "SieveStats.hpp"
+
 #include <stdint.h>
 #include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
 
 namespace primesieve {
 
+class SievingPrimesFile;
+class WindowSieve;
+struct PrimeReciprocal;
+
 using counts_t = std::array<uint64_t, 6>;
 
 enum
@@ -50,6 +60,7 @@ public:
   int getSieveSize() const;
   double getStatus() const;
   double getSeconds() const;
+  const SieveStats& getStats() const;
   // Setters
   void setStart(uint64_t);
   void setStop(uint64_t);
@@ -71,6 +82,36 @@ public:
   virtual void sieve();
   void sieve(uint64_t, uint64_t);
   void sieve(uint64_t, uint64_t, int);
+  /// Count the primes inside (previous stop, stop] where the
+  /// previous stop is getStart() - 1 for the first call. The
+  /// sieve state (PreSieve tables, sieving primes, bucket
+  /// lists) is carried forward between calls, so counting
+  /// consecutive windows with monotonically growing stop is
+  /// incremental instead of from scratch (see WindowSieve.hpp).
+  /// The window state resets when setStart() is called.
+  uint64_t advance(uint64_t stop);
+  /// Share a read-only table of precomputed sieving primes
+  /// (all primes inside [7, sqrt(stop)]) across threads.
+  /// The table may live in a vector (ParallelSieve) or in a
+  /// memory-mapped snapshot file (SievingPrimesFile.hpp)
+  void setSievingPrimes(const uint64_t* primes, uint64_t size);
+  const uint64_t* getSievingPrimes() const;
+  uint64_t getNumSievingPrimes() const;
+  /// Share the precomputed reciprocals of the sieving
+  /// primes (same indexes as the sieving primes table),
+  /// see PrimeReciprocal in Wheel.hpp
+  void setSievingPrimeRecips(const PrimeReciprocal*);
+  const PrimeReciprocal* getSievingPrimeRecips() const;
+  using progress_callback_t = std::function<void(double percent)>;
+  /// Register a callback that is invoked with the sieving
+  /// status in percent while sieve() is running. The per
+  /// chunk status updates of the sieving threads are
+  /// coalesced: the callback runs at most once every
+  /// intervalMillis milliseconds (and once with 100 when
+  /// sieving finishes), so that e.g. feeding a dashboard
+  /// does not slow down sieving.
+  void setProgressCallback(const progress_callback_t&,
+                           uint64_t intervalMillis = 100);
   // nth prime
   uint64_t nthPrime(uint64_t);
   uint64_t nthPrime(int64_t, uint64_t);
@@ -78,7 +119,41 @@ public:
   counts_t& getCounts();
   uint64_t getCount(int) const;
   uint64_t countPrimes(uint64_t, uint64_t);
+  virtual int getNumThreads() const;
   virtual bool updateStatus(uint64_t, bool tryLock = true);
+  /// Cooperatively cancel a running sieve() call from
+  /// another thread: the sieving loops stop at the next
+  /// segment boundary (and the ParallelSieve workers stop
+  /// grabbing new work chunks). The results are partial
+  /// afterwards, see getStoppedAt(). Cancellation is sticky
+  /// (a cancel issued before sieve() starts is not lost),
+  /// create a new object to sieve again.
+  void cancelSieve();
+  /// true if cancelSieve() has been called or the time
+  /// budget has expired, checked once per segment by the
+  /// sieving loops
+  bool isCanceled() const;
+  /// Optional time budget per sieve() call in milliseconds
+  /// (0 = unlimited, the default). When the budget expires
+  /// sieving stops at the next segment boundary and the
+  /// partial results cover [getStart(), getStoppedAt()],
+  /// so interactive callers get partial counts by their
+  /// deadline instead of burning CPU past it.
+  void setTimeBudget(uint64_t millis);
+  /// Largest number up to which the results of the
+  /// preceding sieve() call are complete, == getStop()
+  /// unless sieving was cancelled. For a cancelled
+  /// multi-threaded sieve() the counts additionally
+  /// include any chunks completed beyond getStoppedAt().
+  uint64_t getStoppedAt() const;
+  /// Model of the sieving cost of [start, pos] (in arbitrary
+  /// units), used by updateStatus() to convert the processed
+  /// distance into a time proportional percent: for large
+  /// stop the cost per segment grows with pi(sqrt(x)) due to
+  /// EratBig, so linear percent runs ahead of the wall time.
+  /// See PrimeSieve.cpp.
+  static double sieveCost(uint64_t start, uint64_t stop,
+                          uint64_t pos, int sieveSizeKB);
 protected:
   /// Sieve primes >= start_
   uint64_t start_;
@@ -88,22 +163,58 @@ protected:
   counts_t counts_;
   /// Time elapsed of sieve()
   double seconds_;
+  /// Per-phase wall time of sieve(),
+  /// summed over all threads
+  SieveStats stats_;
   uint64_t getDistance() const;
   void reset();
+  /// Status of sieve() in percent, written by the sieving
+  /// threads and polled cross-thread via getStatus()
+  std::atomic<double> percent_;
+  static void printStatus(double, double);
+  /// Invoked with the status in percent,
+  /// see setProgressCallback()
+  progress_callback_t progressCallback_;
+  void invokeProgressCallback(double percent);
+  /// Where a cancelled sieve() call stopped,
+  /// see getStoppedAt()
+  uint64_t stoppedAt_ = 0;
 private:
+  /// Set by cancelSieve(), sticky
+  std::atomic<bool> cancel_{false};
+  /// Time budget per sieve() call in
+  /// milliseconds, 0 = unlimited
+  uint64_t budgetMillis_ = 0;
+  /// Steady clock deadline (in milliseconds) armed at
+  /// the start of sieve(), 0 = no deadline
+  uint64_t deadlineMillis_ = 0;
   /// Sum of all processed segments
   uint64_t processed_;
   /// Sum of processed segments to update
   uint64_t toUpdate_;
-  /// Status of sieve() in percent
-  double percent_;
   /// Sieve size in kilobytes
   int sieveSize_;
   /// Setter methods set flags e.g. COUNT_PRIMES
   int flags_;
   /// parent ParallelSieve object
   PrimeSieve* parent_;
-  static void printStatus(double, double);
+  /// Shared precomputed sieving primes (may be nullptr)
+  const uint64_t* sievingPrimes_ = nullptr;
+  uint64_t numSievingPrimes_ = 0;
+  /// Shared precomputed sieving prime reciprocals
+  /// (may be nullptr)
+  const PrimeReciprocal* sievingPrimeRecips_ = nullptr;
+  /// Keeps the memory-mapping of a sieving prime snapshot
+  /// alive while sieve() uses its tables, see
+  /// set_sieving_primes_file()
+  std::shared_ptr<const SievingPrimesFile> sievingPrimesFile_;
+  /// Stateful window sieve of advance(), created lazily
+  std::unique_ptr<WindowSieve> windowSieve_;
+  /// Rate limit of the progress callback in milliseconds
+  uint64_t callbackMillis_ = 100;
+  /// Next steady clock time (in milliseconds) the
+  /// progress callback may run
+  std::atomic<uint64_t> nextCallback_;
   bool isParallelSieve() const;
   void processSmallPrimes();
 };
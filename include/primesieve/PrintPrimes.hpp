@@ -16,6 +16,10 @@
 #include "types.hpp"
 
 #include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 namespace primesieve {
@@ -30,23 +34,45 @@ class PrintPrimes : public Erat
 {
 public:
   PrintPrimes(PrimeSieve&);
+  ~PrintPrimes();
   void sieve();
 private:
-  enum { END = 0xff + 1 };
-  static const uint64_t bitmasks_[6][5];
   uint64_t low_ = 0;
   /// Count lookup tables for prime k-tuplets
   std::vector<byte_t> kCounts_[6];
+  /// Reusable output buffer for the writer thread
+  std::vector<char> printBuffer_;
+  /// Reusable output buffer for the k-tuplet formatter.
+  /// It runs on the sieving thread, so it must not share
+  /// printBuffer_ which the writer thread may be using
+  std::vector<char> kTupletBuffer_;
+  /// Sieved segment handed to the writer thread
+  struct SegmentBuffer
+  {
+    std::vector<byte_t> sieve;
+    uint64_t low;
+  };
+  /// Writer thread that formats and prints the sieved
+  /// segments while the main thread keeps sieving
+  std::thread writer_;
+  std::mutex lock_;
+  std::condition_variable pending_;
+  std::condition_variable drained_;
+  std::deque<SegmentBuffer> queue_;
+  std::vector<std::vector<byte_t>> freeBuffers_;
+  bool stop_ = false;
   /// Reference to the associated PrimeSieve object
   PreSieve preSieve_;
   counts_t& counts_;
   PrimeSieve& ps_;
   void initCounts();
   void print();
-  void countPrimes();
   void countkTuplets();
-  void printPrimes() const;
-  void printkTuplets() const;
+  void printPrimes();
+  void printkTuplets();
+  void writerThread();
+  void writeSegment(const SegmentBuffer& segment);
+  void joinWriter();
 };
 
 } // namespace
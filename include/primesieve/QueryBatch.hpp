@@ -0,0 +1,66 @@
+///
+/// @file  QueryBatch.hpp
+/// @brief Answer a batch of prime queries (counts, nth prime,
+///        prime generation) with one sieve pass per disjoint
+///        region instead of one sieve per query.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef QUERYBATCH_HPP
+#define QUERYBATCH_HPP
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+namespace primesieve {
+
+/// Queue heterogeneous queries over (possibly overlapping)
+/// ranges with the add*() methods, execute them all with
+/// run(), then read the answers using the returned query
+/// ids. run() merges the required ranges and sieves each
+/// disjoint region only once, all queries overlapping a
+/// region are answered from the same pass.
+///
+class QueryBatch
+{
+public:
+  /// Count the primes inside [start, stop]
+  std::size_t addCount(uint64_t start, uint64_t stop);
+  /// Find the nth prime > start, @pre n >= 1
+  std::size_t addNthPrime(uint64_t n, uint64_t start = 0);
+  /// Generate the primes inside [start, stop]
+  std::size_t addPrimes(uint64_t start, uint64_t stop);
+  /// Execute all queued queries,
+  /// may only be called once
+  void run();
+  uint64_t count(std::size_t id) const;
+  uint64_t nthPrime(std::size_t id) const;
+  const std::vector<uint64_t>& primes(std::size_t id) const;
+private:
+  enum QueryType { COUNT, NTH_PRIME, PRIMES };
+  struct Query
+  {
+    QueryType type;
+    uint64_t start;
+    uint64_t stop;
+    /// NTH_PRIME: primes still missing
+    uint64_t remaining = 0;
+    uint64_t result = 0;
+    std::vector<uint64_t> primes;
+    bool done = false;
+  };
+  std::vector<Query> queries_;
+  bool hasRun_ = false;
+  void processSmallPrimes(Query& query);
+  void sieveRegion(uint64_t low, uint64_t high);
+  const Query& getQuery(std::size_t id, QueryType type) const;
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,40 @@
+///
+/// @file  SieveStats.hpp
+/// @brief Per-phase sieving time statistics.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef SIEVESTATS_HPP
+#define SIEVESTATS_HPP
+
+namespace primesieve {
+
+/// Wall time spent in each sieving phase, used for
+/// performance analysis via primesieve --time-breakdown.
+/// When counting primes the fused counting pass is included
+/// in the EratSmall phase (see Erat::crossOff)
+///
+struct SieveStats
+{
+  double preSieveSeconds = 0;
+  double eratSmallSeconds = 0;
+  double eratMediumSeconds = 0;
+  double eratBigSeconds = 0;
+
+  SieveStats& operator+=(const SieveStats& other)
+  {
+    preSieveSeconds += other.preSieveSeconds;
+    eratSmallSeconds += other.eratSmallSeconds;
+    eratMediumSeconds += other.eratMediumSeconds;
+    eratBigSeconds += other.eratBigSeconds;
+    return *this;
+  }
+};
+
+} // namespace
+
+#endif
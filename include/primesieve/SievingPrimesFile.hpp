@@ -0,0 +1,63 @@
+///
+/// @file  SievingPrimesFile.hpp
+/// @brief The SievingPrimesFile class reads a sieving prime
+///        snapshot file written by store_sieving_primes_file():
+///        all primes inside [7, sqrt(stop)] together with their
+///        precomputed first multiple reciprocals. The file is
+///        memory-mapped and its tables are used in place, so
+///        jobs with a fixed upper bound skip the deterministic
+///        sieving prime recomputation at every process start
+///        and the pages are shared across processes on the
+///        same machine.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef SIEVINGPRIMESFILE_HPP
+#define SIEVINGPRIMESFILE_HPP
+
+#include "MappedFile.hpp"
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+namespace primesieve {
+
+struct PrimeReciprocal;
+
+class SievingPrimesFile
+{
+public:
+  /// Open and memory-map a sieving prime snapshot file,
+  /// throws a primesieve_error if the file cannot
+  /// be opened or has an invalid format
+  SievingPrimesFile(const std::string& filePath);
+  SievingPrimesFile(const SievingPrimesFile&) = delete;
+  SievingPrimesFile& operator=(const SievingPrimesFile&) = delete;
+  /// The file contains all primes inside [7, maxPrime()]
+  uint64_t maxPrime() const { return maxPrime_; }
+  /// Number of primes in the file
+  uint64_t size() const { return count_; }
+  /// The sieving primes, sorted ascending
+  const uint64_t* primes() const { return primes_; }
+  /// Reciprocal of each sieving prime (same indexes as
+  /// the primes table), see PrimeReciprocal in Wheel.hpp
+  const PrimeReciprocal* recips() const { return recips_; }
+  /// The snapshot installed via set_sieving_primes_file()
+  /// if it contains all primes <= maxPrime, else nullptr
+  static std::shared_ptr<const SievingPrimesFile> getShared(uint64_t maxPrime);
+private:
+  MappedFile file_;
+  uint64_t maxPrime_ = 0;
+  uint64_t count_ = 0;
+  const uint64_t* primes_ = nullptr;
+  const PrimeReciprocal* recips_ = nullptr;
+};
+
+} // namespace
+
+#endif
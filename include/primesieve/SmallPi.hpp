@@ -0,0 +1,44 @@
+///
+/// @file  SmallPi.hpp
+/// @brief The SmallPi class answers small prime counting
+///        queries from a packed bitmap with rank counts
+///        instead of sieving.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef SMALLPI_HPP
+#define SMALLPI_HPP
+
+#include "types.hpp"
+
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+namespace primesieve {
+
+class SmallPi
+{
+public:
+  static SmallPi& getInstance();
+  /// Largest stop answerable by pi()
+  static uint64_t limit();
+  /// Count the primes <= stop, @pre stop <= limit()
+  uint64_t pi(uint64_t stop);
+private:
+  /// Sieve array of [0, limit()], 8 bits per 30 numbers
+  std::vector<byte_t> sieve_;
+  /// rank_[i] = number of 1 bits in the
+  /// sieve words before the i-th word
+  std::vector<uint32_t> rank_;
+  std::once_flag init_;
+  void init();
+};
+
+} // namespace
+
+#endif
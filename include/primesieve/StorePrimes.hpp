@@ -12,6 +12,7 @@
 #define STOREPRIMES_HPP
 
 #include "iterator.hpp"
+#include "pmath.hpp"
 #include "primesieve_error.hpp"
 
 #include <stdint.h>
@@ -22,21 +23,12 @@
 
 namespace primesieve {
 
-/// primeCountApprox(x) >= pi(x)
+/// prime_count_approx(x) >= pi(x) (in practice), uses the
+/// Riemann R based approximation from pmath.hpp
+///
 inline std::size_t prime_count_approx(uint64_t start, uint64_t stop)
 {
-  if (start > stop)
-    return 0;
-  if (stop <= 10)
-    return 4;
-
-  // pi(x) <= x / (log(x) - 1.1) + 5, for x >= 4
-  double x = (double) stop;
-  double logx = std::log(x);
-  double div = logx - 1.1;
-  double pix = (stop - start) / div + 5;
-
-  return (std::size_t) pix;
+  return primeCountApprox(start, stop);
 }
 
 template <typename T>
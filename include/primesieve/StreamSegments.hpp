@@ -0,0 +1,42 @@
+///
+/// @file  StreamSegments.hpp
+/// @brief The StreamSegments class sieves [start, stop] and hands
+///        each sieved segment's raw bitmap to a user callback.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef STREAMSEGMENTS_HPP
+#define STREAMSEGMENTS_HPP
+
+#include "Erat.hpp"
+#include "PreSieve.hpp"
+
+#include <stdint.h>
+#include <cstddef>
+#include <functional>
+
+namespace primesieve {
+
+/// Sieves [start, stop] and invokes the callback once per
+/// segment with a zero-copy view of the internal sieve
+/// array, see sieve_segments() in primesieve.hpp for the
+/// sieve array's bit layout
+///
+class StreamSegments : public Erat
+{
+public:
+  using callback_t = std::function<void(uint64_t, const uint8_t*, std::size_t)>;
+  StreamSegments(uint64_t start, uint64_t stop, const callback_t& callback);
+  void sieve();
+private:
+  PreSieve preSieve_;
+  const callback_t& callback_;
+};
+
+} // namespace
+
+#endif
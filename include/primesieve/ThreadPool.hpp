@@ -0,0 +1,75 @@
+///
+/// @file  ThreadPool.hpp
+/// @brief Persistent library-wide pool of worker threads.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace primesieve {
+
+/// ParallelSieve submits its chunk tasks to this pool
+/// instead of spawning threads with std::async on every
+/// sieve() call. Reusing the worker threads cuts the
+/// per-call latency of small sieving ranges by the thread
+/// spawn/join overhead. The pool is created lazily on
+/// first use and grows up to the number of CPU cores,
+/// idle workers sleep on a condition variable.
+///
+class ThreadPool
+{
+public:
+  static ThreadPool& getInstance();
+  /// Execute task(0), ..., task(threads - 1) on the
+  /// worker threads, blocks until all have finished
+  ///
+  void execute(int threads, const std::function<void(int)>& task);
+  /// Returns true on threads owned by the pool. Code that
+  /// may run inside a task uses this to avoid nested
+  /// execute() calls which could deadlock the pool
+  ///
+  static bool isWorkerThread();
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+private:
+  /// One call to execute(), lives on the
+  /// calling thread's stack while it waits
+  ///
+  struct Job
+  {
+    const std::function<void(int)>* task;
+    int next = 0;
+    int total = 0;
+    int finished = 0;
+    std::exception_ptr exception;
+  };
+
+  ThreadPool() = default;
+  void startThreads(int threads);
+  void workerThread();
+
+  std::vector<std::thread> threads_;
+  std::vector<Job*> jobs_;
+  std::mutex lock_;
+  std::condition_variable pending_;
+  std::condition_variable finished_;
+  bool stop_ = false;
+};
+
+} // namespace
+
+#endif
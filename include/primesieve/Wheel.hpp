@@ -12,13 +12,14 @@
 #ifndef WHEEL_HPP
 #define WHEEL_HPP
 
+#include "bits.hpp"
 #include "config.hpp"
+#include "pmath.hpp"
 #include "primesieve_error.hpp"
 #include "Bucket.hpp"
 #include "types.hpp"
 
 #include <stdint.h>
-#include <algorithm>
 #include <cassert>
 #include <string>
 
@@ -33,9 +34,6 @@ struct WheelInit
   uint8_t wheelIndex;
 };
 
-extern const WheelInit wheel30Init[30];
-extern const WheelInit wheel210Init[210];
-
 /// The WheelElement data structure is used to skip multiples
 /// of small primes using wheel factorization
 ///
@@ -55,14 +53,128 @@ struct WheelElement
   int8_t next;
 };
 
-extern const WheelElement wheel30[8*8];
-extern const WheelElement wheel210[48*8];
+/// Wheel tables of a wheel with modulo MODULO that has
+/// SIZE numbers coprime to MODULO per wheel rotation,
+/// e.g. MODULO = 210, SIZE = 48
+///
+template <int MODULO, int SIZE>
+struct WheelTables
+{
+  WheelInit init[MODULO];
+  WheelElement elem[SIZE * 8];
+};
+
+constexpr int wheelGcd(int a, int b)
+{
+  return (b == 0) ? a : wheelGcd(b, a % b);
+}
+
+/// Generate the wheel tables at compile time so that they
+/// end up in the read-only data segment. The 8 rows of the
+/// elem table correspond to the 8 bits of the sieve array
+/// i.e. to sieving primes congruent to 7, 11, 13, 17, 19,
+/// 23, 29, 31 (mod 30), the SIZE columns correspond to the
+/// multiple factors coprime to MODULO
+///
+template <int MODULO, int SIZE>
+constexpr WheelTables<MODULO, SIZE> generateWheel()
+{
+  WheelTables<MODULO, SIZE> wheel {};
+  const int bitResidues[8] = { 7, 11, 13, 17, 19, 23, 29, 31 };
+
+  // numbers coprime to MODULO per wheel rotation
+  int residues[SIZE] = {};
+  int size = 0;
+  for (int i = 1; i < MODULO; i++)
+    if (wheelGcd(i, MODULO) == 1)
+      residues[size++] = i;
+
+  // used to calculate the first multiple >= start
+  // of each sieving prime
+  for (int i = 0; i < MODULO; i++)
+  {
+    int factor = 0;
+    while (wheelGcd(i + factor, MODULO) != 1)
+      factor++;
+    int index = 0;
+    while (residues[index] != i + factor)
+      index++;
+    wheel.init[i].nextMultipleFactor = (uint8_t) factor;
+    wheel.init[i].wheelIndex = (uint8_t) index;
+  }
+
+  // used to skip multiples of the wheel factors,
+  // one row per sieving prime residue class
+  for (int bit = 0; bit < 8; bit++)
+  {
+    int prime = bitResidues[bit] % 30;
+    for (int i = 0; i < SIZE; i++)
+    {
+      int factor = residues[i];
+      int nextFactor = (i + 1 < SIZE) ? residues[i + 1] : residues[0] + MODULO;
+      int multipleBit = 0;
+      while (bitResidues[multipleBit] % 30 != (prime * factor) % 30)
+        multipleBit++;
+      // multiples with residue 1 belong to bit 7 (= 30 * i + 31)
+      // of the previous sieve array byte
+      int byteOffset = (prime * factor) / 30 - ((prime * factor) % 30 == 1);
+      int nextByteOffset = (prime * nextFactor) / 30 - ((prime * nextFactor) % 30 == 1);
+      WheelElement& e = wheel.elem[bit * SIZE + i];
+      e.unsetBit = (uint8_t) ~(1u << multipleBit);
+      e.nextMultipleFactor = (uint8_t) (nextFactor - factor);
+      e.correct = (uint8_t) (nextByteOffset - byteOffset);
+      e.next = (int8_t) ((i + 1 < SIZE) ? 1 : 1 - SIZE);
+    }
+  }
+
+  return wheel;
+}
+
+extern const WheelTables<30, 8> wheel30Tables;
+extern const WheelTables<210, 48> wheel210Tables;
+
+/// Precomputed reciprocal of a sieving prime, used to
+/// compute the first multiple quotient of addSievingPrime()
+/// using a multiply and shifts instead of a division.
+/// ParallelSieve computes one record per sieving prime and
+/// shares the read-only table across its worker threads:
+/// every worker re-inserts the same primes once per chunk
+/// and the quotient computations dominate that spin-up
+/// phase at big sqrt(stop), see ParallelSieve.cpp.
+///
+struct PrimeReciprocal
+{
+  uint64_t magic;
+  uint64_t shift;
+
+  void init(uint64_t prime)
+  {
+    // magic = ceil(2^(64 + shift) / prime) < 2^64 since a
+    // prime > 2 is never a power of 2
+    using uint128_t = unsigned __int128;
+    shift = ilog2(prime);
+    uint128_t pow = (uint128_t) 1 << (64 + shift);
+    magic = (uint64_t) (pow / prime) + 1;
+  }
+
+  /// Exact floor(x / prime) for x < 2^63: the estimate
+  /// x * magic / 2^(64 + shift) overshoots x / prime by
+  /// less than 2^-(shift + 1) <= 1 / prime, so it never
+  /// reaches the next integer
+  ///
+  uint64_t divide(uint64_t x) const
+  {
+    using uint128_t = unsigned __int128;
+    uint64_t mulhi = (uint64_t) (((uint128_t) x * magic) >> 64);
+    return mulhi >> shift;
+  }
+};
 
 /// The abstract Wheel class is used skip multiples of small
 /// primes in the sieve of Eratosthenes. The EratSmall,
 /// EratMedium and EratBig classes are derived from Wheel.
 ///
-template <int MODULO, int SIZE, const WheelElement* WHEEL, const WheelInit* INIT>
+template <int MODULO, int SIZE, const WheelTables<MODULO, SIZE>* TABLES>
 class Wheel
 {
 public:
@@ -75,23 +187,48 @@ public:
   {
     assert(segmentLow % 30 == 0);
     segmentLow += 6;
-    // calculate the first multiple (of prime) > segmentLow
-    uint64_t quotient = (segmentLow / prime) + 1;
-    quotient = std::max(prime, quotient);
-    uint64_t multiple = prime * quotient;
-    // prime not needed for sieving
-    if (multiple > stop_ ||
-        multiple < segmentLow)
-      return;
-    // calculate the next multiple of prime that is not
-    // divisible by any of the wheel's factors
-    uint64_t nextMultipleFactor = INIT[quotient % MODULO].nextMultipleFactor;
-    uint64_t nextMultiple = prime * nextMultipleFactor;
-    if (nextMultiple > stop_ - multiple)
-      return;
-    nextMultiple += multiple - segmentLow;
-    uint64_t multipleIndex = nextMultiple / 30;
-    uint64_t wheelIndex = wheelOffsets_[prime % 30] + INIT[quotient % MODULO].wheelIndex;
+    uint64_t quotient;
+    // calculate the first multiple (of prime) > segmentLow.
+    // In sequential sieving a prime is added once its square
+    // enters the range, the first multiple is then prime^2
+    // and no division is needed. Workers starting mid-range
+    // add all primes <= sqrt(start) against a large
+    // segmentLow; fastDiv() avoids ~pi(sqrt(start)) 64-bit
+    // hardware divisions in that spin-up phase.
+    if (prime * prime > segmentLow)
+      quotient = prime;
+    else
+      quotient = fastDiv(segmentLow, prime) + 1;
+    storeFirstMultiple(prime, segmentLow, quotient);
+  }
+
+  /// Same as addSievingPrime(prime, segmentLow) but the
+  /// quotient is computed using the precomputed reciprocal
+  /// of the prime (a multiply and shifts instead of a
+  /// division), see PrimeReciprocal
+  ///
+  void addSievingPrime(uint64_t prime, uint64_t segmentLow, const PrimeReciprocal& recip)
+  {
+    assert(segmentLow % 30 == 0);
+    segmentLow += 6;
+    uint64_t quotient;
+    if (prime * prime > segmentLow)
+      quotient = prime;
+    else if (segmentLow < (1ull << 63))
+      quotient = recip.divide(segmentLow) + 1;
+    else
+      quotient = fastDiv(segmentLow, prime) + 1;
+    storeFirstMultiple(prime, segmentLow, quotient);
+  }
+
+  /// Add a sieving prime whose first multiple (multipleIndex,
+  /// wheelIndex) has already been computed externally, e.g.
+  /// using 128-bit arithmetic for sieving windows above 2^64
+  /// where the number line offsets exceed uint64_t, see
+  /// Sieve128.cpp
+  ///
+  void addSievingPrime(uint64_t prime, uint64_t multipleIndex, uint64_t wheelIndex)
+  {
     storeSievingPrime(prime, multipleIndex, wheelIndex);
   }
 
@@ -112,7 +249,7 @@ protected:
 
   static uint64_t getMaxFactor()
   {
-    return WHEEL[0].nextMultipleFactor;
+    return TABLES->elem[0].nextMultipleFactor;
   }
 
   /// Cross-off the current multiple of sievingPrime
@@ -123,20 +260,43 @@ protected:
                        uint64_t* multipleIndex,
                        uint64_t* wheelIndex)
   {
-    sieve[*multipleIndex] &= WHEEL[*wheelIndex].unsetBit;
-    *multipleIndex        += WHEEL[*wheelIndex].nextMultipleFactor * sievingPrime;
-    *multipleIndex        += WHEEL[*wheelIndex].correct;
-    *wheelIndex           += WHEEL[*wheelIndex].next;
+    sieve[*multipleIndex] &= TABLES->elem[*wheelIndex].unsetBit;
+    *multipleIndex        += TABLES->elem[*wheelIndex].nextMultipleFactor * sievingPrime;
+    *multipleIndex        += TABLES->elem[*wheelIndex].correct;
+    *wheelIndex           += TABLES->elem[*wheelIndex].next;
   }
 
 private:
   static const uint64_t wheelOffsets_[30];
   uint64_t stop_;
+
+  /// Store the first multiple prime * quotient (> segmentLow)
+  /// and the position within the sieve array of that multiple
+  /// and its wheel index
+  ///
+  void storeFirstMultiple(uint64_t prime, uint64_t segmentLow, uint64_t quotient)
+  {
+    uint64_t multiple = prime * quotient;
+    // prime not needed for sieving
+    if (multiple > stop_ ||
+        multiple < segmentLow)
+      return;
+    // calculate the next multiple of prime that is not
+    // divisible by any of the wheel's factors
+    uint64_t nextMultipleFactor = TABLES->init[quotient % MODULO].nextMultipleFactor;
+    uint64_t nextMultiple = prime * nextMultipleFactor;
+    if (nextMultiple > stop_ - multiple)
+      return;
+    nextMultiple += multiple - segmentLow;
+    uint64_t multipleIndex = nextMultiple / 30;
+    uint64_t wheelIndex = wheelOffsets_[prime % 30] + TABLES->init[quotient % MODULO].wheelIndex;
+    storeSievingPrime(prime, multipleIndex, wheelIndex);
+  }
 };
 
-template <int MODULO, int SIZE, const WheelElement* WHEEL, const WheelInit* INIT>
+template <int MODULO, int SIZE, const WheelTables<MODULO, SIZE>* TABLES>
 const uint64_t
-Wheel<MODULO, SIZE, WHEEL, INIT>::wheelOffsets_[30] =
+Wheel<MODULO, SIZE, TABLES>::wheelOffsets_[30] =
 {
   0, SIZE * 7, 0, 0, 0, 0,
   0, SIZE * 0, 0, 0, 0, SIZE * 1,
@@ -146,10 +306,22 @@ Wheel<MODULO, SIZE, WHEEL, INIT>::wheelOffsets_[30] =
 };
 
 /// 3rd wheel, skips multiples of 2, 3 and 5
-using Wheel30_t = Wheel<30, 8, wheel30, wheel30Init>;
+using Wheel30_t = Wheel<30, 8, &wheel30Tables>;
 
 /// 4th wheel, skips multiples of 2, 3, 5 and 7
-using Wheel210_t = Wheel<210, 48, wheel210, wheel210Init>;
+using Wheel210_t = Wheel<210, 48, &wheel210Tables>;
+
+/// There is deliberately no 5th wheel (modulo 2310).
+/// generateWheel() could produce its tables, but its
+/// 480 * 8 wheel indexes exceed both the 9 wheelIndex bits
+/// of SievingPrime (Bucket.hpp) and the int8_t range of
+/// WheelElement::next, and shrinking multipleIndex to make
+/// room would cap the sieve size below the current maximum.
+/// A mod-2310 sieve array layout (480 bits per 2310 numbers,
+/// ~22% denser than the 8 bits per 30 numbers layout) would
+/// additionally break the byte-aligned bit layout assumed by
+/// the pre-sieve tables, the prime decoding in Erat.hpp and
+/// the prime k-tuplet bitmasks.
 
 } // namespace
 
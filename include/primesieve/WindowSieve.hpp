@@ -0,0 +1,88 @@
+///
+/// @file  WindowSieve.hpp
+/// @brief The WindowSieve class counts the primes in consecutive
+///        windows with monotonically growing upper bounds,
+///        reusing the sieve state between the windows.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef WINDOWSIEVE_HPP
+#define WINDOWSIEVE_HPP
+
+#include "Erat.hpp"
+#include "PreSieve.hpp"
+#include "SievingPrimes.hpp"
+
+#include <stdint.h>
+#include <memory>
+
+namespace primesieve {
+
+/// The segment iteration is carried forward across advance()
+/// calls: counting the next window only sieves the segments
+/// between the previous and the new upper bound, the PreSieve
+/// tables, sieving primes and bucket state are not rebuilt per
+/// window. Since the bucket memory is sized by sqrt(stop) the
+/// sieve runs towards a horizon that doubles whenever it is
+/// exceeded, so the sieving primes are regenerated only a
+/// logarithmic number of times.
+///
+class WindowSieve
+{
+public:
+  WindowSieve(uint64_t start);
+  /// Count the primes inside (prev, stop] where prev is the
+  /// stop of the previous advance() call (start - 1 for the
+  /// first call). stop must not decrease between calls.
+  uint64_t advance(uint64_t stop);
+private:
+  /// Segment iterator over [start, stop] whose prefix prime
+  /// counts can be queried at any point <= the last sieved
+  /// segment, like CountIntervals but advanced incrementally
+  class Sieve : public Erat
+  {
+  public:
+    Sieve(uint64_t start, uint64_t stop);
+    /// Sieve segments until the segment containing n
+    /// (or the last segment) has been sieved
+    void sieveTo(uint64_t n);
+    /// Number of primes inside [start, n],
+    /// requires sieveTo(n) to have been called
+    uint64_t prefix(uint64_t n) const;
+    /// Total prime count, requires sieveTo(stop)
+    uint64_t count() const { return count_; }
+  private:
+    PreSieve preSieve_;
+    SievingPrimes sievingPrimes_;
+    uint64_t prime_ = 0;
+    /// Lower bound of the last sieved segment
+    uint64_t low_ = 0;
+    /// Upper bound of the last sieved segment
+    uint64_t sievedHigh_ = 0;
+    /// Fused prime count of all sieved segments
+    uint64_t count_ = 0;
+    /// count_ before the last sieved segment
+    uint64_t prevCount_ = 0;
+  };
+
+  /// Upper bound of the previous advance() call
+  uint64_t prevStop_;
+  /// Prefix prime count (primes >= 7) at prevStop_
+  uint64_t prevPrefix_ = 0;
+  /// Prime count of the fully sieved previous horizons
+  uint64_t basePrefix_ = 0;
+  /// First number not covered by a previous horizon
+  uint64_t resume_;
+  /// Stop bound of the current sieve_
+  uint64_t horizon_ = 0;
+  std::unique_ptr<Sieve> sieve_;
+  void grow(uint64_t stop);
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,36 @@
+///
+/// @file   allocator.hpp
+/// @brief  Customization point for primesieve's large internal
+///         allocations (sieve arrays, bucket chunks). HPC
+///         deployments plug in e.g. a pinned memory or hugepage
+///         backed pool via primesieve::set_allocator(), the
+///         default goes through operator new.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef ALLOCATOR_HPP
+#define ALLOCATOR_HPP
+
+#include "types.hpp"
+
+#include <cstddef>
+
+namespace primesieve {
+
+/// Allocate bytes using the allocator installed via
+/// set_allocator() (or operator new by default).
+/// Throws primesieve_error if the allocation fails.
+byte_t* allocBytes(std::size_t bytes);
+
+/// Deallocate memory allocated by allocBytes(), @bytes must
+/// be the size of the allocation (pool allocators are size
+/// aware and avoid per allocation headers). ptr may be null.
+void deallocBytes(void* ptr, std::size_t bytes);
+
+} // namespace
+
+#endif
@@ -45,7 +45,24 @@ enum {
   /// primesieve::iterator maximum cache size in bytes, used if
   /// pi(sqrt(n)) * 8 bytes > MAX_CACHE_ITERATOR.
   ///
-  MAX_CACHE_ITERATOR = (1 << 20) * 1024
+  MAX_CACHE_ITERATOR = (1 << 20) * 1024,
+
+  /// primesieve::iterator keeps up to MAX_CACHE_BLOCKS recently
+  /// generated blocks of primes in order to serve iteration
+  /// direction changes (prev_prime()) within recently visited
+  /// ranges from memory instead of re-sieving them. The blocks
+  /// are delta compressed (about 1 byte per prime).
+  ///
+  MAX_CACHE_BLOCKS = 8,
+
+  /// EratBig prefetches the sieve array cache lines of the
+  /// multiples PREFETCH_DISTANCE sieving primes ahead while
+  /// crossing off multiples, this hides the latency of the
+  /// (random access) sieve array stores. Benchmarked on
+  /// Skylake & Zen 2, 8 was fastest for 10^17 < n < 10^19.
+  /// @pre PREFETCH_DISTANCE % 2 == 0
+  ///
+  PREFETCH_DISTANCE = 8
 };
 
   /// Sieving primes <= (sieveSize in bytes * FACTOR_ERATSMALL)
@@ -69,12 +86,31 @@ enum {
   ///
   const double FACTOR_ERATMEDIUM = 2.5;
 
+  /// Sieving primes <= (sieveSize in bytes * FACTOR_ERATBIG_HOT)
+  /// (and > EratMedium see above) are kept in EratBig's dense hot
+  /// array instead of the bucket lists. These primes have a
+  /// multiple every 1 to 2 segments, storing them in buckets
+  /// drags each 8-byte SievingPrime entry through the cache
+  /// twice per multiple (bucket store + bucket scan) whereas the
+  /// hot array is read linearly once per segment.
+  /// @pre FACTOR_ERATBIG_HOT >= FACTOR_ERATMEDIUM
+  ///
+  const double FACTOR_ERATBIG_HOT = 16.0;
+
   /// Each thread sieves at least a distance of MIN_THREAD_DISTANCE
   /// in order to reduce the initialization overhead.
   /// @pre MIN_THREAD_DISTANCE >= 100
   ///
   const uint64_t MIN_THREAD_DISTANCE = (uint64_t) 1e7;
 
+  /// Experimental: if set to 2 each segment is sieved by 2
+  /// threads, EratMedium runs one L1 sized stripe ahead of
+  /// EratSmall (see Erat::crossOffPipelined). Intended for
+  /// single-range workloads that cannot use ParallelSieve.
+  /// @pre THREADS_PER_SEGMENT == 1 || == 2
+  ///
+  const int THREADS_PER_SEGMENT = 1;
+
 } // namespace config
 } // namespace primesieve
 
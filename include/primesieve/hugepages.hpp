@@ -0,0 +1,56 @@
+///
+/// @file   hugepages.hpp
+/// @brief  Transparent huge page support for large allocations.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef HUGEPAGES_HPP
+#define HUGEPAGES_HPP
+
+#include <stdint.h>
+#include <cstddef>
+
+#if defined(__linux__)
+  #include <sys/mman.h>
+#endif
+
+namespace primesieve {
+
+bool get_huge_pages();
+
+/// Advise the OS to back the interval [ptr, ptr + bytes) by
+/// transparent 2 MB huge pages in order to reduce dTLB misses
+/// in the cross-off loops. This is only a hint, if the kernel
+/// cannot satisfy it the allocation transparently stays on
+/// regular 4 KB pages.
+///
+inline void adviseHugePages(void* ptr, std::size_t bytes)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  const uintptr_t hugePageSize = 2 << 20;
+
+  if (bytes < hugePageSize ||
+      !get_huge_pages())
+    return;
+
+  // madvise(MADV_HUGEPAGE) requires a huge page
+  // aligned start address
+  uintptr_t addr = (uintptr_t) ptr;
+  uintptr_t aligned = (addr + hugePageSize - 1) & ~(hugePageSize - 1);
+  uintptr_t skipped = aligned - addr;
+
+  if (bytes > skipped + hugePageSize)
+    madvise((void*) aligned, bytes - skipped, MADV_HUGEPAGE);
+#else
+  (void) ptr;
+  (void) bytes;
+#endif
+}
+
+} // namespace
+
+#endif
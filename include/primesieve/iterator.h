@@ -26,6 +26,15 @@
 #include <stdint.h>
 #include <stddef.h>
 
+/** See primesieve.h, kept here for standalone inclusion */
+#ifndef PRIMESIEVE_NOEXCEPT
+  #ifdef __cplusplus
+    #define PRIMESIEVE_NOEXCEPT noexcept
+  #else
+    #define PRIMESIEVE_NOEXCEPT
+  #endif
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -64,6 +73,27 @@ void primesieve_free_iterator(primesieve_iterator* it);
  */
 void primesieve_skipto(primesieve_iterator* it, uint64_t start, uint64_t stop_hint);
 
+/**
+ * Get the next block of primes without copying.
+ * Returns a pointer into the iterator's internal buffer (borrowed,
+ * do not free) and stores the number of primes in *size (>= 1).
+ * The pointer is only valid until the next call to any
+ * primesieve_iterator function. This crosses the C ABI once per
+ * block instead of once per prime which is much faster for FFI
+ * bindings. Once all primes <= 2^64 have been generated the
+ * returned block is { UINT64_MAX }. If any error occurs the
+ * returned block is { PRIMESIEVE_ERROR } and is_error is set.
+ */
+const uint64_t* primesieve_next_primes(primesieve_iterator* it, size_t* size);
+
+/**
+ * Same as primesieve_next_primes() but with a status code
+ * return, declared noexcept for C++ callers: the block
+ * pointer is stored in *primes.
+ * @return 0 on success, non-zero if an error occurs.
+ */
+int primesieve_next_primes_noexcept(primesieve_iterator* it, const uint64_t** primes, size_t* size) PRIMESIEVE_NOEXCEPT;
+
 /** Internal use */
 void primesieve_generate_next_primes(primesieve_iterator*);
 
@@ -20,6 +20,8 @@
 namespace primesieve {
 
 class PrimeGenerator;
+class AsyncPrefetch;
+class BlockCache;
 
 uint64_t get_max_stop();
 
@@ -42,6 +44,9 @@ public:
   iterator(uint64_t start = 0, uint64_t stop_hint = get_max_stop());
 
   /// Reset the primesieve iterator to start.
+  /// The sieving primes are kept across skipto() calls, hence
+  /// repositioning the iterator within an already visited
+  /// range costs O(segment) instead of O(sqrt(stop)).
   /// @param start      Generate primes > start (or < start).
   /// @param stop_hint  Stop number optimization hint, gives significant
   ///                   speed up if few primes are generated. E.g. if
@@ -70,6 +75,24 @@ public:
     return primes_[i_];
   }
 
+  /// Get the next block of primes without copying.
+  /// Returns a pointer into the iterator's internal buffer and
+  /// stores the number of primes in @size (>= 1). The pointer is
+  /// only valid until the next call to any of the iterator's
+  /// methods. Once all primes <= 2^64 have been generated the
+  /// returned block is { UINT64_MAX }.
+  ///
+  const uint64_t* next_primes(std::size_t* size);
+
+  /// Enable (or disable) asynchronous prime generation.
+  /// A background thread sieves the next block of primes into a
+  /// second buffer while the caller iterates over the current
+  /// block, the buffers are swapped when the current block is
+  /// exhausted. This hides the sieving latency from the caller
+  /// at the cost of one additional thread and buffer.
+  ///
+  void set_async(bool enable = true);
+
   ~iterator();
 private:
   std::size_t i_;
@@ -79,11 +102,64 @@ private:
   uint64_t stop_;
   uint64_t stop_hint_;
   uint64_t dist_;
+  /// Read-only snapshot of the process-wide sieving prime
+  /// cache, contains (at least) the primes inside
+  /// [7, sievingPrimesLimit_]. Shared by all iterators and
+  /// kept across skipto() calls, so repeatedly constructing
+  /// iterators with a large start only pays the O(sqrt(stop))
+  /// sieving prime generation once per process.
+  std::shared_ptr<const std::vector<uint64_t>> sievingPrimes_;
+  uint64_t sievingPrimesLimit_ = 0;
   std::unique_ptr<PrimeGenerator> primeGenerator_;
+  std::unique_ptr<AsyncPrefetch> async_;
+  std::unique_ptr<BlockCache> blockCache_;
   void generate_next_primes();
+  void generate_next_primes_async();
   void generate_prev_primes();
 };
 
+/// primesieve::iterator32 iterates over the primes < 2^32 using
+/// 32-bit prime storage. Compared to primesieve::iterator this
+/// halves the memory traffic of the internal primes buffer and
+/// doubles the number of primes that fit into the same cache
+/// size. iterator32 only iterates forwards, next_prime() returns
+/// UINT32_MAX once there are no more primes < 2^32.
+///
+class iterator32
+{
+public:
+  /// Create a new iterator32 object.
+  /// @param start      Generate primes > start.
+  /// @param stop_hint  Stop number optimization hint.
+  ///
+  iterator32(uint64_t start = 0, uint64_t stop_hint = ~0u);
+
+  /// Reset the iterator to start.
+  void skipto(uint64_t start, uint64_t stop_hint = ~0u);
+
+  /// Get the next prime.
+  /// Returns UINT32_MAX if next prime > 2^32.
+  ///
+  uint32_t next_prime()
+  {
+    if (i_++ == last_idx_)
+      generate_next_primes();
+    return primes_[i_];
+  }
+
+  ~iterator32();
+private:
+  std::size_t i_;
+  std::size_t last_idx_;
+  std::vector<uint32_t> primes_;
+  uint64_t start_;
+  uint64_t stop_;
+  uint64_t stop_hint_;
+  uint64_t dist_;
+  std::unique_ptr<PrimeGenerator> primeGenerator_;
+  void generate_next_primes();
+};
+
 } // namespace
 
 #endif
@@ -0,0 +1,44 @@
+///
+/// @file   kTuplets.hpp
+/// @brief  Bitmask byte patterns of the prime k-tuplets.
+///         A prime k-tuplet always fits inside a single sieve
+///         byte (8 bits for 30 numbers), so matching a sieve
+///         byte against these masks finds all k-tuplets in its
+///         30 number window. Shared by PrintPrimes and
+///         generate_ktuplets().
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef KTUPLETS_HPP
+#define KTUPLETS_HPP
+
+#include <stdint.h>
+
+namespace primesieve {
+namespace ktuplet {
+
+/// End of a bitmask row, larger than any sieve byte
+enum { END = 0xff + 1 };
+
+/// bitmasks[i] are the byte patterns of the prime
+/// (i + 1)-tuplets, sorted in ascending order.
+/// i = 1 twins, i = 2 triplets, ...
+///
+const uint64_t bitmasks[6][5] =
+{
+  { END },
+  { 0x06, 0x18, 0xc0, END },       // Twin primes:       b00000110, b00011000, b11000000
+  { 0x07, 0x0e, 0x1c, 0x38, END }, // Prime triplets:    b00000111, b00001110, ...
+  { 0x1e, END },                   // Prime quadruplets: b00011110
+  { 0x1f, 0x3e, END },             // Prime quintuplets
+  { 0x3f, END }                    // Prime sextuplets
+};
+
+} // namespace ktuplet
+} // namespace primesieve
+
+#endif
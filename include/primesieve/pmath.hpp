@@ -32,6 +32,49 @@ inline bool isPow2(T x)
   return x != 0 && (x & (x - 1)) == 0;
 }
 
+/// Exact floor(x / y) computed from a double precision
+/// estimate followed by an exact integer correction, faster
+/// than a 64-bit hardware division. The estimate is off by
+/// at most ~x/y * 2^-51 so the correction loops are cheap
+/// (usually 0 or 1 iterations); the few iterations more for
+/// tiny divisors amortize against the saved divides. Large
+/// x fall back to the hardware division, the correction
+/// multiplies must not overflow.
+///
+inline uint64_t fastDiv(uint64_t x, uint64_t y)
+{
+  if (x >= (1ull << 62))
+    return x / y;
+
+  uint64_t q = (uint64_t) ((double) x / (double) y);
+
+  while (q * y > x)
+    q--;
+  while (q * y + y <= x)
+    q++;
+
+  return q;
+}
+
+/// Count the number of 1 bits
+inline uint64_t popcnt64(uint64_t x)
+{
+#if defined(__GNUC__) || \
+    defined(__clang__)
+  return __builtin_popcountll(x);
+#else
+  const uint64_t m1 = 0x5555555555555555ull;
+  const uint64_t m2 = 0x3333333333333333ull;
+  const uint64_t m4 = 0x0F0F0F0F0F0F0F0Full;
+  const uint64_t h01 = 0x0101010101010101ull;
+
+  x -= (x >> 1) & m1;
+  x = (x & m2) + ((x >> 2) & m2);
+  x = (x + (x >> 4)) & m4;
+  return (x * h01) >> 56;
+#endif
+}
+
 template <typename T>
 constexpr T numberOfBits(T)
 {
@@ -105,6 +148,79 @@ constexpr T ctSqrt(T x)
   return ctSqrt<T>(x, 0, x / 2 + 1);
 }
 
+#if __cplusplus >= 201402L
+  /// C++14 relaxed constexpr allows loops, hence the floating
+  /// point approximation functions below can additionally be
+  /// evaluated at compile time e.g. inside static_assert
+  #define PMATH_CONSTEXPR14 constexpr
+#else
+  #define PMATH_CONSTEXPR14 inline
+#endif
+
+/// Square root for doubles, self contained (std::sqrt is not
+/// constexpr) using Newton's method which converges from
+/// above, accurate to ~1 ulp
+///
+PMATH_CONSTEXPR14 double ctSqrt(double x)
+{
+  if (x <= 0)
+    return 0;
+
+  double r = (x < 1) ? 1 : x;
+
+  for (int i = 0; i < 200; i++)
+  {
+    double next = (r + x / r) / 2;
+    if (next >= r)
+      break;
+    r = next;
+  }
+
+  return r;
+}
+
+/// Natural logarithm, self contained (std::log is not
+/// constexpr). The argument is reduced to [1, 2) and the
+/// logarithm computed using the rapidly converging series
+/// log(x) = 2 * atanh((x - 1) / (x + 1)), the reduction
+/// argument satisfies t <= 1/3 so that ~17 series terms
+/// give full double precision
+///
+PMATH_CONSTEXPR14 double ctLog(double x)
+{
+  if (x <= 0)
+    return 0;
+
+  const double log2 = 0.693147180559945309;
+  double exponent = 0;
+
+  while (x >= 2)
+  {
+    x /= 2;
+    exponent += 1;
+  }
+  while (x < 1)
+  {
+    x *= 2;
+    exponent -= 1;
+  }
+
+  double t = (x - 1) / (x + 1);
+  double t2 = t * t;
+  double term = t;
+  double sum = 0;
+
+  for (int k = 1; k < 99; k += 2)
+  {
+    sum += term / k;
+    term *= t2;
+    if (term < 1e-18)
+      break;
+  }
+
+  return exponent * log2 + 2 * sum;
+}
+
 template <typename T>
 inline T isqrt(T x)
 {
@@ -152,24 +268,174 @@ inline B inBetween(A min, B x, C max)
   return x;
 }
 
-/// primeCountApprox(x) >= pi(x)
-inline std::size_t primeCountApprox(uint64_t start, uint64_t stop)
+/// Logarithmic integral li(x), approximates pi(x) with
+/// |li(x) - pi(x)| < sqrt(x) for all x <= 10^19. Calculated
+/// using the rapidly converging Ramanujan series
+///
+PMATH_CONSTEXPR14 double li(double x)
+{
+  if (x <= 1)
+    return 0;
+
+  double gamma = 0.577215664901532861;
+  double logx = ctLog(x);
+  double sum = 0;
+  double inner = 0;
+  double factorial = 1;
+  double p = -1;
+  double power2 = 1;
+  int k = 0;
+
+  for (int n = 1; n < 200; n++)
+  {
+    factorial *= n;
+    p *= -logx;
+    double q = factorial * power2;
+    power2 *= 2;
+
+    for (; k <= (n - 1) / 2; k++)
+      inner += 1.0 / (2 * k + 1);
+
+    double term = (p / q) * inner;
+    sum += term;
+
+    double absTerm = (term < 0) ? -term : term;
+    double absSum = (sum < 0) ? -sum : sum;
+    if (absTerm < absSum * 1e-15)
+      break;
+  }
+
+  return gamma + ctLog(logx) + ctSqrt(x) * sum;
+}
+
+/// Inverse logarithmic integral, liInverse(n) approximates
+/// the nth prime much more accurately than the classic
+/// n * (log n + log log n) formula. Calculated using
+/// Newton's method with li'(x) = 1 / log(x).
+///
+PMATH_CONSTEXPR14 double liInverse(double n)
+{
+  if (n < 2)
+    return 2;
+
+  double x = n * ctLog((n < 3) ? 3 : n);
+
+  for (int i = 0; i < 100; i++)
+  {
+    double term = (li(x) - n) * ctLog(x);
+    x -= term;
+    x = (x < 2) ? 2 : x;
+
+    double absTerm = (term < 0) ? -term : term;
+    if (absTerm < x * 1e-15)
+      break;
+  }
+
+  return x;
+}
+
+/// Riemann R function, approximates pi(x) about an order of
+/// magnitude more accurately than li(x), e.g. at x = 10^16:
+/// li(x) - pi(x) = 3214632 but R(x) - pi(x) = 327052.
+/// Calculated using the Gram series
+/// R(x) = 1 + sum_{k>=1} log(x)^k / (k * k! * zeta(k+1))
+///
+PMATH_CONSTEXPR14 double riemannR(double x)
+{
+  if (x <= 1)
+    return 0;
+
+  // zeta(s) for s = 2, 3, 4, ... zeta(s) = 1 to double
+  // precision for all larger s
+  constexpr double zeta[] =
+  {
+    1.6449340668482264, 1.2020569031595949, 1.0823232337111373,
+    1.0369277551433713, 1.0173430619844486, 1.0083492773819234,
+    1.004077356197943, 1.0020083928260817, 1.0009945751278182,
+    1.0004941886041194, 1.0002460865533078, 1.0001227133475783,
+    1.0000612481350586, 1.000030588236307, 1.0000152822594084,
+    1.0000076371976376, 1.000003817293265, 1.0000019082127163,
+    1.0000009539620338, 1.0000004769329867, 1.0000002384505027,
+    1.0000001192199259, 1.0000000596081891, 1.0000000298035034,
+    1.0000000149015549, 1.0000000074507118, 1.000000003725334,
+    1.0000000018626598, 1.0000000009313275, 1.0000000004656628,
+    1.0000000002328311, 1.0000000001164155, 1.0000000000582077,
+    1.0000000000291038, 1.0000000000145519, 1.000000000007276,
+    1.000000000003638, 1.000000000001819, 1.0000000000009095,
+    1.0000000000004547, 1.0000000000002274, 1.0000000000001137,
+    1.0000000000000568, 1.0000000000000284, 1.0000000000000142,
+    1.0000000000000071, 1.0000000000000036, 1.0000000000000018,
+    1.0000000000000009, 1.0000000000000004, 1.0000000000000002
+  };
+
+  constexpr int zetaSize = (int) (sizeof(zeta) / sizeof(zeta[0]));
+  double logx = ctLog(x);
+  double sum = 1;
+  double term = 1;
+
+  for (int k = 1; k < 300; k++)
+  {
+    // term = log(x)^k / k!
+    term *= logx / k;
+    double z = (k - 1 < zetaSize) ? zeta[k - 1] : 1.0;
+    double t = term / (k * z);
+    sum += t;
+
+    // the series terms grow up to k ~ log(x)
+    // before they start converging to 0
+    if (k > logx && t < sum * 1e-15)
+      break;
+  }
+
+  return sum;
+}
+
+/// Inverse Riemann R function, riemannRInverse(n) is the most
+/// accurate nth prime approximation in this file. Calculated
+/// using Newton's method with R'(x) ~ 1 / log(x).
+///
+PMATH_CONSTEXPR14 double riemannRInverse(double n)
+{
+  if (n < 2)
+    return 2;
+
+  double x = liInverse(n);
+
+  for (int i = 0; i < 100; i++)
+  {
+    double term = (riemannR(x) - n) * ctLog(x);
+    x -= term;
+    x = (x < 2) ? 2 : x;
+
+    double absTerm = (term < 0) ? -term : term;
+    if (absTerm < x * 1e-15)
+      break;
+  }
+
+  return x;
+}
+
+/// primeCountApprox(x) >= pi(x) (in practice)
+PMATH_CONSTEXPR14 std::size_t primeCountApprox(uint64_t start, uint64_t stop)
 {
   if (start > stop)
     return 0;
   if (stop <= 10)
     return 4;
 
-  // pi(x) <= x / (log(x) - 1.1) + 5, for x >= 4
-  double x = (double) stop;
-  double logx = std::log(x);
-  double div = logx - 1.1;
-  double pix = (stop - start) / div + 5;
+  // The old x / (log(x) - 1.1) formula over-allocated by up
+  // to 10% for ranges at large heights. The Riemann R
+  // function tracks pi(x) to within ~sqrt(x) / log(x), the
+  // square root slack covers pi(x)'s fluctuation around R(x)
+  // so that reserve() based on this estimate rarely falls
+  // short
+  double pix = riemannR((double) stop) - riemannR((double) start);
+  pix += ctSqrt(pix) * 2 + 10;
 
   return (std::size_t) pix;
 }
 
-inline std::size_t primeCountApprox(uint64_t stop)
+PMATH_CONSTEXPR14 std::size_t primeCountApprox(uint64_t stop)
 {
   return primeCountApprox(0, stop);
 }
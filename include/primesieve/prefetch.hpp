@@ -0,0 +1,40 @@
+///
+/// @file  prefetch.hpp
+/// @brief Portable software prefetch hint
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef PREFETCH_HPP
+#define PREFETCH_HPP
+
+#if defined(_MSC_VER) && \
+   (defined(_M_IX86) || defined(_M_X64))
+  #include <xmmintrin.h>
+#endif
+
+namespace primesieve {
+
+/// Hint the CPU to load the cache line containing
+/// addr into all cache levels. The prefetch is
+/// non-faulting, addr may be invalid.
+///
+inline void prefetch(const void* addr)
+{
+#if defined(__GNUC__) || \
+    defined(__clang__)
+  __builtin_prefetch(addr, 1 /* write */, 3 /* high locality */);
+#elif defined(_MSC_VER) && \
+     (defined(_M_IX86) || defined(_M_X64))
+  _mm_prefetch((const char*) addr, _MM_HINT_T0);
+#else
+  (void) addr;
+#endif
+}
+
+} // namespace
+
+#endif
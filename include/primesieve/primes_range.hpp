@@ -0,0 +1,155 @@
+///
+/// @file   primes_range.hpp
+/// @brief  The primes_range class is a lazily generated range of
+///         primes that plugs into range-based for loops, the
+///         standard algorithms and (in C++20) std::ranges
+///         pipelines. Its iterator wraps primesieve::iterator, so
+///         dereferencing and incrementing inline the same
+///         i_++ / generate_next_primes() logic as next_prime()
+///         and composed views compile down to the raw loop.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef PRIMES_RANGE_HPP
+#define PRIMES_RANGE_HPP
+
+#include "iterator.hpp"
+
+#include <stdint.h>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+
+#if defined(__cpp_lib_ranges)
+  #include <ranges>
+#endif
+
+namespace primesieve {
+
+/// Lazily generated range of the primes inside [start, stop].
+/// The primes are sieved segment by segment while iterating,
+/// memory usage is PrimePi(stop^0.5) * 8 bytes no matter how
+/// large the range is. primes_range is an input range: its
+/// iterators share one underlying primesieve::iterator (like
+/// std::istream_iterator shares its stream), hence the range
+/// should be traversed only once
+///
+class primes_range
+{
+public:
+  class iterator
+  {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = uint64_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const uint64_t*;
+    using reference = uint64_t;
+
+    /// Past-the-end iterator
+    iterator() = default;
+
+    iterator(uint64_t start, uint64_t stop)
+      : it_(std::make_shared<primesieve::iterator>(start, stop)),
+        stop_(stop)
+    {
+      prime_ = it_->next_prime();
+    }
+
+    uint64_t operator*() const
+    {
+      return prime_;
+    }
+
+    iterator& operator++()
+    {
+      prime_ = it_->next_prime();
+      return *this;
+    }
+
+    iterator operator++(int)
+    {
+      iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    /// Iterators only compare equal once they have run past
+    /// the end of the range (sentinel semantics, the same as
+    /// std::istream_iterator)
+    bool operator==(const iterator& other) const
+    {
+      return atEnd() == other.atEnd();
+    }
+
+    bool operator!=(const iterator& other) const
+    {
+      return !(*this == other);
+    }
+
+  private:
+    bool atEnd() const
+    {
+      return prime_ > stop_ ||
+            ~prime_ == 0;
+    }
+
+    std::shared_ptr<primesieve::iterator> it_;
+    uint64_t prime_ = ~0ull;
+    uint64_t stop_ = 0;
+  };
+
+  primes_range(uint64_t start, uint64_t stop)
+    : start_(start),
+      stop_(stop)
+  { }
+
+  iterator begin() const
+  {
+    return iterator(start_, stop_);
+  }
+
+  iterator end() const
+  {
+    return iterator();
+  }
+
+private:
+  uint64_t start_;
+  uint64_t stop_;
+};
+
+/// primes(start, stop) is a lazy range of the primes inside
+/// [start, stop], e.g.:
+/// for (uint64_t prime : primesieve::primes(100, 200)) { ... }
+///
+inline primes_range primes(uint64_t start, uint64_t stop)
+{
+  return primes_range(start, stop);
+}
+
+/// primes(stop) is a lazy range of the primes <= stop
+inline primes_range primes(uint64_t stop)
+{
+  return primes_range(0, stop);
+}
+
+} // namespace
+
+#if defined(__cpp_lib_ranges)
+
+/// primes_range iterators own their generator (via a
+/// shared_ptr) and stay valid after the range object has been
+/// destroyed, so rvalue ranges may safely be piped into
+/// std::ranges views: primesieve::primes(0, n) | views::filter
+///
+template <>
+inline constexpr bool std::ranges::enable_borrowed_range<primesieve::primes_range> = true;
+
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+///
+/// @file  AsyncSievingPrimes.cpp
+///        When sieving starts near e.g. 10^18 the first segment
+///        already needs all sieving primes up to ~10^9, producing
+///        them is a serial startup delay on the consumer thread.
+///        AsyncSievingPrimes moves the production onto a producer
+///        thread so it overlaps with the consumer's pre-sieve
+///        initialization and main sieving. The primes are handed
+///        over in ascending order in blocks through a bounded
+///        queue, so the consumer starts its first segment as soon
+///        as the primes it needs are available.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve/AsyncSievingPrimes.hpp>
+#include <primesieve/Erat.hpp>
+#include <primesieve/SievingPrimes.hpp>
+#include <primesieve/pmath.hpp>
+
+#include <stdint.h>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+/// Use a producer thread only if sqrt(stop) >= 10^8,
+/// below this threshold generating the sieving primes
+/// takes < 100 ms and a producer thread is not worth
+/// its spawn and synchronization overhead
+const uint64_t minAsyncSqrtStop = 100000000ull;
+
+/// Number of sieving primes per block (512 kilobytes),
+/// large enough that the queue lock is taken rarely
+const size_t blockPrimes = 1 << 16;
+
+/// Maximum number of blocks in the queue, bounds the
+/// memory used when the producer runs far ahead
+const size_t maxQueueSize = 16;
+
+} // namespace
+
+namespace primesieve {
+
+AsyncSievingPrimes::AsyncSievingPrimes(Erat* erat, PreSieve& preSieve)
+{
+  async_ = isqrt(erat->getStop()) >= minAsyncSqrtStop;
+
+  if (async_)
+    producer_ = thread(&AsyncSievingPrimes::producerThread, this, erat, &preSieve);
+  else
+    sievingPrimes_.init(erat, preSieve);
+}
+
+AsyncSievingPrimes::~AsyncSievingPrimes()
+{
+  if (producer_.joinable())
+  {
+    {
+      unique_lock<mutex> guard(lock_);
+      stop_ = true;
+    }
+    drained_.notify_one();
+    producer_.join();
+  }
+}
+
+/// Producer thread, generates the sieving primes in
+/// ascending order and queues them in blocks
+///
+void AsyncSievingPrimes::producerThread(Erat* erat, PreSieve* preSieve)
+{
+  SievingPrimes sievingPrimes(erat, *preSieve);
+  vector<uint64_t> block;
+  block.reserve(blockPrimes);
+  uint64_t prime = 0;
+
+  while (prime != ~0ull)
+  {
+    prime = sievingPrimes.next();
+    block.push_back(prime);
+
+    // the last block ends with the ~0 sentinel
+    // that SievingPrimes::next() returns after
+    // the last sieving prime
+    if (block.size() >= blockPrimes ||
+        prime == ~0ull)
+    {
+      unique_lock<mutex> guard(lock_);
+      drained_.wait(guard, [&] { return queue_.size() < maxQueueSize || stop_; });
+
+      if (stop_)
+        return;
+
+      queue_.push_back(std::move(block));
+      pending_.notify_one();
+      block = vector<uint64_t>();
+      block.reserve(blockPrimes);
+    }
+  }
+}
+
+/// Executed when the current block has been consumed,
+/// waits for the next block from the producer thread
+///
+uint64_t AsyncSievingPrimes::nextBlock()
+{
+  // the ~0 sentinel terminates the last block,
+  // keep returning it like SievingPrimes::next()
+  if (!block_.empty() &&
+      block_.back() == ~0ull)
+    return ~0ull;
+
+  unique_lock<mutex> guard(lock_);
+  pending_.wait(guard, [&] { return !queue_.empty(); });
+
+  block_ = std::move(queue_.front());
+  queue_.pop_front();
+  drained_.notify_one();
+
+  index_ = 0;
+  return block_[index_++];
+}
+
+} // namespace
@@ -0,0 +1,199 @@
+///
+/// @file   BucketPool.cpp
+/// @brief  Pool allocator for the Bucket memory of EratBig.
+///         Retired chunks are recycled via a thread-local free
+///         list backed by a shared global pool instead of going
+///         through the system allocator for each sieve() call.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/BucketPool.hpp>
+#include <primesieve/CpuInfo.hpp>
+#include <primesieve/allocator.hpp>
+#include <primesieve/hugepages.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+namespace {
+
+/// Maximum number of retired chunks kept in the global
+/// pool (128 * 8 megabytes = 1 gigabyte), chunks above
+/// this limit are returned to the system allocator
+///
+const size_t maxPoolChunks = 128;
+
+/// Maximum number of retired chunks kept in each
+/// thread's local free list
+///
+const size_t maxLocalChunks = 16;
+
+mutex poolLock;
+
+/// Set once the global pools have been destroyed at process
+/// exit: the ThreadPool joins its worker threads during
+/// static destruction, so their thread-local free lists may
+/// flush after the pools are gone
+///
+bool poolsDestroyed = false;
+
+/// One global pool per NUMA node. Sieving threads are
+/// pinned to a node so a chunk's memory pages live on the
+/// node of the thread that allocated it (first touch);
+/// recycling it through the same node's pool guarantees
+/// the next user accesses node-local memory. The destructor
+/// returns the retained chunks through deallocBytes() at
+/// process exit, so every chunk allocation is eventually
+/// paired with a deallocation (relevant for leak checkers
+/// and for custom allocators, see set_allocator())
+///
+struct GlobalPools
+{
+  vector<vector<Bucket*>> pools;
+
+  GlobalPools() :
+    pools(max<size_t>(1, cpuInfo.numaNodes()))
+  { }
+
+  ~GlobalPools()
+  {
+    unique_lock<mutex> lock(poolLock);
+    poolsDestroyed = true;
+
+    for (auto& pool : pools)
+      for (Bucket* chunk : pool)
+        deallocBytes(chunk, BucketPool::chunkBuckets() * sizeof(Bucket));
+  }
+};
+
+vector<vector<Bucket*>>& getPools()
+{
+  static GlobalPools global;
+  return global.pools;
+}
+
+/// Add the chunks to the current NUMA node's global pool,
+/// chunks that do not fit below maxPoolChunks are deallocated
+///
+void freeGlobal(vector<Bucket*>& chunks)
+{
+  unique_lock<mutex> lock(poolLock);
+
+  // chunks flushed by a worker thread's free list after
+  // the global pools have been destroyed (process exit)
+  // are deallocated directly
+  if (poolsDestroyed)
+  {
+    lock.unlock();
+    while (!chunks.empty())
+    {
+      deallocBytes(chunks.back(), BucketPool::chunkBuckets() * sizeof(Bucket));
+      chunks.pop_back();
+    }
+    return;
+  }
+
+  auto& pools = getPools();
+  auto& pool = pools[cpuInfo.currentNumaNode() % pools.size()];
+
+  while (!chunks.empty())
+  {
+    Bucket* chunk = chunks.back();
+    chunks.pop_back();
+
+    if (pool.size() < maxPoolChunks)
+      pool.push_back(chunk);
+    else
+    {
+      lock.unlock();
+      deallocBytes(chunk, BucketPool::chunkBuckets() * sizeof(Bucket));
+      lock.lock();
+    }
+  }
+}
+
+/// Each thread's free list, on thread exit the
+/// remaining chunks are moved to the global pool
+///
+struct LocalPool
+{
+  vector<Bucket*> chunks;
+
+  ~LocalPool()
+  {
+    freeGlobal(chunks);
+  }
+};
+
+thread_local LocalPool localPool;
+
+} // namespace
+
+namespace primesieve {
+
+size_t BucketPool::chunkBuckets()
+{
+  // latched at first use, the pool
+  // recycles chunks of this fixed size
+  static const size_t buckets = get_tuning().bytesPerAlloc / sizeof(Bucket);
+  return buckets;
+}
+
+Bucket* BucketPool::getChunk()
+{
+  Bucket* chunk = nullptr;
+
+  if (!localPool.chunks.empty())
+  {
+    chunk = localPool.chunks.back();
+    localPool.chunks.pop_back();
+  }
+  else
+  {
+    auto& pools = getPools();
+    unique_lock<mutex> lock(poolLock);
+    auto& pool = pools[cpuInfo.currentNumaNode() % pools.size()];
+
+    if (!pool.empty())
+    {
+      chunk = pool.back();
+      pool.pop_back();
+    }
+  }
+
+  if (!chunk)
+  {
+    // the buckets are raw storage, EratBig initializes
+    // them before use (see Bucket.hpp)
+    size_t buckets = chunkBuckets();
+    chunk = (Bucket*) allocBytes(buckets * sizeof(Bucket));
+    adviseHugePages(chunk, buckets * sizeof(Bucket));
+  }
+
+  return chunk;
+}
+
+void BucketPool::freeChunks(vector<Bucket*>& chunks)
+{
+  // bulk-recycle into the thread's local free list
+  while (!chunks.empty() &&
+         localPool.chunks.size() < maxLocalChunks)
+  {
+    localPool.chunks.push_back(chunks.back());
+    chunks.pop_back();
+  }
+
+  if (!chunks.empty())
+    freeGlobal(chunks);
+}
+
+} // namespace
@@ -0,0 +1,186 @@
+///
+/// @file   CountCache.cpp
+/// @brief  The CountCache memoizes the prime counts of aligned
+///         10^9 blocks, keyed by block index. If the
+///         PRIMESIEVE_COUNT_FILE environment variable is set
+///         the cache is persisted to that file (and the cache
+///         is only used at all in that case), so jobs that
+///         repeatedly count overlapping subranges of the same
+///         block grid reuse the block counts across runs and
+///         only sieve the block boundary residuals. Unlike the
+///         PiTable checkpoints the cache is sparse: only the
+///         blocks that have actually been counted are stored.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/CountCache.hpp>
+#include <primesieve/ParallelSieve.hpp>
+#include <primesieve/pmath.hpp>
+#include <primesieve/PrimeSieve.hpp>
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+/// Distance covered by one cached block
+const uint64_t blockDist = 1000000000ull;
+
+/// Count the primes inside [start, stop] using the
+/// sieve size and number of threads configured via
+/// the set_sieve_size() and set_num_threads() API
+///
+uint64_t sieveCount(uint64_t start, uint64_t stop)
+{
+  primesieve::ParallelSieve ps;
+  ps.setSieveSize(primesieve::get_sieve_size());
+  ps.setNumThreads(primesieve::get_num_threads());
+  ps.sieve(start, stop, primesieve::COUNT_PRIMES);
+  return ps.getCount(0);
+}
+
+string getFilePath()
+{
+  const char* path = getenv("PRIMESIEVE_COUNT_FILE");
+  return (path) ? path : string();
+}
+
+} // namespace
+
+namespace primesieve {
+
+CountCache& CountCache::getInstance()
+{
+  static CountCache countCache;
+  return countCache;
+}
+
+bool CountCache::enabled()
+{
+  return !getFilePath().empty();
+}
+
+uint64_t CountCache::distance()
+{
+  return blockDist;
+}
+
+/// Count the primes inside [start, stop]. The blocks fully
+/// contained in [start, stop] are answered from the cache
+/// (counting and memoizing missing blocks), only the
+/// residual subranges at the block boundaries are sieved
+/// on every query
+///
+uint64_t CountCache::countPrimes(uint64_t start, uint64_t stop)
+{
+  if (start > stop)
+    return 0;
+
+  // blocks [firstBlock, lastBlock) are
+  // fully contained in [start, stop]
+  uint64_t firstBlock = ceilDiv(start, blockDist);
+  uint64_t lastBlock = stop / blockDist;
+  lastBlock += (stop % blockDist == blockDist - 1);
+
+  if (firstBlock >= lastBlock)
+    return sieveCount(start, stop);
+
+  uint64_t count = 0;
+
+  {
+    unique_lock<mutex> guard(lock_);
+
+    if (!loaded_)
+      load();
+
+    size_t oldSize = counts_.size();
+
+    for (uint64_t i = firstBlock; i < lastBlock; i++)
+    {
+      auto iter = counts_.find(i);
+
+      if (iter == counts_.end())
+      {
+        uint64_t low = i * blockDist;
+        uint64_t blockCount = sieveCount(low, low + blockDist - 1);
+        iter = counts_.emplace(i, blockCount).first;
+      }
+
+      count += iter->second;
+    }
+
+    if (counts_.size() > oldSize)
+      save();
+  }
+
+  // residual subranges at the block boundaries
+  if (start < firstBlock * blockDist)
+    count += sieveCount(start, firstBlock * blockDist - 1);
+  if (stop >= lastBlock * blockDist)
+    count += sieveCount(lastBlock * blockDist, stop);
+
+  return count;
+}
+
+/// Load the block counts from the file pointed to by the
+/// PRIMESIEVE_COUNT_FILE environment variable. The first
+/// 64-bit word is the block distance, the file is ignored
+/// if it has been generated with a different one
+///
+void CountCache::load()
+{
+  loaded_ = true;
+  string filePath = getFilePath();
+  if (filePath.empty())
+    return;
+
+  ifstream file(filePath, ifstream::binary);
+  if (!file)
+    return;
+
+  uint64_t dist = 0;
+  file.read((char*) &dist, sizeof(dist));
+  if (!file || dist != blockDist)
+    return;
+
+  uint64_t block[2];
+  while (file.read((char*) block, sizeof(block)))
+    counts_[block[0]] = block[1];
+}
+
+void CountCache::save() const
+{
+  string filePath = getFilePath();
+  if (filePath.empty())
+    return;
+
+  string tmpFile = filePath + ".tmp";
+  ofstream file(tmpFile, ofstream::binary | ofstream::trunc);
+  if (!file)
+    return;
+
+  file.write((const char*) &blockDist, sizeof(blockDist));
+
+  for (const auto& block : counts_)
+  {
+    uint64_t pair[2] = { block.first, block.second };
+    file.write((const char*) pair, sizeof(pair));
+  }
+
+  file.close();
+  remove(filePath.c_str());
+  rename(tmpFile.c_str(), filePath.c_str());
+}
+
+} // namespace
@@ -0,0 +1,90 @@
+///
+/// @file   CountIntervals.cpp
+/// @brief  Count the primes in many intervals with one sieving
+///         pass. The union of the intervals is sieved once and
+///         after each segment the prefix prime counts of the
+///         boundary points inside the segment are recorded,
+///         which amortizes the sieving and SievingPrimes
+///         initialization cost across all intervals.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/CountIntervals.hpp>
+#include <primesieve/Erat.hpp>
+#include <primesieve/pmath.hpp>
+#include <primesieve/PreSieve.hpp>
+#include <primesieve/SievingPrimes.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace primesieve {
+
+/// @points: sorted ascending boundary points <= stop
+CountIntervals::CountIntervals(uint64_t start,
+                               uint64_t stop,
+                               const vector<uint64_t>& points) :
+  preSieve_(start, stop),
+  points_(points),
+  counts_(points.size(), 0)
+{
+  Erat::init(start, stop, get_sieve_size(), preSieve_);
+
+  // primes are counted while sieving (during the last
+  // cross-off pass of each segment) which avoids a second
+  // pass over the cache-cold sieve array
+  fusedCount_ = &count_;
+}
+
+void CountIntervals::sieve()
+{
+  // boundary points below the sieving
+  // range contain no primes >= start
+  while (index_ < points_.size() && points_[index_] < start_)
+    counts_[index_++] = 0;
+
+  SievingPrimes sievingPrimes(this, preSieve_);
+  uint64_t prime = sievingPrimes.next();
+
+  while (hasNextSegment())
+  {
+    low_ = segmentLow_;
+    uint64_t sqrtHigh = isqrt(segmentHigh_);
+
+    for (; prime <= sqrtHigh; prime = sievingPrimes.next())
+      addSievingPrime(prime);
+
+    // the prefix count of a boundary point needs the
+    // total before the current segment, count_ is
+    // updated while sieving (fused counting)
+    uint64_t prevCount = count_;
+    sieveSegment();
+    updateCounts(prevCount);
+  }
+
+  // boundary points > stop see all primes
+  for (; index_ < points_.size(); index_++)
+    counts_[index_] = count_;
+}
+
+/// Record the prefix prime counts of the boundary
+/// points inside the sieved segment
+///
+void CountIntervals::updateCounts(uint64_t prevCount)
+{
+  uint64_t high = checkedAdd(low_, sieveSize_ * 30 - 1);
+  high = min(high, stop_);
+
+  for (; index_ < points_.size() && points_[index_] <= high; index_++)
+    counts_[index_] = prevCount + countSieve(low_, points_[index_]);
+}
+
+} // namespace
@@ -0,0 +1,117 @@
+///
+/// @file   CountResidues.cpp
+/// @brief  Count the primes ≡ a (mod q) inside [start, stop]
+///         directly on the sieve bitmap. Filtering iterator
+///         output by modulus materializes every prime for a
+///         1/phi(q) yield, here the bits of the wanted residue
+///         class are counted with one table lookup per sieve
+///         byte (8 flags per 30 numbers), so the per segment
+///         cost is independent of q.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/CountResidues.hpp>
+#include <primesieve/Erat.hpp>
+#include <primesieve/pmath.hpp>
+#include <primesieve/PreSieve.hpp>
+#include <primesieve/SievingPrimes.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+namespace primesieve {
+
+CountResidues::CountResidues(uint64_t start,
+                             uint64_t stop,
+                             uint64_t q,
+                             uint64_t a) :
+  preSieve_(start, stop),
+  q_(q)
+{
+  Erat::init(start, stop, get_sieve_size(), preSieve_);
+  initCounts(a);
+}
+
+/// Build the per byte count tables. The byte at base (with
+/// base % 30 == 0) has 8 bits for the numbers base +
+/// { 7, 11, 13, 17, 19, 23, 29, 31 }, whose residues mod q
+/// only depend on r = base % q: the bits ≡ a (mod q) are
+/// selected by a mask per r and the count of selected 1 bits
+/// is tabulated for all 256 byte values
+///
+void CountResidues::initCounts(uint64_t a)
+{
+  const uint64_t bitValues[8] = { 7, 11, 13, 17, 19, 23, 29, 31 };
+
+  // the tables use q * 256 bytes, count_primes_mod() routes
+  // larger moduli to prime filtering (see api.cpp)
+  assert(q_ > 0 && q_ <= (1 << 16));
+  residueCounts_.resize(q_ * 256);
+
+  for (uint64_t r = 0; r < q_; r++)
+  {
+    uint64_t mask = 0;
+    for (uint64_t j = 0; j < 8; j++)
+      if ((r + bitValues[j]) % q_ == a)
+        mask |= 1ull << j;
+
+    for (uint64_t byte = 0; byte <= 255; byte++)
+    {
+      uint64_t bits = byte & mask;
+      byte_t count = 0;
+      for (; bits != 0; bits &= bits - 1)
+        count++;
+      residueCounts_[r * 256 + byte] = count;
+    }
+  }
+}
+
+void CountResidues::sieve()
+{
+  SievingPrimes sievingPrimes(this, preSieve_);
+  uint64_t prime = sievingPrimes.next();
+
+  while (hasNextSegment())
+  {
+    low_ = segmentLow_;
+    uint64_t sqrtHigh = isqrt(segmentHigh_);
+
+    for (; prime <= sqrtHigh; prime = sievingPrimes.next())
+      addSievingPrime(prime);
+
+    // bits < start (first segment) and bits > stop
+    // (last segment) have already been unset
+    sieveSegment();
+    countSegment();
+  }
+}
+
+/// Count the 1 bits of the wanted residue class with one
+/// table lookup per sieve byte
+///
+void CountResidues::countSegment()
+{
+  // the byte base advances by 30 per byte, so its
+  // residue r advances by 30 % q (with wrap around)
+  uint64_t r = low_ % q_;
+  uint64_t step = 30 % q_;
+  const byte_t* counts = residueCounts_.data();
+
+  for (uint64_t i = 0; i < sieveSize_; i++)
+  {
+    count_ += counts[r * 256 + sieve_[i]];
+    r += step;
+    if (r >= q_)
+      r -= q_;
+  }
+}
+
+} // namespace
@@ -0,0 +1,109 @@
+///
+/// @file   CountSieve.cpp
+/// @brief  Count the primes inside [start, stop] without any
+///         printing or k-tuplet infrastructure. The 1 bits are
+///         counted while sieving (during the last cross-off
+///         pass of each segment, see Erat's fusedCount_), hence
+///         the only per segment work besides the cross-off
+///         passes is an optional status update.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve/AsyncSievingPrimes.hpp>
+#include <primesieve/CountSieve.hpp>
+#include <primesieve/pmath.hpp>
+#include <primesieve/PreSieve.hpp>
+#include <primesieve/PrimeSieve.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace primesieve {
+
+CountSieve::CountSieve(PrimeSieve& ps) :
+  preSieve_(ps.getStart(), ps.getStop()),
+  ps_(ps)
+{
+  uint64_t start = max<uint64_t>(7, ps.getStart());
+  uint64_t stop = ps.getStop();
+  uint64_t sieveSize = ps.getSieveSize();
+
+  Erat::init(start, stop, sieveSize, preSieve_);
+  fusedCount_ = &ps.getCounts()[0];
+}
+
+void CountSieve::sieve()
+{
+  const uint64_t* primes = ps_.getSievingPrimes();
+
+  if (primes)
+  {
+    // precomputed read-only sieving prime table, shared
+    // across the worker threads of a ParallelSieve or
+    // memory-mapped from a snapshot file, see
+    // set_sieving_primes_file(). The primes <= preSieve
+    // maxPrime are skipped, their multiples have already
+    // been removed by pre-sieving
+    const PrimeReciprocal* recips = ps_.getSievingPrimeRecips();
+    uint64_t size = ps_.getNumSievingPrimes();
+    uint64_t i = 0;
+
+    while (i < size && primes[i] <= preSieve_.getMaxPrime())
+      i++;
+
+    // checking the cancel flag once per segment gives
+    // cancellation (cancelSieve()) segment granularity
+    // instead of chunk granularity
+    while (hasNextSegment() &&
+           !ps_.isCanceled())
+    {
+      uint64_t sqrtHigh = isqrt(segmentHigh_);
+
+      for (; i < size && primes[i] <= sqrtHigh; i++)
+      {
+        // the shared reciprocals replace the per prime
+        // division of the first multiple computation
+        if (recips)
+          addSievingPrime(primes[i], recips[i]);
+        else
+          addSievingPrime(primes[i]);
+      }
+
+      sieveSegment();
+
+      if (ps_.isStatus())
+        ps_.updateStatus(sieveSize_ * 30);
+    }
+  }
+  else
+  {
+    // for large sqrt(stop) the sieving primes are produced
+    // on a background thread, overlapped with the main
+    // sieving below (see AsyncSievingPrimes.cpp)
+    AsyncSievingPrimes sievingPrimes(this, preSieve_);
+    uint64_t prime = sievingPrimes.next();
+
+    while (hasNextSegment() &&
+           !ps_.isCanceled())
+    {
+      uint64_t sqrtHigh = isqrt(segmentHigh_);
+
+      for (; prime <= sqrtHigh; prime = sievingPrimes.next())
+        addSievingPrime(prime);
+
+      sieveSegment();
+
+      if (ps_.isStatus())
+        ps_.updateStatus(sieveSize_ * 30);
+    }
+  }
+}
+
+} // namespace
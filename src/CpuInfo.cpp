@@ -1,6 +1,13 @@
 ///
 /// @file   CpuInfo.cpp
-/// @brief  Get the CPUs' cache sizes in bytes
+/// @brief  Get the CPUs' cache sizes in bytes. The detection
+///         runs lazily on the first query instead of at static
+///         init, on x86 the cache topology is read from CPUID
+///         (a few instructions) instead of sysfs and the
+///         result can be persisted to a per-host file via the
+///         PRIMESIEVE_CPU_FILE environment variable (same
+///         mechanism as PRIMESIEVE_TUNE_FILE), so short-lived
+///         runs skip the sysfs/sysctl reads entirely.
 ///
 /// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
 ///
@@ -10,9 +17,63 @@
 
 #include <primesieve/CpuInfo.hpp>
 
+#include <stdint.h>
 #include <cstddef>
+#include <cstdio>
+#include <cstdlib>
 #include <exception>
+#include <fstream>
+#include <sstream>
 #include <string>
+#include <vector>
+
+#if defined(__linux__)
+  #include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || \
+    defined(_M_X64) || defined(_M_IX86)
+  #define HAS_CPUID
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+    #include <immintrin.h>
+  #endif
+#endif
+
+#if defined(HAS_CPUID)
+
+namespace {
+
+void runCpuid(int eax, int ecx, int* abcd)
+{
+#if defined(_MSC_VER)
+  __cpuidex(abcd, eax, ecx);
+#else
+  __asm__ ("cpuid"
+           : "=a" (abcd[0]), "=b" (abcd[1]),
+             "=c" (abcd[2]), "=d" (abcd[3])
+           : "a" (eax), "c" (ecx));
+#endif
+}
+
+/// Get the value of the extended control register,
+/// used to check OS support for AVX2 and AVX-512
+///
+uint64_t getXcr0()
+{
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  uint32_t eax;
+  uint32_t edx;
+  __asm__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+  return eax | ((uint64_t) edx << 32);
+#endif
+}
+
+} // namespace
+
+#endif
 
 #if defined(__APPLE__)
   #if !defined(__has_include)
@@ -26,23 +87,53 @@
 #if defined(_WIN32)
 
 #include <windows.h>
-#include <vector>
 
 #elif defined(APPLE_SYSCTL)
 
 #include <sys/types.h>
 #include <sys/sysctl.h>
-#include <vector>
 
-#else // all other OSes
-
-#include <fstream>
-#include <sstream>
+#endif
 
 using namespace std;
 
 namespace {
 
+/// Expand a sysfs CPU list into the CPU numbers
+/// it contains, e.g. "0-3,8" -> { 0, 1, 2, 3, 8 }
+///
+vector<size_t> parseCpuList(const string& cpuList)
+{
+  vector<size_t> cpus;
+  istringstream tokens(cpuList);
+  string token;
+
+  while (getline(tokens, token, ','))
+  {
+    size_t pos = token.find('-');
+
+    if (pos == string::npos)
+      cpus.push_back(stol(token));
+    else
+    {
+      size_t first = stol(token.substr(0, pos));
+      size_t last = stol(token.substr(pos + 1));
+
+      for (size_t cpu = first; cpu <= last; cpu++)
+        cpus.push_back(cpu);
+    }
+  }
+
+  return cpus;
+}
+
+} // namespace
+
+#if !defined(_WIN32) && \
+    !defined(APPLE_SYSCTL)
+
+namespace {
+
 string getString(const string& filename)
 {
   ifstream file(filename);
@@ -59,6 +150,29 @@ string getString(const string& filename)
   return str;
 }
 
+/// Count the CPUs in a sysfs CPU list,
+/// e.g. "0-3,8-11" contains 8 CPUs
+///
+size_t countCpus(const string& cpuList)
+{
+  size_t cpus = 0;
+  istringstream tokens(cpuList);
+  string token;
+
+  while (getline(tokens, token, ','))
+  {
+    size_t pos = token.find('-');
+
+    if (pos == string::npos)
+      cpus += 1;
+    else
+      cpus += stol(token.substr(pos + 1)) -
+              stol(token.substr(0, pos)) + 1;
+  }
+
+  return cpus;
+}
+
 size_t getValue(const string& filename)
 {
   size_t val = 0;
@@ -87,18 +201,32 @@ size_t getValue(const string& filename)
 
 #endif
 
-using namespace std;
-
 namespace primesieve {
 
-CpuInfo::CpuInfo()
-  : l1CacheSize_(0),
-    l2CacheSize_(0),
-    privateL2Cache_(false)
+/// The CPU topology is detected on first use: the per-host
+/// cache file (if any) is tried first, then CPUID on x86,
+/// the OS specific cache queries only run as a last resort
+///
+CpuInfo::CpuData::CpuData()
 {
   try
   {
-    init();
+    initIsa();
+
+    const char* path = getenv("PRIMESIEVE_CPU_FILE");
+
+    if (path && loadFile(path))
+      return;
+
+#if defined(HAS_CPUID)
+    if (!initCpuid())
+#endif
+      initCache();
+
+    initNuma();
+
+    if (path)
+      saveFile(path);
   }
   catch (exception& e)
   {
@@ -106,41 +234,357 @@ CpuInfo::CpuInfo()
   }
 }
 
+/// Detect the instruction set extensions supported by both
+/// the CPU and the operating system. The hot loops query
+/// these flags once at startup and route to their fastest
+/// compiled variant.
+///
+void CpuInfo::CpuData::initIsa()
+{
+#if defined(HAS_CPUID)
+  int abcd[4];
+
+  runCpuid(0, 0, abcd);
+  if (abcd[0] < 7)
+    return;
+
+  runCpuid(7, 0, abcd);
+  uint32_t ebx7 = abcd[1];
+  uint32_t ecx7 = abcd[2];
+  uint32_t edx7 = abcd[3];
+  bmi2_ = (ebx7 >> 8) & 1;
+
+  // CPUs with a mix of performance and
+  // efficiency cores, e.g. Alder Lake
+  hybrid_ = (edx7 >> 15) & 1;
+
+  runCpuid(1, 0, abcd);
+  bool osxsave = (abcd[2] >> 27) & 1;
+  if (!osxsave)
+    return;
+
+  uint64_t xcr0 = getXcr0();
+  bool ymm = (xcr0 & 0x06) == 0x06;
+  bool zmm = (xcr0 & 0xe6) == 0xe6;
+
+  avx2_ = ymm && ((ebx7 >> 5) & 1);
+  avx512_ = zmm && ((ebx7 >> 16) & 1);
+  avx512vpopcnt_ = avx512_ && ((ecx7 >> 14) & 1);
+
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+  neon_ = true;
+#endif
+}
+
+#if defined(HAS_CPUID)
+
+/// Read the cache topology from the deterministic cache
+/// parameters CPUID leaf (4 on Intel, 0x8000001d on AMD)
+/// instead of sysfs files, a few instructions instead of
+/// multiple file reads.
+/// @return true if an L1 and an L2 data cache were found
+///
+bool CpuInfo::CpuData::initCpuid()
+{
+  int abcd[4];
+  runCpuid(0, 0, abcd);
+  int maxLeaf = abcd[0];
+
+  // "AuthenticAMD" (ebx, edx, ecx)
+  bool amd = abcd[1] == 0x68747541 &&
+             abcd[3] == 0x69746e65 &&
+             abcd[2] == 0x444d4163;
+
+  int cacheLeaf = 4;
+
+  if (amd)
+  {
+    runCpuid((int) 0x80000000u, 0, abcd);
+    if ((uint32_t) abcd[0] < 0x8000001d)
+      return false;
+    cacheLeaf = (int) 0x8000001du;
+  }
+  else if (maxLeaf < 4)
+    return false;
+
+  for (int i = 0; i < 16; i++)
+  {
+    runCpuid(cacheLeaf, i, abcd);
+    uint32_t eax = (uint32_t) abcd[0];
+    uint32_t ebx = (uint32_t) abcd[1];
+    uint32_t ecx = (uint32_t) abcd[2];
+
+    // no more caches
+    uint32_t type = eax & 0x1f;
+    if (type == 0)
+      break;
+
+    // data or unified cache
+    if (type == 1 ||
+        type == 3)
+    {
+      uint32_t level = (eax >> 5) & 0x7;
+      size_t ways = ((ebx >> 22) & 0x3ff) + 1;
+      size_t partitions = ((ebx >> 12) & 0x3ff) + 1;
+      size_t lineSize = (ebx & 0xfff) + 1;
+      size_t sets = (size_t) ecx + 1;
+      size_t size = ways * partitions * lineSize * sets;
+
+      if (level == 1)
+        l1CacheSize_ = size;
+      if (level == 2)
+      {
+        l2CacheSize_ = size;
+        // logical CPU cores sharing the cache
+        l2Sharing_ = ((eax >> 14) & 0xfff) + 1;
+      }
+    }
+  }
+
+  bool valid = l1CacheSize_ >= (1 << 12) &&
+               l1CacheSize_ <= (1 << 30) &&
+               l2CacheSize_ >= (1 << 12) &&
+               l2CacheSize_ <= (1 << 30);
+  if (!valid)
+  {
+    l1CacheSize_ = 0;
+    l2CacheSize_ = 0;
+    l2Sharing_ = 0;
+    return false;
+  }
+
+  // SMT threads per physical CPU core
+  // from the x2APIC topology leaf
+  if (maxLeaf >= 11)
+  {
+    runCpuid(11, 0, abcd);
+    uint32_t levelType = ((uint32_t) abcd[2] >> 8) & 0xff;
+    uint32_t logical = (uint32_t) abcd[1] & 0xffff;
+    if (levelType == 1 && logical > 0)
+      threadsPerCore_ = logical;
+  }
+
+  // the L2 cache is private if it is
+  // tied to a physical CPU core
+  if (threadsPerCore_)
+    privateL2Cache_ = (l2Sharing_ <= threadsPerCore_);
+
+  return true;
+}
+
+#endif
+
+/// Load the CPU topology from the per-host cache file
+/// written by saveFile(). Invalid or truncated files are
+/// silently ignored and the topology is re-detected
+///
+bool CpuInfo::CpuData::loadFile(const char* path)
+{
+  ifstream file(path);
+  if (!file)
+    return false;
+
+  size_t l1 = 0;
+  size_t l2 = 0;
+  size_t sharing = 0;
+  size_t threads = 0;
+  size_t privateL2 = 0;
+  bool hasL1Key = false;
+  bool hasL2Key = false;
+  vector<vector<size_t>> numa;
+  string key;
+  string value;
+
+  try
+  {
+    while (file >> key >> value)
+    {
+      if (key == "l1CacheSize") { l1 = stoul(value); hasL1Key = true; }
+      else if (key == "l2CacheSize") { l2 = stoul(value); hasL2Key = true; }
+      else if (key == "l2Sharing") sharing = stoul(value);
+      else if (key == "threadsPerCore") threads = stoul(value);
+      else if (key == "privateL2Cache") privateL2 = stoul(value);
+      else if (key == "numaNodeCpus") numa.push_back(parseCpuList(value));
+      else return false;
+    }
+  }
+  catch (exception&)
+  {
+    return false;
+  }
+
+  if (!hasL1Key ||
+      !hasL2Key)
+    return false;
+
+  l1CacheSize_ = l1;
+  l2CacheSize_ = l2;
+  l2Sharing_ = sharing;
+  threadsPerCore_ = threads;
+  privateL2Cache_ = (privateL2 != 0);
+  numaNodeCpus_ = numa;
+
+  return true;
+}
+
+/// Persist the detected CPU topology so that later runs on
+/// this host skip the detection, write errors are silently
+/// ignored (same .tmp + rename scheme as save_tuning)
+///
+void CpuInfo::CpuData::saveFile(const char* path) const
+{
+  string tmpFile = string(path) + ".tmp";
+  ofstream file(tmpFile, ofstream::trunc);
+  if (!file)
+    return;
+
+  file << "l1CacheSize " << l1CacheSize_ << "\n";
+  file << "l2CacheSize " << l2CacheSize_ << "\n";
+  file << "l2Sharing " << l2Sharing_ << "\n";
+  file << "threadsPerCore " << threadsPerCore_ << "\n";
+  file << "privateL2Cache " << (privateL2Cache_ ? 1 : 0) << "\n";
+
+  for (const auto& cpus : numaNodeCpus_)
+  {
+    file << "numaNodeCpus ";
+    for (size_t i = 0; i < cpus.size(); i++)
+      file << (i ? "," : "") << cpus[i];
+    file << "\n";
+  }
+
+  file.close();
+  std::remove(path);
+  std::rename(tmpFile.c_str(), path);
+}
+
+/// The singleton is created on first use (thread-safe magic
+/// static): runs that never query the CPU topology skip the
+/// detection entirely and nothing runs before main()
+///
+const CpuInfo::CpuData& CpuInfo::data()
+{
+  static const CpuData cpuData;
+  return cpuData;
+}
+
+bool CpuInfo::hasAVX2() const
+{
+  return data().avx2_;
+}
+
+bool CpuInfo::hasAVX512() const
+{
+  return data().avx512_;
+}
+
+bool CpuInfo::hasAVX512VPOPCNT() const
+{
+  return data().avx512vpopcnt_;
+}
+
+bool CpuInfo::hasBMI2() const
+{
+  return data().bmi2_;
+}
+
+bool CpuInfo::hasNEON() const
+{
+  return data().neon_;
+}
+
+bool CpuInfo::hasHybridCores() const
+{
+  return data().hybrid_;
+}
+
 size_t CpuInfo::l1CacheSize() const
 {
-  return l1CacheSize_;
+  return data().l1CacheSize_;
 }
 
 size_t CpuInfo::l2CacheSize() const
 {
-  return l2CacheSize_;
+  return data().l2CacheSize_;
+}
+
+/// Number of logical CPU cores sharing the L2 cache,
+/// 0 if unknown
+///
+size_t CpuInfo::l2Sharing() const
+{
+  return data().l2Sharing_;
+}
+
+/// Number of logical CPU cores per physical CPU core,
+/// 0 if unknown
+///
+size_t CpuInfo::threadsPerCore() const
+{
+  return data().threadsPerCore_;
+}
+
+/// Number of NUMA memory nodes, 0 if unknown
+size_t CpuInfo::numaNodes() const
+{
+  return data().numaNodeCpus_.size();
+}
+
+/// The logical CPU cores of the given NUMA node
+const vector<size_t>& CpuInfo::numaNodeCpus(size_t node) const
+{
+  return data().numaNodeCpus_[node];
+}
+
+/// NUMA node of the CPU the calling
+/// thread runs on, 0 if unknown
+///
+size_t CpuInfo::currentNumaNode() const
+{
+#if defined(__linux__)
+  const auto& numaNodeCpus = data().numaNodeCpus_;
+
+  if (numaNodeCpus.size() > 1)
+  {
+    int cpu = sched_getcpu();
+
+    if (cpu >= 0)
+      for (size_t node = 0; node < numaNodeCpus.size(); node++)
+        for (size_t nodeCpu : numaNodeCpus[node])
+          if (nodeCpu == (size_t) cpu)
+            return node;
+  }
+#endif
+
+  return 0;
 }
 
 bool CpuInfo::privateL2Cache() const
 {
-  return privateL2Cache_;
+  return data().privateL2Cache_;
 }
 
 string CpuInfo::getError() const
 {
-  return error_;
+  return data().error_;
 }
 
 bool CpuInfo::hasL1Cache() const
 {
-  return l1CacheSize_ >= (1 << 12) &&
-         l1CacheSize_ <= (1 << 30);
+  size_t l1CacheSize = data().l1CacheSize_;
+  return l1CacheSize >= (1 << 12) &&
+         l1CacheSize <= (1 << 30);
 }
 
 bool CpuInfo::hasL2Cache() const
 {
-  return l2CacheSize_ >= (1 << 12) &&
-         l2CacheSize_ <= (1 << 30);
+  size_t l2CacheSize = data().l2CacheSize_;
+  return l2CacheSize >= (1 << 12) &&
+         l2CacheSize <= (1 << 30);
 }
 
 #if defined(APPLE_SYSCTL)
 
-void CpuInfo::init()
+void CpuInfo::CpuData::initCache()
 {
   size_t l1Length = sizeof(l1CacheSize_);
   size_t l2Length = sizeof(l2CacheSize_);
@@ -160,6 +604,7 @@ void CpuInfo::init()
       // https://developer.apple.com/library/content/releasenotes/Performance/RN-AffinityAPI/index.html
       sysctlbyname("hw.cacheconfig" , &cacheconfig[0], &size, NULL, 0);
       size_t l2Sharing = cacheconfig[2];
+      l2Sharing_ = l2Sharing;
 
       if (l2Sharing <= 1)
         privateL2Cache_ = true;
@@ -174,6 +619,7 @@ void CpuInfo::init()
         size = sizeof(size);
         sysctlbyname("hw.physicalcpu", &physicalcpu, &size, NULL, 0);
         physicalcpu = max<size_t>(1, physicalcpu);
+        threadsPerCore_ = logicalcpu / physicalcpu;
 
         if (l2Sharing <= logicalcpu / physicalcpu)
           privateL2Cache_ = true;
@@ -182,9 +628,12 @@ void CpuInfo::init()
   }
 }
 
+void CpuInfo::CpuData::initNuma()
+{ }
+
 #elif defined(_WIN32)
 
-void CpuInfo::init()
+void CpuInfo::CpuData::initCache()
 {
   typedef BOOL (WINAPI *LPFN_GLPI)(PSYSTEM_LOGICAL_PROCESSOR_INFORMATION, PDWORD);
 
@@ -217,6 +666,8 @@ void CpuInfo::init()
       // current physical CPU core
       for (threadsPerCore = 0; mask > 0; threadsPerCore++)
         mask &= mask - 1;
+
+      threadsPerCore_ = threadsPerCore;
     }
 
     if (info[i].Relationship == RelationCache &&
@@ -283,6 +734,8 @@ void CpuInfo::init()
       for (; mask > 0; l2Sharing++)
         mask &= mask - 1;
 
+      l2Sharing_ = l2Sharing;
+
       // the L2 cache is private if it is tied to a physical CPU core
       privateL2Cache_ = (l2Sharing <= threadsPerCore);
 
@@ -293,12 +746,15 @@ void CpuInfo::init()
 #endif
 }
 
+void CpuInfo::CpuData::initNuma()
+{ }
+
 #else
 
 /// This works on Linux and Android. We also use this
 /// for all unknown OSes, it might work.
 ///
-void CpuInfo::init()
+void CpuInfo::CpuData::initCache()
 {
   for (int i = 0; i <= 3; i++)
   {
@@ -328,6 +784,11 @@ void CpuInfo::init()
       sharedCpuList = getString(sharedCpuList);
       threadSiblingsList = getString(threadSiblingsList);
 
+      if (!sharedCpuList.empty())
+        l2Sharing_ = countCpus(sharedCpuList);
+      if (!threadSiblingsList.empty())
+        threadsPerCore_ = countCpus(threadSiblingsList);
+
       // https://lwn.net/Articles/254445/
       if (!sharedCpuList.empty() &&
           sharedCpuList == threadSiblingsList)
@@ -336,6 +797,24 @@ void CpuInfo::init()
   }
 }
 
+/// NUMA topology, on multi-socket systems memory
+/// allocated by a thread is served from the node
+/// the thread runs on (first touch policy)
+///
+void CpuInfo::CpuData::initNuma()
+{
+  for (int node = 0; ; node++)
+  {
+    string filename = "/sys/devices/system/node/node" + to_string(node) + "/cpulist";
+    string cpuList = getString(filename);
+
+    if (cpuList.empty())
+      break;
+
+    numaNodeCpus_.push_back(parseCpuList(cpuList));
+  }
+}
+
 #endif
 
 /// Singleton
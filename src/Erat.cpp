@@ -9,25 +9,40 @@
 /// file in the top level directory.
 ///
 
-#include <primesieve/config.hpp>
+#include <primesieve.hpp>
 #include <primesieve/Erat.hpp>
 #include <primesieve/EratSmall.hpp>
 #include <primesieve/EratMedium.hpp>
 #include <primesieve/EratBig.hpp>
 #include <primesieve/PreSieve.hpp>
+#include <primesieve/allocator.hpp>
+#include <primesieve/hugepages.hpp>
 #include <primesieve/pmath.hpp>
 #include <primesieve/primesieve_error.hpp>
+#include <primesieve/ThreadPool.hpp>
 
 #include <stdint.h>
 #include <array>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <thread>
 
 using namespace std;
 using namespace primesieve;
 
 namespace {
 
+/// Current time in seconds, used for
+/// the per-phase sieving stats
+///
+double getTime()
+{
+  auto now = chrono::system_clock::now();
+  return chrono::duration<double>(now.time_since_epoch()).count();
+}
+
 /// unset bits < start
 const array<byte_t, 37> unsetSmaller =
 {
@@ -64,6 +79,21 @@ const array<uint64_t, 64> Erat::bruijnBitValues_ =
   173, 223, 193,  31, 221,  29,  23, 241
 };
 
+/// bitValues_[i] is the value of the i-th
+/// sieve array bit within its 64-bit word
+///
+const array<uint64_t, 64> Erat::bitValues_ =
+{
+    7,  11,  13,  17,  19,  23,  29,  31,
+   37,  41,  43,  47,  49,  53,  59,  61,
+   67,  71,  73,  77,  79,  83,  89,  91,
+   97, 101, 103, 107, 109, 113, 119, 121,
+  127, 131, 133, 137, 139, 143, 149, 151,
+  157, 161, 163, 167, 169, 173, 179, 181,
+  187, 191, 193, 197, 199, 203, 209, 211,
+  217, 221, 223, 227, 229, 233, 239, 241
+};
+
 Erat::Erat() { }
 
 Erat::Erat(uint64_t start, uint64_t stop) :
@@ -71,17 +101,27 @@ Erat::Erat(uint64_t start, uint64_t stop) :
   stop_(stop)
 { }
 
-Erat::~Erat() { }
+Erat::~Erat()
+{
+  deallocBytes(sieveAlloc_, sieveAllocBytes_);
+}
 
-/// @start:      Sieve primes >= start
-/// @stop:       Sieve primes <= stop
-/// @sieveSize:  Sieve size in kilobytes
-/// @preSieve:   Pre-sieve primes
+/// @start:           Sieve primes >= start
+/// @stop:            Sieve primes <= stop
+/// @sieveSize:       Sieve size in kilobytes
+/// @preSieve:        Pre-sieve primes
+/// @maxSievingPrime: Largest sieving prime that will be added,
+///                   isqrt(stop) (the default, passed as 0) for
+///                   ordinary sieving. Sieve128.cpp sieves in
+///                   number line offset coordinates where
+///                   isqrt(stop_) underestimates the sieving
+///                   primes of the 128-bit range and overrides it
 ///
 void Erat::init(uint64_t start,
                 uint64_t stop,
                 uint64_t sieveSize,
-                PreSieve& preSieve)
+                PreSieve& preSieve,
+                uint64_t maxSievingPrime)
 {
   if (start > stop)
     return;
@@ -98,10 +138,20 @@ void Erat::init(uint64_t start,
   uint64_t rem = byteRemainder(start);
   uint64_t dist = sieveSize_ * 30 + 6;
   segmentLow_ = start_ - rem;
+
+  // align the first segment to a 64 byte sieve row (1 byte
+  // maps 30 numbers). sieveSize_ is a multiple of 64 bytes
+  // so all following segments stay row aligned, hence the
+  // bulk scans over the sieve array (popcount, pre-sieving,
+  // vectorized k-tuplet matching) always process whole
+  // cache lines. The bits of the up to 63 extra lead-in
+  // bytes are zeroed in preSieve()
+  segmentLow_ -= segmentLow_ % (64 * 30);
+
   segmentHigh_ = checkedAdd(segmentLow_, dist);
   segmentHigh_ = min(segmentHigh_, stop);
 
-  initErat();
+  initErat(maxSievingPrime);
 }
 
 void Erat::initSieve(uint64_t sieveSize)
@@ -110,17 +160,24 @@ void Erat::initSieve(uint64_t sieveSize)
   sieveSize_ = inBetween(8, sieveSize_, 4096);
   sieveSize_ *= 1024;
 
-  sieve_ = new byte_t[sieveSize_];
-  deleter_.reset(sieve_);
+  // over-allocate so the sieve base can be aligned to
+  // 64 bytes, the allocator only guarantees 16 byte
+  // alignment on most platforms
+  sieveAllocBytes_ = sieveSize_ + 64;
+  sieveAlloc_ = allocBytes(sieveAllocBytes_);
+  uint64_t align = (uint64_t) (uintptr_t) sieveAlloc_ % 64;
+  sieve_ = sieveAlloc_ + (64 - align) % 64;
+  adviseHugePages(sieve_, sieveSize_);
 }
 
-void Erat::initErat()
+void Erat::initErat(uint64_t maxSievingPrime)
 {
-  uint64_t sqrtStop = isqrt(stop_);
+  uint64_t sqrtStop = maxSievingPrime ? maxSievingPrime : isqrt(stop_);
   uint64_t l1Size = EratSmall::getL1Size(sieveSize_);
+  Tuning tuning = get_tuning();
 
-  maxEratSmall_  = (uint64_t) (l1Size * config::FACTOR_ERATSMALL);
-  maxEratMedium_ = (uint64_t) (sieveSize_ * config::FACTOR_ERATMEDIUM);
+  maxEratSmall_  = (uint64_t) (l1Size * tuning.factorEratSmall);
+  maxEratMedium_ = (uint64_t) (sieveSize_ * tuning.factorEratMedium);
 
   if (sqrtStop > maxPreSieve_)
     eratSmall_.init(stop_, l1Size, maxEratSmall_);
@@ -128,6 +185,14 @@ void Erat::initErat()
     eratMedium_.init(stop_, sieveSize_, maxEratMedium_);
   if (sqrtStop > maxEratMedium_)
     eratBig_.init(stop_, sieveSize_, sqrtStop);
+
+  // the pipelined mode overlaps EratMedium and EratSmall,
+  // it needs both enabled and at least 2 stripes
+  stripeSize_ = l1Size;
+  pipelined_ = tuning.threadsPerSegment >= 2 &&
+               eratSmall_.enabled() &&
+               eratMedium_.enabled() &&
+               sieveSize_ > stripeSize_;
 }
 
 bool Erat::hasNextSegment() const
@@ -135,6 +200,24 @@ bool Erat::hasNextSegment() const
   return segmentLow_ < stop_;
 }
 
+/// All numbers inside [start_, segmentLow_ + 1] have been
+/// sieved (and counted via the fused count), so when the
+/// segment loop stops early due to cancellation the results
+/// are complete up to getSievedHigh(). The last byte of the
+/// previous segment maps the numbers up to its base + 31 =
+/// segmentLow_ + 1, and segmentLow_ + {2, ..., 6} are
+/// divisible by 2, 3 or 5
+///
+uint64_t Erat::getSievedHigh() const
+{
+  if (!hasNextSegment())
+    return stop_;
+  if (segmentLow_ > start_)
+    return segmentLow_ + 1;
+  // no segment has been sieved yet
+  return (start_ > 0) ? start_ - 1 : 0;
+}
+
 uint64_t Erat::byteRemainder(uint64_t n)
 {
   n %= 30;
@@ -147,26 +230,142 @@ uint64_t Erat::byteRemainder(uint64_t n)
 ///
 void Erat::preSieve()
 {
+  double time = getTime();
   preSieve_->copy(sieve_, sieveSize_, segmentLow_);
+  stats_.preSieveSeconds += getTime() - time;
 
-  // unset bits < start
+  // unset bits < start, the row alignment of the first
+  // segment (see init()) may put start up to 63 bytes
+  // into the sieve array
   if (segmentLow_ <= start_)
   {
-    if (start_ <= maxPreSieve_)
-      sieve_[0] = 0xff;
     uint64_t rem = byteRemainder(start_);
-    sieve_[0] &= unsetSmaller[rem];
+    uint64_t i = (start_ - rem - segmentLow_) / 30;
+    fill_n(sieve_, i, (byte_t) 0);
+    if (start_ <= maxPreSieve_)
+      sieve_[i] = 0xff;
+    sieve_[i] &= unsetSmaller[rem];
   }
 }
 
 void Erat::crossOff()
 {
-  if (eratSmall_.enabled())
-    eratSmall_.crossOff(sieve_, sieveSize_);
-  if (eratMedium_.enabled())
-    eratMedium_.crossOff(sieve_, sieveSize_);
+  // tasks running inside the thread pool must not
+  // submit nested jobs to it (risk of deadlock),
+  // e.g. the ParallelSieve chunk tasks sieve serially
+  if (pipelined_ &&
+      !ThreadPool::isWorkerThread())
+  {
+    crossOffPipelined();
+    return;
+  }
+
+  double time = getTime();
+
+  if (!fusedCount_)
+  {
+    if (eratSmall_.enabled())
+    {
+      eratSmall_.crossOff(sieve_, sieveSize_);
+      double now = getTime();
+      stats_.eratSmallSeconds += now - time;
+      time = now;
+    }
+    if (eratMedium_.enabled())
+    {
+      eratMedium_.crossOff(sieve_, sieveSize_);
+      double now = getTime();
+      stats_.eratMediumSeconds += now - time;
+      time = now;
+    }
+    if (eratBig_.enabled())
+    {
+      eratBig_.crossOff(sieve_);
+      stats_.eratBigSeconds += getTime() - time;
+    }
+  }
+  else
+  {
+    // The cross-off algorithms only clear bits hence their
+    // order does not matter. EratSmall streams the segment
+    // in L1 sized blocks, by running it last the 1 bits of
+    // each block can be counted while the block is still in
+    // the L1 cache, no second pass over the segment needed
+    if (eratMedium_.enabled())
+    {
+      eratMedium_.crossOff(sieve_, sieveSize_);
+      double now = getTime();
+      stats_.eratMediumSeconds += now - time;
+      time = now;
+    }
+    if (eratBig_.enabled())
+    {
+      eratBig_.crossOff(sieve_);
+      double now = getTime();
+      stats_.eratBigSeconds += now - time;
+      time = now;
+    }
+    if (eratSmall_.enabled())
+      eratSmall_.crossOff(sieve_, sieveSize_, fusedCount_);
+    else
+      *fusedCount_ += popcount((const uint64_t*) sieve_, ceilDiv(sieveSize_, 8));
+
+    stats_.eratSmallSeconds += getTime() - time;
+  }
+}
+
+/// Experimental 2-thread intra-segment mode, see
+/// Tuning::threadsPerSegment. The segment is split into L1
+/// sized stripes and EratMedium runs one stripe ahead of
+/// EratSmall on a second thread. The cross-off algorithms
+/// only clear bits so their order does not matter, and the
+/// stripe handoff (an atomic byte count published by the
+/// EratMedium task) keeps the two threads off the same
+/// bytes. EratBig cannot be striped because its bucket
+/// lists and multipleIndexes are relative to the whole
+/// segment, it runs upfront. EratSmall still runs last on
+/// each stripe so the fused counting reads the stripe
+/// while it is in the L1 cache.
+///
+void Erat::crossOffPipelined()
+{
+  double time = getTime();
+
   if (eratBig_.enabled())
+  {
     eratBig_.crossOff(sieve_);
+    stats_.eratBigSeconds += getTime() - time;
+  }
+
+  // sieve bytes crossed-off by EratMedium
+  std::atomic<uint64_t> sieved(0);
+
+  ThreadPool::getInstance().execute(2, [&](int i)
+  {
+    double t = getTime();
+
+    if (i == 0)
+    {
+      for (uint64_t low = 0; low < sieveSize_; low += stripeSize_)
+      {
+        uint64_t high = min(low + stripeSize_, sieveSize_);
+        eratMedium_.crossOff(&sieve_[low], high - low);
+        sieved.store(high, memory_order_release);
+      }
+      stats_.eratMediumSeconds += getTime() - t;
+    }
+    else
+    {
+      for (uint64_t low = 0; low < sieveSize_; low += stripeSize_)
+      {
+        uint64_t high = min(low + stripeSize_, sieveSize_);
+        while (sieved.load(memory_order_acquire) < high)
+          this_thread::yield();
+        eratSmall_.crossOff(&sieve_[low], high - low, fusedCount_);
+      }
+      stats_.eratSmallSeconds += getTime() - t;
+    }
+  });
 }
 
 void Erat::sieveSegment()
@@ -192,9 +391,11 @@ void Erat::sieveLastSegment()
   sieveSize_ = dist / 30 + 1;
 
   preSieve();
-  crossOff();
 
-  // unset bits > stop
+  // unset bits > stop, the cross-off algorithms only clear
+  // bits so this can be done before crossOff() which lets
+  // the fused counting see the correct last bytes
+
   sieve_[sieveSize_ - 1] &= unsetLarger[rem];
 
   // unset bytes > stop
@@ -202,7 +403,32 @@ void Erat::sieveLastSegment()
   bytes = (8 - bytes) % 8;
   fill_n(&sieve_[sieveSize_], bytes, 0);
 
+  crossOff();
+
   segmentLow_ = stop_;
 }
 
+/// Count the 1 bits (primes) <= n in the sieve array,
+/// @low: value corresponding to the first sieve byte
+///
+uint64_t Erat::countSieve(uint64_t low, uint64_t n) const
+{
+  if (n < low + 7)
+    return 0;
+
+  uint64_t rem = byteRemainder(n);
+  uint64_t i = (n - rem - low) / 30;
+  uint64_t count = popcount((const uint64_t*) sieve_, i / 8);
+
+  // gather the remaining < 8 bytes and the boundary byte
+  // (with its bits > n masked off) into one 64-bit word
+  uint64_t word = 0;
+  byte_t* bytes = (byte_t*) &word;
+  for (uint64_t j = i - i % 8; j < i; j++)
+    bytes[j % 8] = sieve_[j];
+  bytes[i % 8] = sieve_[i] & unsetLarger[rem];
+
+  return count + popcount(&word, 1);
+}
+
 } // namespace
@@ -12,9 +12,12 @@
 ///
 
 #include <primesieve/Bucket.hpp>
+#include <primesieve/BucketPool.hpp>
 #include <primesieve/config.hpp>
+#include <primesieve/CpuInfo.hpp>
 #include <primesieve/EratBig.hpp>
 #include <primesieve/pmath.hpp>
+#include <primesieve/prefetch.hpp>
 #include <primesieve/primesieve_error.hpp>
 #include <primesieve/types.hpp>
 #include <primesieve/Wheel.hpp>
@@ -22,13 +25,115 @@
 #include <stdint.h>
 #include <algorithm>
 #include <cassert>
-#include <memory>
 #include <vector>
 
+#if defined(__x86_64__) && \
+   (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+  #define HAS_AVX2_SKIP
+  #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+  #define HAS_NEON_SKIP
+  #include <arm_neon.h>
+#endif
+
 using namespace std;
+using namespace primesieve;
+
+namespace {
+
+/// Advance a block of 8 hot sieving primes whose next
+/// multiples are all outside the current segment.
+/// @return false if any multiple is inside the segment,
+///         the indexes are left unchanged in that case
+///
+bool skipBlockGeneric(uint32_t* indexes, uint32_t sieveSize)
+{
+  uint32_t maxIndex = SievingPrime::MAX_MULTIPLEINDEX;
+
+  for (int i = 0; i < 8; i++)
+    if ((indexes[i] & maxIndex) < sieveSize)
+      return false;
+
+  // multipleIndex >= sieveSize in all 8 entries, subtracting
+  // sieveSize cannot borrow into the wheelIndex bits
+  for (int i = 0; i < 8; i++)
+    indexes[i] -= sieveSize;
+
+  return true;
+}
+
+#if defined(HAS_AVX2_SKIP)
+
+/// AVX2 version of skipBlockGeneric(), a single 256-bit
+/// load tests the 8 packed multipleIndexes at once
+///
+__attribute__((target("avx2")))
+bool skipBlockAvx2(uint32_t* indexes, uint32_t sieveSize)
+{
+  __m256i v = _mm256_loadu_si256((const __m256i*) indexes);
+  __m256i maxIndex = _mm256_set1_epi32(SievingPrime::MAX_MULTIPLEINDEX);
+  __m256i size = _mm256_set1_epi32((int32_t) sieveSize);
+
+  // multipleIndex < 2^23 and sieveSize <= 2^22,
+  // hence the signed compare is exact
+  __m256i hits = _mm256_cmpgt_epi32(size, _mm256_and_si256(v, maxIndex));
+
+  if (!_mm256_testz_si256(hits, hits))
+    return false;
+
+  _mm256_storeu_si256((__m256i*) indexes, _mm256_sub_epi32(v, size));
+  return true;
+}
+
+#elif defined(HAS_NEON_SKIP)
+
+/// NEON version of skipBlockGeneric(), two 128-bit
+/// loads test the 8 packed multipleIndexes at once
+///
+bool skipBlockNeon(uint32_t* indexes, uint32_t sieveSize)
+{
+  uint32x4_t lo = vld1q_u32(indexes);
+  uint32x4_t hi = vld1q_u32(indexes + 4);
+  uint32x4_t maxIndex = vdupq_n_u32(SievingPrime::MAX_MULTIPLEINDEX);
+  uint32x4_t size = vdupq_n_u32(sieveSize);
+
+  uint32x4_t hits = vorrq_u32(vcltq_u32(vandq_u32(lo, maxIndex), size),
+                              vcltq_u32(vandq_u32(hi, maxIndex), size));
+
+  uint32x2_t any = vorr_u32(vget_low_u32(hits), vget_high_u32(hits));
+  any = vpmax_u32(any, any);
+
+  if (vget_lane_u32(any, 0))
+    return false;
+
+  vst1q_u32(indexes, vsubq_u32(lo, size));
+  vst1q_u32(indexes + 4, vsubq_u32(hi, size));
+  return true;
+}
+
+#endif
+
+bool skipBlock(uint32_t* indexes, uint32_t sieveSize)
+{
+#if defined(HAS_AVX2_SKIP)
+  if (cpuInfo.hasAVX2())
+    return skipBlockAvx2(indexes, sieveSize);
+#elif defined(HAS_NEON_SKIP)
+  if (cpuInfo.hasNEON())
+    return skipBlockNeon(indexes, sieveSize);
+#endif
+  return skipBlockGeneric(indexes, sieveSize);
+}
+
+} // namespace
 
 namespace primesieve {
 
+EratBig::~EratBig()
+{
+  BucketPool::freeChunks(chunks_);
+}
+
 /// @stop:       Upper bound for sieving
 /// @sieveSize:  Sieve size in bytes
 /// @maxPrime:   Sieving primes <= maxPrime
@@ -45,6 +150,30 @@ void EratBig::init(uint64_t stop, uint64_t sieveSize, uint64_t maxPrime)
   moduloSieveSize_ = sieveSize - 1;
   stock_ = nullptr;
 
+  // Sieving primes <= hotMaxPrime_ have a multiple every
+  // 1 to 2 segments, they are kept in the dense hot_ array
+  // and processed linearly instead of being moved through
+  // the bucket lists once per multiple
+  uint64_t maxFactor = getMaxFactor();
+  uint64_t maxIndex = SievingPrime::MAX_MULTIPLEINDEX;
+  uint64_t hotMaxPrime = (uint64_t) (sieveSize * config::FACTOR_ERATBIG_HOT);
+
+  // the multipleIndex of a hot prime is relative to the
+  // current segment and may point into the next segment,
+  // it must fit into SievingPrime's 23 index bits:
+  // sieveSize - 1 + sievingPrime * maxFactor + maxFactor <= maxIndex
+  if (maxIndex > sieveSize + maxFactor)
+  {
+    uint64_t maxSievingPrime = (maxIndex + 1 - sieveSize - maxFactor) / maxFactor;
+    hotMaxPrime = min(hotMaxPrime, maxSievingPrime * 30);
+  }
+  else
+    hotMaxPrime = 0;
+
+  hotMaxPrime_ = min(hotMaxPrime, maxPrime);
+  hotIndexes_.reserve(primeCountApprox(hotMaxPrime_));
+  hotPrimes_.reserve(primeCountApprox(hotMaxPrime_));
+
   Wheel::init(stop, sieveSize);
   init(sieveSize);
 }
@@ -57,9 +186,29 @@ void EratBig::init(uint64_t sieveSize)
   uint64_t maxSegmentCount  = maxMultipleIndex >> log2SieveSize_;
   uint64_t size = maxSegmentCount + 1;
 
-  // EratBig uses up to 1.6 gigabytes of memory
-  uint64_t maxBytes = (1u << 30) * 2;
-  memory_.reserve(maxBytes / config::BYTES_PER_ALLOC);
+  // The number of segments covered by one supersegment is
+  // the largest window whose multipleIndexes (relative to
+  // the window's first segment) still fit into SievingPrime's
+  // 23 index bits. For huge stop numbers the segment count
+  // far exceeds this window: instead of one (mostly empty)
+  // bucket list per segment we then keep one list per
+  // segment inside the window plus one 2nd-level list per
+  // supersegment, whose primes are distributed into the
+  // window when their supersegment begins.
+  uint64_t superSpan = ((uint64_t) SievingPrime::MAX_MULTIPLEINDEX + 1) >> log2SieveSize_;
+  currentSegment_ = 0;
+
+  if (size <= superSpan)
+    superSpan_ = 0;
+  else
+  {
+    superSpan_ = superSpan;
+    size = superSpan;
+    uint64_t superCount = maxSegmentCount / superSpan + 2;
+    superLists_.resize(superCount, nullptr);
+    for (uint64_t i = 0; i < superCount; i++)
+      pushSuperBucket(i);
+  }
 
   lists_.resize(size, nullptr);
   for (uint64_t i = 0; i < size; i++)
@@ -71,31 +220,81 @@ void EratBig::storeSievingPrime(uint64_t prime, uint64_t multipleIndex, uint64_t
 {
   assert(prime <= maxPrime_);
   uint64_t sievingPrime = prime / 30;
+
+  if (prime <= hotMaxPrime_)
+  {
+    assert(multipleIndex <= SievingPrime::MAX_MULTIPLEINDEX);
+    assert(wheelIndex <= SievingPrime::MAX_WHEELINDEX);
+    hotIndexes_.push_back((uint32_t) (multipleIndex | (wheelIndex << 23)));
+    hotPrimes_.push_back((uint32_t) sievingPrime);
+    return;
+  }
+
   uint64_t segment = multipleIndex >> log2SieveSize_;
+
+  if (superSpan_ && segment >= superSpan_)
+  {
+    storeSuper(sievingPrime, multipleIndex, wheelIndex);
+    return;
+  }
+
   multipleIndex &= moduloSieveSize_;
 
   if (!lists_[segment]->store(sievingPrime, multipleIndex, wheelIndex))
     pushBucket(segment);
 }
 
-/// Add an empty bucket to the front of lists_[segment]
-void EratBig::pushBucket(uint64_t segment)
+/// Park a sieving prime whose next multiple lies beyond the
+/// lists_ window at the supersegment level. The stored
+/// multipleIndex is made relative to the first segment of
+/// the target supersegment, which keeps it below 2^23
+///
+void EratBig::storeSuper(uint64_t sievingPrime, uint64_t multipleIndex, uint64_t wheelIndex)
+{
+  uint64_t sieveSize = moduloSieveSize_ + 1;
+  uint64_t superIndex = (currentSegment_ + (multipleIndex >> log2SieveSize_)) / superSpan_;
+  multipleIndex -= (superIndex * superSpan_ - currentSegment_) * sieveSize;
+  uint64_t slot = superIndex % superLists_.size();
+
+  if (!superLists_[slot]->store(sievingPrime, multipleIndex, wheelIndex))
+    pushSuperBucket(slot);
+}
+
+/// Get an empty bucket from the stock_,
+/// refill the stock_ from the pool if needed
+///
+Bucket* EratBig::getEmptyBucket()
 {
-  // allocate new buckets
   if (!stock_)
   {
-    int N = config::BYTES_PER_ALLOC / sizeof(Bucket);
-    memory_.emplace_back(unique_ptr<Bucket[]>(new Bucket[N]));
-    Bucket* bucket = memory_.back().get();
+    int N = (int) BucketPool::chunkBuckets();
+    Bucket* bucket = BucketPool::getChunk();
+    chunks_.push_back(bucket);
 
     for (int i = 0; i < N - 1; i++)
+    {
+      bucket[i].reset();
       bucket[i].setNext(&bucket[i + 1]);
+    }
+    bucket[N-1].reset();
     bucket[N-1].setNext(nullptr);
     stock_ = bucket;
   }
   Bucket* empty = stock_;
   stock_ = stock_->next();
-  moveBucket(*empty, lists_[segment]);
+  return empty;
+}
+
+/// Add an empty bucket to the front of lists_[segment]
+void EratBig::pushBucket(uint64_t segment)
+{
+  moveBucket(*getEmptyBucket(), lists_[segment]);
+}
+
+/// Add an empty bucket to the front of superLists_[slot]
+void EratBig::pushSuperBucket(uint64_t slot)
+{
+  moveBucket(*getEmptyBucket(), superLists_[slot]);
 }
 
 void EratBig::moveBucket(Bucket& src, Bucket*& dest)
@@ -109,12 +308,26 @@ void EratBig::moveBucket(Bucket& src, Bucket*& dest)
 ///
 void EratBig::crossOff(byte_t* sieve)
 {
+  if (!hotIndexes_.empty())
+    crossOffHot(sieve);
+
+  // distribute the sieving primes parked at the
+  // supersegment level into the segment lists once
+  // their supersegment begins
+  if (superSpan_ && currentSegment_ % superSpan_ == 0)
+    unpackSuper();
+
   while (lists_[0]->hasNext() || !lists_[0]->empty())
   {
     Bucket* bucket = lists_[0];
     lists_[0] = nullptr;
     pushBucket(0);
     do {
+      // hide the pointer chase latency at the
+      // bucket boundary behind the current bucket
+      if (bucket->next())
+        prefetch(bucket->next()->begin());
+
       crossOff(sieve, bucket->begin(), bucket->end());
       Bucket* processed = bucket;
       bucket = bucket->next();
@@ -124,6 +337,118 @@ void EratBig::crossOff(byte_t* sieve)
   }
 
   rotate(lists_.begin(), lists_.begin() + 1, lists_.end());
+  currentSegment_++;
+}
+
+/// Distribute the sieving primes of the supersegment
+/// starting at the current segment into lists_. The stored
+/// multipleIndexes are relative to the supersegment's first
+/// segment, which is now the current segment, so they
+/// always land inside the lists_ window. The supersegment's
+/// bucket list is not written to again until the circular
+/// superLists_ index wraps around.
+///
+void EratBig::unpackSuper()
+{
+  uint64_t superIndex = currentSegment_ / superSpan_;
+  uint64_t slot = superIndex % superLists_.size();
+  Bucket* bucket = superLists_[slot];
+  superLists_[slot] = nullptr;
+  pushSuperBucket(slot);
+
+  while (bucket)
+  {
+    for (SievingPrime* prime = bucket->begin(); prime != bucket->end(); prime++)
+    {
+      uint64_t multipleIndex = prime->getMultipleIndex();
+      uint64_t wheelIndex = prime->getWheelIndex();
+      uint64_t sievingPrime = prime->getSievingPrime();
+
+      uint64_t segment = multipleIndex >> log2SieveSize_;
+      multipleIndex &= moduloSieveSize_;
+
+      if (!lists_[segment]->store(sievingPrime, multipleIndex, wheelIndex))
+        pushBucket(segment);
+    }
+
+    Bucket* processed = bucket;
+    bucket = bucket->next();
+    processed->reset();
+    moveBucket(*processed, stock_);
+  }
+}
+
+/// Cross-off the multiples of the hot sieving primes.
+/// These primes hit (almost) every segment, scanning them
+/// in a dense array keeps the memory accesses linear
+/// whereas the bucket lists drag each 8-byte SievingPrime
+/// entry through the cache twice per multiple (bucket
+/// store + bucket scan). Thanks to the structure of arrays
+/// layout the scan only touches the sieving primes array
+/// for primes with a multiple inside the current segment,
+/// blocks of 8 primes whose multiples all lie beyond it
+/// are advanced with a single vector load (skipBlock)
+///
+void EratBig::crossOffHot(byte_t* sieve)
+{
+  uint64_t sieveSize = moduloSieveSize_ + 1;
+  uint64_t maxIndex = SievingPrime::MAX_MULTIPLEINDEX;
+  uint32_t* indexes = hotIndexes_.data();
+  const uint32_t* sievingPrimes = hotPrimes_.data();
+  uint64_t size = hotIndexes_.size();
+
+  // prefetch the cache lines of the (random access)
+  // sieve array stores PREFETCH_DISTANCE ahead,
+  // same scheme as the bucket cross-off below
+  uint64_t distance = config::PREFETCH_DISTANCE;
+  uint64_t ahead = 0;
+
+  for (; ahead < min(distance, size); ahead++)
+    prefetch(&sieve[(indexes[ahead] & maxIndex) & moduloSieveSize_]);
+
+  uint64_t i = 0;
+
+  while (i < size)
+  {
+    while (i + 8 <= size &&
+           skipBlock(&indexes[i], (uint32_t) sieveSize))
+    {
+      i += 8;
+      for (; ahead < min(i + distance, size); ahead++)
+        prefetch(&sieve[(indexes[ahead] & maxIndex) & moduloSieveSize_]);
+    }
+
+    if (i == size)
+      break;
+
+    if (ahead < size)
+    {
+      prefetch(&sieve[(indexes[ahead] & maxIndex) & moduloSieveSize_]);
+      ahead++;
+    }
+
+    uint64_t multipleIndex = indexes[i] & maxIndex;
+
+    // the next multiple is not
+    // inside the current segment
+    if (multipleIndex >= sieveSize)
+    {
+      // subtracting cannot borrow into the wheelIndex bits
+      indexes[i++] -= (uint32_t) sieveSize;
+      continue;
+    }
+
+    uint64_t wheelIndex = indexes[i] >> 23;
+    uint64_t sievingPrime = sievingPrimes[i];
+
+    // cross-off the multiples (unset bits)
+    // inside the current segment
+    do {
+      unsetBit(sieve, sievingPrime, &multipleIndex, &wheelIndex);
+    } while (multipleIndex < sieveSize);
+
+    indexes[i++] = (uint32_t) ((multipleIndex - sieveSize) | (wheelIndex << 23));
+  }
 }
 
 /// Segmented sieve of Eratosthenes with wheel factorization
@@ -137,10 +462,27 @@ void EratBig::crossOff(byte_t* sieve, SievingPrime* primes, SievingPrime* end)
   uint64_t moduloSieveSize = moduloSieveSize_;
   uint64_t log2SieveSize = log2SieveSize_;
 
+  // each sieving prime unsets a single bit at a random
+  // sieve array position, prefetch those cache lines
+  // PREFETCH_DISTANCE sieving primes ahead so the
+  // stores below hit the L1 cache
+  uint64_t distance = config::PREFETCH_DISTANCE;
+  SievingPrime* ahead = primes;
+
+  for (; ahead < min(primes + distance, end); ahead++)
+    prefetch(&sieve[ahead->getMultipleIndex()]);
+
   // 2 sieving primes are processed per loop iteration
   // to increase instruction level parallelism
   for (; primes + 2 <= end; primes += 2)
-  { 
+  {
+    if (ahead + 2 <= end)
+    {
+      prefetch(&sieve[ahead[0].getMultipleIndex()]);
+      prefetch(&sieve[ahead[1].getMultipleIndex()]);
+      ahead += 2;
+    }
+
     uint64_t multipleIndex0 = primes[0].getMultipleIndex();
     uint64_t wheelIndex0    = primes[0].getWheelIndex();
     uint64_t sievingPrime0  = primes[0].getSievingPrime();
@@ -156,14 +498,18 @@ void EratBig::crossOff(byte_t* sieve, SievingPrime* primes, SievingPrime* end)
     uint64_t segment0 = multipleIndex0 >> log2SieveSize;
     uint64_t segment1 = multipleIndex1 >> log2SieveSize;
 
-    multipleIndex0 &= moduloSieveSize;
-    multipleIndex1 &= moduloSieveSize;
-
-    // move the 2 sieving primes to the list related
-    // to their next multiple
-    if (!lists[segment0]->store(sievingPrime0, multipleIndex0, wheelIndex0))
+    // move the 2 sieving primes to the list related to
+    // their next multiple. Very distant multiples (rare,
+    // well predicted branch) are parked at the
+    // supersegment level instead.
+    if (superSpan_ && segment0 >= superSpan_)
+      storeSuper(sievingPrime0, multipleIndex0, wheelIndex0);
+    else if (!lists[segment0]->store(sievingPrime0, multipleIndex0 & moduloSieveSize, wheelIndex0))
       pushBucket(segment0);
-    if (!lists[segment1]->store(sievingPrime1, multipleIndex1, wheelIndex1))
+
+    if (superSpan_ && segment1 >= superSpan_)
+      storeSuper(sievingPrime1, multipleIndex1, wheelIndex1);
+    else if (!lists[segment1]->store(sievingPrime1, multipleIndex1 & moduloSieveSize, wheelIndex1))
       pushBucket(segment1);
   }
 
@@ -175,9 +521,10 @@ void EratBig::crossOff(byte_t* sieve, SievingPrime* primes, SievingPrime* end)
 
     unsetBit(sieve, sievingPrime, &multipleIndex, &wheelIndex);
     uint64_t segment = multipleIndex >> log2SieveSize;
-    multipleIndex &= moduloSieveSize;
 
-    if (!lists[segment]->store(sievingPrime, multipleIndex, wheelIndex))
+    if (superSpan_ && segment >= superSpan_)
+      storeSuper(sievingPrime, multipleIndex, wheelIndex);
+    else if (!lists[segment]->store(sievingPrime, multipleIndex & moduloSieveSize, wheelIndex))
       pushBucket(segment);
   }
 }
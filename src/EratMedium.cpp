@@ -1,7 +1,10 @@
 ///
 /// @file   EratMedium.cpp
 /// @brief  Segmented sieve of Eratosthenes optimized for
-///         medium sieving primes.
+///         medium sieving primes. The cross-off loops are
+///         compile-time specialized for each wheel position so
+///         that the multiple increments are constants kept in
+///         registers instead of indirect wheel table lookups.
 ///
 /// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
 ///
@@ -9,6 +12,7 @@
 /// file in the top level directory.
 ///
 
+#include <primesieve/bits.hpp>
 #include <primesieve/Bucket.hpp>
 #include <primesieve/EratMedium.hpp>
 #include <primesieve/primesieve_error.hpp>
@@ -52,63 +56,192 @@ void EratMedium::storeSievingPrime(uint64_t prime, uint64_t multipleIndex, uint6
 }
 
 /// Segmented sieve of Eratosthenes with wheel factorization
-/// optimized for medium sieving primes that have a
-/// few multiples per segment
+/// optimized for medium sieving primes that have a few
+/// multiples per segment. This algorithm uses a hardcoded
+/// modulo 30 wheel that skips multiples of 2, 3 and 5.
+/// Each wheel position has its own specialized loop case so
+/// the compiler can keep the increments in registers
 ///
 void EratMedium::crossOff(byte_t* sieve, uint64_t sieveSize)
 {
-  size_t i = 0;
-  size_t size = primes_.size();
-  auto primes = primes_.data();
+  byte_t* sieveEnd = sieve + sieveSize;
 
-  // process 3 sieving primes per loop iteration to
-  // increase instruction level parallelism
-  for (; i < size - size % 3; i += 3)
+  for (auto& prime : primes_)
   {
-    uint64_t multipleIndex0 = primes[i + 0].getMultipleIndex();
-    uint64_t wheelIndex0    = primes[i + 0].getWheelIndex();
-    uint64_t sievingPrime0  = primes[i + 0].getSievingPrime();
-    uint64_t multipleIndex1 = primes[i + 1].getMultipleIndex();
-    uint64_t wheelIndex1    = primes[i + 1].getWheelIndex();
-    uint64_t sievingPrime1  = primes[i + 1].getSievingPrime();
-    uint64_t multipleIndex2 = primes[i + 2].getMultipleIndex();
-    uint64_t wheelIndex2    = primes[i + 2].getWheelIndex();
-    uint64_t sievingPrime2  = primes[i + 2].getSievingPrime();
+    uint64_t sievingPrime  = prime.getSievingPrime();
+    uint64_t multipleIndex = prime.getMultipleIndex();
+    uint64_t wheelIndex    = prime.getWheelIndex();
 
-    while (multipleIndex0 < sieveSize)
+    // pointer to the byte containing the next multiple
+    // of sievingPrime within the current segment
+    byte_t* p = &sieve[multipleIndex];
+
+    switch (wheelIndex)
     {
-      unsetBit(sieve, sievingPrime0, &multipleIndex0, &wheelIndex0);
-      if (multipleIndex1 >= sieveSize) break;
-      unsetBit(sieve, sievingPrime1, &multipleIndex1, &wheelIndex1);
-      if (multipleIndex2 >= sieveSize) break;
-      unsetBit(sieve, sievingPrime2, &multipleIndex2, &wheelIndex2);
+      for (;;) // i*30 + 7
+      {
+        case 0:  if (p >= sieveEnd) { prime.setWheelIndex(0); break; }
+                 *p &= BIT0; p += sievingPrime * 6 + 1;
+        case 1:  if (p >= sieveEnd) { prime.setWheelIndex(1); break; }
+                 *p &= BIT4; p += sievingPrime * 4 + 1;
+        case 2:  if (p >= sieveEnd) { prime.setWheelIndex(2); break; }
+                 *p &= BIT3; p += sievingPrime * 2 + 0;
+        case 3:  if (p >= sieveEnd) { prime.setWheelIndex(3); break; }
+                 *p &= BIT7; p += sievingPrime * 4 + 1;
+        case 4:  if (p >= sieveEnd) { prime.setWheelIndex(4); break; }
+                 *p &= BIT6; p += sievingPrime * 2 + 1;
+        case 5:  if (p >= sieveEnd) { prime.setWheelIndex(5); break; }
+                 *p &= BIT2; p += sievingPrime * 4 + 1;
+        case 6:  if (p >= sieveEnd) { prime.setWheelIndex(6); break; }
+                 *p &= BIT1; p += sievingPrime * 6 + 1;
+        case 7:  if (p >= sieveEnd) { prime.setWheelIndex(7); break; }
+                 *p &= BIT5; p += sievingPrime * 2 + 1;
+      }
+      break;
+      for (;;) // i*30 + 11
+      {
+        case 8:  if (p >= sieveEnd) { prime.setWheelIndex(8); break; }
+                 *p &= BIT1; p += sievingPrime * 6 + 2;
+        case 9:  if (p >= sieveEnd) { prime.setWheelIndex(9); break; }
+                 *p &= BIT3; p += sievingPrime * 4 + 1;
+        case 10: if (p >= sieveEnd) { prime.setWheelIndex(10); break; }
+                 *p &= BIT7; p += sievingPrime * 2 + 1;
+        case 11: if (p >= sieveEnd) { prime.setWheelIndex(11); break; }
+                 *p &= BIT5; p += sievingPrime * 4 + 2;
+        case 12: if (p >= sieveEnd) { prime.setWheelIndex(12); break; }
+                 *p &= BIT0; p += sievingPrime * 2 + 0;
+        case 13: if (p >= sieveEnd) { prime.setWheelIndex(13); break; }
+                 *p &= BIT6; p += sievingPrime * 4 + 2;
+        case 14: if (p >= sieveEnd) { prime.setWheelIndex(14); break; }
+                 *p &= BIT2; p += sievingPrime * 6 + 2;
+        case 15: if (p >= sieveEnd) { prime.setWheelIndex(15); break; }
+                 *p &= BIT4; p += sievingPrime * 2 + 1;
+      }
+      break;
+      for (;;) // i*30 + 13
+      {
+        case 16: if (p >= sieveEnd) { prime.setWheelIndex(16); break; }
+                 *p &= BIT2; p += sievingPrime * 6 + 2;
+        case 17: if (p >= sieveEnd) { prime.setWheelIndex(17); break; }
+                 *p &= BIT7; p += sievingPrime * 4 + 2;
+        case 18: if (p >= sieveEnd) { prime.setWheelIndex(18); break; }
+                 *p &= BIT5; p += sievingPrime * 2 + 1;
+        case 19: if (p >= sieveEnd) { prime.setWheelIndex(19); break; }
+                 *p &= BIT4; p += sievingPrime * 4 + 2;
+        case 20: if (p >= sieveEnd) { prime.setWheelIndex(20); break; }
+                 *p &= BIT1; p += sievingPrime * 2 + 1;
+        case 21: if (p >= sieveEnd) { prime.setWheelIndex(21); break; }
+                 *p &= BIT0; p += sievingPrime * 4 + 1;
+        case 22: if (p >= sieveEnd) { prime.setWheelIndex(22); break; }
+                 *p &= BIT6; p += sievingPrime * 6 + 3;
+        case 23: if (p >= sieveEnd) { prime.setWheelIndex(23); break; }
+                 *p &= BIT3; p += sievingPrime * 2 + 1;
+      }
+      break;
+      for (;;) // i*30 + 17
+      {
+        case 24: if (p >= sieveEnd) { prime.setWheelIndex(24); break; }
+                 *p &= BIT3; p += sievingPrime * 6 + 3;
+        case 25: if (p >= sieveEnd) { prime.setWheelIndex(25); break; }
+                 *p &= BIT6; p += sievingPrime * 4 + 3;
+        case 26: if (p >= sieveEnd) { prime.setWheelIndex(26); break; }
+                 *p &= BIT0; p += sievingPrime * 2 + 1;
+        case 27: if (p >= sieveEnd) { prime.setWheelIndex(27); break; }
+                 *p &= BIT1; p += sievingPrime * 4 + 2;
+        case 28: if (p >= sieveEnd) { prime.setWheelIndex(28); break; }
+                 *p &= BIT4; p += sievingPrime * 2 + 1;
+        case 29: if (p >= sieveEnd) { prime.setWheelIndex(29); break; }
+                 *p &= BIT5; p += sievingPrime * 4 + 2;
+        case 30: if (p >= sieveEnd) { prime.setWheelIndex(30); break; }
+                 *p &= BIT7; p += sievingPrime * 6 + 4;
+        case 31: if (p >= sieveEnd) { prime.setWheelIndex(31); break; }
+                 *p &= BIT2; p += sievingPrime * 2 + 1;
+      }
+      break;
+      for (;;) // i*30 + 19
+      {
+        case 32: if (p >= sieveEnd) { prime.setWheelIndex(32); break; }
+                 *p &= BIT4; p += sievingPrime * 6 + 4;
+        case 33: if (p >= sieveEnd) { prime.setWheelIndex(33); break; }
+                 *p &= BIT2; p += sievingPrime * 4 + 2;
+        case 34: if (p >= sieveEnd) { prime.setWheelIndex(34); break; }
+                 *p &= BIT6; p += sievingPrime * 2 + 2;
+        case 35: if (p >= sieveEnd) { prime.setWheelIndex(35); break; }
+                 *p &= BIT0; p += sievingPrime * 4 + 2;
+        case 36: if (p >= sieveEnd) { prime.setWheelIndex(36); break; }
+                 *p &= BIT5; p += sievingPrime * 2 + 1;
+        case 37: if (p >= sieveEnd) { prime.setWheelIndex(37); break; }
+                 *p &= BIT7; p += sievingPrime * 4 + 3;
+        case 38: if (p >= sieveEnd) { prime.setWheelIndex(38); break; }
+                 *p &= BIT3; p += sievingPrime * 6 + 4;
+        case 39: if (p >= sieveEnd) { prime.setWheelIndex(39); break; }
+                 *p &= BIT1; p += sievingPrime * 2 + 1;
+      }
+      break;
+      for (;;) // i*30 + 23
+      {
+        case 40: if (p >= sieveEnd) { prime.setWheelIndex(40); break; }
+                 *p &= BIT5; p += sievingPrime * 6 + 5;
+        case 41: if (p >= sieveEnd) { prime.setWheelIndex(41); break; }
+                 *p &= BIT1; p += sievingPrime * 4 + 3;
+        case 42: if (p >= sieveEnd) { prime.setWheelIndex(42); break; }
+                 *p &= BIT2; p += sievingPrime * 2 + 1;
+        case 43: if (p >= sieveEnd) { prime.setWheelIndex(43); break; }
+                 *p &= BIT6; p += sievingPrime * 4 + 3;
+        case 44: if (p >= sieveEnd) { prime.setWheelIndex(44); break; }
+                 *p &= BIT7; p += sievingPrime * 2 + 2;
+        case 45: if (p >= sieveEnd) { prime.setWheelIndex(45); break; }
+                 *p &= BIT3; p += sievingPrime * 4 + 3;
+        case 46: if (p >= sieveEnd) { prime.setWheelIndex(46); break; }
+                 *p &= BIT4; p += sievingPrime * 6 + 5;
+        case 47: if (p >= sieveEnd) { prime.setWheelIndex(47); break; }
+                 *p &= BIT0; p += sievingPrime * 2 + 1;
+      }
+      break;
+      for (;;) // i*30 + 29
+      {
+        case 48: if (p >= sieveEnd) { prime.setWheelIndex(48); break; }
+                 *p &= BIT6; p += sievingPrime * 6 + 6;
+        case 49: if (p >= sieveEnd) { prime.setWheelIndex(49); break; }
+                 *p &= BIT5; p += sievingPrime * 4 + 4;
+        case 50: if (p >= sieveEnd) { prime.setWheelIndex(50); break; }
+                 *p &= BIT4; p += sievingPrime * 2 + 2;
+        case 51: if (p >= sieveEnd) { prime.setWheelIndex(51); break; }
+                 *p &= BIT3; p += sievingPrime * 4 + 4;
+        case 52: if (p >= sieveEnd) { prime.setWheelIndex(52); break; }
+                 *p &= BIT2; p += sievingPrime * 2 + 2;
+        case 53: if (p >= sieveEnd) { prime.setWheelIndex(53); break; }
+                 *p &= BIT1; p += sievingPrime * 4 + 4;
+        case 54: if (p >= sieveEnd) { prime.setWheelIndex(54); break; }
+                 *p &= BIT0; p += sievingPrime * 6 + 5;
+        case 55: if (p >= sieveEnd) { prime.setWheelIndex(55); break; }
+                 *p &= BIT7; p += sievingPrime * 2 + 2;
+      }
+      break;
+      for (;;) // i*30 + 31
+      {
+        case 56: if (p >= sieveEnd) { prime.setWheelIndex(56); break; }
+                 *p &= BIT7; p += sievingPrime * 6 + 1;
+        case 57: if (p >= sieveEnd) { prime.setWheelIndex(57); break; }
+                 *p &= BIT0; p += sievingPrime * 4 + 0;
+        case 58: if (p >= sieveEnd) { prime.setWheelIndex(58); break; }
+                 *p &= BIT1; p += sievingPrime * 2 + 0;
+        case 59: if (p >= sieveEnd) { prime.setWheelIndex(59); break; }
+                 *p &= BIT2; p += sievingPrime * 4 + 0;
+        case 60: if (p >= sieveEnd) { prime.setWheelIndex(60); break; }
+                 *p &= BIT3; p += sievingPrime * 2 + 0;
+        case 61: if (p >= sieveEnd) { prime.setWheelIndex(61); break; }
+                 *p &= BIT4; p += sievingPrime * 4 + 0;
+        case 62: if (p >= sieveEnd) { prime.setWheelIndex(62); break; }
+                 *p &= BIT5; p += sievingPrime * 6 + 0;
+        case 63: if (p >= sieveEnd) { prime.setWheelIndex(63); break; }
+                 *p &= BIT6; p += sievingPrime * 2 + 0;
+      }
+      break;
     }
 
-    while (multipleIndex0 < sieveSize) unsetBit(sieve, sievingPrime0, &multipleIndex0, &wheelIndex0);
-    while (multipleIndex1 < sieveSize) unsetBit(sieve, sievingPrime1, &multipleIndex1, &wheelIndex1);
-    while (multipleIndex2 < sieveSize) unsetBit(sieve, sievingPrime2, &multipleIndex2, &wheelIndex2);
-
-    multipleIndex0 -= sieveSize;
-    multipleIndex1 -= sieveSize;
-    multipleIndex2 -= sieveSize;
-
-    primes[i + 0].set(multipleIndex0, wheelIndex0);
-    primes[i + 1].set(multipleIndex1, wheelIndex1);
-    primes[i + 2].set(multipleIndex2, wheelIndex2);
-  }
-
-  // process remaining sieving primes
-  for (; i < size; i++)
-  {
-    uint64_t multipleIndex = primes[i].getMultipleIndex();
-    uint64_t wheelIndex    = primes[i].getWheelIndex();
-    uint64_t sievingPrime  = primes[i].getSievingPrime();
-
-    while (multipleIndex < sieveSize)
-      unsetBit(sieve, sievingPrime, &multipleIndex, &wheelIndex);
-
-    multipleIndex -= sieveSize;
-    primes[i].set(multipleIndex, wheelIndex);
+    // set multipleIndex for next segment
+    prime.setMultipleIndex((uint64_t) (p - sieveEnd));
   }
 }
 
@@ -20,10 +20,139 @@
 
 #include <stdint.h>
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstring>
 #include <vector>
 
+#if defined(__x86_64__) && \
+   (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+  #define HAS_AVX2_CROSSOFF
+  #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+  #define HAS_NEON_CROSSOFF
+  #include <arm_neon.h>
+#endif
+
 using namespace std;
+using namespace primesieve;
+
+namespace {
+
+/// Sieving primes <= maxPatternPrime are crossed-off using
+/// precomputed byte patterns instead of the unrolled modulo 30
+/// wheel loop. Their patterns repeat every prime bytes hence
+/// the sieve array can be updated 32 bytes at a time.
+///
+const uint64_t maxPatternPrime = 127;
+
+/// wheel30 residues indexed by wheelIndex / 8,
+/// prime = sievingPrime * 30 + residue
+///
+const array<uint64_t, 8> wheelResidues = { 7, 11, 13, 17, 19, 23, 29, 1 };
+
+/// Cross-off the multiples of up to 4 pattern primes,
+/// the sieve array is streamed through only once per
+/// group of pattern primes
+///
+void crossOffGeneric(byte_t* sieve,
+                     uint64_t chunks,
+                     const byte_t* const* patterns,
+                     uint64_t* phases,
+                     const uint64_t* primes,
+                     size_t size)
+{
+  for (uint64_t i = 0; i < chunks; i++, sieve += 32)
+  {
+    for (size_t k = 0; k < size; k++)
+    {
+      const byte_t* pattern = patterns[k] + phases[k];
+
+      for (int j = 0; j < 32; j += 8)
+      {
+        uint64_t bits;
+        uint64_t mask;
+        memcpy(&bits, &sieve[j], 8);
+        memcpy(&mask, &pattern[j], 8);
+        bits &= mask;
+        memcpy(&sieve[j], &bits, 8);
+      }
+
+      phases[k] += 32;
+      while (phases[k] >= primes[k])
+        phases[k] -= primes[k];
+    }
+  }
+}
+
+#if defined(HAS_AVX2_CROSSOFF)
+
+/// AVX2 version of crossOffGeneric(), each iteration
+/// updates 32 sieve bytes using 256-bit ANDs
+///
+__attribute__((target("avx2")))
+void crossOffAvx2(byte_t* sieve,
+                  uint64_t chunks,
+                  const byte_t* const* patterns,
+                  uint64_t* phases,
+                  const uint64_t* primes,
+                  size_t size)
+{
+  for (uint64_t i = 0; i < chunks; i++, sieve += 32)
+  {
+    __m256i bits = _mm256_loadu_si256((const __m256i*) sieve);
+
+    for (size_t k = 0; k < size; k++)
+    {
+      const byte_t* pattern = patterns[k] + phases[k];
+      __m256i mask = _mm256_loadu_si256((const __m256i*) pattern);
+      bits = _mm256_and_si256(bits, mask);
+
+      phases[k] += 32;
+      while (phases[k] >= primes[k])
+        phases[k] -= primes[k];
+    }
+
+    _mm256_storeu_si256((__m256i*) sieve, bits);
+  }
+}
+
+#elif defined(HAS_NEON_CROSSOFF)
+
+/// NEON version of crossOffGeneric(), each iteration
+/// updates 32 sieve bytes using two 128-bit ANDs
+///
+void crossOffNeon(byte_t* sieve,
+                  uint64_t chunks,
+                  const byte_t* const* patterns,
+                  uint64_t* phases,
+                  const uint64_t* primes,
+                  size_t size)
+{
+  for (uint64_t i = 0; i < chunks; i++, sieve += 32)
+  {
+    uint8x16_t lo = vld1q_u8(sieve);
+    uint8x16_t hi = vld1q_u8(sieve + 16);
+
+    for (size_t k = 0; k < size; k++)
+    {
+      const byte_t* pattern = patterns[k] + phases[k];
+      lo = vandq_u8(lo, vld1q_u8(pattern));
+      hi = vandq_u8(hi, vld1q_u8(pattern + 16));
+
+      phases[k] += 32;
+      while (phases[k] >= primes[k])
+        phases[k] -= primes[k];
+    }
+
+    vst1q_u8(sieve, lo);
+    vst1q_u8(sieve + 16, hi);
+  }
+}
+
+#endif
+
+} // namespace
 
 namespace primesieve {
 
@@ -69,12 +198,21 @@ void EratSmall::storeSievingPrime(uint64_t prime, uint64_t multipleIndex, uint64
   assert(prime <= maxPrime_);
   uint64_t sievingPrime = prime / 30;
   primes_.emplace_back(sievingPrime, multipleIndex, wheelIndex);
+
+  // the prime is moved to patternPrimes_ after
+  // its first segment has been sieved
+  if (prime <= maxPatternPrime)
+    hasPatternCandidates_ = true;
 }
 
-/// Cross-off the multiples of small sieving
-/// primes from the sieve array
+/// Cross-off the multiples of small sieving primes from
+/// the sieve array. If @count is non-null EratSmall runs
+/// as the last cross-off algorithm and the 1 bits of each
+/// L1 sized block are counted while the block is still in
+/// the L1 cache, which avoids a second pass over the
+/// segment for count workloads
 ///
-void EratSmall::crossOff(byte_t* sieve, uint64_t sieveSize)
+void EratSmall::crossOff(byte_t* sieve, uint64_t sieveSize, uint64_t* count)
 {
   byte_t* sieveEnd = sieve + sieveSize;
 
@@ -83,17 +221,154 @@ void EratSmall::crossOff(byte_t* sieve, uint64_t sieveSize)
     byte_t* start = sieve;
     sieve += l1Size_;
     sieve = min(sieve, sieveEnd);
+    crossOffPatterns(start, sieve);
     crossOff(start, sieve);
+
+    if (count)
+    {
+      uint64_t bytes = (uint64_t) (sieve - start);
+      *count += popcount((const uint64_t*) start, ceilDiv(bytes, 8));
+    }
+  }
+
+  if (hasPatternCandidates_)
+  {
+    migratePatternPrimes();
+    hasPatternCandidates_ = false;
+  }
+}
+
+/// Cross-off the multiples of the pattern primes using
+/// 32-byte wide ANDs, uses AVX2 or NEON if supported by
+/// the CPU.
+/// Each pass processes a group of up to 4 pattern primes
+/// so that the sieve array is streamed through only once
+/// per group instead of once per sieving prime
+///
+void EratSmall::crossOffPatterns(byte_t* sieve, byte_t* sieveEnd)
+{
+  size_t size = patternPrimes_.size();
+
+  for (size_t i = 0; i < size; i += 4)
+  {
+    size_t n = min<size_t>(4, size - i);
+    const byte_t* patterns[4];
+    uint64_t phases[4];
+    uint64_t primes[4];
+
+    for (size_t k = 0; k < n; k++)
+    {
+      PatternPrime& pp = patternPrimes_[i + k];
+      patterns[k] = &patterns_[pp.offset];
+      phases[k] = pp.phase;
+      primes[k] = pp.prime;
+    }
+
+    uint64_t bytes = (uint64_t) (sieveEnd - sieve);
+    uint64_t chunks = bytes / 32;
+
+#if defined(HAS_AVX2_CROSSOFF)
+    if (cpuInfo.hasAVX2())
+      crossOffAvx2(sieve, chunks, patterns, phases, primes, n);
+    else
+#elif defined(HAS_NEON_CROSSOFF)
+    if (cpuInfo.hasNEON())
+      crossOffNeon(sieve, chunks, patterns, phases, primes, n);
+    else
+#endif
+      crossOffGeneric(sieve, chunks, patterns, phases, primes, n);
+
+    // process the remaining bytes (< 32)
+    // at the end of the segment
+    for (byte_t* p = sieve + chunks * 32; p < sieveEnd; p++)
+    {
+      for (size_t k = 0; k < n; k++)
+      {
+        *p &= patterns[k][phases[k]];
+        if (++phases[k] == primes[k])
+          phases[k] = 0;
+      }
+    }
+
+    // set phases for the next segment
+    for (size_t k = 0; k < n; k++)
+      patternPrimes_[i + k].phase = phases[k];
+  }
+}
+
+/// Move the sieving primes <= maxPatternPrime from primes_
+/// to patternPrimes_ and precompute their cross-off byte
+/// patterns. The first segment of each new sieving prime is
+/// processed by the wheel loop (which never crosses-off the
+/// prime itself), afterwards all pattern bits correspond to
+/// composites so the repeating pattern can be applied
+///
+void EratSmall::migratePatternPrimes()
+{
+  size_t keep = 0;
+
+  for (SievingPrime& sp : primes_)
+  {
+    uint64_t sievingPrime = sp.getSievingPrime();
+    uint64_t wheelIndex = sp.getWheelIndex();
+    uint64_t prime = sievingPrime * 30 + wheelResidues[wheelIndex / 8];
+
+    if (prime > maxPatternPrime)
+    {
+      primes_[keep++] = sp;
+      continue;
+    }
+
+    // the pattern repeats every prime bytes, it is
+    // padded by 31 bytes so that unaligned 32-byte
+    // loads never read past the end
+    uint64_t offset = patterns_.size();
+    patterns_.resize(offset + prime + 31, 0xff);
+
+    // simulate one full wheel rotation (8 multiples)
+    // which advances by exactly prime bytes
+    uint64_t idx = 0;
+    for (int j = 0; j < 8; j++)
+    {
+      patterns_[offset + idx] &= wheel30Tables.elem[wheelIndex].unsetBit;
+      idx += wheel30Tables.elem[wheelIndex].nextMultipleFactor * sievingPrime;
+      idx += wheel30Tables.elem[wheelIndex].correct;
+      wheelIndex += wheel30Tables.elem[wheelIndex].next;
+    }
+
+    assert(idx == prime);
+
+    // replicate the pattern into the padding bytes
+    for (uint64_t j = prime; j < prime + 31; j++)
+      patterns_[offset + j] = patterns_[offset + j - prime];
+
+    // multipleIndex is relative to the start of the
+    // next segment, pattern[0] corresponds to the byte
+    // of the next multiple
+    uint64_t multipleIndex = sp.getMultipleIndex();
+    uint64_t phase = (prime - multipleIndex % prime) % prime;
+    patternPrimes_.push_back(PatternPrime{ prime, phase, offset });
   }
+
+  primes_.resize(keep);
 }
 
 /// Segmented sieve of Eratosthenes with wheel factorization
 /// optimized for small sieving primes that have many multiples
 /// per segment. This algorithm uses a hardcoded modulo 30
-/// wheel that skips multiples of 2, 3 and 5
+/// wheel that skips multiples of 2, 3 and 5.
+/// Full wheel rotations (8 multiples) are crossed-off by the
+/// unrolled loops below without any bounds checks, the per
+/// multiple checks against sieveEnd only run for the final
+/// partial rotation of the segment
 ///
 void EratSmall::crossOff(byte_t* sieve, byte_t* sieveEnd)
 {
+  // largest byte offset accessed by one unrolled wheel
+  // rotation, relative to p and sievingPrime * 28, one
+  // entry per residue chain (= wheelIndex / 8)
+  const uint64_t maxOffsets[8] = { 6, 10, 12, 16, 18, 22, 27, 1 };
+
   for (auto& prime : primes_)
   {
     uint64_t sievingPrime  = prime.getSievingPrime();
@@ -101,9 +376,13 @@ void EratSmall::crossOff(byte_t* sieve, byte_t* sieveEnd)
     uint64_t wheelIndex    = prime.getWheelIndex();
 
     // pointer to the byte containing the first multiple
-    // of sievingPrime within the current segment
+    // of sievingPrime within the current segment.
+    // The check-free unrolled loops run while the entire
+    // next rotation fits below sieveEnd, using the exact
+    // stride of this prime's residue chain instead of the
+    // worst case offset of all 8 chains
     byte_t* p = &sieve[multipleIndex];
-    byte_t* loopLimit = sieveEnd - (sievingPrime * 28 + 27);
+    byte_t* loopLimit = sieveEnd - (sievingPrime * 28 + maxOffsets[wheelIndex / 8]);
     if (loopLimit > sieveEnd)
       loopLimit = p;
 
@@ -0,0 +1,207 @@
+///
+/// @file   GapSieve.cpp
+/// @brief  Collect prime gap statistics (maximal gap, gap
+///         histogram, gap records) directly from the sieve
+///         array. Iterating next_prime() and subtracting
+///         decodes every prime through the iterator machinery,
+///         the gaps however are visible in the sieve bits: the
+///         segment is scanned word by word with the same
+///         de Bruijn bitscan as Erat::nextPrime() and empty
+///         words (240 numbers) cost a single compare. The range
+///         is sieved in parallel chunks, the per-chunk
+///         statistics are stitched together in range order
+///         using each chunk's first and last prime.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/Erat.hpp>
+#include <primesieve/GapSieve.hpp>
+#include <primesieve/littleendian_cast.hpp>
+#include <primesieve/pmath.hpp>
+#include <primesieve/PreSieve.hpp>
+#include <primesieve/SievingPrimes.hpp>
+#include <primesieve/ThreadPool.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace primesieve {
+
+GapSieve::GapSieve(uint64_t start, uint64_t stop) :
+  preSieve_(start, stop)
+{
+  Erat::init(start, stop, get_sieve_size(), preSieve_);
+}
+
+void GapSieve::sieve()
+{
+  SievingPrimes sievingPrimes(this, preSieve_);
+  uint64_t prime = sievingPrimes.next();
+
+  while (hasNextSegment())
+  {
+    low_ = segmentLow_;
+    uint64_t sqrtHigh = isqrt(segmentHigh_);
+
+    for (; prime <= sqrtHigh; prime = sievingPrimes.next())
+      addSievingPrime(prime);
+
+    sieveSegment();
+    scanSegment();
+  }
+}
+
+/// Scan the sieved segment word by word. The gap between two
+/// consecutive primes falls out of their decoded bit
+/// positions, a zero word advances the scan by 240 numbers
+/// with a single compare so that the large gap regions this
+/// statistic is after are the cheapest to traverse
+///
+void GapSieve::scanSegment()
+{
+  // sieveSegment() zero pads the last segment
+  // to a multiple of 8 bytes
+  uint64_t numWords = ceilDiv(sieveSize_, 8);
+  uint64_t low = low_;
+
+  for (uint64_t i = 0; i < numWords; i++)
+  {
+    uint64_t bits = littleendian_cast<uint64_t>(&sieve_[i * 8]);
+
+    if (bits)
+    {
+      size_t count = popcnt64(bits);
+      for (size_t j = 0; j < count; j++)
+        recordPrime(nextPrime(&bits, low));
+    }
+
+    low += 8 * 30;
+  }
+}
+
+void GapSieve::recordPrime(uint64_t prime)
+{
+  if (prevPrime_)
+  {
+    uint64_t gap = prime - prevPrime_;
+    if (gap >= histogram_.size())
+      histogram_.resize(gap + 1, 0);
+    histogram_[gap]++;
+
+    if (gap > maxGap_)
+    {
+      maxGap_ = gap;
+      records_.emplace_back(prevPrime_, gap);
+    }
+  }
+  else
+    firstPrime_ = prime;
+
+  prevPrime_ = prime;
+}
+
+PrimeGaps prime_gaps(uint64_t start, uint64_t stop)
+{
+  PrimeGaps result;
+
+  if (start > stop)
+    return result;
+
+  uint64_t prevLast = 0;
+
+  // Append the statistics of the next chunk in range order.
+  // The gap across the chunk boundary (last prime of the
+  // previous chunk to first prime of this chunk) is known to
+  // neither chunk and stitched in here, it may itself be a
+  // gap record
+  auto append = [&](uint64_t first, uint64_t last,
+                    const vector<uint64_t>& histogram,
+                    const vector<pair<uint64_t, uint64_t>>& records)
+  {
+    // chunk contains no primes
+    if (!first)
+      return;
+
+    if (prevLast)
+    {
+      uint64_t gap = first - prevLast;
+      if (gap >= result.histogram.size())
+        result.histogram.resize(gap + 1, 0);
+      result.histogram[gap]++;
+
+      if (gap > result.maxGap)
+      {
+        result.maxGap = gap;
+        result.maxGapStart = prevLast;
+        result.records.emplace_back(prevLast, gap);
+      }
+    }
+
+    // a chunk local gap record is a global record
+    // only if it beats all preceding chunks
+    for (const auto& record : records)
+    {
+      if (record.second > result.maxGap)
+      {
+        result.maxGap = record.second;
+        result.maxGapStart = record.first;
+        result.records.push_back(record);
+      }
+    }
+
+    if (histogram.size() > result.histogram.size())
+      result.histogram.resize(histogram.size(), 0);
+    for (size_t gap = 0; gap < histogram.size(); gap++)
+      result.histogram[gap] += histogram[gap];
+
+    prevLast = last;
+  };
+
+  // the primes 2, 3 and 5 are not
+  // representable in the sieve array
+  for (uint64_t prime : { 2, 3, 5 })
+    if (prime >= start && prime <= stop)
+      append(prime, prime, {}, {});
+
+  uint64_t sieveStart = max<uint64_t>(start, 7);
+  if (sieveStart > stop)
+    return result;
+
+  uint64_t dist = stop - sieveStart;
+  uint64_t maxThreads = dist / get_tuning().minThreadDistance;
+  int threads = (int) inBetween(1, maxThreads, get_num_threads());
+
+  auto ranges = partition_range(sieveStart, stop, threads);
+  threads = (int) ranges.size();
+  vector<unique_ptr<GapSieve>> chunks(threads);
+
+  auto sieveTask = [&](int t)
+  {
+    chunks[t].reset(new GapSieve(ranges[t].first, ranges[t].second));
+    chunks[t]->sieve();
+  };
+
+  if (threads == 1)
+    sieveTask(0);
+  else
+    ThreadPool::getInstance().execute(threads, sieveTask);
+
+  for (auto& chunk : chunks)
+    append(chunk->firstPrime(), chunk->lastPrime(),
+           chunk->histogram(), chunk->records());
+
+  return result;
+}
+
+} // namespace
@@ -9,7 +9,7 @@
 /// file in the top level directory.
 ///
 
-#include <primesieve/config.hpp>
+#include <primesieve.hpp>
 #include <primesieve/IteratorHelper.hpp>
 #include <primesieve/pmath.hpp>
 
@@ -31,11 +31,20 @@ uint64_t getNextDist(uint64_t n, uint64_t dist)
 
   uint64_t minDist = (uint64_t) x;
   uint64_t limit = numeric_limits<uint64_t>::max() / 4;
-  dist = max(dist, minDist);
 
   if (dist < limit)
     dist *= 4;
 
+  // the block size adapts to the observed consumption:
+  // a new block is only generated once the caller has
+  // exhausted the previous one and skipto() resets dist
+  // to a few hundred. Hence the first blocks after
+  // skipto() stay far below the sqrt(n) amortization
+  // floor (a caller that reads only a few primes wastes
+  // little sieving), while sequential consumers keep
+  // quadrupling and reach the floor within 3 blocks
+  dist = max(dist, minDist / 16);
+
   return dist;
 }
 
@@ -44,8 +53,9 @@ uint64_t getPrevDist(uint64_t n, uint64_t* dist)
   double x = (double) n;
   x = max(x, 10.0);
 
-  double minDist = config::MIN_CACHE_ITERATOR;
-  double maxDist = config::MAX_CACHE_ITERATOR;
+  Tuning tuning = get_tuning();
+  double minDist = (double) tuning.minCacheIterator;
+  double maxDist = (double) tuning.maxCacheIterator;
   double logx = log(x);
 
   minDist *= logx;
@@ -54,14 +64,20 @@ uint64_t getPrevDist(uint64_t n, uint64_t* dist)
   minDist /= sizeof(uint64_t);
   maxDist /= sizeof(uint64_t);
 
-  if (*dist < minDist)
-  {
-    minDist = (double) *dist;
+  uint64_t limit = numeric_limits<uint64_t>::max() / 4;
+  if (*dist < limit)
     *dist *= 4;
-  }
 
-  double defaultDist = sqrt(x) * 2;
-  double newDist = max(minDist, defaultDist);
+  // backward blocks grow geometrically between the two
+  // cache bounds, mirroring getNextDist(). Since the
+  // sieving primes come from the process-wide cache
+  // (iterator.cpp) a backward block no longer pays an
+  // O(sqrt(n)) sieving prime generation, which previously
+  // forced every block to span at least 2 * sqrt(n) for
+  // amortization. Hence the first prev_prime() call now
+  // sieves minCacheIterator bytes of primes instead of a
+  // 2 * sqrt(n) block, matching next_prime()'s latency
+  double newDist = max((double) *dist, minDist);
   newDist = min(newDist, maxDist);
 
   return (uint64_t) newDist;
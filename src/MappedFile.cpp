@@ -0,0 +1,89 @@
+///
+/// @file   MappedFile.cpp
+/// @brief  RAII wrapper around a read-only memory-mapped file,
+///         see MappedFile.hpp.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve/MappedFile.hpp>
+#include <primesieve/primesieve_error.hpp>
+
+#include <stdint.h>
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+#if !defined(_WIN32)
+  #define HAS_MMAP
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace primesieve {
+
+MappedFile::MappedFile(const std::string& filePath,
+                       std::size_t minBytes,
+                       const std::string& name)
+{
+#if defined(HAS_MMAP)
+  fd_ = open(filePath.c_str(), O_RDONLY);
+  if (fd_ < 0)
+    throw primesieve_error("cannot open file: " + filePath);
+
+  struct stat st;
+  if (fstat(fd_, &st) < 0 ||
+      (uint64_t) st.st_size < minBytes)
+  {
+    close(fd_);
+    fd_ = -1;
+    throw primesieve_error("invalid " + name + ": " + filePath);
+  }
+
+  fileSize_ = (size_t) st.st_size;
+  map_ = mmap(nullptr, fileSize_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (map_ == MAP_FAILED)
+  {
+    map_ = nullptr;
+    close(fd_);
+    fd_ = -1;
+    throw primesieve_error("cannot mmap file: " + filePath);
+  }
+
+  base_ = (const unsigned char*) map_;
+#else
+  // no memory-mapping available,
+  // read the whole file into memory
+  ifstream file(filePath, ifstream::binary | ifstream::ate);
+  if (!file)
+    throw primesieve_error("cannot open file: " + filePath);
+
+  fileSize_ = (size_t) file.tellg();
+  if (fileSize_ < minBytes)
+    throw primesieve_error("invalid " + name + ": " + filePath);
+
+  buffer_.resize(fileSize_);
+  file.seekg(0);
+  file.read((char*) buffer_.data(), fileSize_);
+  base_ = buffer_.data();
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#if defined(HAS_MMAP)
+  if (map_)
+    munmap(map_, fileSize_);
+  if (fd_ >= 0)
+    close(fd_);
+#endif
+}
+
+} // namespace
@@ -8,20 +8,28 @@
 /// file in the top level directory.
 ///
 
-#include <primesieve/config.hpp>
+#include <primesieve.hpp>
+#include <primesieve/CpuInfo.hpp>
 #include <primesieve/ParallelSieve.hpp>
 #include <primesieve/PrimeSieve.hpp>
+#include <primesieve/SievingPrimesFile.hpp>
+#include <primesieve/ThreadPool.hpp>
+#include <primesieve/Wheel.hpp>
 #include <primesieve/pmath.hpp>
 
 #include <stdint.h>
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cassert>
 #include <chrono>
-#include <future>
-#include <mutex>
+#include <thread>
 #include <vector>
 
+#if defined(__linux__)
+  #include <sched.h>
+#endif
+
 using namespace std;
 using namespace primesieve;
 
@@ -34,23 +42,51 @@ counts_t& operator+=(counts_t& v1, const counts_t& v2)
   return v1;
 }
 
+#if defined(__linux__)
+
+/// Pin the calling thread to the CPUs of one NUMA node
+/// (threads are distributed round-robin over the nodes).
+/// Without pinning the OS migrates threads across nodes
+/// and their pre-sieve tables and bucket memory end up
+/// being read through the socket interconnect
+///
+void pinToNumaNode(int threadIndex)
+{
+  size_t nodes = cpuInfo.numaNodes();
+
+  if (nodes < 2)
+    return;
+
+  auto& cpus = cpuInfo.numaNodeCpus(threadIndex % nodes);
+
+  if (cpus.empty())
+    return;
+
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+
+  for (size_t cpu : cpus)
+    CPU_SET((int) cpu, &cpuSet);
+
+  sched_setaffinity(0, sizeof(cpuSet), &cpuSet);
+}
+
+#else
+
+void pinToNumaNode(int)
+{ }
+
+#endif
+
 } // namespace
 
 namespace primesieve {
 
 ParallelSieve::ParallelSieve() :
-  shm_(nullptr),
   numThreads_(getMaxThreads())
-{ }
-
-void ParallelSieve::init(SharedMemory& shm)
 {
-  setStart(shm.start);
-  setStop(shm.stop);
-  setSieveSize(shm.sieveSize);
-  setFlags(shm.flags);
-  setNumThreads(shm.threads);
-  shm_ = &shm;
+  shared_.processed = 0;
+  shared_.printedPercent = -1;
 }
 
 int ParallelSieve::getMaxThreads()
@@ -78,42 +114,140 @@ int ParallelSieve::idealNumThreads() const
     return 1;
 
   uint64_t threshold = isqrt(stop_) / 5;
-  threshold = max(threshold, config::MIN_THREAD_DISTANCE);
+  threshold = max(threshold, get_tuning().minThreadDistance);
   uint64_t threads = getDistance() / threshold;
   threads = inBetween(1, threads, numThreads_);
 
+  // When the per-thread working set (sieve array, sieving
+  // primes, bucket lists) greatly exceeds the per-core L2
+  // cache, sieving is memory bandwidth bound and running a
+  // thread on each SMT sibling only adds cache and
+  // bandwidth pressure. Cap at one thread per physical
+  // core in that regime, unless the user has explicitly
+  // chosen a thread count via setNumThreads().
+  if (numThreads_ == getMaxThreads() &&
+      cpuInfo.hasL2Cache() &&
+      cpuInfo.threadsPerCore() > 1)
+  {
+    uint64_t sieveBytes = (uint64_t) getSieveSize() << 10;
+    uint64_t workingSet = sieveBytes + primeCountApprox(isqrt(stop_)) * 16;
+
+    if (workingSet > cpuInfo.l2CacheSize() * 4)
+    {
+      uint64_t cores = getMaxThreads() / cpuInfo.threadsPerCore();
+      cores = max<uint64_t>(cores, 1);
+      threads = min(threads, cores);
+    }
+  }
+
   return (int) threads;
 }
 
-/// Get a thread distance which ensures a good load
-/// balance when using multiple threads
+/// Benchmark a few candidate thread counts on small
+/// subranges of [start_, stop_] and keep the fastest one.
+/// On memory bandwidth bound machines the bandwidth can
+/// saturate below the modeled thread count, the probe picks
+/// the empirically fastest count instead. Falls back to
+/// idealNumThreads() when the range is too small to
+/// amortize the probe.
 ///
-uint64_t ParallelSieve::getThreadDistance(int threads) const
+int ParallelSieve::calibrateNumThreads()
 {
-  assert(threads > 0);
+  int ideal = idealNumThreads();
 
-  uint64_t balanced = isqrt(stop_) * 1000;
-  uint64_t unbalanced = getDistance() / threads;
-  uint64_t fastest = min(balanced, unbalanced);
-  uint64_t threadDistance = max(config::MIN_THREAD_DISTANCE, fastest);
-  uint64_t iters = getDistance() / threadDistance;
+  if (ideal <= 1)
+  {
+    setNumThreads(max(1, ideal));
+    return getNumThreads();
+  }
+
+  // the candidates explore below the model's choice,
+  // duplicates are skipped
+  array<int, 3> candidates = { ideal, (ideal * 3) / 4, ideal / 2 };
+
+  uint64_t threshold = isqrt(stop_) / 5;
+  threshold = max(threshold, get_tuning().minThreadDistance);
+
+  // each candidate sieves enough chunks to keep all its
+  // threads busy; skip the probe if it is not amortized
+  uint64_t probeTotal = 0;
+  for (int threads : candidates)
+    probeTotal += threshold * threads;
+
+  if (getDistance() / 20 < probeTotal)
+  {
+    setNumThreads(ideal);
+    return getNumThreads();
+  }
 
-  if (iters < threads * 5u)
-    threadDistance = max(config::MIN_THREAD_DISTANCE, unbalanced);
+  uint64_t low = start_;
+  double bestRate = 0;
+  int best = ideal;
 
-  threadDistance += 30 - threadDistance % 30;
-  return threadDistance;
+  for (size_t i = 0; i < candidates.size(); i++)
+  {
+    int threads = candidates[i];
+    if (threads < 1 ||
+        (i > 0 && threads == candidates[i - 1]))
+      continue;
+
+    uint64_t high = low + threshold * threads;
+    ParallelSieve ps;
+    ps.setSieveSize(getSieveSize());
+    ps.setNumThreads(threads);
+    ps.sieve(low, high, COUNT_PRIMES);
+
+    double rate = (double) (high - low) / max(ps.getSeconds(), 1e-9);
+    if (rate > bestRate)
+    {
+      bestRate = rate;
+      best = threads;
+    }
+
+    low = high + 1;
+  }
+
+  setNumThreads(best);
+  return getNumThreads();
+}
+
+/// Get the distance of the next work chunk. Chunks shrink
+/// geometrically towards the end of the range: while much
+/// work remains the threads grab large chunks (low
+/// scheduling overhead), near the end they grab small
+/// chunks so that no thread idles while the last expensive
+/// high chunks finish
+///
+uint64_t ParallelSieve::getChunkDistance(uint64_t remaining, int threads) const
+{
+  assert(threads > 0);
+
+  // on hybrid CPUs (performance + efficiency cores) the
+  // efficiency cores finish chunks considerably slower,
+  // finer grained chunks prevent the fast cores from
+  // idling at the end of the range while an efficiency
+  // core works through a large tail chunk
+  uint64_t parts = threads * 4u;
+  if (cpuInfo.hasHybridCores())
+    parts = threads * 16u;
+
+  uint64_t balanced = isqrt(stop_) * 1000;
+  uint64_t chunk = remaining / parts;
+  chunk = min(chunk, balanced);
+  chunk = max(chunk, get_tuning().minThreadDistance);
+  chunk += 30 - chunk % 30;
+  return chunk;
 }
 
 /// Align n to modulo (30 + 2) to prevent prime k-tuplet
 /// (twin primes, prime triplets) gaps
 ///
-uint64_t ParallelSieve::align(uint64_t n) const
+uint64_t ParallelSieve::align(uint64_t n, uint64_t stop)
 {
   uint64_t n32 = checkedAdd(n, 32);
 
-  if (n32 >= stop_)
-    return stop_;
+  if (n32 >= stop)
+    return stop;
 
   return n32 - n % 30;
 }
@@ -124,6 +258,13 @@ uint64_t ParallelSieve::align(uint64_t n) const
 void ParallelSieve::sieve()
 {
   reset();
+  shared_.processed = 0;
+  shared_.printedPercent = -1;
+
+  // the progress callback needs the status
+  // to be computed while sieving
+  if (progressCallback_)
+    addFlags(CALCULATE_STATUS);
 
   if (start_ > stop_)
     return;
@@ -135,80 +276,202 @@ void ParallelSieve::sieve()
   else
   {
     auto t1 = chrono::system_clock::now();
-    uint64_t threadDistance = getThreadDistance(threads);
-    uint64_t iters = ((getDistance() - 1) / threadDistance) + 1;
-    threads = inBetween(1, threads, iters);
-    atomic<uint64_t> i(0);
 
-    // each thread executes 1 task
-    auto task = [&]()
+    // precompute the chunk boundaries upfront (same
+    // geometrically shrinking sizes as getChunkDistance
+    // hands out), so that acquiring a chunk in the workers
+    // is a single wait-free fetch_add on a ticket counter
+    // instead of a compare-exchange retry loop
+    vector<uint64_t> chunkLows;
+    uint64_t chunkLow = start_;
+
+    while (chunkLow < stop_)
+    {
+      chunkLows.push_back(chunkLow);
+      uint64_t dist = getChunkDistance(stop_ - chunkLow, threads);
+      chunkLow = checkedAdd(chunkLow, dist);
+    }
+
+    // the ticket counter is contended by all workers,
+    // isolate it on its own cache line so that its updates
+    // do not invalidate the stack slots around it (e.g. the
+    // sieving prime table header that every worker reads
+    // per segment)
+    struct alignas(64) ChunkCounter
+    {
+      atomic<uint64_t> ticket;
+    };
+    ChunkCounter chunk;
+    chunk.ticket = 0;
+
+    // compute the sieving primes once and share the
+    // read-only table across all worker threads, instead
+    // of each worker re-sieving the identical sqrt(stop)
+    // range for each of its chunks. A persisted snapshot
+    // that covers sqrt(stop) replaces even that one-time
+    // computation by a memory-mapping, see
+    // set_sieving_primes_file()
+    vector<uint64_t> sievingPrimes;
+    vector<PrimeReciprocal> sievingPrimeRecips;
+    auto snapshot = SievingPrimesFile::getShared(isqrt(stop_));
+    const uint64_t* primes;
+    uint64_t numPrimes;
+    const PrimeReciprocal* recips;
+
+    if (snapshot)
+    {
+      primes = snapshot->primes();
+      numPrimes = snapshot->size();
+      recips = snapshot->recips();
+    }
+    else
+    {
+      generate_primes(7, isqrt(stop_), &sievingPrimes);
+
+      // precompute the first multiple reciprocal of each
+      // sieving prime once and share the read-only table
+      // across all workers: every worker re-inserts the same
+      // primes once per chunk and the per prime quotient
+      // computations are a measurable part of that spin-up
+      // phase at big sqrt(stop), see PrimeReciprocal
+      sievingPrimeRecips.resize(sievingPrimes.size());
+      for (size_t i = 0; i < sievingPrimes.size(); i++)
+        sievingPrimeRecips[i].init(sievingPrimes[i]);
+
+      primes = sievingPrimes.data();
+      numPrimes = sievingPrimes.size();
+      recips = sievingPrimeRecips.data();
+    }
+
+    // per-worker sieving results, each worker accumulates
+    // into its own cache line padded slot so that the
+    // writes of neighbouring workers never invalidate
+    // each other's cache lines
+    struct alignas(64) WorkerContext
     {
-      PrimeSieve ps(this);
-      uint64_t j;
       counts_t counts;
-      counts.fill(0);
+      SieveStats stats;
+      /// Lowest position a cancelled chunk stopped at
+      uint64_t stoppedAt = ~0ull;
+    };
+    vector<WorkerContext> workers(threads);
 
-      while ((j = i++) < iters)
+    // each thread executes 1 task, the threads grab
+    // tickets from the shared counter until the
+    // precomputed chunk table is exhausted
+    auto task = [&](int threadIndex)
+    {
+      pinToNumaNode(threadIndex);
+      PrimeSieve ps(this);
+      ps.setSievingPrimes(primes, numPrimes);
+      ps.setSievingPrimeRecips(recips);
+      WorkerContext& worker = workers[threadIndex];
+      worker.counts.fill(0);
+
+      while (!isCanceled())
       {
-        uint64_t start = start_ + j * threadDistance;
-        uint64_t stop = checkedAdd(start, threadDistance);
-        stop = align(stop);
+        uint64_t i = chunk.ticket.fetch_add(1, memory_order_relaxed);
+        if (i >= chunkLows.size())
+          break;
+
+        uint64_t start = chunkLows[i];
+        uint64_t chunkHigh = (i + 1 < chunkLows.size()) ? chunkLows[i + 1] : stop_;
+        uint64_t stop = align(chunkHigh, stop_);
         if (start > start_)
-          start = align(start) + 1;
+          start = align(start, stop_) + 1;
 
         // sieve the range [start, stop]
         ps.sieve(start, stop);
-        counts += ps.getCounts();
-      }
+        worker.counts += ps.getCounts();
+        worker.stats += ps.getStats();
 
-      return counts;
+        // a chunk interrupted by cancellation is only
+        // sieved up to its getStoppedAt() position
+        if (ps.getStoppedAt() < stop)
+          worker.stoppedAt = min(worker.stoppedAt, ps.getStoppedAt());
+      }
     };
 
-    vector<future<counts_t>> futures;
-    futures.reserve(threads);
+    // submit the tasks to the persistent thread pool,
+    // reusing its threads avoids the thread spawn/join
+    // overhead of std::async for each sieve() call
+    ThreadPool::getInstance().execute(threads, task);
 
-    for (int t = 0; t < threads; t++)
-      futures.emplace_back(async(launch::async, task));
+    for (auto& worker : workers)
+    {
+      counts_ += worker.counts;
+      stats_ += worker.stats;
+    }
 
-    for (auto &f : futures)
-      counts_ += f.get();
+    if (isCanceled())
+    {
+      // the results are complete up to the lowest position
+      // a worker stopped at, or up to the first chunk that
+      // no worker has claimed. Every ticket < the final
+      // counter value has been fetched and its chunk sieved
+      // (at least partially)
+      uint64_t claimed = chunk.ticket.load(memory_order_relaxed);
+      claimed = min<uint64_t>(claimed, chunkLows.size());
+      uint64_t stoppedAt = stop_;
+      if (claimed < chunkLows.size())
+        stoppedAt = (chunkLows[claimed] > 0) ? chunkLows[claimed] - 1 : 0;
+      for (auto& worker : workers)
+        stoppedAt = min(stoppedAt, worker.stoppedAt);
+      stoppedAt_ = stoppedAt;
+    }
 
     auto t2 = chrono::system_clock::now();
     chrono::duration<double> seconds = t2 - t1;
     seconds_ = seconds.count();
-  }
 
-  if (shm_)
-  {
-    // communicate the sieving results to
-    // the primesieve GUI application
-    copy(counts_.begin(), counts_.end(), shm_->counts);
-    shm_->seconds = seconds_;
+    // the final status must not be dropped
+    // by the callback's rate limit
+    if (progressCallback_)
+      progressCallback_(100);
   }
 }
 
-/// Print status in percent to stdout
+/// Print status in percent to stdout.
+/// The sieving threads accumulate their processed segments
+/// into an atomic counter with relaxed ordering, there is
+/// no lock on this path. Only the thread that first reaches
+/// a new percent value aggregates and prints it.
 /// @processed:  Sum of recently processed segments
-/// @tryLock:    Do not block if tryLock = true
 ///
-bool ParallelSieve::updateStatus(uint64_t processed, bool tryLock)
+bool ParallelSieve::updateStatus(uint64_t processed, bool)
 {
-  unique_lock<mutex> lock(lock_, defer_lock);
+  uint64_t total = shared_.processed.fetch_add(processed, memory_order_relaxed) + processed;
 
-  if (tryLock)
-    lock.try_lock();
-  else
-    lock.lock();
+  double percent = 100;
+  if (getDistance() > 0)
+    percent = total * 100.0 / getDistance();
+  percent = min(percent, 100.0);
+
+  if (progressCallback_)
+    invokeProgressCallback(percent);
 
-  if (lock.owns_lock())
+  int newPercent = (int) percent;
+  int oldPercent = shared_.printedPercent.load(memory_order_relaxed);
+
+  while (newPercent > oldPercent)
   {
-    PrimeSieve::updateStatus(processed);
-    if (shm_)
-      shm_->status = getStatus();
-    return true;
+    if (shared_.printedPercent.compare_exchange_weak(oldPercent, newPercent))
+    {
+      // max-update: two CAS winners may store in either
+      // order, a stale status must not overwrite a newer
+      // one (getStatus() is polled cross-thread and
+      // must be monotonic)
+      double oldStatus = percent_.load(memory_order_relaxed);
+      while (percent > oldStatus &&
+             !percent_.compare_exchange_weak(oldStatus, percent, memory_order_relaxed));
+
+      if (isFlag(PRINT_STATUS))
+        printStatus(oldPercent, percent);
+      break;
+    }
   }
 
-  return false;
+  return true;
 }
 
 } // namespace
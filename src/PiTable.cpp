@@ -0,0 +1,172 @@
+///
+/// @file   PiTable.cpp
+/// @brief  The PiTable caches pi(x) at checkpoints of 10^9 so
+///         that repeated prime counting queries only need to
+///         sieve the residual subrange above the largest
+///         checkpoint <= stop. The table is built on demand and
+///         kept for the lifetime of the process. If the
+///         PRIMESIEVE_PI_FILE environment variable is set the
+///         table is additionally persisted to that file, so a
+///         table generated once can be reused across runs.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/ParallelSieve.hpp>
+#include <primesieve/PiTable.hpp>
+#include <primesieve/PrimeSieve.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+/// Distance between two pi(x) checkpoints
+const uint64_t checkpointDist = 1000000000ull;
+
+/// Upper limit for the size of the checkpoint table,
+/// 2^22 entries = 32 megabytes, enough for
+/// stop < 4.2 * 10^15
+const uint64_t maxCheckpoints = 1 << 22;
+
+/// Count the primes inside [start, stop] using the
+/// sieve size and number of threads configured via
+/// the set_sieve_size() and set_num_threads() API
+///
+uint64_t countPrimes(uint64_t start, uint64_t stop)
+{
+  primesieve::ParallelSieve ps;
+  ps.setSieveSize(primesieve::get_sieve_size());
+  ps.setNumThreads(primesieve::get_num_threads());
+  ps.sieve(start, stop, primesieve::COUNT_PRIMES);
+  return ps.getCount(0);
+}
+
+string getFilePath()
+{
+  const char* path = getenv("PRIMESIEVE_PI_FILE");
+  return (path) ? path : string();
+}
+
+} // namespace
+
+namespace primesieve {
+
+PiTable& PiTable::getInstance()
+{
+  static PiTable piTable;
+  return piTable;
+}
+
+uint64_t PiTable::distance()
+{
+  return checkpointDist;
+}
+
+/// Count the primes <= stop. All checkpoints <= stop are
+/// answered from the table (extending it if necessary),
+/// only the residual (checkpoint, stop] subrange is sieved
+///
+uint64_t PiTable::pi(uint64_t stop)
+{
+  uint64_t checkpoints = stop / checkpointDist;
+  checkpoints = min(checkpoints, maxCheckpoints);
+  uint64_t count = 0;
+
+  if (checkpoints > 0)
+  {
+    unique_lock<mutex> guard(lock_);
+
+    if (!loaded_)
+      load();
+    if (pi_.size() < checkpoints)
+      extend(checkpoints);
+
+    count = pi_[checkpoints - 1];
+  }
+
+  uint64_t low = checkpoints * checkpointDist;
+  if (low < stop)
+    count += countPrimes(low + 1, stop);
+
+  return count;
+}
+
+/// Extend the table up to @checkpoints entries by sieving
+/// the missing [checkpoint, checkpoint + 10^9] subranges,
+/// must be called while holding lock_
+///
+void PiTable::extend(uint64_t checkpoints)
+{
+  pi_.reserve(checkpoints);
+
+  while (pi_.size() < checkpoints)
+  {
+    uint64_t i = pi_.size();
+    uint64_t low = i * checkpointDist;
+    uint64_t count = (i > 0) ? pi_[i - 1] : 0;
+    count += countPrimes(low + 1, low + checkpointDist);
+    pi_.push_back(count);
+  }
+
+  save();
+}
+
+/// Load the checkpoint table from the file pointed to by
+/// the PRIMESIEVE_PI_FILE environment variable. The first
+/// 64-bit word is the checkpoint distance, the table is
+/// ignored if it has been generated with a different one
+///
+void PiTable::load()
+{
+  loaded_ = true;
+  string filePath = getFilePath();
+  if (filePath.empty())
+    return;
+
+  ifstream file(filePath, ifstream::binary);
+  if (!file)
+    return;
+
+  uint64_t dist = 0;
+  file.read((char*) &dist, sizeof(dist));
+  if (!file || dist != checkpointDist)
+    return;
+
+  uint64_t count;
+  while (file.read((char*) &count, sizeof(count)))
+    pi_.push_back(count);
+}
+
+void PiTable::save() const
+{
+  string filePath = getFilePath();
+  if (filePath.empty())
+    return;
+
+  string tmpFile = filePath + ".tmp";
+  ofstream file(tmpFile, ofstream::binary | ofstream::trunc);
+  if (!file)
+    return;
+
+  file.write((const char*) &checkpointDist, sizeof(checkpointDist));
+  file.write((const char*) pi_.data(), pi_.size() * sizeof(uint64_t));
+  file.close();
+
+  remove(filePath.c_str());
+  rename(tmpFile.c_str(), filePath.c_str());
+}
+
+} // namespace
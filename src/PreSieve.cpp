@@ -10,6 +10,7 @@
 ///
 
 #include <primesieve/PreSieve.hpp>
+#include <primesieve/CpuInfo.hpp>
 #include <primesieve/EratSmall.hpp>
 #include <primesieve/pmath.hpp>
 #include <primesieve/types.hpp>
@@ -17,7 +18,19 @@
 #include <stdint.h>
 #include <algorithm>
 #include <array>
+#include <cstring>
 #include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) && \
+   (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+  #define HAS_AVX2_PRESIEVE
+  #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+  #define HAS_NEON_PRESIEVE
+  #include <arm_neon.h>
+#endif
 
 using namespace std;
 using namespace primesieve;
@@ -30,6 +43,241 @@ const array<uint64_t, 5> primes = { 7, 11, 13, 17, 19 };
 // prime products of primes >= 7
 const array<uint64_t, 5> primeProducts = { 210, 2310, 30030, 510510, 9699690 };
 
+/// Extended pre-sieve table for the primes { 23, 29, 31 }.
+/// The table is built lazily on first use and shared
+/// read-only between all threads, this way the threads of
+/// ParallelSieve do not each build their own table.
+///
+struct ExtendedPreSieve
+{
+  enum : uint64_t { primeProduct = 30 * 23 * 29 * 31 };
+  std::vector<byte_t> buffer;
+
+  void init()
+  {
+    uint64_t size = primeProduct / 30;
+    buffer.resize(size, 0xff);
+
+    EratSmall eratSmall;
+    uint64_t stop = primeProduct * 2;
+    eratSmall.init(stop, size, 31);
+
+    for (uint64_t prime : { 23, 29, 31 })
+      eratSmall.addSievingPrime(prime, primeProduct);
+
+    eratSmall.crossOff(&buffer[0], size);
+  }
+};
+
+/// Build a pre-sieve buffer by removing the multiples
+/// of the primes <= maxPrime from it
+///
+void initBuffer(vector<byte_t>& buffer,
+                uint64_t maxPrime,
+                uint64_t primeProduct)
+{
+  uint64_t size = primeProduct / 30;
+  buffer.resize(size, 0xff);
+
+  EratSmall eratSmall;
+  uint64_t stop = primeProduct * 2;
+  eratSmall.init(stop, size, maxPrime);
+
+  for (uint64_t prime : primes)
+    if (prime <= maxPrime)
+      eratSmall.addSievingPrime(prime, primeProduct);
+
+  eratSmall.crossOff(&buffer[0], size);
+}
+
+/// Process-wide cache of the pre-sieve buffers, keyed by
+/// maxPrime (one entry per element of the primes array)
+/// and replicated once per NUMA node. Each buffer is built
+/// lazily on first use and then shared read-only by all
+/// concurrent sieves, so short-lived PrimeSieve objects no
+/// longer pay the buffer initialization cost on every
+/// sieve() call.
+///
+struct BufferCache
+{
+  vector<array<vector<byte_t>, 5>> buffers;
+  unique_ptr<once_flag[]> flags;
+
+  BufferCache()
+  {
+    size_t nodes = max<size_t>(1, cpuInfo.numaNodes());
+    buffers.resize(nodes);
+    flags.reset(new once_flag[nodes * primes.size()]);
+  }
+};
+
+BufferCache& getBufferCache()
+{
+  static BufferCache cache;
+  return cache;
+}
+
+/// On NUMA systems the table is replicated once per node:
+/// each replica is built by the first thread running on
+/// that node, so its pages are allocated in node-local
+/// memory (first touch) and the copy loops never read the
+/// table through the socket interconnect
+///
+struct ExtendedTables
+{
+  vector<ExtendedPreSieve> replicas;
+  unique_ptr<once_flag[]> flags;
+
+  ExtendedTables()
+  {
+    size_t nodes = max<size_t>(1, cpuInfo.numaNodes());
+    replicas.resize(nodes);
+    flags.reset(new once_flag[nodes]);
+  }
+};
+
+ExtendedTables& getExtendedTables()
+{
+  static ExtendedTables tables;
+  return tables;
+}
+
+/// AND the pre-sieve buffer into the sieve
+/// array, 8 bytes at a time
+///
+void andBytesGeneric(byte_t* sieve,
+                     const byte_t* buffer,
+                     uint64_t bytes)
+{
+  uint64_t i = 0;
+
+  for (; i + 8 <= bytes; i += 8)
+  {
+    uint64_t bits;
+    uint64_t mask;
+    memcpy(&bits, &sieve[i], 8);
+    memcpy(&mask, &buffer[i], 8);
+    bits &= mask;
+    memcpy(&sieve[i], &bits, 8);
+  }
+
+  for (; i < bytes; i++)
+    sieve[i] &= buffer[i];
+}
+
+#if defined(HAS_AVX2_PRESIEVE)
+
+/// AVX2 version of andBytesGeneric(), each
+/// iteration updates 32 sieve bytes
+///
+__attribute__((target("avx2")))
+void andBytesAvx2(byte_t* sieve,
+                  const byte_t* buffer,
+                  uint64_t bytes)
+{
+  uint64_t i = 0;
+
+  for (; i + 32 <= bytes; i += 32)
+  {
+    __m256i bits = _mm256_loadu_si256((const __m256i*) &sieve[i]);
+    __m256i mask = _mm256_loadu_si256((const __m256i*) &buffer[i]);
+    _mm256_storeu_si256((__m256i*) &sieve[i], _mm256_and_si256(bits, mask));
+  }
+
+  andBytesGeneric(&sieve[i], &buffer[i], bytes - i);
+}
+
+/// Copy the pre-sieve buffer to the sieve array using
+/// non-temporal stores. This is used for segments larger
+/// than the L2 cache: the first segment bytes would be
+/// evicted again before the sieving loops reach them, so
+/// the copy should not pollute the cache. libc's memcpy
+/// makes the same switch, but based on the size of the
+/// individual copy which here is at most one buffer
+/// (<= 316 kilobytes) and hence always below its
+/// non-temporal threshold.
+///
+__attribute__((target("avx2")))
+void copyBytesAvx2Stream(byte_t* sieve,
+                         const byte_t* buffer,
+                         uint64_t bytes)
+{
+  // _mm256_stream_si256 requires the store
+  // addresses to be aligned to 32 bytes
+  uint64_t align = (32 - (uintptr_t) sieve % 32) % 32;
+  align = min(align, bytes);
+  copy_n(buffer, align, sieve);
+  sieve += align;
+  buffer += align;
+  bytes -= align;
+  uint64_t i = 0;
+
+  for (; i + 32 <= bytes; i += 32)
+  {
+    __m256i bits = _mm256_loadu_si256((const __m256i*) &buffer[i]);
+    _mm256_stream_si256((__m256i*) &sieve[i], bits);
+  }
+
+  _mm_sfence();
+  copy_n(&buffer[i], bytes - i, &sieve[i]);
+}
+
+#elif defined(HAS_NEON_PRESIEVE)
+
+/// NEON version of andBytesGeneric(), each iteration
+/// updates 32 sieve bytes using two 128-bit ANDs
+///
+void andBytesNeon(byte_t* sieve,
+                  const byte_t* buffer,
+                  uint64_t bytes)
+{
+  uint64_t i = 0;
+
+  for (; i + 32 <= bytes; i += 32)
+  {
+    uint8x16_t lo = vandq_u8(vld1q_u8(&sieve[i]), vld1q_u8(&buffer[i]));
+    uint8x16_t hi = vandq_u8(vld1q_u8(&sieve[i + 16]), vld1q_u8(&buffer[i + 16]));
+    vst1q_u8(&sieve[i], lo);
+    vst1q_u8(&sieve[i + 16], hi);
+  }
+
+  andBytesGeneric(&sieve[i], &buffer[i], bytes - i);
+}
+
+#endif
+
+void andBytes(byte_t* sieve,
+              const byte_t* buffer,
+              uint64_t bytes)
+{
+#if defined(HAS_AVX2_PRESIEVE)
+  if (cpuInfo.hasAVX2())
+    andBytesAvx2(sieve, buffer, bytes);
+  else
+#elif defined(HAS_NEON_PRESIEVE)
+  if (cpuInfo.hasNEON())
+    andBytesNeon(sieve, buffer, bytes);
+  else
+#endif
+    andBytesGeneric(sieve, buffer, bytes);
+}
+
+void copyBytes(byte_t* sieve,
+               const byte_t* buffer,
+               uint64_t bytes,
+               bool stream)
+{
+#if defined(HAS_AVX2_PRESIEVE)
+  if (stream && cpuInfo.hasAVX2())
+  {
+    copyBytesAvx2Stream(sieve, buffer, bytes);
+    return;
+  }
+#endif
+  (void) stream;
+  copy_n(buffer, bytes, sieve);
+}
+
 } // namespace
 
 namespace primesieve {
@@ -49,29 +297,29 @@ PreSieve::PreSieve(uint64_t start, uint64_t stop)
   i = min(i, primes.size() - 1);
   maxPrime_ = primes[i];
   primeProduct_ = primeProducts[i];
-
-  init();
-}
-
-/// Pre-sieve a small buffer by removing the
-/// multiples of primes <= maxPrime.
-///
-void PreSieve::init()
-{
   size_ = primeProduct_ / 30;
-  buffer_ = new byte_t[size_];
-  deleter_.reset(buffer_);
-  fill_n(buffer_, size_, 0xff);
-
-  EratSmall eratSmall;
-  uint64_t stop = primeProduct_ * 2;
-  eratSmall.init(stop, size_, maxPrime_);
 
-  for (uint64_t prime : primes)
-    if (prime <= maxPrime_)
-      eratSmall.addSievingPrime(prime, primeProduct_);
+  // get the shared buffer from the process-wide
+  // cache, build it on first use
+  auto& cache = getBufferCache();
+  size_t node = min(cpuInfo.currentNumaNode(), cache.buffers.size() - 1);
+  auto& buffer = cache.buffers[node][i];
+  uint64_t maxPrime = maxPrime_;
+  uint64_t primeProduct = primeProduct_;
+  call_once(cache.flags[node * primes.size() + i],
+            [&]{ initBuffer(buffer, maxPrime, primeProduct); });
+  buffer_ = &buffer[0];
 
-  eratSmall.crossOff(buffer_, size_);
+  // for large sieving ranges additionally pre-sieve the
+  // multiples of { 23, 29, 31 } using the shared table
+  if (threshold > primeProducts.back())
+  {
+    auto& tables = getExtendedTables();
+    size_t node = min(cpuInfo.currentNumaNode(), tables.replicas.size() - 1);
+    call_once(tables.flags[node], [&]{ tables.replicas[node].init(); });
+    extendedBuffer_ = &tables.replicas[node].buffer[0];
+    maxPrime_ = 31;
+  }
 }
 
 /// Copy pre-sieved buffer to sieve array
@@ -84,19 +332,53 @@ void PreSieve::copy(byte_t* sieve,
   uint64_t i = remainder / 30;
   uint64_t sizeLeft = size_ - i;
 
+  // segments larger than the L2 cache are copied
+  // using non-temporal stores, see copyBytesAvx2Stream()
+  bool stream = cpuInfo.hasL2Cache() &&
+                sieveSize > cpuInfo.l2CacheSize();
+
   if (sieveSize <= sizeLeft)
-    copy_n(&buffer_[i], sieveSize, sieve);
+    copyBytes(sieve, &buffer_[i], sieveSize, stream);
   else
   {
     // copy the last remaining bytes of buffer
     // to the beginning of the sieve array
-    copy_n(&buffer_[i], sizeLeft, sieve);
+    copyBytes(sieve, &buffer_[i], sizeLeft, stream);
 
     // restart copying at the beginning of buffer
     for (i = sizeLeft; i + size_ < sieveSize; i += size_)
-      copy_n(buffer_, size_, &sieve[i]);
+      copyBytes(&sieve[i], buffer_, size_, stream);
+
+    copyBytes(&sieve[i], buffer_, sieveSize - i, stream);
+  }
 
-    copy_n(buffer_, sieveSize - i, &sieve[i]);
+  if (extendedBuffer_)
+    applyExtended(sieve, sieveSize, segmentLow);
+}
+
+/// AND the extended pre-sieve table into the sieve array
+/// to remove the multiples of { 23, 29, 31 }
+///
+void PreSieve::applyExtended(byte_t* sieve,
+                             uint64_t sieveSize,
+                             uint64_t segmentLow) const
+{
+  uint64_t size = ExtendedPreSieve::primeProduct / 30;
+  const byte_t* buffer = extendedBuffer_;
+
+  // find segmentLow index
+  uint64_t remainder = segmentLow % ExtendedPreSieve::primeProduct;
+  uint64_t i = remainder / 30;
+  uint64_t j = 0;
+
+  while (j < sieveSize)
+  {
+    uint64_t bytes = min(sieveSize - j, size - i);
+    andBytes(&sieve[j], &buffer[i], bytes);
+    j += bytes;
+    i += bytes;
+    if (i == size)
+      i = 0;
   }
 }
 
@@ -0,0 +1,433 @@
+///
+/// @file   PrimeBitmap.cpp
+/// @brief  Compressed prime indicator bitmaps with hybrid
+///         (array / bitmap) containers, built directly from the
+///         sieve array bytes. Unlike general purpose compressed
+///         bitmaps no run containers are used: prime indicator
+///         bitmaps contain no long runs of set bits, only empty
+///         windows, which are simply omitted.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/littleendian_cast.hpp>
+#include <primesieve/PrimeBitmap.hpp>
+#include <primesieve/primesieve_error.hpp>
+#include <primesieve/types.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+/// File format identifier
+const char magic[8] = { 'p', 'b', 'i', 't', 'm', 'a', 'p', '1' };
+
+/// Sieve bytes per window
+const uint64_t windowBytes = 4096;
+
+/// Numbers per window, each sieve
+/// byte covers 30 numbers
+const uint64_t windowNumbers = windowBytes * 30;
+
+/// Bit values of the sieve byte layout
+const uint8_t bitValues[8] = { 7, 11, 13, 17, 19, 23, 29, 31 };
+
+/// Maps n % 30 to its bit position inside the sieve byte,
+/// -1 for the residues the wheel skips. The residue 1
+/// corresponds to bit 7 (value 31) of the previous byte.
+///
+const int8_t bitForResidue[30] =
+{
+  -1,  7, -1, -1, -1, -1, -1,  0, -1, -1,
+  -1,  1, -1,  2, -1, -1, -1,  3, -1,  4,
+  -1, -1, -1,  5, -1, -1, -1, -1, -1,  6
+};
+
+/// Number corresponding to the bit
+/// position pos inside a window
+uint64_t bitPosToNumber(uint64_t low, uint64_t pos)
+{
+  return low + (pos / 8) * 30 + bitValues[pos % 8];
+}
+
+/// Bit of the smallMask_ flagging
+/// the primes 2, 3 and 5
+int smallMaskBit(uint64_t prime)
+{
+  return (prime == 2) ? 0 : (prime == 3) ? 1 : 2;
+}
+
+uint64_t bitScanForward(uint64_t bits)
+{
+#if defined(__GNUC__) || \
+    defined(__clang__)
+  return __builtin_ctzll(bits);
+#else
+  uint64_t pos = 0;
+  while (!(bits & 1))
+  {
+    bits >>= 1;
+    pos++;
+  }
+  return pos;
+#endif
+}
+
+} // namespace
+
+namespace primesieve {
+
+/// Build a container from a window's sieve bytes:
+/// array encoding if it is smaller than the raw
+/// bytes, otherwise keep the bytes
+///
+PrimeBitmap::Container PrimeBitmap::makeContainer(uint64_t low, const uint8_t* window)
+{
+  Container container;
+  container.low = low;
+  container.count = (uint32_t) popcount((const uint64_t*) window, windowBytes / 8);
+
+  if (container.count * 2 < windowBytes)
+  {
+    container.type = ARRAY;
+    container.bits.reserve(container.count);
+
+    for (uint64_t i = 0; i < windowBytes; i += 8)
+    {
+      uint64_t bits = littleendian_cast<uint64_t>(&window[i]);
+      while (bits)
+      {
+        uint64_t pos = i * 8 + bitScanForward(bits);
+        bits &= bits - 1;
+        container.bits.push_back((uint16_t) pos);
+      }
+    }
+  }
+  else
+  {
+    container.type = BITMAP;
+    container.bytes.assign(window, window + windowBytes);
+  }
+
+  return container;
+}
+
+PrimeBitmap PrimeBitmap::sieve(uint64_t start, uint64_t stop)
+{
+  PrimeBitmap bitmap;
+  bitmap.start_ = start;
+  bitmap.stop_ = stop;
+
+  if (start > stop)
+    return bitmap;
+
+  for (uint64_t prime : { 2, 3, 5 })
+    if (prime >= start && prime <= stop)
+      bitmap.smallMask_ |= 1 << smallMaskBit(prime);
+
+  // the windows are filled straight from the segment
+  // stream, a window may span two segments
+  vector<uint8_t> window(windowBytes, 0);
+  uint64_t windowLow = ~0ull;
+
+  auto flush = [&]()
+  {
+    Container container = makeContainer(windowLow, window.data());
+    if (container.count > 0)
+      bitmap.containers_.push_back(std::move(container));
+    fill(window.begin(), window.end(), 0);
+  };
+
+  sieve_segments(start, stop,
+    [&](uint64_t low, const uint8_t* sieve, size_t size)
+    {
+      uint64_t byteIdx = low / 30;
+
+      while (size > 0)
+      {
+        uint64_t offset = byteIdx % windowBytes;
+        uint64_t currentLow = (byteIdx - offset) * 30;
+
+        if (currentLow != windowLow)
+        {
+          if (windowLow != ~0ull)
+            flush();
+          windowLow = currentLow;
+        }
+
+        uint64_t bytes = min((uint64_t) size, windowBytes - offset);
+        copy_n(sieve, bytes, &window[offset]);
+        sieve += bytes;
+        size -= bytes;
+        byteIdx += bytes;
+      }
+    });
+
+  if (windowLow != ~0ull)
+    flush();
+
+  return bitmap;
+}
+
+uint64_t PrimeBitmap::count() const
+{
+  uint64_t count = 0;
+
+  for (uint64_t prime : { 2, 3, 5 })
+    count += (smallMask_ >> smallMaskBit(prime)) & 1;
+
+  for (const Container& container : containers_)
+    count += container.count;
+
+  return count;
+}
+
+/// Find the container whose window contains low
+const PrimeBitmap::Container* PrimeBitmap::findContainer(uint64_t low) const
+{
+  auto it = upper_bound(containers_.begin(), containers_.end(), low,
+    [](uint64_t n, const Container& container)
+    {
+      return n < container.low;
+    });
+
+  if (it == containers_.begin())
+    return nullptr;
+
+  const Container& container = *(it - 1);
+  if (low >= container.low + windowNumbers)
+    return nullptr;
+
+  return &container;
+}
+
+bool PrimeBitmap::contains(uint64_t n) const
+{
+  if (n < 7)
+  {
+    if (n == 2 || n == 3 || n == 5)
+      return (smallMask_ >> smallMaskBit(n)) & 1;
+    return false;
+  }
+
+  uint64_t byteIdx = n / 30;
+  int8_t bit = bitForResidue[n % 30];
+
+  if (bit < 0)
+    return false;
+  if (bit == 7)
+    byteIdx -= 1;
+
+  const Container* container = findContainer(byteIdx * 30);
+  if (!container)
+    return false;
+
+  uint64_t offset = byteIdx - container->low / 30;
+  uint16_t pos = (uint16_t) (offset * 8 + bit);
+
+  if (container->type == BITMAP)
+    return (container->bytes[offset] >> bit) & 1;
+
+  return binary_search(container->bits.begin(), container->bits.end(), pos);
+}
+
+void PrimeBitmap::intersect(const PrimeBitmap& other)
+{
+  smallMask_ &= other.smallMask_;
+  start_ = max(start_, other.start_);
+  stop_ = min(stop_, other.stop_);
+
+  vector<Container> result;
+  auto it1 = containers_.begin();
+  auto it2 = other.containers_.begin();
+
+  while (it1 != containers_.end() &&
+         it2 != other.containers_.end())
+  {
+    if (it1->low < it2->low)
+      ++it1;
+    else if (it2->low < it1->low)
+      ++it2;
+    else
+    {
+      Container container;
+
+      if (it1->type == BITMAP &&
+          it2->type == BITMAP)
+      {
+        // AND the windows, then re-encode as the
+        // result may have become sparse
+        vector<uint8_t> window(windowBytes);
+        for (uint64_t i = 0; i < windowBytes; i++)
+          window[i] = it1->bytes[i] & it2->bytes[i];
+        container = makeContainer(it1->low, window.data());
+      }
+      else if (it1->type == ARRAY &&
+               it2->type == ARRAY)
+      {
+        container.low = it1->low;
+        container.type = ARRAY;
+        set_intersection(it1->bits.begin(), it1->bits.end(),
+                         it2->bits.begin(), it2->bits.end(),
+                         back_inserter(container.bits));
+        container.count = (uint32_t) container.bits.size();
+      }
+      else
+      {
+        // filter the sparse container's bit
+        // positions through the bitmap
+        const Container& array = (it1->type == ARRAY) ? *it1 : *it2;
+        const Container& bitmap = (it1->type == ARRAY) ? *it2 : *it1;
+
+        container.low = array.low;
+        container.type = ARRAY;
+
+        for (uint16_t pos : array.bits)
+          if ((bitmap.bytes[pos / 8] >> (pos % 8)) & 1)
+            container.bits.push_back(pos);
+
+        container.count = (uint32_t) container.bits.size();
+      }
+
+      if (container.count > 0)
+        result.push_back(std::move(container));
+
+      ++it1;
+      ++it2;
+    }
+  }
+
+  containers_ = std::move(result);
+}
+
+void PrimeBitmap::decode(vector<uint64_t>& primes) const
+{
+  for (uint64_t prime : { 2, 3, 5 })
+    if ((smallMask_ >> smallMaskBit(prime)) & 1)
+      primes.push_back(prime);
+
+  for (const Container& container : containers_)
+  {
+    if (container.type == ARRAY)
+    {
+      for (uint16_t pos : container.bits)
+        primes.push_back(bitPosToNumber(container.low, pos));
+    }
+    else
+    {
+      for (uint64_t i = 0; i < windowBytes; i += 8)
+      {
+        uint64_t bits = littleendian_cast<uint64_t>(&container.bytes[i]);
+        while (bits)
+        {
+          uint64_t pos = i * 8 + bitScanForward(bits);
+          bits &= bits - 1;
+          primes.push_back(bitPosToNumber(container.low, pos));
+        }
+      }
+    }
+  }
+}
+
+uint64_t PrimeBitmap::byteSize() const
+{
+  // magic + start + stop + smallMask + container count
+  uint64_t size = sizeof(magic) + 8 + 8 + 1 + 8;
+
+  for (const Container& container : containers_)
+  {
+    // low + count + type
+    size += 8 + 4 + 1;
+    size += container.bits.size() * 2;
+    size += container.bytes.size();
+  }
+
+  return size;
+}
+
+void PrimeBitmap::save(const string& filePath) const
+{
+  ofstream file(filePath, ofstream::binary | ofstream::trunc);
+  if (!file)
+    throw primesieve_error("cannot open file: " + filePath);
+
+  uint64_t numContainers = containers_.size();
+  file.write(magic, sizeof(magic));
+  file.write((const char*) &start_, 8);
+  file.write((const char*) &stop_, 8);
+  file.write((const char*) &smallMask_, 1);
+  file.write((const char*) &numContainers, 8);
+
+  for (const Container& container : containers_)
+  {
+    file.write((const char*) &container.low, 8);
+    file.write((const char*) &container.count, 4);
+    file.write((const char*) &container.type, 1);
+
+    if (container.type == ARRAY)
+      file.write((const char*) container.bits.data(), container.bits.size() * 2);
+    else
+      file.write((const char*) container.bytes.data(), container.bytes.size());
+  }
+}
+
+PrimeBitmap PrimeBitmap::load(const string& filePath)
+{
+  ifstream file(filePath, ifstream::binary);
+  if (!file)
+    throw primesieve_error("cannot open file: " + filePath);
+
+  char fileMagic[8];
+  file.read(fileMagic, sizeof(fileMagic));
+  if (!file || memcmp(fileMagic, magic, sizeof(magic)) != 0)
+    throw primesieve_error("invalid prime bitmap file: " + filePath);
+
+  PrimeBitmap bitmap;
+  uint64_t numContainers = 0;
+  file.read((char*) &bitmap.start_, 8);
+  file.read((char*) &bitmap.stop_, 8);
+  file.read((char*) &bitmap.smallMask_, 1);
+  file.read((char*) &numContainers, 8);
+  bitmap.containers_.reserve(numContainers);
+
+  for (uint64_t i = 0; i < numContainers; i++)
+  {
+    Container container;
+    file.read((char*) &container.low, 8);
+    file.read((char*) &container.count, 4);
+    file.read((char*) &container.type, 1);
+
+    if (container.type == ARRAY)
+    {
+      container.bits.resize(container.count);
+      file.read((char*) container.bits.data(), container.bits.size() * 2);
+    }
+    else if (container.type == BITMAP)
+    {
+      container.bytes.resize(windowBytes);
+      file.read((char*) container.bytes.data(), container.bytes.size());
+    }
+    else
+      throw primesieve_error("invalid prime bitmap file: " + filePath);
+
+    if (!file)
+      throw primesieve_error("invalid prime bitmap file: " + filePath);
+
+    bitmap.containers_.push_back(std::move(container));
+  }
+
+  return bitmap;
+}
+
+} // namespace
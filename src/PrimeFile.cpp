@@ -0,0 +1,400 @@
+///
+/// @file   PrimeFile.cpp
+/// @brief  Compact on-disk prime store. store_primes_file()
+///         writes the primes inside [start, stop] to a file as
+///         delta-encoded blocks of 4096 primes (the first prime
+///         of each block is stored in full in a sparse index at
+///         the end of the file, the other primes as 16-bit gaps
+///         to their predecessor). The PrimeFile class memory-maps
+///         such a file, so random access over cached ranges needs
+///         no sieving and the pages are shared across processes.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/pmath.hpp>
+#include <primesieve/PrimeFile.hpp>
+#include <primesieve/PrimeGenerator.hpp>
+#include <primesieve/primesieve_error.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+  #define HAS_MMAP
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+/// File format identifier
+const char magic[8] = { 'p', 'r', 'i', 'm', 'e', 's', '0', '1' };
+
+/// magic + start + stop + count
+const uint64_t headerBytes = 32;
+
+/// Number of primes per block
+const uint64_t blockPrimes = 4096;
+
+/// Each block stores blockPrimes - 1 gaps of 2 bytes,
+/// its first prime lives in the index
+const uint64_t blockBytes = (blockPrimes - 1) * 2;
+
+/// generate_primes_file() maps the output file in windows
+/// of 2^20 primes (8 megabytes, a multiple of the page
+/// size as required by mmap offsets)
+const uint64_t windowPrimes = 1 << 20;
+const uint64_t windowBytes = windowPrimes * 8;
+
+} // namespace
+
+namespace primesieve {
+
+/// Store the primes inside [start, stop]
+/// into an on-disk prime store file
+///
+void store_primes_file(uint64_t start, uint64_t stop, const std::string& filePath)
+{
+  ofstream file(filePath, ofstream::binary | ofstream::trunc);
+  if (!file)
+    throw primesieve_error("cannot open file: " + filePath);
+
+  uint64_t header[3] = { start, stop, 0 };
+  file.write(magic, sizeof(magic));
+  file.write((const char*) header, sizeof(header));
+
+  vector<uint64_t> anchors;
+  vector<uint16_t> gaps;
+  vector<uint64_t> chunkPrimes;
+  gaps.reserve(blockPrimes - 1);
+
+  uint64_t count = 0;
+  uint64_t prev = 0;
+  uint64_t low = start;
+  uint64_t dist = 100000000ull;
+
+  while (low <= stop)
+  {
+    uint64_t high = checkedAdd(low, dist);
+    high = min(high, stop);
+    chunkPrimes.clear();
+    generate_primes(low, high, &chunkPrimes);
+
+    for (uint64_t prime : chunkPrimes)
+    {
+      if (count % blockPrimes == 0)
+        anchors.push_back(prime);
+      else
+      {
+        // the largest known prime gap < 2^64
+        // is only 1552, gaps always fit
+        gaps.push_back((uint16_t) (prime - prev));
+
+        if (gaps.size() == blockPrimes - 1)
+        {
+          file.write((const char*) gaps.data(), gaps.size() * 2);
+          gaps.clear();
+        }
+      }
+
+      prev = prime;
+      count++;
+    }
+
+    if (high >= stop)
+      break;
+    low = high + 1;
+  }
+
+  // partial last block, then the sparse index
+  file.write((const char*) gaps.data(), gaps.size() * 2);
+  file.write((const char*) anchors.data(), anchors.size() * 8);
+
+  // patch the prime count in the header
+  file.seekp(sizeof(magic) + 16);
+  file.write((const char*) &count, 8);
+}
+
+/// Generate the primes inside [start, stop] into a file of
+/// raw 64-bit primes (native byte order, no header). The
+/// primes are decoded by PrimeGenerator::fillBuffer directly
+/// into a memory-mapped window of the file, so no
+/// intermediate vector is allocated and peak memory stays
+/// constant no matter how large the file grows. Each
+/// finished window is handed to the OS with msync so the
+/// output streams to disk while sieving continues
+///
+uint64_t generate_primes_file(uint64_t start, uint64_t stop, const std::string& filePath)
+{
+  if (~stop == 0)
+    stop--;
+  if (start > stop)
+  {
+    // create an empty file
+    ofstream file(filePath, ofstream::binary | ofstream::trunc);
+    if (!file)
+      throw primesieve_error("cannot open file: " + filePath);
+    return 0;
+  }
+
+#if defined(HAS_MMAP)
+
+  int fd = open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    throw primesieve_error("cannot open file: " + filePath);
+
+  PrimeGenerator primeGenerator(start, stop);
+  uint64_t count = 0;
+  uint64_t offset = 0;
+
+  // fillBuffer() stops once fewer than 64 free slots
+  // remain, the carry buffer fills the < 64 slots at the
+  // end of each window so the file contains no holes
+  uint64_t carry[64];
+  size_t carrySize = 0;
+  size_t carryUsed = 0;
+
+  while (true)
+  {
+    if (ftruncate(fd, offset + windowBytes) < 0)
+    {
+      close(fd);
+      throw primesieve_error("cannot grow file: " + filePath);
+    }
+
+    void* map = mmap(nullptr, windowBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+    if (map == MAP_FAILED)
+    {
+      close(fd);
+      throw primesieve_error("cannot mmap file: " + filePath);
+    }
+
+    uint64_t* window = (uint64_t*) map;
+    size_t used = 0;
+
+    // leftover primes from the previous window's tail
+    while (carryUsed < carrySize && used < windowPrimes)
+      window[used++] = carry[carryUsed++];
+
+    // decode the primes directly into the mapping
+    while (!primeGenerator.finished() &&
+           windowPrimes - used >= 64)
+    {
+      size_t size = 0;
+      primeGenerator.fillBuffer(window + used, windowPrimes - used, &size);
+      used += size;
+    }
+
+    // fill the window's tail through the carry buffer
+    while (used < windowPrimes &&
+           !primeGenerator.finished())
+    {
+      if (carryUsed >= carrySize)
+      {
+        carryUsed = 0;
+        carrySize = 0;
+        primeGenerator.fillBuffer(carry, 64, &carrySize);
+      }
+      while (carryUsed < carrySize && used < windowPrimes)
+        window[used++] = carry[carryUsed++];
+    }
+
+    count += used;
+
+    // start writing the finished window to disk
+    // while the next window is being sieved
+    msync(map, windowBytes, MS_ASYNC);
+    munmap(map, windowBytes);
+    offset += windowBytes;
+
+    if (used < windowPrimes)
+      break;
+  }
+
+  // trim the partially filled last window
+  if (ftruncate(fd, count * 8) < 0)
+  {
+    close(fd);
+    throw primesieve_error("cannot truncate file: " + filePath);
+  }
+
+  close(fd);
+  return count;
+
+#else
+
+  // no memory-mapping available,
+  // fall back to chunked buffered writes
+  ofstream file(filePath, ofstream::binary | ofstream::trunc);
+  if (!file)
+    throw primesieve_error("cannot open file: " + filePath);
+
+  uint64_t count = 0;
+  vector<uint64_t> buffer(windowPrimes);
+
+  generate_primes_buffered(start, stop, buffer.data(), buffer.size(),
+    [&](const uint64_t* primes, size_t size)
+    {
+      file.write((const char*) primes, size * 8);
+      count += size;
+    });
+
+  return count;
+
+#endif
+}
+
+PrimeFile::PrimeFile(const std::string& filePath) :
+  file_(filePath, headerBytes, "prime store file")
+{
+  const unsigned char* base = file_.base();
+
+  uint64_t header[3];
+  bool valid = (memcmp(base, magic, sizeof(magic)) == 0);
+  memcpy(header, base + sizeof(magic), sizeof(header));
+  start_ = header[0];
+  stop_ = header[1];
+  count_ = header[2];
+
+  // the count header field is untrusted: bound it by the
+  // file size (each prime takes at least 2 gap bytes)
+  // before reconstructing the exact layout, so the
+  // arithmetic below cannot wrap for a corrupt or crafted
+  // count and defeat the bounds check
+  valid &= (count_ <= (file_.size() - headerBytes) / 2);
+  if (!valid)
+    throw primesieve_error("invalid prime store file: " + filePath);
+
+  numBlocks_ = ceilDiv(count_, blockPrimes);
+  uint64_t dataBytes = 0;
+  if (numBlocks_ > 0)
+  {
+    uint64_t lastPrimes = count_ - (numBlocks_ - 1) * blockPrimes;
+    dataBytes = (numBlocks_ - 1) * blockBytes + (lastPrimes - 1) * 2;
+  }
+
+  if (file_.size() != headerBytes + dataBytes + numBlocks_ * 8)
+    throw primesieve_error("invalid prime store file: " + filePath);
+
+  blocks_ = base + headerBytes;
+  index_ = base + headerBytes + dataBytes;
+}
+
+/// Number of primes in the block
+uint64_t PrimeFile::blockSize(uint64_t block) const
+{
+  if (block + 1 == numBlocks_)
+    return count_ - block * blockPrimes;
+  return blockPrimes;
+}
+
+/// First prime of the block (from the sparse index)
+uint64_t PrimeFile::blockAnchor(uint64_t block) const
+{
+  uint64_t anchor;
+  memcpy(&anchor, index_ + block * 8, 8);
+  return anchor;
+}
+
+/// Find the last block whose first prime is <= start
+/// using binary search on the sparse index
+///
+uint64_t PrimeFile::findBlock(uint64_t start) const
+{
+  uint64_t low = 0;
+  uint64_t high = numBlocks_;
+
+  while (high - low > 1)
+  {
+    uint64_t mid = low + (high - low) / 2;
+    if (blockAnchor(mid) <= start)
+      low = mid;
+    else
+      high = mid;
+  }
+
+  return low;
+}
+
+/// Position the iterator so that the
+/// next nextPrime() returns the first prime >= start
+///
+void PrimeFile::jumpTo(uint64_t start)
+{
+  block_ = (numBlocks_ > 0) ? findBlock(start) : 0;
+  indexInBlock_ = 0;
+  prime_ = 0;
+
+  for (;;)
+  {
+    uint64_t block = block_;
+    uint64_t index = indexInBlock_;
+    uint64_t prev = prime_;
+    uint64_t prime = nextPrime();
+
+    if (prime == 0 || prime >= start)
+    {
+      block_ = block;
+      indexInBlock_ = index;
+      prime_ = prev;
+      return;
+    }
+  }
+}
+
+/// Get the next prime, returns 0 once all
+/// primes in the file have been iterated
+///
+uint64_t PrimeFile::nextPrime()
+{
+  while (block_ < numBlocks_)
+  {
+    if (indexInBlock_ < blockSize(block_))
+    {
+      if (indexInBlock_ == 0)
+        prime_ = blockAnchor(block_);
+      else
+      {
+        uint16_t gap;
+        memcpy(&gap, blocks_ + block_ * blockBytes + (indexInBlock_ - 1) * 2, 2);
+        prime_ += gap;
+      }
+
+      indexInBlock_++;
+      return prime_;
+    }
+
+    block_++;
+    indexInBlock_ = 0;
+  }
+
+  return 0;
+}
+
+/// Append the primes inside [start, stop] to the primes
+/// vector. Repositions the iterator used by nextPrime()
+///
+void PrimeFile::read(uint64_t start, uint64_t stop, std::vector<uint64_t>& primes)
+{
+  jumpTo(start);
+  uint64_t prime;
+
+  while ((prime = nextPrime()) != 0 &&
+         prime <= stop)
+    primes.push_back(prime);
+}
+
+} // namespace
@@ -26,62 +26,63 @@
 
 using namespace std;
 
-namespace primesieve {
+namespace {
 
-/// First 64 primes
-const array<uint64_t, 64> PrimeGenerator::smallPrimes =
+/// Per byte lookup tables used by PrimeGenerator::sum().
+/// A sieve byte encodes 8 potential primes within a window
+/// of 30 numbers: byteCount maps a byte to its number of
+/// set bits and byteSum to the sum of the bit values
+/// { 7, 11, 13, 17, 19, 23, 29, 31 } of its set bits.
+///
+struct ByteSumTables
 {
-    2,   3,   5,   7,  11,  13,  17,  19,
-   23,  29,  31,  37,  41,  43,  47,  53,
-   59,  61,  67,  71,  73,  79,  83,  89,
-   97, 101, 103, 107, 109, 113, 127, 131,
-  137, 139, 149, 151, 157, 163, 167, 173,
-  179, 181, 191, 193, 197, 199, 211, 223,
-  227, 229, 233, 239, 241, 251, 257, 263,
-  269, 271, 277, 281, 283, 293, 307, 311
-};
+  array<uint8_t, 256> count;
+  array<uint8_t, 256> sum;
 
-/// Number of primes <= n
-const array<uint8_t, 312> PrimeGenerator::primePi =
-{
-   0,  0,  1,  2,  2,  3,  3,  4,  4,  4,
-   4,  5,  5,  6,  6,  6,  6,  7,  7,  8,
-   8,  8,  8,  9,  9,  9,  9,  9,  9, 10,
-  10, 11, 11, 11, 11, 11, 11, 12, 12, 12,
-  12, 13, 13, 14, 14, 14, 14, 15, 15, 15,
-  15, 15, 15, 16, 16, 16, 16, 16, 16, 17,
-  17, 18, 18, 18, 18, 18, 18, 19, 19, 19,
-  19, 20, 20, 21, 21, 21, 21, 21, 21, 22,
-  22, 22, 22, 23, 23, 23, 23, 23, 23, 24,
-  24, 24, 24, 24, 24, 24, 24, 25, 25, 25,
-  25, 26, 26, 27, 27, 27, 27, 28, 28, 29,
-  29, 29, 29, 30, 30, 30, 30, 30, 30, 30,
-  30, 30, 30, 30, 30, 30, 30, 31, 31, 31,
-  31, 32, 32, 32, 32, 32, 32, 33, 33, 34,
-  34, 34, 34, 34, 34, 34, 34, 34, 34, 35,
-  35, 36, 36, 36, 36, 36, 36, 37, 37, 37,
-  37, 37, 37, 38, 38, 38, 38, 39, 39, 39,
-  39, 39, 39, 40, 40, 40, 40, 40, 40, 41,
-  41, 42, 42, 42, 42, 42, 42, 42, 42, 42,
-  42, 43, 43, 44, 44, 44, 44, 45, 45, 46,
-  46, 46, 46, 46, 46, 46, 46, 46, 46, 46,
-  46, 47, 47, 47, 47, 47, 47, 47, 47, 47,
-  47, 47, 47, 48, 48, 48, 48, 49, 49, 50,
-  50, 50, 50, 51, 51, 51, 51, 51, 51, 52,
-  52, 53, 53, 53, 53, 53, 53, 53, 53, 53,
-  53, 54, 54, 54, 54, 54, 54, 55, 55, 55,
-  55, 55, 55, 56, 56, 56, 56, 56, 56, 57,
-  57, 58, 58, 58, 58, 58, 58, 59, 59, 59,
-  59, 60, 60, 61, 61, 61, 61, 61, 61, 61,
-  61, 61, 61, 62, 62, 62, 62, 62, 62, 62,
-  62, 62, 62, 62, 62, 62, 62, 63, 63, 63,
-  63, 64
+  ByteSumTables()
+  {
+    const array<uint8_t, 8> bitValues = { 7, 11, 13, 17, 19, 23, 29, 31 };
+
+    for (int byte = 0; byte < 256; byte++)
+    {
+      count[byte] = 0;
+      sum[byte] = 0;
+
+      for (int bit = 0; bit < 8; bit++)
+      {
+        if (byte & (1 << bit))
+        {
+          count[byte] += 1;
+          sum[byte] += bitValues[bit];
+        }
+      }
+    }
+  }
 };
 
+const ByteSumTables byteSumTables;
+
+} // namespace
+
+namespace primesieve {
+
+/// All 6542 primes < 2^16, generated
+/// at compile time
+const SmallPrimes smallPrimes = generateSmallPrimes();
+
 PrimeGenerator::PrimeGenerator(uint64_t start, uint64_t stop) :
   Erat(start, stop),
   preSieve_(start, stop)
-{ }
+{
+  // the primes inside [start, stop] that are below 2^16
+  // are served from the small primes table, no sieve
+  // state is constructed for them
+  if (start_ <= smallPrimes.back())
+  {
+    smallIdx_ = getStartIdx();
+    smallStopIdx_ = getStopIdx();
+  }
+}
 
 void PrimeGenerator::init()
 {
@@ -91,67 +92,85 @@ void PrimeGenerator::init()
   start_ = max(start_, sieving);
 
   Erat::init(start_, stop_, sieveSize, preSieve_);
-  sievingPrimes_.init(this, preSieve_);
+
+  if (sharedPrimes_)
+  {
+    // the primes <= preSieve maxPrime are skipped, their
+    // multiples have already been removed by pre-sieving
+    const vector<uint64_t>& primes = *sharedPrimes_;
+    while (sharedIdx_ < primes.size() &&
+           primes[sharedIdx_] <= preSieve_.getMaxPrime())
+      sharedIdx_++;
+  }
+  else
+    sievingPrimes_.init(this, preSieve_);
+
   isInit_ = true;
 }
 
-size_t PrimeGenerator::getStartIdx() const
+void PrimeGenerator::setSievingPrimes(const vector<uint64_t>* sharedPrimes)
 {
-  size_t startIdx = 0;
-
-  if (start_ > 1)
-    startIdx = primePi[start_ - 1];
+  sharedPrimes_ = sharedPrimes;
+}
 
-  return startIdx;
+/// Index of the first prime >= start
+size_t PrimeGenerator::getStartIdx() const
+{
+  return lower_bound(smallPrimes.begin(), smallPrimes.end(), start_) -
+         smallPrimes.begin();
 }
 
+/// Index one past the last prime <= stop
 size_t PrimeGenerator::getStopIdx() const
 {
-  size_t stopIdx = 0;
-
-  if (stop_ < smallPrimes.back())
-    stopIdx = primePi[stop_];
-  else
-    stopIdx = smallPrimes.size();
+  if (stop_ >= smallPrimes.back())
+    return smallPrimes.size();
 
-  return stopIdx;
+  return upper_bound(smallPrimes.begin(), smallPrimes.end(), stop_) -
+         smallPrimes.begin();
 }
 
-void PrimeGenerator::init(vector<uint64_t>& primes)
+template <typename T>
+void PrimeGenerator::init(vector<T>& primes)
 {
   size_t size = primeCountApprox(start_, stop_);
   primes.reserve(size);
 
-  if (start_ <= smallPrimes.back())
-  {
-    size_t a = getStartIdx();
-    size_t b = getStopIdx();
-
-    primes.insert(primes.end(),
-             smallPrimes.begin() + a,
-             smallPrimes.begin() + b);
-  }
+  primes.insert(primes.end(),
+           smallPrimes.begin() + smallIdx_,
+           smallPrimes.begin() + smallStopIdx_);
+  smallIdx_ = smallStopIdx_;
 
   init();
 }
 
-void PrimeGenerator::init(vector<uint64_t>& primes, size_t* size)
+template <typename T>
+void PrimeGenerator::init(vector<T>& primes, size_t* size)
 {
-  if (start_ <= smallPrimes.back())
+  if (smallIdx_ < smallStopIdx_)
   {
-    size_t a = getStartIdx();
-    size_t b = getStopIdx();
-    *size = b - a;
+    size_t n = min(smallStopIdx_ - smallIdx_, primes.size());
+
+    for (size_t i = 0; i < n; i++)
+      primes[i] = (T) smallPrimes[smallIdx_ + i];
+
+    *size = n;
+    smallIdx_ += n;
 
-    copy(smallPrimes.begin() + a,
-         smallPrimes.begin() + b,
-         primes.begin());
+    // the table part of the range did not fit into the
+    // buffer, keep serving the table (the sieve is only
+    // initialized once the table is exhausted)
+    if (smallIdx_ < smallStopIdx_)
+      return;
   }
+  else if (start_ <= smallPrimes.back())
+    *size = 0;
 
   init();
 }
 
-bool PrimeGenerator::sieveSegment(vector<uint64_t>& primes)
+template <typename T>
+bool PrimeGenerator::sieveSegment(vector<T>& primes)
 {
   if (!isInit_)
     init(primes);
@@ -163,7 +182,8 @@ bool PrimeGenerator::sieveSegment(vector<uint64_t>& primes)
   return true;
 }
 
-bool PrimeGenerator::sieveSegment(vector<uint64_t>& primes, size_t* size)
+template <typename T>
+bool PrimeGenerator::sieveSegment(vector<T>& primes, size_t* size)
 {
   if (!isInit_)
   {
@@ -175,7 +195,7 @@ bool PrimeGenerator::sieveSegment(vector<uint64_t>& primes, size_t* size)
   if (!hasNextSegment())
   {
     *size = 1;
-    primes[0] = ~0ull;
+    primes[0] = (T) ~0ull;
     finished_ = (primes[0] > stop_);
     return false;
   }
@@ -191,32 +211,216 @@ void PrimeGenerator::sieveSegment()
   sieveIdx_ = 0;
   low_ = segmentLow_;
 
-  if (!prime_)
-    prime_ = sievingPrimes_.next();
-
-  while (prime_ <= sqrtHigh)
+  if (sharedPrimes_)
   {
-    addSievingPrime(prime_);
-    prime_ = sievingPrimes_.next();
+    const vector<uint64_t>& primes = *sharedPrimes_;
+    for (; sharedIdx_ < primes.size() &&
+           primes[sharedIdx_] <= sqrtHigh; sharedIdx_++)
+      addSievingPrime(primes[sharedIdx_]);
+  }
+  else
+  {
+    if (!prime_)
+      prime_ = sievingPrimes_.next();
+
+    while (prime_ <= sqrtHigh)
+    {
+      addSievingPrime(prime_);
+      prime_ = sievingPrimes_.next();
+    }
   }
 
   Erat::sieveSegment();
 }
 
-void PrimeGenerator::fill(vector<uint64_t>& primes)
+template <typename T>
+void PrimeGenerator::fill(vector<T>& primes)
 {
   while (sieveSegment(primes))
   {
+    // one popcount pass establishes the segment's exact
+    // prime count, so the vector is resized only once per
+    // segment and the decode loop below writes unchecked
+    // through a raw pointer, without any per word capacity
+    // branches. The popcount pass is memory bound and much
+    // cheaper than the decoding pass
+    uint64_t words = ceilDiv(sieveSize_, 8);
+    size_t count = popcount((const uint64_t*) sieve_, words);
+    size_t size = primes.size();
+    primes.resize(size + count);
+    T* array = primes.data() + size;
+
     for (; sieveIdx_ < sieveSize_; sieveIdx_ += 8)
     {
       uint64_t bits = littleendian_cast<uint64_t>(&sieve_[sieveIdx_]);
 
-      while (bits)
-        primes.push_back(nextPrime(&bits, low_));
+      // decode all of the word's primes using indexed
+      // stores, this avoids the loop carried (bits != 0)
+      // dependency of testing each bit
+      size_t n = popcnt64(bits);
+
+      for (size_t i = 0; i < n; i++)
+        array[i] = (T) nextPrime(&bits, low_);
 
+      array += n;
       low_ += 8 * 30;
     }
   }
 }
 
+/// Sum the primes inside [start, stop] modulo 2^64.
+/// The sieve bytes are not decoded into primes: each byte
+/// adds byteCount * low + byteSum via two lookup tables,
+/// i.e. 8 potential primes cost two table loads and one
+/// multiply instead of one decode step per prime.
+///
+uint64_t PrimeGenerator::sum()
+{
+  uint64_t sum = 0;
+
+  if (!isInit_)
+  {
+    for (size_t i = smallIdx_; i < smallStopIdx_; i++)
+      sum += smallPrimes[i];
+    smallIdx_ = smallStopIdx_;
+
+    init();
+  }
+
+  while (hasNextSegment())
+  {
+    sieveSegment();
+
+    for (; sieveIdx_ < sieveSize_; sieveIdx_++, low_ += 30)
+    {
+      uint64_t bits = sieve_[sieveIdx_];
+      sum += byteSumTables.count[bits] * low_ + byteSumTables.sum[bits];
+    }
+  }
+
+  return sum;
+}
+
+/// Same decoding loop as fill() above but the primes are
+/// written directly into a caller provided buffer, no
+/// intermediate growable container is used
+///
+void PrimeGenerator::fillBuffer(uint64_t* buffer,
+                                size_t capacity,
+                                size_t* size)
+{
+  size_t i = 0;
+
+  if (!isInit_)
+  {
+    // the primes < 2^16 are copied from a lookup table,
+    // possibly across multiple calls if the table part
+    // of the range exceeds the buffer
+    for (; smallIdx_ < smallStopIdx_ && i < capacity; smallIdx_++)
+      buffer[i++] = smallPrimes[smallIdx_];
+
+    if (smallIdx_ < smallStopIdx_)
+    {
+      *size = i;
+      return;
+    }
+
+    init();
+  }
+
+  while (true)
+  {
+    if (sieveIdx_ >= sieveSize_)
+    {
+      if (!hasNextSegment())
+      {
+        finished_ = true;
+        break;
+      }
+      sieveSegment();
+    }
+
+    // stop before the buffer can overflow, one
+    // 64-bit sieve word decodes up to 64 primes
+    if (i + 64 > capacity)
+      break;
+
+    uint64_t bits = littleendian_cast<uint64_t>(&sieve_[sieveIdx_]);
+    sieveIdx_ += 8;
+    size_t count = popcnt64(bits);
+
+    for (size_t j = 0; j < count; j++)
+      buffer[i + j] = nextPrime(&bits, low_);
+
+    i += count;
+    low_ += 8 * 30;
+  }
+
+  *size = i;
+}
+
+/// Skipping 64 primes per popcount instead of decoding
+/// them one at a time makes the final nth prime scan
+/// (nthPrime.cpp) mostly memory bound
+///
+uint64_t PrimeGenerator::nthPrime(uint64_t* k)
+{
+  uint64_t n = *k;
+
+  if (!isInit_)
+  {
+    // the primes < 2^16 are served
+    // from a lookup table
+    if (smallIdx_ < smallStopIdx_)
+    {
+      if (n <= smallStopIdx_ - smallIdx_)
+      {
+        *k = 0;
+        return smallPrimes[smallIdx_ + n - 1];
+      }
+      n -= smallStopIdx_ - smallIdx_;
+      smallIdx_ = smallStopIdx_;
+    }
+
+    init();
+  }
+
+  while (true)
+  {
+    if (sieveIdx_ >= sieveSize_)
+    {
+      if (!hasNextSegment())
+      {
+        finished_ = true;
+        *k = n;
+        return 0;
+      }
+      sieveSegment();
+    }
+
+    uint64_t bits = littleendian_cast<uint64_t>(&sieve_[sieveIdx_]);
+    sieveIdx_ += 8;
+    uint64_t count = popcnt64(bits);
+
+    if (count >= n)
+    {
+      // clear the n - 1 first set bits, the
+      // next set bit is the nth prime
+      for (; n > 1; n--)
+        bits &= bits - 1;
+
+      *k = 0;
+      return nextPrime(&bits, low_);
+    }
+
+    n -= count;
+    low_ += 8 * 30;
+  }
+}
+
+template void PrimeGenerator::fill<uint32_t>(vector<uint32_t>&);
+template void PrimeGenerator::fill<uint64_t>(vector<uint64_t>&);
+template bool PrimeGenerator::sieveSegment<uint32_t>(vector<uint32_t>&, size_t*);
+template bool PrimeGenerator::sieveSegment<uint64_t>(vector<uint64_t>&, size_t*);
+
 } // namespace
@@ -10,17 +10,24 @@
 /// file in the top level directory.
 ///
 
+#include <primesieve.hpp>
 #include <primesieve/PrimeSieve.hpp>
+#include <primesieve/CountSieve.hpp>
 #include <primesieve/pmath.hpp>
 #include <primesieve/PrintPrimes.hpp>
+#include <primesieve/SievingPrimesFile.hpp>
 #include <primesieve/types.hpp>
+#include <primesieve/WindowSieve.hpp>
 
 #include <stdint.h>
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -46,6 +53,12 @@ const array<SmallPrime, 8> smallPrimes
   { 5, 17, 4, "(5, 7, 11, 13, 17)" }
 }};
 
+uint64_t steadyMillis()
+{
+  auto now = chrono::steady_clock::now().time_since_epoch();
+  return chrono::duration_cast<chrono::milliseconds>(now).count();
+}
+
 } // namespace
 
 namespace primesieve {
@@ -76,9 +89,14 @@ void PrimeSieve::reset()
 {
   counts_.fill(0);
   seconds_ = 0.0;
+  stats_ = SieveStats();
   toUpdate_ = 0;
   processed_ = 0;
   percent_ = -1.0;
+  nextCallback_ = 0;
+  stoppedAt_ = stop_;
+  // arm the deadline of the time budget
+  deadlineMillis_ = budgetMillis_ ? steadyMillis() + budgetMillis_ : 0;
 }
 
 bool PrimeSieve::isParallelSieve() const
@@ -141,6 +159,11 @@ double PrimeSieve::getSeconds() const
   return seconds_;
 }
 
+const SieveStats& PrimeSieve::getStats() const
+{
+  return stats_;
+}
+
 double PrimeSieve::getStatus() const
 {
   return percent_;
@@ -170,6 +193,9 @@ void PrimeSieve::setSieveSize(int sieveSize)
 void PrimeSieve::setStart(uint64_t start)
 {
   start_ = start;
+  // the window state of advance() is
+  // anchored at the old start
+  windowSieve_.reset();
 }
 
 /// Set a stop number (upper bound) for sieving
@@ -178,6 +204,57 @@ void PrimeSieve::setStop(uint64_t stop)
   stop_ = stop;
 }
 
+/// Model of the sieving cost of [start, pos] in arbitrary
+/// units. The cache resident algorithms (pre-sieving,
+/// EratSmall, EratMedium) cost a constant amount per number,
+/// but each sieving prime > maxEratMedium additionally
+/// performs one bucket operation per segment (EratBig), so
+/// the cost per number grows with pi(sqrt(x)). Percent
+/// derived linearly from the processed distance therefore
+/// runs ahead of the wall time for large stop, e.g. a pi(x)
+/// run displays 90% with well over 10% of the time left.
+///
+/// With pi(sqrt(x)) ~= 2 * sqrt(x) / log(x) the integral of
+/// the per number cost over [start, pos] is:
+///
+/// cost = (pos - start) + bigOpCost / segmentNumbers *
+///        (2/log(stop) * 2/3 * (pos^1.5 - x0^1.5)
+///         - pi(maxEratMedium) * (pos - x0))
+///
+/// with x0 = max(start, maxEratMedium^2), the position where
+/// EratBig starts getting sieving primes. bigOpCost is the
+/// cost of one EratBig bucket operation relative to sieving
+/// one number with the cache resident algorithms, calibrated
+/// using the --time-breakdown instrumentation (SieveStats)
+///
+double PrimeSieve::sieveCost(uint64_t start, uint64_t stop,
+                             uint64_t pos, int sieveSizeKB)
+{
+  double cost = (double) pos - (double) start;
+  if (cost <= 0)
+    return 0;
+
+  double sieveBytes = sieveSizeKB * 1024.0;
+  double maxEratMedium = sieveBytes * get_tuning().factorEratMedium;
+  double x0 = max((double) start, maxEratMedium * maxEratMedium);
+
+  if ((double) pos > x0)
+  {
+    // cost of one bucket operation relative to
+    // sieving one number below maxEratMedium^2
+    double bigOpCost = 4.0;
+    double segmentNumbers = sieveBytes * 30;
+    double logStop = log(max(4.0, (double) stop));
+    double piM = maxEratMedium / log(max(4.0, maxEratMedium));
+    double bigOps = 2.0 / logStop * (2.0 / 3.0) *
+                    (pow((double) pos, 1.5) - pow(x0, 1.5));
+    bigOps -= piM * ((double) pos - x0);
+    cost += max(0.0, bigOps) * bigOpCost / segmentNumbers;
+  }
+
+  return cost;
+}
+
 /// Print status in percent to stdout.
 /// @processed:  Sum of recently processed segments
 ///
@@ -194,15 +271,55 @@ bool PrimeSieve::updateStatus(uint64_t processed, bool tryLock)
     processed_ += processed;
     double percent = 100;
     if (getDistance() > 0)
-      percent = processed_ * 100.0 / getDistance();
+    {
+      // weight the processed distance by the sieving cost
+      // model so that the percent tracks the wall time
+      uint64_t pos = start_ + min(processed_, getDistance());
+      double total = sieveCost(start_, stop_, stop_, sieveSize_);
+      if (total > 0)
+        percent = sieveCost(start_, stop_, pos, sieveSize_) * 100.0 / total;
+    }
     double old = percent_;
-    percent_ = min(percent, 100.0);
+    percent = min(percent, 100.0);
+    percent_ = percent;
     if (isFlag(PRINT_STATUS))
-      printStatus(old, percent_);
+      printStatus(old, percent);
+    if (progressCallback_)
+      invokeProgressCallback(percent);
   }
   return true;
 }
 
+void PrimeSieve::setProgressCallback(const progress_callback_t& callback,
+                                     uint64_t intervalMillis)
+{
+  progressCallback_ = callback;
+  callbackMillis_ = intervalMillis;
+}
+
+/// Invoke the progress callback unless one has already run
+/// within the last callbackMillis_ milliseconds. The per
+/// segment (and per chunk) status updates are coalesced so
+/// that the callback's cost stays off the sieving hot path.
+///
+void PrimeSieve::invokeProgressCallback(double percent)
+{
+  auto now = chrono::steady_clock::now().time_since_epoch();
+  uint64_t millis = chrono::duration_cast<chrono::milliseconds>(now).count();
+  uint64_t next = nextCallback_.load(memory_order_relaxed);
+
+  // only the first thread that reaches the
+  // deadline invokes the callback
+  while (millis >= next)
+  {
+    if (nextCallback_.compare_exchange_weak(next, millis + callbackMillis_))
+    {
+      progressCallback_(percent);
+      break;
+    }
+  }
+}
+
 void PrimeSieve::printStatus(double old, double current)
 {
   int percent = (int) current;
@@ -229,12 +346,93 @@ void PrimeSieve::processSmallPrimes()
   }
 }
 
+/// PrimeSieve is single-threaded,
+/// ParallelSieve overrides this method
+///
+int PrimeSieve::getNumThreads() const
+{
+  return 1;
+}
+
+void PrimeSieve::cancelSieve()
+{
+  cancel_.store(true, memory_order_relaxed);
+}
+
+/// Checked once per segment by the sieving loops. The
+/// worker PrimeSieve objects of a ParallelSieve delegate
+/// to the parent's cancel flag and deadline
+///
+bool PrimeSieve::isCanceled() const
+{
+  if (cancel_.load(memory_order_relaxed))
+    return true;
+  if (deadlineMillis_ &&
+      steadyMillis() >= deadlineMillis_)
+    return true;
+  if (parent_)
+    return parent_->isCanceled();
+  return false;
+}
+
+void PrimeSieve::setTimeBudget(uint64_t millis)
+{
+  budgetMillis_ = millis;
+}
+
+uint64_t PrimeSieve::getStoppedAt() const
+{
+  return stoppedAt_;
+}
+
+void PrimeSieve::setSievingPrimes(const uint64_t* primes, uint64_t size)
+{
+  sievingPrimes_ = primes;
+  numSievingPrimes_ = size;
+}
+
+const uint64_t* PrimeSieve::getSievingPrimes() const
+{
+  return sievingPrimes_;
+}
+
+uint64_t PrimeSieve::getNumSievingPrimes() const
+{
+  return numSievingPrimes_;
+}
+
+void PrimeSieve::setSievingPrimeRecips(const PrimeReciprocal* recips)
+{
+  sievingPrimeRecips_ = recips;
+}
+
+const PrimeReciprocal* PrimeSieve::getSievingPrimeRecips() const
+{
+  return sievingPrimeRecips_;
+}
+
 uint64_t PrimeSieve::countPrimes(uint64_t start, uint64_t stop)
 {
   sieve(start, stop, COUNT_PRIMES);
   return getCount(0);
 }
 
+/// Count the primes inside (previous stop, stop], the sieve
+/// state is carried forward between calls so consecutive
+/// windows are counted incrementally, see WindowSieve.cpp
+///
+uint64_t PrimeSieve::advance(uint64_t stop)
+{
+  if (!windowSieve_)
+    windowSieve_.reset(new WindowSieve(start_));
+
+  uint64_t count = windowSieve_->advance(stop);
+  stop_ = stop;
+  counts_[0] += count;
+
+  return count;
+}
+
 void PrimeSieve::sieve(uint64_t start, uint64_t stop)
 {
   setStart(start);
@@ -257,6 +455,11 @@ void PrimeSieve::sieve()
 {
   reset();
 
+  // the progress callback needs the status
+  // to be computed while sieving
+  if (progressCallback_)
+    addFlags(CALCULATE_STATUS);
+
   if (start_ > stop_)
     return;
 
@@ -272,8 +475,52 @@ void PrimeSieve::sieve()
 
   if (stop_ >= 7)
   {
-    PrintPrimes printPrimes(*this);
-    printPrimes.sieve();
+    // reuse the sieving primes (and their reciprocals) from
+    // a persisted snapshot that covers sqrt(stop), replacing
+    // their deterministic recomputation at every run, see
+    // set_sieving_primes_file(). The worker objects of a
+    // ParallelSieve already got a shared table from their
+    // parent
+    if (!sievingPrimes_)
+    {
+      sievingPrimesFile_ = SievingPrimesFile::getShared(isqrt(stop_));
+      if (sievingPrimesFile_)
+      {
+        setSievingPrimes(sievingPrimesFile_->primes(), sievingPrimesFile_->size());
+        setSievingPrimeRecips(sievingPrimesFile_->recips());
+      }
+    }
+
+    // count-only workloads (the common case) use the lean
+    // CountSieve, printing and prime k-tuplet counting use
+    // the full PrintPrimes infrastructure
+    if (isCountPrimes() &&
+        !isCountkTuplets() &&
+        !isPrint())
+    {
+      CountSieve countSieve(*this);
+      countSieve.sieve();
+      stats_ += countSieve.getStats();
+      if (isCanceled())
+        stoppedAt_ = min(stop_, countSieve.getSievedHigh());
+    }
+    else
+    {
+      PrintPrimes printPrimes(*this);
+      printPrimes.sieve();
+      stats_ += printPrimes.getStats();
+      if (isCanceled())
+        stoppedAt_ = min(stop_, printPrimes.getSievedHigh());
+    }
+
+    // drop the snapshot tables again, the next sieve()
+    // call re-checks the coverage for its own stop
+    if (sievingPrimesFile_)
+    {
+      setSievingPrimes(nullptr, 0);
+      setSievingPrimeRecips(nullptr);
+      sievingPrimesFile_.reset();
+    }
   }
 
   auto t2 = chrono::system_clock::now();
@@ -282,6 +529,11 @@ void PrimeSieve::sieve()
 
   if (isStatus())
     updateStatus(finishStatus, false);
+
+  // the final status must not be dropped
+  // by the callback's rate limit
+  if (progressCallback_)
+    progressCallback_(100);
 }
 
 } // namespace
@@ -11,33 +11,150 @@
 /// file in the top level directory.
 ///
 
+#include <primesieve/kTuplets.hpp>
 #include <primesieve/littleendian_cast.hpp>
 #include <primesieve/pmath.hpp>
 #include <primesieve/PreSieve.hpp>
 #include <primesieve/PrintPrimes.hpp>
 #include <primesieve/PrimeSieve.hpp>
 #include <primesieve/Erat.hpp>
-#include <primesieve/SievingPrimes.hpp>
+#include <primesieve/AsyncSievingPrimes.hpp>
 #include <primesieve/types.hpp>
 
 #include <stdint.h>
 #include <algorithm>
-#include <iostream>
-#include <sstream>
+#include <cstdio>
+
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define HAS_SSE2
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+  #include <arm_neon.h>
+  #define HAS_NEON
+#endif
 
 using namespace std;
 
-namespace primesieve {
+namespace {
+
+#if defined(HAS_SSE2)
+
+/// Count the sieve bytes that contain a prime k-tuplet
+/// i.e. (byte & bitmask) == bitmask. 16 bytes are matched
+/// per instruction, the 0xff match results are accumulated
+/// byte-wise and flushed with psadbw before they can
+/// overflow (every 255 iterations)
+///
+uint64_t countBitmask(const primesieve::byte_t* sieve, uint64_t size, uint64_t bitmask)
+{
+  uint64_t vecSize = size - size % 16;
+  uint64_t i = 0;
+
+  __m128i zero = _mm_setzero_si128();
+  __m128i mask = _mm_set1_epi8((char) bitmask);
+  __m128i sums = zero;
+
+  while (i < vecSize)
+  {
+    uint64_t chunk = min(vecSize, i + 255 * 16);
+    __m128i counter = zero;
+
+    for (; i < chunk; i += 16)
+    {
+      __m128i bytes = _mm_loadu_si128((const __m128i*) &sieve[i]);
+      __m128i match = _mm_cmpeq_epi8(_mm_and_si128(bytes, mask), mask);
+      counter = _mm_sub_epi8(counter, match);
+    }
+
+    sums = _mm_add_epi64(sums, _mm_sad_epu8(counter, zero));
+  }
+
+  uint64_t lanes[2];
+  _mm_storeu_si128((__m128i*) lanes, sums);
+  uint64_t count = lanes[0] + lanes[1];
+
+  for (; i < size; i++)
+    count += (sieve[i] & bitmask) == bitmask;
+
+  return count;
+}
+
+#elif defined(HAS_NEON)
+
+/// Count the sieve bytes that contain a prime k-tuplet
+/// i.e. (byte & bitmask) == bitmask. 16 bytes are matched
+/// per instruction, the 0xff match results are accumulated
+/// byte-wise and widened to 64 bits before they can
+/// overflow (every 255 iterations)
+///
+uint64_t countBitmask(const primesieve::byte_t* sieve, uint64_t size, uint64_t bitmask)
+{
+  uint64_t vecSize = size - size % 16;
+  uint64_t i = 0;
+
+  uint8x16_t mask = vdupq_n_u8((uint8_t) bitmask);
+  uint64x2_t sums = vdupq_n_u64(0);
+
+  while (i < vecSize)
+  {
+    uint64_t chunk = min(vecSize, i + 255 * 16);
+    uint8x16_t counter = vdupq_n_u8(0);
+
+    for (; i < chunk; i += 16)
+    {
+      uint8x16_t bytes = vld1q_u8(&sieve[i]);
+      uint8x16_t match = vceqq_u8(vandq_u8(bytes, mask), mask);
+      counter = vsubq_u8(counter, match);
+    }
+
+    sums = vaddq_u64(sums, vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(counter))));
+  }
+
+  uint64_t count = vgetq_lane_u64(sums, 0) +
+                   vgetq_lane_u64(sums, 1);
+
+  for (; i < size; i++)
+    count += (sieve[i] & bitmask) == bitmask;
+
+  return count;
+}
+
+#endif
+
+/// Write @n in decimal to the buffer,
+/// returns one past the last char written
+///
+char* writeNumber(uint64_t n, char* p)
+{
+  char digits[20];
+  int size = 0;
+
+  do
+  {
+    digits[size++] = '0' + (char) (n % 10);
+    n /= 10;
+  }
+  while (n > 0);
+
+  while (size > 0)
+    *p++ = digits[--size];
+
+  return p;
+}
 
-const uint64_t PrintPrimes::bitmasks_[6][5] =
+/// Write @n in decimal followed by '\n' to the buffer,
+/// returns one past the last char written
+///
+char* writeDecimal(uint64_t n, char* p)
 {
-  { END },
-  { 0x06, 0x18, 0xc0, END },       // Twin primes:       b00000110, b00011000, b11000000
-  { 0x07, 0x0e, 0x1c, 0x38, END }, // Prime triplets:    b00000111, b00001110, ...
-  { 0x1e, END },                   // Prime quadruplets: b00011110
-  { 0x1f, 0x3e, END },             // Prime quintuplets
-  { 0x3f, END }                    // Prime sextuplets
-};
+  p = writeNumber(n, p);
+  *p++ = '\n';
+  return p;
+}
+
+} // namespace
+
+namespace primesieve {
 
 PrintPrimes::PrintPrimes(PrimeSieve& ps) :
   preSieve_(ps.getStart(), ps.getStop()),
@@ -50,10 +167,21 @@ PrintPrimes::PrintPrimes(PrimeSieve& ps) :
 
   Erat::init(start, stop, sieveSize, preSieve_);
 
+  // primes are counted while sieving (during the last
+  // cross-off pass of each segment) which avoids a second
+  // pass over the cache-cold sieve array
+  if (ps_.isCountPrimes())
+    fusedCount_ = &counts_[0];
+
   if (ps_.isCountkTuplets())
     initCounts();
 }
 
+PrintPrimes::~PrintPrimes()
+{
+  joinWriter();
+}
+
 /// Initialize the lookup tables to count the number
 /// of twins, triplets, ... per byte
 ///
@@ -69,7 +197,7 @@ void PrintPrimes::initCounts()
     for (uint64_t j = 0; j < 256; j++)
     {
       byte_t count = 0;
-      for (const uint64_t* b = bitmasks_[i]; *b <= j; b++)
+      for (const uint64_t* b = ktuplet::bitmasks[i]; *b <= j; b++)
       {
         if ((j & *b) == *b)
           count++;
@@ -81,27 +209,79 @@ void PrintPrimes::initCounts()
 
 void PrintPrimes::sieve()
 {
-  SievingPrimes sievingPrimes(this, preSieve_);
-  uint64_t prime = sievingPrimes.next();
+  const uint64_t* primes = ps_.getSievingPrimes();
+
+  if (primes)
+  {
+    // precomputed read-only sieving prime table (shared by
+    // ParallelSieve across its worker threads, or
+    // memory-mapped from a snapshot file, see
+    // set_sieving_primes_file()), instead of re-sieving the
+    // identical sqrt(stop) range. The primes <= preSieve
+    // maxPrime are skipped, their multiples have already
+    // been removed by pre-sieving
+    const PrimeReciprocal* recips = ps_.getSievingPrimeRecips();
+    uint64_t size = ps_.getNumSievingPrimes();
+    uint64_t i = 0;
+
+    while (i < size && primes[i] <= preSieve_.getMaxPrime())
+      i++;
+
+    // checking the cancel flag once per segment gives
+    // cancellation (cancelSieve()) segment granularity
+    // instead of chunk granularity
+    while (hasNextSegment() &&
+           !ps_.isCanceled())
+    {
+      low_ = segmentLow_;
+      uint64_t sqrtHigh = isqrt(segmentHigh_);
+
+      for (; i < size && primes[i] <= sqrtHigh; i++)
+      {
+        // the shared reciprocals replace the per prime
+        // division of the first multiple computation
+        if (recips)
+          addSievingPrime(primes[i], recips[i]);
+        else
+          addSievingPrime(primes[i]);
+      }
 
-  while (hasNextSegment())
+      sieveSegment();
+      print();
+    }
+  }
+  else
   {
-    low_ = segmentLow_;
-    uint64_t sqrtHigh = isqrt(segmentHigh_);
+    // for large sqrt(stop) the sieving primes are produced
+    // on a background thread, overlapped with the main
+    // sieving below (see AsyncSievingPrimes.cpp)
+    AsyncSievingPrimes sievingPrimes(this, preSieve_);
+    uint64_t prime = sievingPrimes.next();
+
+    while (hasNextSegment() &&
+           !ps_.isCanceled())
+    {
+      low_ = segmentLow_;
+      uint64_t sqrtHigh = isqrt(segmentHigh_);
 
-    for (; prime <= sqrtHigh; prime = sievingPrimes.next())
-      addSievingPrime(prime);
+      for (; prime <= sqrtHigh; prime = sievingPrimes.next())
+        addSievingPrime(prime);
 
-    sieveSegment();
-    print();
+      sieveSegment();
+      print();
+    }
   }
+
+  // wait until all queued
+  // segments have been printed
+  joinWriter();
 }
 
-/// Executed after each sieved segment
+/// Executed after each sieved segment,
+/// primes have already been counted while sieving
+///
 void PrintPrimes::print()
 {
-  if (ps_.isCountPrimes())
-    countPrimes();
   if (ps_.isCountkTuplets())
     countkTuplets();
   if (ps_.isPrintPrimes())
@@ -113,12 +293,6 @@ void PrintPrimes::print()
     ps_.updateStatus(sieveSize_ * 30);
 }
 
-void PrintPrimes::countPrimes()
-{
-  uint64_t size = ceilDiv(sieveSize_, 8);
-  counts_[0] += popcount((const uint64_t*) sieve_, size);
-}
-
 void PrintPrimes::countkTuplets()
 {
   // i = 1 twins, i = 2 triplets, ...
@@ -129,6 +303,12 @@ void PrintPrimes::countkTuplets()
 
     uint64_t sum = 0;
 
+#if defined(HAS_SSE2) || defined(HAS_NEON)
+    // vectorized bitmask matching, one pass
+    // over the sieve array per bitmask
+    for (const uint64_t* b = ktuplet::bitmasks[i]; *b != ktuplet::END; b++)
+      sum += countBitmask(sieve_, sieveSize_, *b);
+#else
     for (uint64_t j = 0; j < sieveSize_; j += 4)
     {
       sum += kCounts_[i][sieve_[j+0]];
@@ -136,39 +316,133 @@ void PrintPrimes::countkTuplets()
       sum += kCounts_[i][sieve_[j+2]];
       sum += kCounts_[i][sieve_[j+3]];
     }
+#endif
 
     counts_[i] += sum;
   }
 }
 
-/// Print primes to stdout
-void PrintPrimes::printPrimes() const
+/// Hand the sieved segment to the writer thread which
+/// formats and prints it while the main thread sieves the
+/// next segment. The queue is bounded so sieving runs at
+/// most 4 segments ahead of the writer
+///
+void PrintPrimes::printPrimes()
 {
-  uint64_t i = 0;
-  uint64_t low = low_;
+  unique_lock<mutex> guard(lock_);
+
+  if (!writer_.joinable())
+    writer_ = thread(&PrintPrimes::writerThread, this);
 
-  while (i < sieveSize_)
+  drained_.wait(guard, [&] { return queue_.size() < 4; });
+
+  SegmentBuffer segment;
+  if (!freeBuffers_.empty())
   {
-    uint64_t size = min(i + (1 << 16), sieveSize_);
-    ostringstream primes;
+    segment.sieve = std::move(freeBuffers_.back());
+    freeBuffers_.pop_back();
+  }
 
-    for (; i < size; i += 8)
-    {
-      uint64_t bits = littleendian_cast<uint64_t>(&sieve_[i]);
-      while (bits)
-        primes << nextPrime(&bits, low) << '\n';
+  // include the zeroed padding bytes of the last segment
+  // so the writer can read whole 64-bit words
+  uint64_t size = ceilDiv(sieveSize_, 8) * 8;
+  segment.sieve.assign(sieve_, sieve_ + size);
+  segment.low = low_;
+  queue_.push_back(std::move(segment));
+  pending_.notify_one();
+}
 
-      low += 8 * 30;
+/// Writer thread, prints the queued segments in order
+void PrintPrimes::writerThread()
+{
+  unique_lock<mutex> guard(lock_);
+
+  while (true)
+  {
+    pending_.wait(guard, [&] { return !queue_.empty() || stop_; });
+
+    if (queue_.empty())
+      break;
+
+    SegmentBuffer segment = std::move(queue_.front());
+    queue_.pop_front();
+    drained_.notify_one();
+
+    guard.unlock();
+    writeSegment(segment);
+    guard.lock();
+    freeBuffers_.push_back(std::move(segment.sieve));
+  }
+}
+
+/// Stop and join the writer thread after
+/// all queued segments have been printed
+///
+void PrintPrimes::joinWriter()
+{
+  if (writer_.joinable())
+  {
+    {
+      unique_lock<mutex> guard(lock_);
+      stop_ = true;
     }
+    pending_.notify_one();
+    writer_.join();
+    stop_ = false;
+  }
+}
 
-    cout << primes.str();
+/// Print the primes of a segment to stdout. The primes are
+/// formatted with writeDecimal() into a reusable 1 megabyte
+/// flat buffer that is flushed with fwrite() when nearly
+/// full, which is ~5x faster than streaming each prime
+/// through an ostringstream
+///
+void PrintPrimes::writeSegment(const SegmentBuffer& segment)
+{
+  if (printBuffer_.empty())
+    printBuffer_.resize(1 << 20);
+
+  char* buffer = printBuffer_.data();
+  char* flushLimit = buffer + printBuffer_.size() - 2048;
+  char* p = buffer;
+  const byte_t* sieve = segment.sieve.data();
+  uint64_t sieveSize = segment.sieve.size();
+  uint64_t low = segment.low;
+
+  for (uint64_t i = 0; i < sieveSize; i += 8)
+  {
+    uint64_t bits = littleendian_cast<uint64_t>(&sieve[i]);
+    while (bits)
+      p = writeDecimal(nextPrime(&bits, low), p);
+
+    low += 8 * 30;
+
+    // a 64-bit sieve word holds at most 64 primes of
+    // up to 21 chars each, well below the 2048 margin
+    if (p >= flushLimit)
+    {
+      fwrite(buffer, 1, (size_t) (p - buffer), stdout);
+      p = buffer;
+    }
   }
+
+  fwrite(buffer, 1, (size_t) (p - buffer), stdout);
 }
 
-/// Print prime k-tuplets to stdout
-void PrintPrimes::printkTuplets() const
+/// Print prime k-tuplets to stdout. Like printPrimes() the
+/// k-tuplets are formatted into a reusable flat buffer that
+/// is flushed with fwrite() when nearly full, instead of an
+/// ostringstream reallocated for every segment
+///
+void PrintPrimes::printkTuplets()
 {
-  ostringstream kTuplets;
+  if (kTupletBuffer_.empty())
+    kTupletBuffer_.resize(1 << 20);
+
+  char* buffer = kTupletBuffer_.data();
+  char* flushLimit = buffer + kTupletBuffer_.size() - 2048;
+  char* p = buffer;
   // i = 1 twins, i = 2 triplets, ...
   uint_t i = 1;
   uint64_t low = low_;
@@ -177,22 +451,40 @@ void PrintPrimes::printkTuplets() const
 
   for (uint64_t j = 0; j < sieveSize_; j++, low += 30)
   {
-    for (const uint64_t* bitmask = bitmasks_[i]; *bitmask <= sieve_[j]; bitmask++)
+    for (const uint64_t* bitmask = ktuplet::bitmasks[i]; *bitmask <= sieve_[j]; bitmask++)
     {
       if ((sieve_[j] & *bitmask) == *bitmask)
       {
-        kTuplets << "(";
+        *p++ = '(';
         uint64_t bits = *bitmask;
         while (bits != 0)
         {
-          kTuplets << nextPrime(&bits, low);
-          kTuplets << ((bits != 0) ? ", " : ")\n");
+          p = writeNumber(nextPrime(&bits, low), p);
+          if (bits != 0)
+          {
+            *p++ = ',';
+            *p++ = ' ';
+          }
+          else
+          {
+            *p++ = ')';
+            *p++ = '\n';
+          }
         }
       }
     }
+
+    // a sieve byte holds at most a few k-tuplets of up to
+    // 6 primes each (< 1 kilobyte of text), well below
+    // the 2048 margin
+    if (p >= flushLimit)
+    {
+      fwrite(buffer, 1, (size_t) (p - buffer), stdout);
+      p = buffer;
+    }
   }
 
-  cout << kTuplets.str();
+  fwrite(buffer, 1, (size_t) (p - buffer), stdout);
 }
 
 } // namespace
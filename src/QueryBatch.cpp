@@ -0,0 +1,407 @@
+///
+/// @file   QueryBatch.cpp
+/// @brief  Answer a batch of prime queries (counts, nth prime,
+///         prime generation) with one sieve pass per disjoint
+///         region. The required ranges of all queries are
+///         merged into disjoint regions, each region is sieved
+///         once via sieve_segments() and every query overlapping
+///         a segment extracts its answer (a masked popcount, a
+///         prime decode, or an nth prime countdown) from the
+///         same raw sieve bytes.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/pmath.hpp>
+#include <primesieve/primesieve_error.hpp>
+#include <primesieve/QueryBatch.hpp>
+#include <primesieve/types.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+namespace {
+
+/// bitValues[i] is the value of the i-th
+/// bit within a sieve byte
+const array<uint64_t, 8> bitValues = { 7, 11, 13, 17, 19, 23, 29, 31 };
+
+/// unset bits < start, same table as in Erat.cpp
+const array<byte_t, 37> unsetSmaller =
+{
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xfe, 0xfe, 0xfe, 0xfe, 0xfc, 0xfc, 0xf8, 0xf8,
+  0xf8, 0xf8, 0xf0, 0xf0, 0xe0, 0xe0, 0xe0, 0xe0,
+  0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0x80, 0x80,
+  0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+/// unset bits > stop, same table as in Erat.cpp
+const array<byte_t, 37> unsetLarger =
+{
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+  0x01, 0x01, 0x01, 0x03, 0x03, 0x07, 0x07, 0x07,
+  0x07, 0x0f, 0x0f, 0x1f, 0x1f, 0x1f, 0x1f, 0x3f,
+  0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x7f, 0x7f, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+uint64_t byteRemainder(uint64_t n)
+{
+  n %= 30;
+  if (n <= 6) n += 30;
+  return n;
+}
+
+/// Clamp [a, b] to the values representable in the
+/// segment and return the masked boundary byte indexes,
+/// returns false if the clamped interval is empty
+///
+bool clampRange(uint64_t size,
+                uint64_t low,
+                uint64_t& a,
+                uint64_t& b,
+                uint64_t& ia,
+                uint64_t& ib)
+{
+  a = max(a, low + 7);
+  b = min(b, low + size * 30 + 1);
+
+  if (a > b)
+    return false;
+
+  ia = (a - byteRemainder(a) - low) / 30;
+  ib = (b - byteRemainder(b) - low) / 30;
+  return true;
+}
+
+/// Count the primes inside [a, b],
+/// @low: value corresponding to the first sieve byte
+///
+uint64_t countRange(const byte_t* sieve,
+                    uint64_t size,
+                    uint64_t low,
+                    uint64_t a,
+                    uint64_t b)
+{
+  uint64_t ia, ib;
+  if (!clampRange(size, low, a, b, ia, ib))
+    return 0;
+
+  uint64_t count = 0;
+  uint64_t word = 0;
+  int k = 0;
+
+  for (uint64_t i = ia; i <= ib; i++)
+  {
+    byte_t byte = sieve[i];
+    if (i == ia) byte &= unsetSmaller[byteRemainder(a)];
+    if (i == ib) byte &= unsetLarger[byteRemainder(b)];
+    word |= (uint64_t) byte << (8 * k++);
+
+    if (k == 8)
+    {
+      count += popcnt64(word);
+      word = 0;
+      k = 0;
+    }
+  }
+
+  return count + popcnt64(word);
+}
+
+/// Append the primes inside [a, b] to the primes vector
+void decodeRange(const byte_t* sieve,
+                 uint64_t size,
+                 uint64_t low,
+                 uint64_t a,
+                 uint64_t b,
+                 vector<uint64_t>& primes)
+{
+  uint64_t ia, ib;
+  if (!clampRange(size, low, a, b, ia, ib))
+    return;
+
+  for (uint64_t i = ia; i <= ib; i++)
+  {
+    byte_t byte = sieve[i];
+    if (i == ia) byte &= unsetSmaller[byteRemainder(a)];
+    if (i == ib) byte &= unsetLarger[byteRemainder(b)];
+
+    for (int bit = 0; byte; bit++, byte >>= 1)
+      if (byte & 1)
+        primes.push_back(low + i * 30 + bitValues[bit]);
+  }
+}
+
+/// Find the remaining-th prime > a inside the segment,
+/// returns 0 if the segment contains fewer primes
+///
+uint64_t nthRange(const byte_t* sieve,
+                  uint64_t size,
+                  uint64_t low,
+                  uint64_t a,
+                  uint64_t& remaining)
+{
+  uint64_t b = low + size * 30 + 1;
+  uint64_t ia, ib;
+  if (!clampRange(size, low, a, b, ia, ib))
+    return 0;
+
+  for (uint64_t i = ia; i <= ib; i++)
+  {
+    byte_t byte = sieve[i];
+    if (i == ia) byte &= unsetSmaller[byteRemainder(a)];
+
+    for (int bit = 0; byte; bit++, byte >>= 1)
+      if (byte & 1)
+        if (--remaining == 0)
+          return low + i * 30 + bitValues[bit];
+  }
+
+  return 0;
+}
+
+/// Upper bound approximation of the nth prime > start,
+/// an underestimate merely triggers the extension loop
+/// in QueryBatch::run()
+///
+uint64_t nthPrimeBound(uint64_t n, uint64_t start)
+{
+  double m = (double) (n + primeCountApprox(start));
+  m = max(m, 6.0);
+
+  // liInverse(m) approximates the mth prime, add the li(x)
+  // approximation error |li(x) - pi(x)| < sqrt(x) for
+  // all x <= 10^19 so the bound rarely falls short
+  double bound = liInverse(m);
+  bound += sqrt(bound) + maxPrimeGap(bound);
+  bound = max(bound, (double) start + maxPrimeGap((double) start));
+
+  return checkedAdd((uint64_t) bound, 100);
+}
+
+} // namespace
+
+namespace primesieve {
+
+size_t QueryBatch::addCount(uint64_t start, uint64_t stop)
+{
+  if (hasRun_)
+    throw primesieve_error("QueryBatch: cannot add queries after run()");
+
+  Query query;
+  query.type = COUNT;
+  query.start = start;
+  query.stop = stop;
+  queries_.push_back(std::move(query));
+  return queries_.size() - 1;
+}
+
+size_t QueryBatch::addNthPrime(uint64_t n, uint64_t start)
+{
+  if (hasRun_)
+    throw primesieve_error("QueryBatch: cannot add queries after run()");
+  if (n == 0)
+    throw primesieve_error("QueryBatch: nth prime n must be >= 1");
+
+  Query query;
+  query.type = NTH_PRIME;
+  query.start = start;
+  query.stop = nthPrimeBound(n, start);
+  query.remaining = n;
+  queries_.push_back(std::move(query));
+  return queries_.size() - 1;
+}
+
+size_t QueryBatch::addPrimes(uint64_t start, uint64_t stop)
+{
+  if (hasRun_)
+    throw primesieve_error("QueryBatch: cannot add queries after run()");
+
+  Query query;
+  query.type = PRIMES;
+  query.start = start;
+  query.stop = stop;
+  queries_.push_back(std::move(query));
+  return queries_.size() - 1;
+}
+
+/// The primes 2, 3 and 5 are not
+/// representable in the sieve array
+///
+void QueryBatch::processSmallPrimes(Query& query)
+{
+  for (uint64_t prime : { 2, 3, 5 })
+  {
+    switch (query.type)
+    {
+      case COUNT:
+        query.result += (prime >= query.start && prime <= query.stop);
+        break;
+      case PRIMES:
+        if (prime >= query.start && prime <= query.stop)
+          query.primes.push_back(prime);
+        break;
+      case NTH_PRIME:
+        if (prime > query.start && !query.done)
+        {
+          if (--query.remaining == 0)
+          {
+            query.result = prime;
+            query.done = true;
+          }
+        }
+        break;
+    }
+  }
+}
+
+/// Sieve [low, high] once and let every query extract
+/// its answer from the raw sieve bytes
+///
+void QueryBatch::sieveRegion(uint64_t low, uint64_t high)
+{
+  sieve_segments(low, high,
+    [&](uint64_t segLow, const uint8_t* sieve, size_t size)
+    {
+      for (Query& query : queries_)
+      {
+        if (query.done)
+          continue;
+
+        switch (query.type)
+        {
+          case COUNT:
+            query.result += countRange(sieve, size, segLow, query.start, query.stop);
+            break;
+          case PRIMES:
+            decodeRange(sieve, size, segLow, query.start, query.stop, query.primes);
+            break;
+          case NTH_PRIME:
+          {
+            // only count primes <= query.stop, the interval
+            // beyond query.stop is covered by a later
+            // extension pass (no double counting)
+            uint64_t a = checkedAdd(query.start, 1);
+            uint64_t count = countRange(sieve, size, segLow, a, query.stop);
+
+            if (count < query.remaining)
+              query.remaining -= count;
+            else
+            {
+              query.result = nthRange(sieve, size, segLow, a, query.remaining);
+              query.done = true;
+            }
+            break;
+          }
+        }
+      }
+    });
+}
+
+void QueryBatch::run()
+{
+  if (hasRun_)
+    throw primesieve_error("QueryBatch: run() may only be called once");
+
+  hasRun_ = true;
+
+  for (Query& query : queries_)
+    processSmallPrimes(query);
+
+  // collect the required range of each query
+  vector<pair<uint64_t, uint64_t>> intervals;
+
+  for (Query& query : queries_)
+  {
+    uint64_t low = max<uint64_t>(query.start, 7);
+    if (query.type == NTH_PRIME)
+      low = max<uint64_t>(checkedAdd(query.start, 1), 7);
+    if (query.type == NTH_PRIME && query.done)
+      continue;
+    if (low <= query.stop && query.stop >= 7)
+      intervals.emplace_back(low, query.stop);
+  }
+
+  // merge into disjoint regions, each
+  // region is sieved only once
+  sort(intervals.begin(), intervals.end());
+  size_t i = 0;
+
+  for (size_t j = 1; j < intervals.size(); j++)
+  {
+    if (intervals[j].first <= checkedAdd(intervals[i].second, 1))
+      intervals[i].second = max(intervals[i].second, intervals[j].second);
+    else
+      intervals[++i] = intervals[j];
+  }
+
+  intervals.resize(min(intervals.size(), i + 1));
+
+  for (auto& region : intervals)
+    sieveRegion(region.first, region.second);
+
+  // the ranges of all count & generate queries have been
+  // fully covered, exclude them from the extension passes
+  // below whose regions may overlap already counted ground
+  for (Query& query : queries_)
+    if (query.type != NTH_PRIME)
+      query.done = true;
+
+  // the nth prime approximation is an upper bound, but if
+  // it was too small keep extending the scanned interval
+  for (Query& query : queries_)
+  {
+    while (query.type == NTH_PRIME && !query.done)
+    {
+      uint64_t low = checkedAdd(query.stop, 1);
+      if (low >= get_max_stop())
+        throw primesieve_error("QueryBatch: nth prime > 2^64");
+
+      double x = (double) low;
+      uint64_t dist = (uint64_t) (query.remaining * log(max(x, 4.0)) * 2);
+      dist = max<uint64_t>(dist, (uint64_t) maxPrimeGap(x));
+      query.stop = checkedAdd(low, dist);
+      sieveRegion(low, query.stop);
+    }
+  }
+}
+
+const QueryBatch::Query& QueryBatch::getQuery(size_t id, QueryType type) const
+{
+  if (!hasRun_)
+    throw primesieve_error("QueryBatch: run() has not been called");
+  if (id >= queries_.size() || queries_[id].type != type)
+    throw primesieve_error("QueryBatch: invalid query id");
+
+  return queries_[id];
+}
+
+uint64_t QueryBatch::count(size_t id) const
+{
+  return getQuery(id, COUNT).result;
+}
+
+uint64_t QueryBatch::nthPrime(size_t id) const
+{
+  return getQuery(id, NTH_PRIME).result;
+}
+
+const vector<uint64_t>& QueryBatch::primes(size_t id) const
+{
+  return getQuery(id, PRIMES).primes;
+}
+
+} // namespace
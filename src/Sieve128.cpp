@@ -0,0 +1,243 @@
+///
+/// @file   Sieve128.cpp
+/// @brief  Count the primes in a window whose bounds exceed
+///         2^64, using unsigned __int128 only where needed.
+///         The window is rebased onto a 64-bit offset
+///         coordinate system: base_ is the largest multiple of
+///         the primes <= 31 primorial below start, all segment
+///         bounds and cross-off indexes are offsets from base_
+///         and fit into uint64_t. Cross-off advancement only
+///         adds multiples of the sieving primes and masks bits
+///         by residue class, it is translation invariant, so
+///         the whole Erat machinery (pre-sieve, wheels,
+///         EratSmall/Medium/Big, fused counting) runs unchanged
+///         in offset coordinates. Only the first multiple of
+///         each sieving prime depends on the absolute position
+///         of the window and is computed with 128-bit
+///         arithmetic.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/Erat.hpp>
+#include <primesieve/PreSieve.hpp>
+#include <primesieve/primesieve_error.hpp>
+#include <primesieve/Wheel.hpp>
+
+#include <stdint.h>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#if defined(__SIZEOF_INT128__)
+
+using namespace std;
+
+namespace {
+
+using uint128_t = unsigned __int128;
+
+/// Product of the primes <= 31 (the primorial of 31).
+/// The pre-sieve buffers are indexed modulo their prime
+/// products (9699690 at most, 620310 for the extended
+/// 23 * 29 * 31 table, see PreSieve.cpp) and the wheel and
+/// bit layout arithmetic works modulo 30 and 210. All of
+/// these divide the primorial of 31, hence aligning base_
+/// to it preserves every residue the offset coordinates
+/// depend on.
+const uint64_t primorial31 = 200560490130ull;
+
+/// Integer square root of a 128-bit number. The floating
+/// point estimate is off by at most a few thousand for
+/// 128-bit operands, the loops correct it exactly.
+///
+uint64_t isqrt128(uint128_t x)
+{
+  uint64_t r = (uint64_t) sqrt((double) x);
+  while (r > 0 && (uint128_t) r * r > x)
+    r--;
+  uint128_t next = (uint128_t) r + 1;
+  while (next * next <= x)
+  {
+    r = (uint64_t) next;
+    next++;
+  }
+  return r;
+}
+
+/// Same layout as Wheel::wheelOffsets_ (Wheel.hpp): maps
+/// prime % 30 to the first wheel index of the prime's
+/// residue class, SIZE = 8 for the mod 30 wheel and
+/// SIZE = 48 for the mod 210 wheel
+///
+const uint64_t wheelOffsets30[30] =
+{
+  0,  8 * 7, 0, 0, 0, 0,
+  0,  8 * 0, 0, 0, 0,  8 * 1,
+  0,  8 * 2, 0, 0, 0,  8 * 3,
+  0,  8 * 4, 0, 0, 0,  8 * 5,
+  0, 0,      0, 0, 0,  8 * 6
+};
+
+const uint64_t wheelOffsets210[30] =
+{
+  0, 48 * 7, 0, 0, 0, 0,
+  0, 48 * 0, 0, 0, 0, 48 * 1,
+  0, 48 * 2, 0, 0, 0, 48 * 3,
+  0, 48 * 4, 0, 0, 0, 48 * 5,
+  0, 0,      0, 0, 0, 48 * 6
+};
+
+class Sieve128 : public primesieve::Erat
+{
+public:
+  Sieve128(uint128_t base,
+           uint64_t start,
+           uint64_t stop,
+           uint64_t sqrtStop) :
+    preSieve_(start, stop),
+    base_(base),
+    sqrtStop_(sqrtStop)
+  {
+    // isqrt(stop_) would underestimate the sieving primes
+    // of the 128-bit range in offset coordinates, pass the
+    // true sqrt so that EratSmall/Medium/Big are enabled
+    // against the correct thresholds
+    Erat::init(start, stop, primesieve::get_sieve_size(), preSieve_, sqrtStop);
+
+    // primes are counted while sieving (during the last
+    // cross-off pass of each segment) which avoids a second
+    // pass over the cache-cold sieve array
+    fusedCount_ = &count_;
+  }
+
+  uint64_t count()
+  {
+    addSievingPrimes();
+
+    while (hasNextSegment())
+      sieveSegment();
+
+    return count_;
+  }
+
+private:
+  primesieve::PreSieve preSieve_;
+  /// start of the offset coordinate system,
+  /// base_ % primorial31 == 0
+  uint128_t base_;
+  uint64_t sqrtStop_;
+  uint64_t count_ = 0;
+
+  /// The window is narrower than its sqrt(stop), all
+  /// sieving primes are added upfront against the first
+  /// segment (like ParallelSieve workers starting
+  /// mid-range do)
+  ///
+  void addSievingPrimes()
+  {
+    primesieve::iterator it(maxPreSieve_, sqrtStop_);
+    uint64_t prime = it.next_prime();
+
+    for (; prime <= sqrtStop_; prime = it.next_prime())
+      addSievingPrime128(prime);
+  }
+
+  /// 128-bit version of Wheel::addSievingPrime(): compute
+  /// the first multiple > segmentLow of prime on the
+  /// absolute number line, then store its sieve array
+  /// position as a 64-bit offset from base_
+  ///
+  void addSievingPrime128(uint64_t prime)
+  {
+    uint128_t segmentLow = base_ + segmentLow_;
+    uint128_t stop = base_ + stop_;
+    assert((uint64_t) (segmentLow % 30) == 0);
+    segmentLow += 6;
+    uint128_t quotient;
+    if ((uint128_t) prime * prime > segmentLow)
+      quotient = prime;
+    else
+      quotient = segmentLow / prime + 1;
+    uint128_t multiple = (uint128_t) prime * quotient;
+    // prime not needed for sieving
+    if (multiple > stop)
+      return;
+
+    if (prime > maxEratMedium_)
+    {
+      const primesieve::WheelInit& init = primesieve::wheel210Tables.init[(uint64_t) (quotient % 210)];
+      uint128_t nextMultiple = (uint128_t) prime * init.nextMultipleFactor;
+      if (nextMultiple > stop - multiple)
+        return;
+      uint64_t offset = (uint64_t) (nextMultiple + (multiple - segmentLow));
+      uint64_t wheelIndex = wheelOffsets210[prime % 30] + init.wheelIndex;
+      eratBig_.addSievingPrime(prime, offset / 30, wheelIndex);
+    }
+    else
+    {
+      const primesieve::WheelInit& init = primesieve::wheel30Tables.init[(uint64_t) (quotient % 30)];
+      uint128_t nextMultiple = (uint128_t) prime * init.nextMultipleFactor;
+      if (nextMultiple > stop - multiple)
+        return;
+      uint64_t offset = (uint64_t) (nextMultiple + (multiple - segmentLow));
+      uint64_t wheelIndex = wheelOffsets30[prime % 30] + init.wheelIndex;
+
+      if (prime > maxEratSmall_)
+        eratMedium_.addSievingPrime(prime, offset / 30, wheelIndex);
+      else
+        eratSmall_.addSievingPrime(prime, offset / 30, wheelIndex);
+    }
+  }
+};
+
+} // namespace
+
+#endif
+
+namespace primesieve {
+
+uint64_t count_primes_128(uint64_t startHi,
+                          uint64_t startLo,
+                          uint64_t stopHi,
+                          uint64_t stopLo)
+{
+  // bounds below 2^64, delegate to the parallel 64-bit sieve
+  if (stopHi == 0)
+  {
+    if (startHi != 0)
+      return 0;
+    return count_primes(startLo, stopLo);
+  }
+
+#if defined(__SIZEOF_INT128__)
+  uint128_t start = ((uint128_t) startHi << 64) | startLo;
+  uint128_t stop = ((uint128_t) stopHi << 64) | stopLo;
+
+  if (start > stop)
+    return 0;
+
+  uint128_t base = (start / primorial31) * primorial31;
+
+  // Erat requires start >= 7, keep the
+  // start offset comfortably above it
+  if (start - base < 37 &&
+      base >= primorial31)
+    base -= primorial31;
+
+  uint128_t dist = stop - base;
+  if (dist > numeric_limits<uint64_t>::max())
+    throw primesieve_error("count_primes_128: (stop - start) must be < 2^64 - 5*10^11");
+
+  Sieve128 sieve(base, (uint64_t) (start - base), (uint64_t) dist, isqrt128(stop));
+  return sieve.count();
+#else
+  throw primesieve_error("count_primes_128: requires a compiler with unsigned __int128 support");
+#endif
+}
+
+} // namespace
@@ -0,0 +1,165 @@
+///
+/// @file   SievingPrimesFile.cpp
+/// @brief  Sieving prime snapshot files. For jobs with a fixed
+///         upper bound the sieving primes (and their first
+///         multiple reciprocals) are identical for every run, so
+///         store_sieving_primes_file() serializes them once and
+///         set_sieving_primes_file() memory-maps the snapshot in
+///         subsequent runs: the tables are used in place, no
+///         recomputation, and the pages are shared across
+///         processes on the same machine.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/pmath.hpp>
+#include <primesieve/primesieve_error.hpp>
+#include <primesieve/SievingPrimesFile.hpp>
+#include <primesieve/Wheel.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+/// File format identifier
+const char magic[8] = { 's', 'p', 'r', 'i', 'm', 'e', 's', '1' };
+
+/// magic + maxPrime + count
+const uint64_t headerBytes = 24;
+
+mutex snapshotLock;
+
+/// The snapshot installed via set_sieving_primes_file().
+/// Published as a shared_ptr so that a sieve() call keeps
+/// its mapping alive even if another thread swaps the file
+///
+shared_ptr<const primesieve::SievingPrimesFile> snapshot;
+
+} // namespace
+
+namespace primesieve {
+
+/// Store the sieving primes needed to sieve up to stop (all
+/// primes inside [7, sqrt(stop)]) and their reciprocals
+/// into a snapshot file
+///
+void store_sieving_primes_file(uint64_t stop, const std::string& filePath)
+{
+  uint64_t maxPrime = isqrt(stop);
+
+  // the prime count is needed upfront: the reciprocal
+  // table starts right after the primes table
+  uint64_t count = 0;
+  if (maxPrime >= 7)
+    count = count_primes(7, maxPrime);
+
+  ofstream file(filePath, ofstream::binary | ofstream::trunc);
+  if (!file)
+    throw primesieve_error("cannot open file: " + filePath);
+
+  uint64_t header[2] = { maxPrime, count };
+  file.write(magic, sizeof(magic));
+  file.write((const char*) header, sizeof(header));
+
+  uint64_t primesPos = headerBytes;
+  uint64_t recipsPos = headerBytes + count * 8;
+  vector<uint64_t> chunkPrimes;
+  vector<PrimeReciprocal> chunkRecips;
+  uint64_t low = 7;
+  uint64_t dist = 100000000ull;
+
+  while (low <= maxPrime)
+  {
+    uint64_t high = checkedAdd(low, dist);
+    high = min(high, maxPrime);
+    chunkPrimes.clear();
+    generate_primes(low, high, &chunkPrimes);
+
+    chunkRecips.resize(chunkPrimes.size());
+    for (size_t i = 0; i < chunkPrimes.size(); i++)
+      chunkRecips[i].init(chunkPrimes[i]);
+
+    file.seekp(primesPos);
+    file.write((const char*) chunkPrimes.data(), chunkPrimes.size() * 8);
+    primesPos += chunkPrimes.size() * 8;
+
+    file.seekp(recipsPos);
+    file.write((const char*) chunkRecips.data(), chunkRecips.size() * sizeof(PrimeReciprocal));
+    recipsPos += chunkRecips.size() * sizeof(PrimeReciprocal);
+
+    if (high >= maxPrime)
+      break;
+    low = high + 1;
+  }
+
+  if (!file ||
+      primesPos != headerBytes + count * 8)
+    throw primesieve_error("cannot write file: " + filePath);
+}
+
+/// Memory-map a snapshot file and use its tables in all
+/// subsequent sieving whose sqrt(stop) it covers, an
+/// empty file path stops using the snapshot
+///
+void set_sieving_primes_file(const std::string& filePath)
+{
+  shared_ptr<const SievingPrimesFile> file;
+  if (!filePath.empty())
+    file = make_shared<SievingPrimesFile>(filePath);
+
+  unique_lock<mutex> lock(snapshotLock);
+  snapshot = std::move(file);
+}
+
+std::shared_ptr<const SievingPrimesFile> SievingPrimesFile::getShared(uint64_t maxPrime)
+{
+  unique_lock<mutex> lock(snapshotLock);
+
+  if (snapshot &&
+      snapshot->maxPrime() >= maxPrime)
+    return snapshot;
+
+  return nullptr;
+}
+
+SievingPrimesFile::SievingPrimesFile(const std::string& filePath) :
+  file_(filePath, headerBytes, "sieving prime snapshot file")
+{
+  const unsigned char* base = file_.base();
+  uint64_t tableBytes = 8 + sizeof(PrimeReciprocal);
+
+  uint64_t header[2];
+  bool valid = (memcmp(base, magic, sizeof(magic)) == 0);
+  memcpy(header, base + sizeof(magic), sizeof(header));
+  maxPrime_ = header[0];
+  count_ = header[1];
+
+  // the count header field is untrusted, compare it against
+  // the table count derived from the file size instead of
+  // reconstructing the file size from it (whose
+  // multiplication could wrap for a corrupt count)
+  valid &= (count_ == (file_.size() - headerBytes) / tableBytes &&
+            (file_.size() - headerBytes) % tableBytes == 0);
+  if (!valid)
+    throw primesieve_error("invalid sieving prime snapshot file: " + filePath);
+
+  // both tables are 8 byte aligned (the mapping is page
+  // aligned and the header is 24 bytes), so they are used
+  // in place without copying or decoding
+  primes_ = (const uint64_t*) (base + headerBytes);
+  recips_ = (const PrimeReciprocal*) (base + headerBytes + count_ * 8);
+}
+
+} // namespace
@@ -0,0 +1,140 @@
+///
+/// @file   SmallPi.cpp
+/// @brief  Answer small prime counting queries (stop <= 10^7)
+///         in constant time. pi(x) for x < 64 comes from a
+///         static lookup table, larger stops are answered from
+///         a packed mod 30 sieve bitmap of [0, 10^7] with rank
+///         counts per 64-bit word: one table load plus one
+///         popcount per query. The bitmap (~460 kilobytes) is
+///         built once per process on first use, afterwards no
+///         sieve object is constructed anymore.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/pmath.hpp>
+#include <primesieve/SmallPi.hpp>
+#include <primesieve/types.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <mutex>
+
+using namespace std;
+using namespace primesieve;
+
+namespace {
+
+/// Upper limit of the bitmap
+const uint64_t smallPiLimit = 10000000;
+
+/// pi(x) for x < 64
+const array<uint8_t, 64> piTiny =
+{
+   0,  0,  1,  2,  2,  3,  3,  4,  4,  4,
+   4,  5,  5,  6,  6,  6,  6,  7,  7,  8,
+   8,  8,  8,  9,  9,  9,  9,  9,  9, 10,
+  10, 11, 11, 11, 11, 11, 11, 12, 12, 12,
+  12, 13, 13, 14, 14, 14, 14, 15, 15, 15,
+  15, 15, 15, 16, 16, 16, 16, 16, 16, 17,
+  17, 18, 18, 18
+};
+
+/// unset bits > stop, same table as in Erat.cpp
+const array<byte_t, 37> unsetLarger =
+{
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+  0x01, 0x01, 0x01, 0x03, 0x03, 0x07, 0x07, 0x07,
+  0x07, 0x0f, 0x0f, 0x1f, 0x1f, 0x1f, 0x1f, 0x3f,
+  0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x7f, 0x7f, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+uint64_t byteRemainder(uint64_t n)
+{
+  n %= 30;
+  if (n <= 6) n += 30;
+  return n;
+}
+
+} // namespace
+
+namespace primesieve {
+
+SmallPi& SmallPi::getInstance()
+{
+  static SmallPi smallPi;
+  return smallPi;
+}
+
+uint64_t SmallPi::limit()
+{
+  return smallPiLimit;
+}
+
+/// Count the primes <= stop
+uint64_t SmallPi::pi(uint64_t stop)
+{
+  assert(stop <= limit());
+
+  if (stop < piTiny.size())
+    return piTiny[stop];
+
+  call_once(init_, [this] { init(); });
+
+  uint64_t rem = byteRemainder(stop);
+  uint64_t i = (stop - rem) / 30;
+  uint64_t count = rank_[i / 8];
+
+  // gather the remaining < 8 bytes and the boundary byte
+  // (with its bits > stop masked off) into one 64-bit word
+  uint64_t word = 0;
+  byte_t* bytes = (byte_t*) &word;
+  for (uint64_t j = i - i % 8; j < i; j++)
+    bytes[j % 8] = sieve_[j];
+  bytes[i % 8] = sieve_[i] & unsetLarger[rem];
+
+  // the primes 2, 3 and 5 are not
+  // representable in the sieve array
+  return 3 + count + popcount(&word, 1);
+}
+
+/// Build the bitmap and its rank counts, runs once per
+/// process. The raw sieve bytes are copied straight out of
+/// the segment callback, no primes are decoded
+///
+void SmallPi::init()
+{
+  uint64_t bytes = smallPiLimit / 30 + 1;
+  // pad to whole 64-bit words so pi() can
+  // always gather full words
+  uint64_t size = ceilDiv(bytes, 8) * 8;
+  sieve_.resize(size, 0);
+
+  sieve_segments(7, smallPiLimit,
+    [this](uint64_t low, const uint8_t* sieve, size_t n)
+    {
+      copy_n(sieve, n, &sieve_[low / 30]);
+    });
+
+  uint64_t words = size / 8;
+  rank_.reserve(words);
+  uint64_t count = 0;
+
+  for (uint64_t w = 0; w < words; w++)
+  {
+    rank_.push_back((uint32_t) count);
+    uint64_t word;
+    memcpy(&word, &sieve_[w * 8], 8);
+    count += popcount(&word, 1);
+  }
+}
+
+} // namespace
@@ -0,0 +1,59 @@
+///
+/// @file   StreamSegments.cpp
+/// @brief  Sieve [start, stop] and invoke a user callback with
+///         the raw sieve array after each sieved segment. The
+///         callback gets a zero-copy view of the internal sieve
+///         array (8 bits per 30 numbers), so consumers that
+///         intersect the bitmap with their own data structures
+///         avoid decoding the primes and re-encoding them.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/Erat.hpp>
+#include <primesieve/pmath.hpp>
+#include <primesieve/PreSieve.hpp>
+#include <primesieve/SievingPrimes.hpp>
+#include <primesieve/StreamSegments.hpp>
+
+#include <stdint.h>
+#include <cstddef>
+
+using namespace std;
+
+namespace primesieve {
+
+StreamSegments::StreamSegments(uint64_t start,
+                               uint64_t stop,
+                               const callback_t& callback) :
+  preSieve_(start, stop),
+  callback_(callback)
+{
+  Erat::init(start, stop, get_sieve_size(), preSieve_);
+}
+
+void StreamSegments::sieve()
+{
+  SievingPrimes sievingPrimes(this, preSieve_);
+  uint64_t prime = sievingPrimes.next();
+
+  while (hasNextSegment())
+  {
+    uint64_t low = segmentLow_;
+    uint64_t sqrtHigh = isqrt(segmentHigh_);
+
+    for (; prime <= sqrtHigh; prime = sievingPrimes.next())
+      addSievingPrime(prime);
+
+    // bits < start (first segment) and bits > stop
+    // (last segment) have already been unset
+    sieveSegment();
+    callback_(low, sieve_, sieveSize_);
+  }
+}
+
+} // namespace
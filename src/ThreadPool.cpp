@@ -0,0 +1,129 @@
+///
+/// @file   ThreadPool.cpp
+/// @brief  Persistent library-wide pool of worker threads,
+///         see ThreadPool.hpp.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve/ThreadPool.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+using namespace std;
+
+namespace {
+
+thread_local bool isWorker = false;
+
+}
+
+namespace primesieve {
+
+bool ThreadPool::isWorkerThread()
+{
+  return isWorker;
+}
+
+ThreadPool& ThreadPool::getInstance()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    unique_lock<mutex> lock(lock_);
+    stop_ = true;
+  }
+
+  pending_.notify_all();
+
+  for (auto& thread : threads_)
+    thread.join();
+}
+
+/// Lazily grow the pool, the worker threads
+/// persist until the program exits
+///
+void ThreadPool::startThreads(int threads)
+{
+  while (threads_.size() < (size_t) threads)
+    threads_.emplace_back(&ThreadPool::workerThread, this);
+}
+
+void ThreadPool::execute(int threads, const function<void(int)>& task)
+{
+  Job job;
+  job.task = &task;
+  job.total = threads;
+
+  unique_lock<mutex> lock(lock_);
+  startThreads(threads);
+  jobs_.push_back(&job);
+  pending_.notify_all();
+
+  finished_.wait(lock, [&] {
+    return job.finished == job.total;
+  });
+
+  if (job.exception)
+    rethrow_exception(job.exception);
+}
+
+void ThreadPool::workerThread()
+{
+  isWorker = true;
+  unique_lock<mutex> lock(lock_);
+
+  while (true)
+  {
+    pending_.wait(lock, [&] {
+      return stop_ || !jobs_.empty();
+    });
+
+    if (stop_)
+      return;
+
+    // hand out the job's next task index, once
+    // all indexes are handed out the job is
+    // removed from the queue (its caller still
+    // waits for the finished count)
+    Job* job = jobs_.front();
+    int index = job->next++;
+
+    if (job->next == job->total)
+      jobs_.erase(jobs_.begin());
+
+    lock.unlock();
+    exception_ptr exception;
+
+    try
+    {
+      (*job->task)(index);
+    }
+    catch (...)
+    {
+      exception = current_exception();
+    }
+
+    lock.lock();
+
+    // the first exception is rethrown
+    // on the calling thread
+    if (exception && !job->exception)
+      job->exception = exception;
+
+    if (++job->finished == job->total)
+      finished_.notify_all();
+  }
+}
+
+} // namespace
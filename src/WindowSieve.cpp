@@ -0,0 +1,137 @@
+///
+/// @file   WindowSieve.cpp
+/// @brief  Count the primes in consecutive windows with
+///         monotonically growing upper bounds. Each advance(stop)
+///         call continues the segment iteration up to the segment
+///         containing stop, the count at a boundary inside a
+///         segment is derived from the fused segment counts plus
+///         a partial count of the last sieved segment, like
+///         CountIntervals does for a batch of boundary points.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/Erat.hpp>
+#include <primesieve/pmath.hpp>
+#include <primesieve/PreSieve.hpp>
+#include <primesieve/primesieve_error.hpp>
+#include <primesieve/SievingPrimes.hpp>
+#include <primesieve/WindowSieve.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+
+using namespace std;
+
+namespace primesieve {
+
+WindowSieve::Sieve::Sieve(uint64_t start, uint64_t stop) :
+  preSieve_(start, stop)
+{
+  uint64_t sieveStart = max<uint64_t>(7, start);
+
+  Erat::init(sieveStart, stop, get_sieve_size(), preSieve_);
+  sievingPrimes_.init(this, preSieve_);
+
+  // primes are counted while sieving (during the last
+  // cross-off pass of each segment) which avoids a second
+  // pass over the cache-cold sieve array
+  fusedCount_ = &count_;
+}
+
+void WindowSieve::Sieve::sieveTo(uint64_t n)
+{
+  n = min(n, stop_);
+
+  while (sievedHigh_ < n &&
+         hasNextSegment())
+  {
+    low_ = segmentLow_;
+    uint64_t sqrtHigh = isqrt(segmentHigh_);
+
+    if (!prime_)
+      prime_ = sievingPrimes_.next();
+
+    while (prime_ <= sqrtHigh)
+    {
+      addSievingPrime(prime_);
+      prime_ = sievingPrimes_.next();
+    }
+
+    prevCount_ = count_;
+    sieveSegment();
+
+    // the last segment is truncated at stop_,
+    // sieveSegment() shrinks sieveSize_ for it
+    if (!hasNextSegment())
+      sievedHigh_ = stop_;
+    else
+      sievedHigh_ = checkedAdd(low_, sieveSize_ * 30 - 1);
+  }
+}
+
+uint64_t WindowSieve::Sieve::prefix(uint64_t n) const
+{
+  n = min(n, sievedHigh_);
+  return prevCount_ + countSieve(low_, n);
+}
+
+WindowSieve::WindowSieve(uint64_t start) :
+  prevStop_(checkedSub(start, 1)),
+  resume_(start)
+{ }
+
+/// Replace the sieve with one whose stop bound (horizon)
+/// covers stop. The horizon doubles so that the sieving
+/// primes are regenerated only a logarithmic number of
+/// times while the windows advance.
+///
+void WindowSieve::grow(uint64_t stop)
+{
+  if (sieve_)
+  {
+    // finish the current horizon, its total
+    // count becomes part of the base prefix
+    sieve_->sieveTo(horizon_);
+    basePrefix_ += sieve_->count();
+    resume_ = checkedAdd(horizon_, 1);
+  }
+
+  // give the sieve a horizon of at least a few segments
+  uint64_t sieveBytes = (uint64_t) get_sieve_size() << 10;
+  horizon_ = checkedAdd(stop, stop);
+  horizon_ = max(horizon_, checkedAdd(resume_, sieveBytes * 30 * 4));
+  sieve_.reset(new Sieve(resume_, horizon_));
+}
+
+uint64_t WindowSieve::advance(uint64_t stop)
+{
+  if (stop < prevStop_)
+    throw primesieve_error("advance(): stop must not decrease");
+
+  uint64_t count = 0;
+
+  // the primes 2, 3 and 5 are not
+  // representable in the sieve array
+  for (uint64_t prime : { 2, 3, 5 })
+    count += (prime > prevStop_ && prime <= stop);
+
+  if (!sieve_ ||
+      stop > horizon_)
+    grow(stop);
+
+  sieve_->sieveTo(stop);
+  uint64_t prefix = basePrefix_ + sieve_->prefix(stop);
+
+  count += prefix - prevPrefix_;
+  prevPrefix_ = prefix;
+  prevStop_ = stop;
+
+  return count;
+}
+
+} // namespace
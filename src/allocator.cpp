@@ -0,0 +1,74 @@
+///
+/// @file   allocator.cpp
+/// @brief  Customization point for primesieve's large internal
+///         allocations, see set_allocator() in primesieve.hpp.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/allocator.hpp>
+#include <primesieve/primesieve_error.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+/// Installed by set_allocator(), null = default allocator.
+/// deallocBytes() always uses the currently installed hooks,
+/// so set_allocator() must be called before sieving starts
+/// while no internal allocations are alive (the bucket pools
+/// keep chunks across sieve() calls, see BucketPool.cpp)
+std::atomic<primesieve::allocator_t> allocHook(nullptr);
+std::atomic<primesieve::deallocator_t> deallocHook(nullptr);
+
+} // namespace
+
+namespace primesieve {
+
+void set_allocator(allocator_t alloc, deallocator_t dealloc)
+{
+  if (!alloc != !dealloc)
+    throw primesieve_error("set_allocator: alloc and dealloc must both be set (or both null)");
+
+  allocHook = alloc;
+  deallocHook = dealloc;
+}
+
+byte_t* allocBytes(size_t bytes)
+{
+  allocator_t alloc = allocHook.load();
+
+  if (alloc)
+  {
+    void* ptr = alloc(bytes);
+    if (!ptr)
+      throw primesieve_error("custom allocator failed to allocate " + to_string(bytes) + " bytes");
+    return (byte_t*) ptr;
+  }
+
+  return (byte_t*) ::operator new(bytes);
+}
+
+void deallocBytes(void* ptr, size_t bytes)
+{
+  if (!ptr)
+    return;
+
+  deallocator_t dealloc = deallocHook.load();
+
+  if (dealloc)
+    dealloc(ptr, bytes);
+  else
+    ::operator delete(ptr);
+}
+
+} // namespace
@@ -14,13 +14,16 @@
 #include <primesieve.hpp>
 #include <primesieve/PrimeSieve.hpp>
 #include <primesieve/ParallelSieve.hpp>
+#include <primesieve/PiTable.hpp>
 #include <primesieve/malloc_vector.hpp>
 
 #include <stdint.h>
+#include <atomic>
 #include <cstdlib>
 #include <cstddef>
 #include <cerrno>
 #include <exception>
+#include <thread>
 
 using namespace std;
 using namespace primesieve;
@@ -69,8 +72,241 @@ void* store_n_primes(uint64_t n, uint64_t start)
   return NULL;
 }
 
+/// Same as the C++ store_primes() but the primes are written
+/// directly into the caller owned buffer, so there are no
+/// realloc copies and no ownership transfer
+///
+template <typename T>
+size_t store_primes_buffer(uint64_t start,
+                           uint64_t stop,
+                           void* buffer,
+                           size_t capacity)
+{
+  try
+  {
+    if (!buffer)
+      throw primesieve_error("buffer must not be NULL");
+
+    T* primes = (T*) buffer;
+    size_t size = 0;
+
+    if (start > 0)
+      start--;
+    if (~stop == 0)
+      stop--;
+
+    if (start < stop)
+    {
+      primesieve::iterator it(start, stop);
+      uint64_t prime = it.next_prime();
+      for (; prime <= stop; prime = it.next_prime())
+      {
+        if (size >= capacity)
+          throw primesieve_error("buffer too small, use primesieve_count_approx()");
+        primes[size++] = (T) prime;
+      }
+    }
+
+    return size;
+  }
+  catch (exception&)
+  {
+    errno = EDOM;
+    return ~((size_t) 0);
+  }
+}
+
 } // namespace
 
+size_t primesieve_count_approx(uint64_t start, uint64_t stop)
+{
+  return prime_count_approx(start, stop);
+}
+
+size_t primesieve_generate_primes_buffer(uint64_t start, uint64_t stop, void* buffer, size_t capacity, int type)
+{
+  switch (type)
+  {
+    case SHORT_PRIMES:     return store_primes_buffer<short>(start, stop, buffer, capacity);
+    case USHORT_PRIMES:    return store_primes_buffer<unsigned short>(start, stop, buffer, capacity);
+    case INT_PRIMES:       return store_primes_buffer<int>(start, stop, buffer, capacity);
+    case UINT_PRIMES:      return store_primes_buffer<unsigned int>(start, stop, buffer, capacity);
+    case LONG_PRIMES:      return store_primes_buffer<long>(start, stop, buffer, capacity);
+    case ULONG_PRIMES:     return store_primes_buffer<unsigned long>(start, stop, buffer, capacity);
+    case LONGLONG_PRIMES:  return store_primes_buffer<long long>(start, stop, buffer, capacity);
+    case ULONGLONG_PRIMES: return store_primes_buffer<unsigned long long>(start, stop, buffer, capacity);
+    case INT16_PRIMES:     return store_primes_buffer<int16_t>(start, stop, buffer, capacity);
+    case UINT16_PRIMES:    return store_primes_buffer<uint16_t>(start, stop, buffer, capacity);
+    case INT32_PRIMES:     return store_primes_buffer<int32_t>(start, stop, buffer, capacity);
+    case UINT32_PRIMES:    return store_primes_buffer<uint32_t>(start, stop, buffer, capacity);
+    case INT64_PRIMES:     return store_primes_buffer<int64_t>(start, stop, buffer, capacity);
+    case UINT64_PRIMES:    return store_primes_buffer<uint64_t>(start, stop, buffer, capacity);
+  }
+  errno = EDOM;
+  return ~((size_t) 0);
+}
+
+/// The *_noexcept() variants below report errors via their
+/// int return value instead of an error sentinel plus errno.
+/// They are declared noexcept so that C++ call sites (e.g.
+/// -fno-exceptions embedded builds) compile without unwind
+/// code, internally the sieve still uses exceptions but none
+/// ever escapes
+///
+int primesieve_generate_primes_buffer_noexcept(uint64_t start, uint64_t stop, void* buffer, size_t capacity, int type, size_t* size) PRIMESIEVE_NOEXCEPT
+{
+  size_t n = primesieve_generate_primes_buffer(start, stop, buffer, capacity, type);
+
+  if (n == ~((size_t) 0))
+  {
+    if (size)
+      *size = 0;
+    return 1;
+  }
+
+  if (size)
+    *size = n;
+  return 0;
+}
+
+int primesieve_nth_prime_noexcept(int64_t n, uint64_t start, uint64_t* prime) PRIMESIEVE_NOEXCEPT
+{
+  try
+  {
+    ParallelSieve ps;
+    ps.setSieveSize(get_sieve_size());
+    ps.setNumThreads(get_num_threads());
+    uint64_t nthPrime = ps.nthPrime(n, start);
+    if (prime)
+      *prime = nthPrime;
+    return 0;
+  }
+  catch (exception&)
+  {
+    if (prime)
+      *prime = 0;
+    return 1;
+  }
+}
+
+int primesieve_count_primes_noexcept(uint64_t start, uint64_t stop, uint64_t* count) PRIMESIEVE_NOEXCEPT
+{
+  try
+  {
+    uint64_t primes;
+
+    // pi(x) queries are mostly answered
+    // from the checkpoint table
+    if (start == 0 &&
+        stop >= PiTable::distance())
+      primes = PiTable::getInstance().pi(stop);
+    else
+    {
+      ParallelSieve ps;
+      ps.setSieveSize(get_sieve_size());
+      ps.setNumThreads(get_num_threads());
+      ps.sieve(start, stop, COUNT_PRIMES);
+      primes = ps.getCount(0);
+    }
+
+    if (count)
+      *count = primes;
+    return 0;
+  }
+  catch (exception&)
+  {
+    if (count)
+      *count = 0;
+    return 1;
+  }
+}
+
+/// Handle of an asynchronous operation, see
+/// primesieve_count_primes_async() in primesieve.h.
+/// The sieving runs in a dedicated background thread,
+/// cancellation uses PrimeSieve::cancelSieve() whose
+/// flag the sieving loops check once per segment
+///
+struct primesieve_async
+{
+  ParallelSieve ps;
+  std::thread thread;
+  std::atomic<bool> cancelled;
+  /// 0 = success, 1 = error, 2 = cancelled
+  std::atomic<int> status;
+};
+
+primesieve_async* primesieve_count_primes_async(uint64_t start, uint64_t stop, primesieve_async_callback callback, void* user_data)
+{
+  try
+  {
+    if (!callback)
+      throw primesieve_error("callback must not be NULL");
+
+    primesieve_async* async = new primesieve_async();
+    async->cancelled = false;
+    async->status = 1;
+    async->ps.setSieveSize(get_sieve_size());
+    async->ps.setNumThreads(get_num_threads());
+
+    async->thread = std::thread([=]()
+    {
+      uint64_t count = 0;
+      int status;
+
+      try
+      {
+        count = async->ps.countPrimes(start, stop);
+        // the counts are incomplete after cancellation,
+        // cancelled wins over success
+        status = async->cancelled.load() ? 2 : 0;
+      }
+      catch (exception&)
+      {
+        status = 1;
+      }
+
+      async->status = status;
+      callback(count, status, user_data);
+    });
+
+    return async;
+  }
+  catch (exception&)
+  {
+    errno = EDOM;
+  }
+  return NULL;
+}
+
+void primesieve_async_cancel(primesieve_async* async)
+{
+  if (async)
+  {
+    // set cancelled before cancelSieve() so that the
+    // background thread reads cancelled = true once
+    // its sieving loops have stopped
+    async->cancelled = true;
+    async->ps.cancelSieve();
+  }
+}
+
+int primesieve_async_wait(primesieve_async* async)
+{
+  if (!async)
+  {
+    errno = EDOM;
+    return 1;
+  }
+
+  if (async->thread.joinable())
+    async->thread.join();
+
+  int status = async->status;
+  delete async;
+  return status;
+}
+
 void* primesieve_generate_primes(uint64_t start, uint64_t stop, size_t* size, int type)
 {
   switch (type)
@@ -144,6 +380,12 @@ uint64_t primesieve_count_primes(uint64_t start, uint64_t stop)
 {
   try
   {
+    // pi(x) queries are mostly answered
+    // from the checkpoint table
+    if (start == 0 &&
+        stop >= PiTable::distance())
+      return PiTable::getInstance().pi(stop);
+
     ParallelSieve ps;
     ps.setSieveSize(get_sieve_size());
     ps.setNumThreads(get_num_threads());
@@ -346,6 +588,42 @@ void primesieve_set_num_threads(int num_threads)
   set_num_threads(num_threads);
 }
 
+void primesieve_set_tuning(const primesieve_tuning* tuning)
+{
+  try
+  {
+    if (!tuning)
+      throw primesieve_error("tuning must not be NULL");
+
+    Tuning t;
+    t.factorEratSmall = tuning->factor_eratsmall;
+    t.factorEratMedium = tuning->factor_eratmedium;
+    t.bytesPerAlloc = tuning->bytes_per_alloc;
+    t.minCacheIterator = tuning->min_cache_iterator;
+    t.maxCacheIterator = tuning->max_cache_iterator;
+    t.minThreadDistance = tuning->min_thread_distance;
+    set_tuning(t);
+  }
+  catch (exception&)
+  {
+    errno = EDOM;
+  }
+}
+
+void primesieve_get_tuning(primesieve_tuning* tuning)
+{
+  if (!tuning)
+    return;
+
+  Tuning t = get_tuning();
+  tuning->factor_eratsmall = t.factorEratSmall;
+  tuning->factor_eratmedium = t.factorEratMedium;
+  tuning->bytes_per_alloc = t.bytesPerAlloc;
+  tuning->min_cache_iterator = t.minCacheIterator;
+  tuning->max_cache_iterator = t.maxCacheIterator;
+  tuning->min_thread_distance = t.minThreadDistance;
+}
+
 uint64_t primesieve_get_max_stop()
 {
   return get_max_stop();
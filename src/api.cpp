@@ -11,15 +11,33 @@
 ///
 
 #include <primesieve.hpp>
+#include <primesieve/config.hpp>
+#include <primesieve/CountCache.hpp>
+#include <primesieve/CountIntervals.hpp>
+#include <primesieve/CountResidues.hpp>
 #include <primesieve/CpuInfo.hpp>
+#include <primesieve/kTuplets.hpp>
 #include <primesieve/pmath.hpp>
+#include <primesieve/PrimeGenerator.hpp>
 #include <primesieve/PrimeSieve.hpp>
 #include <primesieve/ParallelSieve.hpp>
+#include <primesieve/PiTable.hpp>
+#include <primesieve/SmallPi.hpp>
+#include <primesieve/StreamSegments.hpp>
+#include <primesieve/ThreadPool.hpp>
 
 #include <stdint.h>
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <limits>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace {
 
@@ -27,10 +45,313 @@ int sieve_size = 0;
 
 int num_threads = 0;
 
+bool huge_pages = true;
+
+/// Runtime tuning parameters, the defaults match the
+/// compile time constants in config.hpp
+primesieve::Tuning tuning =
+{
+  primesieve::config::FACTOR_ERATSMALL,
+  primesieve::config::FACTOR_ERATMEDIUM,
+  (uint64_t) primesieve::config::BYTES_PER_ALLOC,
+  (uint64_t) primesieve::config::MIN_CACHE_ITERATOR,
+  (uint64_t) primesieve::config::MAX_CACHE_ITERATOR,
+  primesieve::config::MIN_THREAD_DISTANCE,
+  primesieve::config::THREADS_PER_SEGMENT
+};
+
+bool validTuning(const primesieve::Tuning& t)
+{
+  return (t.factorEratSmall >= 0 && t.factorEratSmall <= 3) &&
+         (t.factorEratMedium >= 0 && t.factorEratMedium <= 5) &&
+         t.bytesPerAlloc >= (1 << 20) &&
+         t.minCacheIterator >= (1 << 16) &&
+         t.minCacheIterator <= t.maxCacheIterator &&
+         t.minThreadDistance >= 100 &&
+         t.threadsPerSegment >= 1 &&
+         t.threadsPerSegment <= 2;
+}
+
+std::once_flag tune_file_flag;
+
+/// Load the tuning profile written by save_tuning() from the
+/// file pointed to by the PRIMESIEVE_TUNE_FILE environment
+/// variable (same mechanism as PRIMESIEVE_PI_FILE). Invalid
+/// or unreadable profile files are silently ignored, an
+/// explicitly set sieve size is not overwritten.
+///
+void loadTuneFile()
+{
+  const char* path = std::getenv("PRIMESIEVE_TUNE_FILE");
+  if (!path)
+    return;
+
+  std::ifstream file(path);
+  if (!file)
+    return;
+
+  primesieve::Tuning t = tuning;
+  double tuneSieveSize = 0;
+  std::string key;
+  double value;
+
+  while (file >> key >> value)
+  {
+    if (key == "factorEratSmall") t.factorEratSmall = value;
+    else if (key == "factorEratMedium") t.factorEratMedium = value;
+    else if (key == "bytesPerAlloc") t.bytesPerAlloc = (uint64_t) value;
+    else if (key == "minCacheIterator") t.minCacheIterator = (uint64_t) value;
+    else if (key == "maxCacheIterator") t.maxCacheIterator = (uint64_t) value;
+    else if (key == "minThreadDistance") t.minThreadDistance = (uint64_t) value;
+    else if (key == "threadsPerSegment") t.threadsPerSegment = (int) value;
+    else if (key == "sieveSize") tuneSieveSize = value;
+    else return;
+  }
+
+  if (!validTuning(t))
+    return;
+
+  tuning = t;
+
+  if (tuneSieveSize && !sieve_size)
+    primesieve::set_sieve_size((int) tuneSieveSize);
+}
+
 }
 
 namespace primesieve {
 
+/// Sieve disjoint subranges concurrently with one
+/// PrimeGenerator per thread, then copy the per-chunk
+/// outputs to their final position in the contiguous
+/// primes vector (also in parallel). The chunk buffers
+/// are sized upfront using prime_count_approx so the
+/// sieving threads never reallocate.
+///
+void generate_primes_parallel(uint64_t start, uint64_t stop, std::vector<uint64_t>* primes)
+{
+  if (!primes)
+    return;
+  if (~stop == 0)
+    stop--;
+  if (start > stop)
+    return;
+
+  uint64_t dist = stop - start;
+  uint64_t maxThreads = dist / tuning.minThreadDistance;
+  int threads = (int) inBetween(1, maxThreads, get_num_threads());
+
+  if (threads == 1)
+  {
+    generate_primes(start, stop, primes);
+    return;
+  }
+
+  uint64_t chunk = dist / threads;
+  std::vector<std::vector<uint64_t>> chunkPrimes(threads);
+
+  auto sieveTask = [&](int t)
+  {
+    uint64_t low = start + chunk * t + (t > 0);
+    uint64_t high = (t + 1 == threads) ? stop : start + chunk * (t + 1);
+    auto& out = chunkPrimes[t];
+    out.reserve(prime_count_approx(low, high));
+    PrimeGenerator primeGenerator(low, high);
+    primeGenerator.fill(out);
+  };
+
+  ThreadPool::getInstance().execute(threads, sieveTask);
+
+  // compute the exact offset of each chunk
+  // in the output vector
+  std::vector<std::size_t> offsets(threads);
+  std::size_t offset = primes->size();
+
+  for (int t = 0; t < threads; t++)
+  {
+    offsets[t] = offset;
+    offset += chunkPrimes[t].size();
+  }
+
+  primes->resize(offset);
+  uint64_t* data = primes->data();
+
+  auto copyTask = [&](int t)
+  {
+    auto& out = chunkPrimes[t];
+    std::copy(out.begin(), out.end(), data + offsets[t]);
+  };
+
+  ThreadPool::getInstance().execute(threads, copyTask);
+}
+
+/// Store the first members of the prime k-tuplets inside
+/// [start, stop]. The chunk borders come from
+/// partition_range() whose modulo (30 + 2) alignment
+/// guarantees no k-tuplet byte is split across chunks. The
+/// k-tuplets are matched with the same byte bitmasks that
+/// PrintPrimes uses, directly against the raw sieve bytes
+/// of the sieve_segments() callback, so exporting e.g. the
+/// twin primes runs at sieve speed instead of print speed
+///
+void generate_ktuplets(int k, uint64_t start, uint64_t stop, std::vector<uint64_t>* kTuplets)
+{
+  if (!kTuplets)
+    return;
+  if (k < 2 || k > 6)
+    throw primesieve_error("generate_ktuplets: k must be >= 2 && <= 6");
+  if (~stop == 0)
+    stop--;
+  if (start > stop)
+    return;
+
+  // k-tuplets with a member <= 5 are not representable
+  // in the sieve array, same list as the smallPrimes
+  // table in PrimeSieve.cpp
+  struct SmallTuplet { int k; uint64_t first; uint64_t last; };
+  const std::array<SmallTuplet, 5> smallTuplets =
+  {{
+    { 2, 3,  5 }, // (3, 5)
+    { 2, 5,  7 }, // (5, 7)
+    { 3, 5, 11 }, // (5, 7, 11)
+    { 4, 5, 13 }, // (5, 7, 11, 13)
+    { 5, 5, 17 }  // (5, 7, 11, 13, 17)
+  }};
+
+  for (auto& t : smallTuplets)
+    if (t.k == k && t.first >= start && t.last <= stop)
+      kTuplets->push_back(t.first);
+
+  if (stop < 7)
+    return;
+
+  // value of the i-th bit within a sieve byte
+  const std::array<uint64_t, 8> bitValues = { 7, 11, 13, 17, 19, 23, 29, 31 };
+  const uint64_t* bitmasks = ktuplet::bitmasks[k - 1];
+
+  // offset of each bitmask's first member
+  // within its 30 number window
+  std::array<uint64_t, 5> firstMember;
+  for (int i = 0; bitmasks[i] != ktuplet::END; i++)
+  {
+    int bit = 0;
+    while (!(bitmasks[i] & (1ull << bit)))
+      bit++;
+    firstMember[i] = bitValues[bit];
+  }
+
+  uint64_t dist = stop - start;
+  uint64_t maxThreads = dist / tuning.minThreadDistance;
+  int threads = (int) inBetween(1, maxThreads, get_num_threads());
+
+  auto ranges = partition_range(std::max<uint64_t>(start, 7), stop, threads);
+  threads = (int) ranges.size();
+  std::vector<std::vector<uint64_t>> chunkTuplets(threads);
+
+  auto sieveTask = [&](int t)
+  {
+    auto& out = chunkTuplets[t];
+
+    sieve_segments(ranges[t].first, ranges[t].second,
+      [&](uint64_t low, const uint8_t* sieve, std::size_t size)
+      {
+        for (std::size_t j = 0; j < size; j++)
+          for (const uint64_t* b = bitmasks; *b <= sieve[j]; b++)
+            if ((sieve[j] & *b) == *b)
+              out.push_back(low + j * 30 + firstMember[b - bitmasks]);
+      });
+  };
+
+  if (threads == 1)
+    sieveTask(0);
+  else
+    ThreadPool::getInstance().execute(threads, sieveTask);
+
+  for (auto& chunk : chunkTuplets)
+    kTuplets->insert(kTuplets->end(), chunk.begin(), chunk.end());
+}
+
+/// Allocation-free prime generation into a caller
+/// provided buffer, layered on PrimeGenerator::fillBuffer
+/// so the primes never pass through an intermediate
+/// growable container
+///
+void generate_primes_buffered(uint64_t start,
+                              uint64_t stop,
+                              uint64_t* buffer,
+                              std::size_t capacity,
+                              const std::function<void(const uint64_t*, std::size_t)>& callback)
+{
+  if (!buffer || !callback)
+    return;
+  if (capacity < 64)
+    throw primesieve_error("generate_primes_buffered: buffer capacity must be >= 64");
+  if (~stop == 0)
+    stop--;
+  if (start > stop)
+    return;
+
+  PrimeGenerator primeGenerator(start, stop);
+  std::size_t size = 0;
+
+  while (!primeGenerator.finished())
+  {
+    primeGenerator.fillBuffer(buffer, capacity, &size);
+    if (size > 0)
+      callback(buffer, size);
+  }
+}
+
+void sieve_segments(uint64_t start,
+                    uint64_t stop,
+                    const std::function<void(uint64_t, const uint8_t*, std::size_t)>& callback)
+{
+  if (!callback)
+    return;
+
+  // primes < 7 are not representable
+  // in the sieve array's bit layout
+  start = std::max<uint64_t>(start, 7);
+  if (start > stop)
+    return;
+
+  StreamSegments streamSegments(start, stop, callback);
+  streamSegments.sieve();
+}
+
+/// The subinterval borders are aligned to modulo (30 + 2)
+/// using ParallelSieve::align, exactly like the work chunks
+/// of the sieving threads, so that summing the counts of
+/// the subintervals matches a single-run count
+///
+std::vector<std::pair<uint64_t, uint64_t>>
+  partition_range(uint64_t start, uint64_t stop, uint64_t parts)
+{
+  std::vector<std::pair<uint64_t, uint64_t>> ranges;
+
+  if (start > stop)
+    return ranges;
+
+  parts = std::max<uint64_t>(1, parts);
+  uint64_t chunk = (stop - start) / parts;
+  uint64_t low = start;
+
+  for (uint64_t i = 0; i < parts; i++)
+  {
+    uint64_t high = stop;
+    if (i + 1 < parts)
+      high = ParallelSieve::align(checkedAdd(low, chunk), stop);
+
+    ranges.emplace_back(low, high);
+    if (high >= stop)
+      break;
+
+    low = high + 1;
+  }
+
+  return ranges;
+}
+
 uint64_t nth_prime(int64_t n, uint64_t start)
 {
   ParallelSieve ps;
@@ -41,6 +362,36 @@ uint64_t nth_prime(int64_t n, uint64_t start)
 
 uint64_t count_primes(uint64_t start, uint64_t stop)
 {
+  // tiny queries are answered from a static table plus a
+  // packed rank bitmap, no sieve object is constructed
+  if (stop <= SmallPi::limit())
+  {
+    if (start > stop)
+      return 0;
+    SmallPi& smallPi = SmallPi::getInstance();
+    uint64_t count = smallPi.pi(stop);
+    if (start > 0)
+      count -= smallPi.pi(start - 1);
+    return count;
+  }
+
+  // pi(x) queries are mostly answered from the checkpoint
+  // table, only the residual subrange above the largest
+  // checkpoint needs to be sieved
+  if (start == 0 &&
+      stop >= PiTable::distance())
+    return PiTable::getInstance().pi(stop);
+
+  // optional memoization mode: the counts of aligned 10^9
+  // blocks are cached in the file pointed to by the
+  // PRIMESIEVE_COUNT_FILE environment variable, repeated
+  // jobs over overlapping ranges reuse the block counts
+  // and only sieve the block boundary residuals
+  if (start < stop &&
+      stop - start >= CountCache::distance() - 1 &&
+      CountCache::enabled())
+    return CountCache::getInstance().countPrimes(start, stop);
+
   ParallelSieve ps;
   ps.setSieveSize(get_sieve_size());
   ps.setNumThreads(get_num_threads());
@@ -48,6 +399,257 @@ uint64_t count_primes(uint64_t start, uint64_t stop)
   return ps.getCount(0);
 }
 
+/// Count the primes ≡ a (mod q) inside [start, stop]. The
+/// residue class is counted directly on the sieve bitmap
+/// (see CountResidues.cpp), large intervals are split
+/// across threads and the per thread counts are summed
+///
+uint64_t count_primes_mod(uint64_t start, uint64_t stop, uint64_t q, uint64_t a)
+{
+  if (q == 0)
+    throw primesieve_error("count_primes_mod: modulus must be > 0");
+
+  a %= q;
+  if (~stop == 0)
+    stop--;
+  if (start > stop)
+    return 0;
+
+  // The residue count tables use q * 256 bytes of memory
+  // (see CountResidues.cpp), so the table engine is capped
+  // at a few thousand, which covers every pi(x; q, a) use
+  // case. Larger moduli fall back to filtering the generated
+  // primes: slower per prime, but the memory usage is
+  // independent of q and huge moduli (whose table size
+  // computation would overflow) are handled correctly
+  const uint64_t maxResidueModulus = 4096;
+
+  if (q > maxResidueModulus)
+  {
+    // the generated primes include 2, 3 and 5,
+    // no separate small prime handling needed
+    auto filter = [q, a](uint64_t acc, const uint64_t* primes, std::size_t size)
+    {
+      for (std::size_t i = 0; i < size; i++)
+        acc += (primes[i] % q == a);
+      return acc;
+    };
+
+    auto sum = [](uint64_t x, uint64_t y) { return x + y; };
+    return reduce_primes(start, stop, 0, filter, sum);
+  }
+
+  uint64_t count = 0;
+
+  // primes below the sieving range
+  const uint64_t smallPrimes[3] = { 2, 3, 5 };
+  for (uint64_t prime : smallPrimes)
+    if (prime >= start && prime <= stop && prime % q == a)
+      count++;
+
+  uint64_t low = std::max<uint64_t>(7, start);
+  if (low > stop)
+    return count;
+
+  uint64_t dist = stop - low;
+  uint64_t maxThreads = dist / tuning.minThreadDistance;
+  int threads = (int) inBetween(1, maxThreads, get_num_threads());
+
+  if (threads == 1)
+  {
+    CountResidues countResidues(low, stop, q, a);
+    countResidues.sieve();
+    return count + countResidues.getCount();
+  }
+
+  std::vector<uint64_t> counts(threads, 0);
+  uint64_t chunk = dist / threads;
+
+  auto countTask = [&](int t)
+  {
+    uint64_t first = low + chunk * t + (t > 0);
+    uint64_t last = (t + 1 == threads) ? stop : low + chunk * (t + 1);
+    CountResidues countResidues(first, last, q, a);
+    countResidues.sieve();
+    counts[t] = countResidues.getCount();
+  };
+
+  ThreadPool::getInstance().execute(threads, countTask);
+
+  for (uint64_t c : counts)
+    count += c;
+
+  return count;
+}
+
+uint64_t sum_primes(uint64_t start, uint64_t stop)
+{
+  if (~stop == 0)
+    stop--;
+  if (start > stop)
+    return 0;
+
+  uint64_t dist = stop - start;
+  uint64_t maxThreads = dist / tuning.minThreadDistance;
+  int threads = (int) inBetween(1, maxThreads, get_num_threads());
+
+  if (threads == 1)
+  {
+    PrimeGenerator primeGenerator(start, stop);
+    return primeGenerator.sum();
+  }
+
+  std::vector<uint64_t> sums(threads, 0);
+  uint64_t chunk = dist / threads;
+
+  auto sumTask = [&](int t)
+  {
+    uint64_t low = start + chunk * t + (t > 0);
+    uint64_t high = (t + 1 == threads) ? stop : start + chunk * (t + 1);
+    PrimeGenerator primeGenerator(low, high);
+    sums[t] = primeGenerator.sum();
+  };
+
+  ThreadPool::getInstance().execute(threads, sumTask);
+
+  uint64_t sum = 0;
+  for (uint64_t s : sums)
+    sum += s;
+
+  return sum;
+}
+
+uint64_t reduce_primes(uint64_t start,
+                       uint64_t stop,
+                       uint64_t init,
+                       const std::function<uint64_t(uint64_t, const uint64_t*, std::size_t)>& block,
+                       const std::function<uint64_t(uint64_t, uint64_t)>& merge)
+{
+  if (!block || !merge)
+    return init;
+  if (~stop == 0)
+    stop--;
+  if (start > stop)
+    return init;
+
+  uint64_t dist = stop - start;
+  uint64_t maxThreads = dist / tuning.minThreadDistance;
+  int threads = (int) inBetween(1, maxThreads, get_num_threads());
+
+  // fold one subrange using a stack buffer, the primes
+  // never pass through a growable container
+  auto fold = [&](uint64_t low, uint64_t high)
+  {
+    uint64_t buffer[1024];
+    std::size_t size = 0;
+    uint64_t acc = init;
+    PrimeGenerator primeGenerator(low, high);
+
+    while (!primeGenerator.finished())
+    {
+      primeGenerator.fillBuffer(buffer, 1024, &size);
+      if (size > 0)
+        acc = block(acc, buffer, size);
+    }
+
+    return acc;
+  };
+
+  if (threads == 1)
+    return fold(start, stop);
+
+  std::vector<uint64_t> partials(threads, init);
+  uint64_t chunk = dist / threads;
+
+  auto foldTask = [&](int t)
+  {
+    uint64_t low = start + chunk * t + (t > 0);
+    uint64_t high = (t + 1 == threads) ? stop : start + chunk * (t + 1);
+    partials[t] = fold(low, high);
+  };
+
+  ThreadPool::getInstance().execute(threads, foldTask);
+
+  // combine the per-thread partial
+  // results in range order
+  uint64_t result = partials[0];
+  for (int t = 1; t < threads; t++)
+    result = merge(result, partials[t]);
+
+  return result;
+}
+
+/// The interval boundaries are deduplicated and sorted,
+/// then CountIntervals sieves the union of the intervals
+/// once and records the prefix prime count at each
+/// boundary, the count of an interval is the difference
+/// of its two boundary prefix counts
+///
+std::vector<uint64_t> count_primes_intervals(const std::vector<std::pair<uint64_t, uint64_t>>& intervals)
+{
+  std::vector<uint64_t> counts(intervals.size(), 0);
+  std::vector<uint64_t> points;
+  points.reserve(intervals.size() * 2);
+  uint64_t start = get_max_stop();
+
+  for (const auto& interval : intervals)
+  {
+    if (interval.first >= interval.second)
+      continue;
+    start = std::min(start, interval.first);
+    if (interval.first > 0)
+      points.push_back(interval.first - 1);
+    points.push_back(interval.second - 1);
+  }
+
+  if (points.empty())
+    return counts;
+
+  std::sort(points.begin(), points.end());
+  points.erase(std::unique(points.begin(), points.end()), points.end());
+  uint64_t stop = points.back();
+
+  // pi[i] = number of primes inside [start, points[i]]
+  std::vector<uint64_t> pi(points.size(), 0);
+  start = std::max<uint64_t>(7, start);
+
+  if (start <= stop)
+  {
+    CountIntervals countIntervals(start, stop, points);
+    countIntervals.sieve();
+    pi = countIntervals.getCounts();
+  }
+
+  // primes below the sieving range
+  const uint64_t smallPrimes[3] = { 2, 3, 5 };
+
+  for (std::size_t i = 0; i < intervals.size(); i++)
+  {
+    uint64_t a = intervals[i].first;
+    uint64_t b = intervals[i].second;
+    if (a >= b)
+      continue;
+
+    auto prefix = [&](uint64_t n)
+    {
+      auto iter = std::lower_bound(points.begin(), points.end(), n);
+      return pi[iter - points.begin()];
+    };
+
+    uint64_t count = prefix(b - 1);
+    if (a > 0)
+      count -= prefix(a - 1);
+
+    for (uint64_t prime : smallPrimes)
+      if (a <= prime && prime < b)
+        count++;
+
+    counts[i] = count;
+  }
+
+  return counts;
+}
+
 uint64_t count_twins(uint64_t start, uint64_t stop)
 {
   ParallelSieve ps;
@@ -148,6 +750,55 @@ void set_num_threads(int threads)
   num_threads = inBetween(1, threads, ParallelSieve::getMaxThreads());
 }
 
+void set_huge_pages(bool enable)
+{
+  huge_pages = enable;
+}
+
+bool get_huge_pages()
+{
+  return huge_pages;
+}
+
+void set_tuning(const Tuning& t)
+{
+  if (!validTuning(t))
+    throw primesieve_error("set_tuning: invalid tuning parameters");
+
+  // consume the profile load flag so that a profile file
+  // cannot overwrite explicitly set tuning parameters
+  std::call_once(tune_file_flag, []{});
+  tuning = t;
+}
+
+Tuning get_tuning()
+{
+  std::call_once(tune_file_flag, loadTuneFile);
+  return tuning;
+}
+
+void save_tuning(const std::string& filePath)
+{
+  std::string tmpFile = filePath + ".tmp";
+  std::ofstream file(tmpFile, std::ofstream::trunc);
+  if (!file)
+    throw primesieve_error("save_tuning: cannot write " + filePath);
+
+  Tuning t = get_tuning();
+  file << "factorEratSmall " << t.factorEratSmall << "\n";
+  file << "factorEratMedium " << t.factorEratMedium << "\n";
+  file << "bytesPerAlloc " << t.bytesPerAlloc << "\n";
+  file << "minCacheIterator " << t.minCacheIterator << "\n";
+  file << "maxCacheIterator " << t.maxCacheIterator << "\n";
+  file << "minThreadDistance " << t.minThreadDistance << "\n";
+  file << "threadsPerSegment " << t.threadsPerSegment << "\n";
+  file << "sieveSize " << get_sieve_size() << "\n";
+  file.close();
+
+  std::remove(filePath.c_str());
+  std::rename(tmpFile.c_str(), filePath.c_str());
+}
+
 uint64_t get_max_stop()
 {
   return std::numeric_limits<uint64_t>::max();
@@ -166,6 +817,9 @@ void set_sieve_size(int kilobytes)
 
 int get_sieve_size()
 {
+  // the tuning profile may contain a sieve size
+  std::call_once(tune_file_flag, loadTuneFile);
+
   // user specified sieve size
   if (sieve_size)
     return sieve_size;
@@ -177,28 +831,43 @@ int get_sieve_size()
   l1CacheSize /= 1024;
   l2CacheSize /= 1024;
 
-  // check if each CPU core has a private L2 cache
   if (cpuInfo.hasL2Cache() &&
-      cpuInfo.privateL2Cache() &&
       l2CacheSize > l1CacheSize)
   {
-    l2CacheSize = inBetween(32, l2CacheSize, 4096);
-    l2CacheSize = floorPow2(l2CacheSize);
-    return (int) l2CacheSize;
+    // if the L2 cache is shared between multiple physical
+    // CPU cores (e.g. clusters of efficiency cores on
+    // hybrid CPUs) we only use each core's share of the
+    // L2 cache in order to avoid cache thrashing
+    if (!cpuInfo.privateL2Cache())
+    {
+      size_t threadsPerCore = std::max<size_t>(1, cpuInfo.threadsPerCore());
+      size_t l2Sharing = cpuInfo.l2Sharing();
+      size_t cores = l2Sharing / threadsPerCore;
+
+      if (cores > 0)
+        l2CacheSize /= cores;
+      else
+        l2CacheSize = 0;
+    }
+
+    if (l2CacheSize > l1CacheSize)
+    {
+      l2CacheSize = inBetween(32, l2CacheSize, 4096);
+      l2CacheSize = floorPow2(l2CacheSize);
+      return (int) l2CacheSize;
+    }
   }
-  else
-  {
-    if (!cpuInfo.hasL1Cache())
-      l1CacheSize = 32;
 
-    // if the CPU does not have an L2 cache or if the
-    // cache is shared between all CPU cores we
-    // set the sieve size to the CPU's L1 cache size
+  if (!cpuInfo.hasL1Cache())
+    l1CacheSize = 32;
 
-    l1CacheSize = inBetween(8, l1CacheSize, 4096);
-    l1CacheSize = floorPow2(l1CacheSize);
-    return (int) l1CacheSize;
-  }
+  // if the CPU does not have an L2 cache or if its
+  // per core share of the L2 cache is tiny we set the
+  // sieve size to the CPU's L1 cache size
+
+  l1CacheSize = inBetween(8, l1CacheSize, 4096);
+  l1CacheSize = floorPow2(l1CacheSize);
+  return (int) l1CacheSize;
 }
 
 } // namespace
@@ -46,6 +46,8 @@ struct Option
 
 enum OptionID
 {
+  OPTION_BINARY,
+  OPTION_CHECKPOINT,
   OPTION_COUNT,
   OPTION_HELP,
   OPTION_NTHPRIME,
@@ -54,17 +56,22 @@ enum OptionID
   OPTION_DISTANCE,
   OPTION_PRINT,
   OPTION_QUIET,
+  OPTION_RESUME,
   OPTION_SIZE,
   OPTION_THREADS,
   OPTION_TIME,
+  OPTION_TIME_BREAKDOWN,
+  OPTION_TUNE,
   OPTION_VERSION
 };
 
 /// Command-line options
 map<string, OptionID> optionMap =
 {
+  { "--binary",    OPTION_BINARY },
   { "-c",          OPTION_COUNT },
   { "--count",     OPTION_COUNT },
+  { "--checkpoint", OPTION_CHECKPOINT },
   { "-h",          OPTION_HELP },
   { "--help",      OPTION_HELP },
   { "-n",          OPTION_NTHPRIME },
@@ -77,11 +84,14 @@ map<string, OptionID> optionMap =
   { "--print",     OPTION_PRINT },
   { "-q",          OPTION_QUIET },
   { "--quiet",     OPTION_QUIET },
+  { "--resume",    OPTION_RESUME },
   { "-s",          OPTION_SIZE },
   { "--size",      OPTION_SIZE },
   { "-t",          OPTION_THREADS },
   { "--threads",   OPTION_THREADS },
   { "--time",      OPTION_TIME },
+  { "--time-breakdown", OPTION_TIME_BREAKDOWN },
+  { "--tune",      OPTION_TUNE },
   { "-v",          OPTION_VERSION },
   { "--version",   OPTION_VERSION }
 };
@@ -186,14 +196,19 @@ CmdOptions parseOptions(int argc, char* argv[])
 
     switch (optionMap[opt.opt])
     {
+      case OPTION_BINARY:    opts.binary = true; opts.quiet = true; break;
       case OPTION_COUNT:     optionCount(opt, opts); break;
       case OPTION_PRINT:     optionPrint(opt, opts); break;
       case OPTION_SIZE:      opts.sieveSize = opt.getValue<int>(); break;
       case OPTION_THREADS:   opts.threads = opt.getValue<int>(); break;
+      case OPTION_CHECKPOINT: opts.checkpoint = true; break;
       case OPTION_QUIET:     opts.quiet = true; break;
+      case OPTION_RESUME:    opts.resume = true; opts.checkpoint = true; break;
       case OPTION_NTHPRIME:  opts.nthPrime = true; break;
       case OPTION_NO_STATUS: opts.status = false; break;
       case OPTION_TIME:      opts.time = true; break;
+      case OPTION_TIME_BREAKDOWN: opts.timeBreakdown = true; opts.time = true; break;
+      case OPTION_TUNE:      opts.tune = true; break;
       case OPTION_NUMBER:    opts.numbers.push_back(opt.getValue<uint64_t>()); break;
       case OPTION_DISTANCE:  opts.numbers.push_back(opt.getValue<uint64_t>() + opts.numbers[0]); break;
       case OPTION_VERSION:   version(); break;
@@ -201,7 +216,7 @@ CmdOptions parseOptions(int argc, char* argv[])
     }
   }
 
-  if (opts.numbers.empty())
+  if (opts.numbers.empty() && !opts.tune)
     throw primesieve_error("missing STOP number");
 
   if (opts.quiet)
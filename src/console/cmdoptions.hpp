@@ -19,19 +19,29 @@ struct CmdOptions
   int flags;
   int sieveSize;
   int threads;
+  bool binary;
   bool quiet;
   bool nthPrime;
   bool status;
   bool time;
+  bool timeBreakdown;
+  bool checkpoint;
+  bool resume;
+  bool tune;
 
   CmdOptions() :
     flags(0),
     sieveSize(0),
     threads(0),
+    binary(false),
     quiet(false),
     nthPrime(false),
     status(true),
-    time(false)
+    time(false),
+    timeBreakdown(false),
+    checkpoint(false),
+    resume(false),
+    tune(false)
   { }
 };
 
@@ -27,8 +27,12 @@ const string helpMenu
   "\n"
   "Options:\n"
   "\n"
+  "          --binary        Print primes as raw 8-byte integers, much\n"
+  "                          faster than the decimal --print output\n"
   "  -c[N+], --count[=N+]    Count primes and prime k-tuplets, N <= 6,\n"
   "                          e.g. -c1 primes, -c2 twins, -c3 triplets, ...\n"
+  "          --checkpoint    Periodically save the sieving state to the\n"
+  "                          primesieve.save file in the current directory\n"
   "  -d<N>,  --dist=<N>      Sieve the interval [START, START + N]\n"
   "  -h,     --help          Print this help menu\n"
   "  -n,     --nthprime      Calculate the nth prime,\n"
@@ -37,9 +41,16 @@ const string helpMenu
   "  -p[N],  --print[=N]     Print primes or prime k-tuplets, N <= 6,\n"
   "                          e.g. -p1 primes, -p2 twins, -p3 triplets, ...\n"
   "  -q,     --quiet         Quiet mode, prints less output\n"
+  "          --resume        Resume an interrupted sieving run from the\n"
+  "                          primesieve.save file (implies --checkpoint)\n"
   "  -s<N>,  --size=<N>      Set the sieve size in kilobytes, N <= 4096\n"
   "  -t<N>,  --threads=<N>   Set the number of threads, N <= CPU cores\n"
   "          --time          Print the time elapsed in seconds\n"
+  "          --time-breakdown  Print the time spent in each sieving\n"
+  "                          phase (implies --time)\n"
+  "          --tune          Benchmark this CPU and write a tuning\n"
+  "                          profile file, the profile is loaded\n"
+  "                          automatically via PRIMESIEVE_TUNE_FILE\n"
   "  -v,     --version       Print version and license information\n"
   "\n"
   "Examples:\n"
@@ -8,21 +8,111 @@
 /// file in the top level directory.
 ///
 
+#include <primesieve.hpp>
 #include <primesieve/ParallelSieve.hpp>
+#include <primesieve/pmath.hpp>
+#include <primesieve/primesieve_error.hpp>
 #include "cmdoptions.hpp"
 
 #include <stdint.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <exception>
 #include <iomanip>
 #include <string>
+#include <vector>
 
 using namespace std;
 using namespace primesieve;
 
 namespace {
 
-void printResults(ParallelSieve& ps, CmdOptions& opt)
+/// State file used by --checkpoint and --resume
+const string checkpointFile = "primesieve.save";
+
+counts_t& operator+=(counts_t& v1, const counts_t& v2)
+{
+  for (size_t i = 0; i < v1.size(); i++)
+    v1[i] += v2[i];
+  return v1;
+}
+
+/// Atomically replace the checkpoint file with the
+/// current sieving state
+///
+void writeCheckpoint(uint64_t start,
+                     uint64_t stop,
+                     uint64_t low,
+                     int flags,
+                     const counts_t& counts,
+                     double seconds)
+{
+  string tmpFile = checkpointFile + ".tmp";
+  ofstream file(tmpFile, ofstream::trunc);
+
+  file << start << " " << stop << " "
+       << low << " " << flags << "\n";
+  for (uint64_t count : counts)
+    file << count << " ";
+  file << "\n" << fixed << setprecision(3) << seconds << "\n";
+  file.close();
+
+  remove(checkpointFile.c_str());
+  rename(tmpFile.c_str(), checkpointFile.c_str());
+}
+
+/// Load the state of an interrupted sieving run,
+/// returns false if there is no checkpoint file
+///
+bool readCheckpoint(uint64_t start,
+                    uint64_t stop,
+                    int flags,
+                    uint64_t& low,
+                    counts_t& counts,
+                    double& seconds)
+{
+  ifstream file(checkpointFile);
+  if (!file)
+    return false;
+
+  uint64_t fileStart;
+  uint64_t fileStop;
+  int fileFlags;
+
+  if (!(file >> fileStart >> fileStop >> low >> fileFlags))
+    return false;
+  for (uint64_t& count : counts)
+    if (!(file >> count))
+      return false;
+  if (!(file >> seconds))
+    return false;
+
+  if (fileStart != start ||
+      fileStop != stop ||
+      fileFlags != flags)
+    throw primesieve_error(checkpointFile + " does not match the current invocation");
+
+  return true;
+}
+
+/// Align n to modulo (30 + 2) to prevent prime k-tuplet
+/// (twin primes, prime triplets) gaps at the stripe
+/// boundaries, same as ParallelSieve
+///
+uint64_t align(uint64_t n, uint64_t stop)
+{
+  uint64_t n32 = checkedAdd(n, 32);
+
+  if (n32 >= stop)
+    return stop;
+
+  return n32 - n % 30;
+}
+
+void printResults(ParallelSieve& ps, CmdOptions& opt, double seconds)
 {
   cout << left;
 
@@ -41,7 +131,95 @@ void printResults(ParallelSieve& ps, CmdOptions& opt)
       cout << text[i] << ps.getCount(i) << endl;
 
   if (opt.time)
-    cout << "Seconds: " << fixed << setprecision(3) << ps.getSeconds() << endl;
+    cout << "Seconds: " << fixed << setprecision(3) << seconds << endl;
+
+  if (opt.timeBreakdown)
+  {
+    // per-phase times are summed over all threads, so they
+    // can add up to more than the elapsed wall time
+    const SieveStats& stats = ps.getStats();
+    cout << "PreSieve seconds: " << stats.preSieveSeconds << endl;
+    cout << "EratSmall seconds: " << stats.eratSmallSeconds << endl;
+    cout << "EratMedium seconds: " << stats.eratMediumSeconds << endl;
+    cout << "EratBig seconds: " << stats.eratBigSeconds << endl;
+  }
+}
+
+/// Sieve [start, stop] in stripes and save the sieving
+/// state after each stripe, so that an interrupted run
+/// can be continued with --resume instead of being
+/// restarted from scratch
+///
+void sieveCheckpoint(ParallelSieve& ps, CmdOptions& opt)
+{
+  uint64_t start = ps.getStart();
+  uint64_t stop = ps.getStop();
+  uint64_t low = start;
+  counts_t totals;
+  totals.fill(0);
+  double seconds = 0;
+
+  if (opt.resume &&
+      readCheckpoint(start, stop, opt.flags, low, totals, seconds) &&
+      !opt.quiet)
+    cout << "Resuming at " << low << endl;
+
+  // large enough to keep all threads busy, small enough
+  // that a failure only loses a few minutes of work
+  uint64_t stripe = (stop - start) / 1000;
+  stripe = max(stripe, (uint64_t) 1000000000ull);
+
+  while (low <= stop)
+  {
+    uint64_t high = align(checkedAdd(low, stripe), stop);
+    ps.sieve(low, high);
+    totals += ps.getCounts();
+    seconds += ps.getSeconds();
+    writeCheckpoint(start, stop, checkedAdd(high, 1), opt.flags, totals, seconds);
+
+    if (high >= stop)
+      break;
+    low = high + 1;
+  }
+
+  remove(checkpointFile.c_str());
+  ps.getCounts() = totals;
+  printResults(ps, opt, seconds);
+}
+
+/// Print primes to stdout as raw 8-byte integers (native
+/// byte order, little-endian on all supported CPUs). The
+/// primes are generated into a large buffer and written
+/// with one fwrite() per batch, which avoids the decimal
+/// formatting cost of --print entirely
+///
+void printBinary(CmdOptions& opt)
+{
+  auto& numbers = opt.numbers;
+
+  if (numbers.size() < 2)
+    numbers.push_front(0);
+
+  uint64_t low = numbers[0];
+  uint64_t stop = numbers[1];
+
+  // ~5 million primes (40 megabytes) per
+  // batch at low prime densities
+  uint64_t dist = 100000000ull;
+  vector<uint64_t> primes;
+
+  while (low <= stop)
+  {
+    uint64_t high = checkedAdd(low, dist);
+    high = min(high, stop);
+    primes.clear();
+    generate_primes(low, high, &primes);
+    fwrite(primes.data(), sizeof(uint64_t), primes.size(), stdout);
+
+    if (high >= stop)
+      break;
+    low = high + 1;
+  }
 }
 
 /// Count & print primes and prime k-tuplets
@@ -73,8 +251,13 @@ void sieve(CmdOptions& opt)
   if (opt.status)
     ps.addFlags(PRINT_STATUS);
 
-  ps.sieve();
-  printResults(ps, opt);
+  if (opt.checkpoint)
+    sieveCheckpoint(ps, opt);
+  else
+  {
+    ps.sieve();
+    printResults(ps, opt, ps.getSeconds());
+  }
 }
 
 void nthPrime(CmdOptions& opt)
@@ -110,6 +293,30 @@ void nthPrime(CmdOptions& opt)
     cout << "Seconds: " << fixed << setprecision(3) << ps.getSeconds() << endl;
 }
 
+/// Benchmark the local CPU and write the best tuning
+/// parameters to a profile file, which is loaded
+/// automatically via PRIMESIEVE_TUNE_FILE in later runs
+///
+void tune()
+{
+  const char* env = getenv("PRIMESIEVE_TUNE_FILE");
+  string filePath = env ? env : "primesieve.tune";
+
+  cout << "Calibrating, this takes a few seconds..." << endl;
+  Tuning t = calibrate_tuning();
+  set_tuning(t);
+  save_tuning(filePath);
+
+  cout << "Sieve size = " << get_sieve_size() << " kilobytes" << endl;
+  cout << "factorEratSmall = " << t.factorEratSmall << endl;
+  cout << "factorEratMedium = " << t.factorEratMedium << endl;
+  cout << "Profile written to " << filePath << endl;
+
+  if (!env)
+    cout << "Set PRIMESIEVE_TUNE_FILE=" << filePath
+         << " to load the profile automatically." << endl;
+}
+
 } // namespace
 
 int main(int argc, char* argv[])
@@ -118,8 +325,12 @@ int main(int argc, char* argv[])
   {
     CmdOptions opt = parseOptions(argc, argv);
 
-    if (opt.nthPrime)
+    if (opt.tune)
+      tune();
+    else if (opt.nthPrime)
       nthPrime(opt);
+    else if (opt.binary)
+      printBinary(opt);
     else
       sieve(opt);
   }
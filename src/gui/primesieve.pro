@@ -25,13 +25,13 @@ SOURCES += \
   src/main.cpp \
   src/PrimeSieveGUI.cpp \
   src/PrimeSieveGUI_menu.cpp \
-  src/PrimeSieveProcess.cpp
+  src/PrimeSieveWorker.cpp
 
 HEADERS += \
   ../../include/primesieve/calculator.hpp \
   src/PrimeSieveGUI.hpp \
   src/PrimeSieveGUI_const.hpp \
-  src/PrimeSieveProcess.hpp
+  src/PrimeSieveWorker.hpp
 
 # ---------------------------------------------------------
 # Sieve of Eratosthenes source code
@@ -41,12 +41,17 @@ INCLUDEPATH += ../../include
 
 SOURCES += \
   ../api.cpp \
+  ../AsyncSievingPrimes.cpp \
+  ../BucketPool.cpp \
+  ../CountIntervals.cpp \
   ../CpuInfo.cpp \
   ../EratBig.cpp \
   ../EratMedium.cpp \
   ../EratSmall.cpp \
   ../iterator.cpp \
   ../IteratorHelper.cpp \
+  ../PiTable.cpp \
+  ../PrimeFile.cpp \
   ../PrimeGenerator.cpp \
   ../nthPrime.cpp \
   ../ParallelSieve.cpp \
@@ -54,6 +59,8 @@ SOURCES += \
   ../PreSieve.cpp \
   ../PrintPrimes.cpp \
   ../SievingPrimes.cpp \
+  ../StreamSegments.cpp \
+  ../ThreadPool.cpp \
   ../PrimeSieve.cpp \
   ../Erat.cpp \
   ../Wheel.cpp
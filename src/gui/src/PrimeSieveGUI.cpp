@@ -19,7 +19,7 @@
 
 #include "PrimeSieveGUI.hpp"
 #include "ui_PrimeSieveGUI.h"
-#include "PrimeSieveProcess.hpp"
+#include "PrimeSieveWorker.hpp"
 
 #include <primesieve.hpp>
 #include <primesieve/calculator.hpp>
@@ -30,9 +30,6 @@
 #if QT_VERSION >= 0x050000
   #include <QtGlobal>
   #include <QCoreApplication>
-  #include <QByteArray>
-  #include <QTextStream>
-  #include <QFile>
   #include <QSize>
   #include <QtWidgets/QMessageBox>
   #include <QTextCursor>
@@ -41,9 +38,6 @@
 #else
   #include <QtGlobal>
   #include <QCoreApplication>
-  #include <QByteArray>
-  #include <QTextStream>
-  #include <QFile>
   #include <QSize>
   #include <QMessageBox>
   #include <QTextCursor>
@@ -55,7 +49,7 @@ using namespace primesieve;
 
 PrimeSieveGUI::PrimeSieveGUI(QWidget *parent) :
   QMainWindow(parent), ui(new Ui::PrimeSieveGUI), validator_(0),
-  primeSieveProcess_(0), saveAct_(0), quitAct_(0), aboutAct_(0),
+  worker_(0), saveAct_(0), quitAct_(0), aboutAct_(0),
   alignmentGroup_(0) {
   ui->setupUi(this);
   primeText_.push_back("Prime numbers");
@@ -253,15 +247,16 @@ void PrimeSieveGUI::on_sieveButton_clicked() {
     ui->textEdit->clear();
     progressBarTimer_.start(25);
 
-    // start a new process for sieving (avoids cancel
-    // trouble with multiple threads)
-    primeSieveProcess_ = new PrimeSieveProcess(this);
+    // start sieving in-process on a worker thread,
+    // repeated queries reuse the warm caches of the GUI
+    // process instead of spawning a child process per run
+    worker_ = new PrimeSieveWorker(this);
     if (flags_ & PRINT_FLAGS)
-      connect(primeSieveProcess_, SIGNAL(readyReadStandardOutput()),
-          this, SLOT(printProcessOutput()));
-    connect(primeSieveProcess_, SIGNAL(finished(int, QProcess::ExitStatus)),
-        this, SLOT(processFinished(int, QProcess::ExitStatus)));
-    primeSieveProcess_->start(lowerBound, upperBound, this->getSieveSize(),
+      connect(worker_, SIGNAL(printText(const QString&)),
+          this, SLOT(appendPrintText(const QString&)));
+    connect(worker_, SIGNAL(finished()),
+        this, SLOT(workerFinished()));
+    worker_->start(lowerBound, upperBound, this->getSieveSize(),
         flags_, this->getThreads());
 
   } catch (std::invalid_argument& ex) {
@@ -274,67 +269,31 @@ void PrimeSieveGUI::on_sieveButton_clicked() {
 }
 
 void PrimeSieveGUI::advanceProgressBar() {
-  int permil = static_cast<int>(primeSieveProcess_->getStatus() * 10.0);
+  int permil = static_cast<int>(worker_->getStatus() * 10.0);
   ui->progressBar->setValue(permil);
 }
 
 /**
- * Redirects the standard output (prime numbers or prime k-tuplets) of
- * the primeSieveProcess_ to the TextEdit.
+ * Appends a chunk of primes (or prime k-tuplets) emitted by
+ * the worker_ thread to the TextEdit.
  */
-void PrimeSieveGUI::printProcessOutput() {
-  QByteArray buffer;
-  buffer.reserve(PRINT_BUFFER_SIZE + 256);
-  while (ui->cancelButton->isEnabled() && primeSieveProcess_->canReadLine()) {
-    buffer.clear();
-    while (primeSieveProcess_->canReadLine() && buffer.size() < PRINT_BUFFER_SIZE)
-      buffer.append(primeSieveProcess_->readLine(256));
-    // remove "\r\n" or '\n', '\r' at the back
-    while (buffer.endsWith('\n') ||
-           buffer.endsWith('\r'))
-      buffer.chop(1);
-    if (!buffer.isEmpty())
-      ui->textEdit->appendPlainText(buffer);
-/// @brief   Keep the GUI responsive.
-/// @bug     processEvents() crashes on Windows with MSVC 2010 and Qt 5 beta.
-/// @warning QApplication::processEvents() must not be used on
-///          operating systems that use signal recursion (like Linux
-///          X11) otherwise the stack will explode!
-#if defined(Q_OS_WIN) || defined(Q_OS_MAC) || defined(Q_OS_IOS)
-    QApplication::processEvents();
-#else
-    ui->textEdit->repaint();
-#endif
-  }
+void PrimeSieveGUI::appendPrintText(const QString& text) {
+  if (ui->cancelButton->isEnabled())
+    ui->textEdit->appendPlainText(text);
 }
 
 /**
- * Is executed when the primeSieveProcess_ finishes, checks for
- * process errors and calls this->printResults().
+ * Is executed when the worker_ thread finishes, checks for
+ * errors and calls this->printResults().
  */
-void PrimeSieveGUI::processFinished(int exitCode,
-    QProcess::ExitStatus exitStatus) {
-  // the process did not exit normally, i.e. threw and exception
-  if (exitCode != 0) {
-    // Qt uses '/' internally, even for Windows
-    QString path = QCoreApplication::applicationDirPath() + "/" + APPLICATION_NAME + "_error.txt";
-    QFile error_log(path);
-    if (error_log.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-      QTextStream out(&error_log);
-      out << primeSieveProcess_->readAllStandardError();
-      error_log.close();
-    }
+void PrimeSieveGUI::workerFinished() {
+  // the worker thread caught an exception while sieving
+  if (!worker_->getError().isEmpty()) {
+    QString error = worker_->getError();
     this->cleanUp();
-    QMessageBox::critical(this, APPLICATION_NAME,
-        "The PrimeSieveProcess reported an error (see primesieve_error.txt), sieving has been aborted.");
+    QMessageBox::critical(this, APPLICATION_NAME, error);
   }
-  // the PrimeSieveProcess has been interrupted by a signal (SIGTERM,
-  // SIGKILL, ...) or a segmentation fault
-  else if (exitStatus == QProcess::CrashExit) {
-    this->cleanUp();
-    QMessageBox::critical(this, APPLICATION_NAME, "The PrimeSieveProcess crashed, sieving has been aborted.");
-  }
-  // the PrimeSieveProcess has finished correctly
+  // the worker thread has finished correctly
   else {
     ui->progressBar->setValue(ui->progressBar->maximum());
     // print results if not canceled lately
@@ -366,11 +325,11 @@ void PrimeSieveGUI::printResults() {
   // print prime counts & time elapsed
   for (int i = 0; i < primeText_.size(); i++) {
     if (flags_ & (COUNT_PRIMES << i))
-      ui->textEdit->appendPlainText(primeText_[i] + ":\t" + QString::number(primeSieveProcess_->getCount(i)));
+      ui->textEdit->appendPlainText(primeText_[i] + ":\t" + QString::number(worker_->getCount(i)));
   }
   if (flags_ & COUNT_KTUPLETS)
     ui->textEdit->appendPlainText("");
-  QString time("Elapsed time:\t" + QString::number(primeSieveProcess_->getSeconds(), 'f', 2) + " sec");
+  QString time("Elapsed time:\t" + QString::number(worker_->getSeconds(), 'f', 2) + " sec");
   ui->textEdit->appendPlainText(time);
 }
 
@@ -381,20 +340,29 @@ void PrimeSieveGUI::on_cancelButton_clicked() {
   ui->cancelButton->setDisabled(true);
   ui->progressBar->setValue(0);
   // too late to abort
-  if ((flags_ & PRINT_FLAGS) && primeSieveProcess_->isFinished())
+  if ((flags_ & PRINT_FLAGS) && worker_->isFinished())
     return;
   this->cleanUp();
 }
 
 /**
- * Clean up after sieving is finished or canceled (abort the
- * PrimeSieveProcess if still running).
+ * Clean up after sieving is finished or canceled (cancel the
+ * worker_ thread if still running).
  */
 void PrimeSieveGUI::cleanUp() {
   progressBarTimer_.stop();
-  if (primeSieveProcess_ != 0)
-    delete primeSieveProcess_;
-  primeSieveProcess_ = 0;
+  if (worker_ != 0) {
+    worker_->disconnect();
+    if (worker_->isRunning()) {
+      // the worker stops grabbing new work chunks and
+      // deletes itself once its current chunk finishes,
+      // the GUI stays responsive meanwhile
+      worker_->cancel();
+      connect(worker_, SIGNAL(finished()), worker_, SLOT(deleteLater()));
+    } else
+      delete worker_;
+  }
+  worker_ = 0;
   // invert buttons
   ui->cancelButton->setDisabled(true);
   ui->sieveButton->setEnabled(true);
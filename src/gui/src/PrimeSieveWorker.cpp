@@ -0,0 +1,212 @@
+/*
+ * PrimeSieveWorker.cpp -- This file is part of primesieve
+ *
+ * Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "PrimeSieveWorker.hpp"
+#include "PrimeSieveGUI_const.hpp"
+
+#include <primesieve.hpp>
+#include <primesieve/ParallelSieve.hpp>
+
+#include <QtGlobal>
+#include <QString>
+#include <chrono>
+#include <exception>
+
+using namespace primesieve;
+
+namespace {
+
+const int PRINT_FLAGS = PRINT_SEXTUPLETS * 2 - PRINT_PRIMES;
+
+/**
+ * Minimal span of k consecutive primes that form a prime
+ * k-tuplet: twins (p, p+2), triplets (p, p+2, p+6) and
+ * (p, p+4, p+6), ... For primes > 5 every k consecutive
+ * primes with this span match one of the admissible
+ * patterns, the same k-tuplets that PrintPrimes detects
+ * using its sieve byte bitmasks.
+ */
+const quint64 kTupletSpan[6] = { 0, 2, 6, 8, 12, 16 };
+
+} // namespace
+
+PrimeSieveWorker::PrimeSieveWorker(QObject* parent) :
+  QThread(parent), cancel_(false), status_(0.0),
+  seconds_(0.0), start_(0), stop_(0), flags_(0),
+  isPrint_(false) {
+}
+
+/**
+ * Start sieving the primes within [start, stop]
+ * on the worker thread.
+ */
+void PrimeSieveWorker::start(quint64 start, quint64 stop,
+    int sieveSize, int flags, int threads) {
+  start_ = start;
+  stop_ = stop;
+  flags_ = flags;
+  isPrint_ = (flags & PRINT_FLAGS) != 0;
+  cancel_ = false;
+  status_ = 0.0;
+  seconds_ = 0.0;
+  error_.clear();
+  for (int i = 0; i < 6; i++)
+    counts_[i] = 0;
+  ps_.setStart(start);
+  ps_.setStop(stop);
+  ps_.setSieveSize(sieveSize);
+  ps_.setFlags(flags);
+  ps_.setNumThreads(threads);
+  QThread::start();
+}
+
+/**
+ * Cancel sieving, the worker thread stops at the next
+ * work chunk (counting) or print buffer (printing).
+ */
+void PrimeSieveWorker::cancel() {
+  cancel_ = true;
+  ps_.cancelSieve();
+}
+
+void PrimeSieveWorker::run() {
+  try {
+    if (isPrint_)
+      this->sievePrint();
+    else {
+      ps_.sieve();
+      for (int i = 0; i < 6; i++)
+        counts_[i] = ps_.getCount(i);
+      seconds_ = ps_.getSeconds();
+    }
+  }
+  catch (std::exception& e) {
+    error_ = e.what();
+  }
+}
+
+/**
+ * Print run: generate the primes within [start_, stop_] using
+ * primesieve::iterator, count the selected primes/k-tuplets and
+ * emit the formatted output in chunks of PRINT_BUFFER_SIZE
+ * characters. The print menu uses radio button like behaviour
+ * hence at most one print option is set.
+ */
+void PrimeSieveWorker::sievePrint() {
+  auto t1 = std::chrono::system_clock::now();
+
+  // i = 0 primes, i = 1 twins, i = 2 triplets, ...
+  int printIndex = 0;
+  for (; !(flags_ & (PRINT_PRIMES << printIndex)); printIndex++);
+
+  // sliding window of the last 6 primes
+  quint64 window[6];
+  int size = 0;
+
+  QString buffer;
+  buffer.reserve(PRINT_BUFFER_SIZE + 256);
+  double dist = static_cast<double>(stop_ - start_) + 1.0;
+
+  primesieve::iterator it(start_ > 0 ? start_ - 1 : 0, stop_);
+  quint64 prime = it.next_prime();
+
+  for (; prime <= stop_; prime = it.next_prime()) {
+    if (cancel_.load())
+      return;
+
+    if (size == 6) {
+      for (int i = 1; i < 6; i++)
+        window[i - 1] = window[i];
+      size = 5;
+    }
+    window[size++] = prime;
+
+    if (flags_ & COUNT_PRIMES)
+      counts_[0]++;
+    if (printIndex == 0) {
+      buffer.append(QString::number(prime));
+      buffer.append('\n');
+    }
+
+    // the last k primes form a k-tuplet if their
+    // span equals the k-tuplet's minimal span
+    for (int i = 1; i < 6; i++) {
+      int k = i + 1;
+      if (size >= k &&
+          prime - window[size - k] == kTupletSpan[i]) {
+        if (flags_ & (COUNT_PRIMES << i))
+          counts_[i]++;
+        if (printIndex == i) {
+          buffer.append('(');
+          for (int j = size - k; j < size; j++) {
+            buffer.append(QString::number(window[j]));
+            buffer.append((j + 1 < size) ? ", " : ")\n");
+          }
+        }
+      }
+    }
+
+    status_ = static_cast<double>(prime - start_) * 100.0 / dist;
+
+    if (buffer.size() >= PRINT_BUFFER_SIZE) {
+      buffer.chop(1);
+      emit printText(buffer);
+      buffer.clear();
+    }
+  }
+
+  if (!buffer.isEmpty()) {
+    buffer.chop(1);
+    emit printText(buffer);
+  }
+
+  status_ = 100.0;
+  auto t2 = std::chrono::system_clock::now();
+  std::chrono::duration<double> seconds = t2 - t1;
+  seconds_ = seconds.count();
+}
+
+/**
+ * @return The count of primes/k-tuplets within [start, stop].
+ * @pre index < 6
+ */
+quint64 PrimeSieveWorker::getCount(unsigned int index) const {
+  return counts_[index];
+}
+
+/**
+ * @return The sieving status in percent.
+ */
+double PrimeSieveWorker::getStatus() const {
+  return isPrint_ ? status_.load() : ps_.getStatus();
+}
+
+/**
+ * @return The time elapsed in seconds (if sieving is finished).
+ */
+double PrimeSieveWorker::getSeconds() const {
+  return seconds_;
+}
+
+/**
+ * @return The error message if sieving threw an exception.
+ */
+QString PrimeSieveWorker::getError() const {
+  return error_;
+}
@@ -0,0 +1,74 @@
+/*
+ * PrimeSieveWorker.hpp -- This file is part of primesieve
+ *
+ * Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PRIMESIEVEWORKER_HPP
+#define PRIMESIEVEWORKER_HPP
+
+#include <primesieve/ParallelSieve.hpp>
+
+#include <QThread>
+#include <QtGlobal>
+#include <QString>
+#include <atomic>
+
+/**
+ * QThread class used for prime sieving. The sieving runs
+ * in-process on a worker thread, repeated interactive queries
+ * reuse the warm caches (and thread pool) of the GUI process
+ * instead of paying the process spawn and shared memory polling
+ * latency of a child process per run.
+ */
+class PrimeSieveWorker : public QThread {
+Q_OBJECT
+public:
+  PrimeSieveWorker(QObject*);
+  void start(quint64, quint64, int, int, int);
+  void cancel();
+  quint64 getCount(unsigned int) const;
+  double getStatus() const;
+  double getSeconds() const;
+  QString getError() const;
+signals:
+  /// Chunk of formatted primes or prime k-tuplets,
+  /// appended to the GUI's TextEdit
+  void printText(const QString&);
+protected:
+  void run();
+private:
+  /// Multi-threaded sieve used for counting
+  primesieve::ParallelSieve ps_;
+  /// The count of primes/k-tuplets within [start_, stop_]
+  quint64 counts_[6];
+  /// Set by cancel()
+  std::atomic<bool> cancel_;
+  /// Sieving status in percent, written by the worker
+  /// thread and polled by the GUI's progress timer
+  std::atomic<double> status_;
+  /// Time elapsed in seconds
+  std::atomic<double> seconds_;
+  quint64 start_;
+  quint64 stop_;
+  int flags_;
+  bool isPrint_;
+  /// Error message if run() threw an exception
+  QString error_;
+  void sievePrint();
+};
+
+#endif // PRIMESIEVEWORKER_HPP
@@ -18,7 +18,6 @@
  */
 
 #include "PrimeSieveGUI.hpp"
-#include <primesieve/ParallelSieve.hpp>
 
 #if QT_VERSION >= 0x050000
   #include <QtWidgets/QApplication>
@@ -26,61 +25,13 @@
   #include <QtGui/QApplication>
 #endif
 
-#include <QSharedMemory>
-#include <stdexcept>
-#include <cstdlib>
-#include <iostream>
-
 /**
- * The primesieve GUI is launched if the user starts the application
- * by mouse click or without arguments, a PrimeSieveProcess is
- * launched if process and a shared memory identifiers are provided as
- * arguments.
- * @param argv[1] [process identifier]
- * @param argv[2] [Shared memory identifier]
- * @see   PrimeSieveProcess.cpp
+ * Launch the primesieve GUI, the sieving runs in-process on a
+ * worker thread.
+ * @see PrimeSieveWorker.cpp
  */
 int main(int argc, char *argv[])
 {
-  if (argc == 3)
-  {
-    QString psp("PrimeSieveProcess");
-    QString parent(argv[1]);
-    if (parent.compare(psp) == 0)
-    {
-      // open an existing and initialized shared memory
-      QString id(argv[2]);
-      QSharedMemory sharedMemory(id);
-      if (!sharedMemory.attach())
-      {
-        std::cerr << "Unable to attach shared memory " << argv[2] << std::endl;
-        exit(EXIT_FAILURE);
-      }
-      // map the attached shared memory to the shm segment
-      primesieve::ParallelSieve::SharedMemory* shm =
-          static_cast<primesieve::ParallelSieve::SharedMemory*>(sharedMemory.data());
-      try
-      {
-        // initialize the ParallelSieve object with
-        // values from the shared memory segment provided by
-        // the primesieve GUI and start sieving
-        if (!shm)
-          throw std::runtime_error("sharedMemory.data() must not be NULL");
-        primesieve::ParallelSieve ps;
-        ps.init(*shm);
-        ps.sieve();
-      }
-      catch (std::exception& e)
-      {
-        sharedMemory.detach();
-        std::cerr << "ParallelSieve error: " << e.what() << std::endl;
-        exit(EXIT_FAILURE);
-      }
-      sharedMemory.detach();
-      return 0;
-    }
-  }
-  // Qt GUI interface
   QApplication a(argc, argv);
   PrimeSieveGUI w;
   w.show();
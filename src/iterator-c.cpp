@@ -125,6 +125,83 @@ void primesieve_generate_next_primes(primesieve_iterator* it)
   it->last_idx--;
 }
 
+/// Returns the unconsumed part of the current block of
+/// primes, or generates a whole new block. When no
+/// incremental sieving is in progress the entire next
+/// [start, stop] window is sieved at once so that FFI
+/// bindings get a few hundred thousand primes per call
+///
+const uint64_t* primesieve_next_primes(primesieve_iterator* it, size_t* size)
+{
+  auto& primes = getPrimes(it);
+
+  // return the unconsumed tail of the current block,
+  // also finishes a block started by next_prime()
+  if (it->i < it->last_idx)
+  {
+    const uint64_t* tail = &it->primes[it->i + 1];
+    *size = it->last_idx - it->i;
+    it->i = it->last_idx;
+    return tail;
+  }
+
+  // finish the current window incrementally, a whole
+  // new block would skip its remaining primes
+  if (it->primeGenerator)
+  {
+    primesieve_generate_next_primes(it);
+    *size = it->last_idx + 1;
+    it->i = it->last_idx;
+    return it->primes;
+  }
+
+  try
+  {
+    primes.clear();
+
+    while (primes.empty())
+    {
+      if (it->stop >= get_max_stop())
+      {
+        // next prime > 2^64
+        primes.push_back(~0ull);
+        break;
+      }
+
+      IteratorHelper::next(&it->start, &it->stop, it->stop_hint, &it->dist);
+      PrimeGenerator primeGenerator(it->start, it->stop);
+      primeGenerator.fill(primes);
+    }
+  }
+  catch (exception&)
+  {
+    primes.resize(1);
+    primes[0] = PRIMESIEVE_ERROR;
+    it->is_error = true;
+    errno = EDOM;
+  }
+
+  it->primes = &primes[0];
+  it->last_idx = primes.size() - 1;
+  it->i = it->last_idx;
+  *size = primes.size();
+  return it->primes;
+}
+
+/// Status code variant of primesieve_next_primes(), declared
+/// noexcept so that C++ call sites compile without unwind
+/// code. The block serving loop above performs no memory
+/// allocation in its steady state: the primes vector keeps
+/// its capacity across resize()/clear() calls, so after the
+/// first block only the per window PrimeGenerator
+/// construction allocates
+///
+int primesieve_next_primes_noexcept(primesieve_iterator* it, const uint64_t** primes, size_t* size) PRIMESIEVE_NOEXCEPT
+{
+  *primes = primesieve_next_primes(it, size);
+  return (it->is_error) ? 1 : 0;
+}
+
 void primesieve_generate_prev_primes(primesieve_iterator* it)
 {
   auto& primes = getPrimes(it);
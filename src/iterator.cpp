@@ -7,11 +7,18 @@
 /// file in the top level directory.
 ///
 
+#include <primesieve.hpp>
 #include <primesieve/iterator.hpp>
+#include <primesieve/config.hpp>
 #include <primesieve/IteratorHelper.hpp>
+#include <primesieve/pmath.hpp>
 #include <primesieve/PrimeGenerator.hpp>
+#include <primesieve/ThreadPool.hpp>
 
 #include <stdint.h>
+#include <algorithm>
+#include <future>
+#include <mutex>
 #include <vector>
 #include <memory>
 
@@ -23,12 +30,252 @@ void clear(std::unique_ptr<T>& ptr)
   ptr.reset(nullptr);
 }
 
+/// Generate the primes in [start, stop] and append them in
+/// ascending order. Large intervals are split into slices
+/// that are sieved concurrently, IteratorHelper::prev picks
+/// multi megabyte distances at large start values so the
+/// slices amortize the fork/join overhead.
+///
+void fillBlock(uint64_t start, uint64_t stop, std::vector<uint64_t>& primes,
+               const std::vector<uint64_t>* sievingPrimes = nullptr)
+{
+  using namespace primesieve;
+
+  uint64_t dist = stop - start;
+  uint64_t maxThreads = dist / get_tuning().minThreadDistance;
+  int threads = (int) inBetween(1, maxThreads, get_num_threads());
+
+  if (threads == 1)
+  {
+    PrimeGenerator primeGenerator(start, stop);
+    if (sievingPrimes)
+      primeGenerator.setSievingPrimes(sievingPrimes);
+    primeGenerator.fill(primes);
+    return;
+  }
+
+  uint64_t chunk = dist / threads;
+  std::vector<std::vector<uint64_t>> slices(threads);
+
+  auto task = [&](int t)
+  {
+    uint64_t low = start + chunk * t + (t > 0);
+    uint64_t high = (t + 1 == threads) ? stop : start + chunk * (t + 1);
+    auto& slice = slices[t];
+    slice.reserve(prime_count_approx(low, high));
+    PrimeGenerator primeGenerator(low, high);
+    if (sievingPrimes)
+      primeGenerator.setSievingPrimes(sievingPrimes);
+    primeGenerator.fill(slice);
+  };
+
+  ThreadPool::getInstance().execute(threads, task);
+
+  for (auto& slice : slices)
+    primes.insert(primes.end(), slice.begin(), slice.end());
+}
+
+/// Process-wide cache of the sieving primes, shared by all
+/// iterators. The primes are published as immutable
+/// snapshots (the table is copied when it is extended), so
+/// iterators in other threads keep reading their snapshot
+/// while the cache grows. The first iterator with a large
+/// start pays the sieving prime generation (in parallel,
+/// via fillBlock), every later iterator merely acquires the
+/// shared snapshot, which makes its first next_prime call
+/// O(segment) instead of O(sqrt(start)).
+///
+class SievingPrimesCache
+{
+public:
+  static SievingPrimesCache& getInstance()
+  {
+    static SievingPrimesCache cache;
+    return cache;
+  }
+
+  /// Get a snapshot containing (at least) all
+  /// primes inside [7, sqrtStop]
+  ///
+  std::shared_ptr<const std::vector<uint64_t>> get(uint64_t sqrtStop, uint64_t* limit)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (limit_ < sqrtStop)
+    {
+      // extend with 25% headroom so that an iterator whose
+      // stop grows block by block does not trigger a
+      // copy-on-extend for each of its blocks
+      uint64_t newLimit = sqrtStop;
+      if (limit_ > 0)
+        newLimit += sqrtStop / 4;
+
+      auto primes = std::make_shared<std::vector<uint64_t>>();
+      if (primes_)
+        *primes = *primes_;
+
+      uint64_t low = std::max(limit_ + 1, (uint64_t) 7);
+      fillBlock(low, newLimit, *primes);
+      primes_ = std::move(primes);
+      limit_ = newLimit;
+    }
+
+    *limit = limit_;
+    return primes_;
+  }
+
+private:
+  std::mutex mutex_;
+  uint64_t limit_ = 0;
+  std::shared_ptr<std::vector<uint64_t>> primes_;
+};
+
 } // namespace
 
 namespace primesieve {
 
+/// Second prime buffer that is filled by a
+/// background thread, see set_async()
+///
+class AsyncPrefetch
+{
+public:
+  std::vector<uint64_t> primes;
+  std::future<void> future;
+  bool enabled = false;
+};
+
+/// LRU cache of the most recently generated blocks of
+/// primes. Serves iteration direction changes within
+/// recently visited ranges without re-sieving them.
+/// The primes are stored as delta compressed gaps: prime
+/// gaps almost always fit into a single byte, gaps >=
+/// ESCAPE use an escape code followed by a 4 byte gap.
+/// This lets the same memory cache about 8x more primes
+/// than uint64_t storage.
+///
+class BlockCache
+{
+public:
+  /// If a cached block covers [low, high] decode its
+  /// primes inside [low, high] and append them to primes
+  ///
+  bool find(uint64_t low, uint64_t high, std::vector<uint64_t>& primes)
+  {
+    for (std::size_t i = 0; i < blocks_.size(); i++)
+    {
+      Block& block = blocks_[i];
+      if (block.low <= low &&
+          block.high >= high)
+      {
+        decode(block, low, high, primes);
+        // most recently used block first
+        std::rotate(blocks_.begin(), blocks_.begin() + i, blocks_.begin() + i + 1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Cache the primes inside [low, high],
+  /// evict the least recently used block
+  ///
+  void insert(uint64_t low, uint64_t high, const uint64_t* begin, const uint64_t* end)
+  {
+    if (blocks_.size() >= config::MAX_CACHE_BLOCKS)
+      blocks_.pop_back();
+
+    Block block;
+    block.low = low;
+    block.high = high;
+    block.count = (std::size_t) (end - begin);
+
+    if (block.count > 0)
+    {
+      block.first = *begin;
+      block.deltas.reserve(block.count - 1);
+
+      for (const uint64_t* p = begin + 1; p < end; p++)
+      {
+        uint64_t gap = p[0] - p[-1];
+        if (gap < ESCAPE)
+          block.deltas.push_back((uint8_t) gap);
+        else
+        {
+          // the largest known prime gap < 2^64 is 1550,
+          // 4 bytes cover any gap a block can contain
+          block.deltas.push_back(ESCAPE);
+          block.deltas.push_back((uint8_t) (gap >> 0));
+          block.deltas.push_back((uint8_t) (gap >> 8));
+          block.deltas.push_back((uint8_t) (gap >> 16));
+          block.deltas.push_back((uint8_t) (gap >> 24));
+        }
+      }
+    }
+
+    blocks_.insert(blocks_.begin(), std::move(block));
+  }
+
+private:
+  enum { ESCAPE = 0xff };
+
+  struct Block
+  {
+    uint64_t low = 0;
+    uint64_t high = 0;
+    uint64_t first = 0;
+    std::size_t count = 0;
+    std::vector<uint8_t> deltas;
+  };
+
+  /// Prefix sum over the gaps, append
+  /// the primes inside [low, high]
+  ///
+  static void decode(const Block& block,
+                     uint64_t low,
+                     uint64_t high,
+                     std::vector<uint64_t>& primes)
+  {
+    if (block.count == 0)
+      return;
+
+    uint64_t prime = block.first;
+    const uint8_t* deltas = block.deltas.data();
+    std::size_t size = block.deltas.size();
+    std::size_t i = 0;
+
+    while (true)
+    {
+      if (prime >= low &&
+          prime <= high)
+        primes.push_back(prime);
+      if (prime > high || i >= size)
+        break;
+
+      uint64_t gap = deltas[i++];
+      if (gap == ESCAPE)
+      {
+        gap = deltas[i + 0] |
+              ((uint64_t) deltas[i + 1]) << 8 |
+              ((uint64_t) deltas[i + 2]) << 16 |
+              ((uint64_t) deltas[i + 3]) << 24;
+        i += 4;
+      }
+      prime += gap;
+    }
+  }
+
+  std::vector<Block> blocks_;
+};
+
 iterator::~iterator()
-{ }
+{
+  // wait for the background thread, its buffer
+  // must outlive the sieving
+  if (async_ &&
+      async_->future.valid())
+    async_->future.wait();
+}
 
 iterator::iterator(uint64_t start,
                    uint64_t stop_hint)
@@ -39,6 +286,14 @@ iterator::iterator(uint64_t start,
 void iterator::skipto(uint64_t start,
                       uint64_t stop_hint)
 {
+  // discard primes sieved in the background
+  if (async_ &&
+      async_->future.valid())
+  {
+    async_->future.get();
+    async_->primes.clear();
+  }
+
   start_ = start;
   stop_ = start;
   stop_hint_ = stop_hint;
@@ -49,13 +304,198 @@ void iterator::skipto(uint64_t start,
   primes_.clear();
 }
 
+void iterator::set_async(bool enable)
+{
+  if (!async_)
+    async_.reset(new AsyncPrefetch());
+
+  if (async_->future.valid())
+    async_->future.get();
+
+  async_->enabled = enable;
+  async_->primes.clear();
+
+  // the synchronous and asynchronous modes generate
+  // different block sequences, hence restart from the
+  // last returned prime
+  if (!primes_.empty())
+    skipto(primes_[i_], stop_hint_);
+}
+
+/// Returns the unconsumed part of the current block
+/// of primes (or generates the next block), the
+/// caller processes it in place i.e. without the
+/// per prime call and copy of next_prime()
+///
+const uint64_t* iterator::next_primes(std::size_t* size)
+{
+  if (primes_.empty() ||
+      i_ >= last_idx_)
+  {
+    generate_next_primes();
+    *size = last_idx_ + 1;
+    i_ = last_idx_;
+    return primes_.data();
+  }
+
+  const uint64_t* primes = &primes_[i_ + 1];
+  *size = last_idx_ - i_;
+  i_ = last_idx_;
+  return primes;
+}
+
 void iterator::generate_next_primes()
 {
+  if (async_ &&
+      async_->enabled)
+  {
+    generate_next_primes_async();
+    return;
+  }
+
+  while (true)
+  {
+    if (!primeGenerator_)
+    {
+      IteratorHelper::next(&start_, &stop_, stop_hint_, &dist_);
+
+      // serve the block from the cache of recently
+      // generated blocks if possible
+      if (blockCache_)
+      {
+        primes_.clear();
+        if (blockCache_->find(start_, stop_, primes_))
+        {
+          if (primes_.empty())
+            continue;
+          i_ = 0;
+          last_idx_ = primes_.size() - 1;
+          return;
+        }
+      }
+
+      // the sieving primes come from the process-wide
+      // cache and are kept across skipto() calls, so both
+      // repositioning the iterator and constructing new
+      // iterators within an already visited range cost
+      // O(segment) instead of O(sqrt(stop)): the new
+      // PrimeGenerator merely recomputes its wheel state
+      // from the shared table
+      uint64_t sqrtStop = isqrt(stop_);
+      if (sqrtStop >= 7 &&
+          sievingPrimesLimit_ < sqrtStop)
+        sievingPrimes_ = SievingPrimesCache::getInstance().get(sqrtStop, &sievingPrimesLimit_);
+
+      auto p = new PrimeGenerator(start_, stop_);
+      if (sievingPrimes_)
+        p->setSievingPrimes(sievingPrimes_.get());
+      primeGenerator_.reset(p);
+      primes_.resize(64);
+    }
+
+    for (last_idx_ = 0; !last_idx_;)
+      primeGenerator_->fill(primes_, &last_idx_);
+
+    if (primeGenerator_->finished())
+      clear(primeGenerator_);
+    else
+      break;
+  }
+
+  i_ = 0;
+  last_idx_--;
+}
+
+/// Swap in the primes sieved by the background thread
+/// (or sieve them now if there are none), then start
+/// sieving the next block in the background while the
+/// caller iterates over the current block
+///
+void iterator::generate_next_primes_async()
+{
+  auto& async = *async_;
+  primes_.clear();
+
+  while (primes_.empty())
+  {
+    if (async.future.valid())
+    {
+      async.future.get();
+      primes_.swap(async.primes);
+    }
+    else if (stop_ < get_max_stop())
+    {
+      IteratorHelper::next(&start_, &stop_, stop_hint_, &dist_);
+      PrimeGenerator generator(start_, stop_);
+      generator.fill(primes_);
+    }
+    else
+      // next prime > 2^64
+      primes_.push_back(~0ull);
+
+    if (stop_ < get_max_stop())
+    {
+      IteratorHelper::next(&start_, &stop_, stop_hint_, &dist_);
+      async.primes.clear();
+      uint64_t start = start_;
+      uint64_t stop = stop_;
+
+      async.future = std::async(std::launch::async,
+        [&async, start, stop]()
+        {
+          PrimeGenerator generator(start, stop);
+          generator.fill(async.primes);
+        });
+    }
+  }
+
+  i_ = 0;
+  last_idx_ = primes_.size() - 1;
+}
+
+iterator32::~iterator32()
+{ }
+
+iterator32::iterator32(uint64_t start,
+                       uint64_t stop_hint)
+{
+  skipto(start, stop_hint);
+}
+
+void iterator32::skipto(uint64_t start,
+                        uint64_t stop_hint)
+{
+  start_ = start;
+  stop_ = start;
+  stop_hint_ = stop_hint;
+  i_ = 0;
+  last_idx_ = 0;
+  dist_ = PrimeGenerator::maxCachedPrime();
+  clear(primeGenerator_);
+  primes_.clear();
+}
+
+void iterator32::generate_next_primes()
+{
+  uint64_t maxStop = ~0u;
+
   while (true)
   {
     if (!primeGenerator_)
     {
+      // all primes < 2^32 have been generated
+      if (start_ >= maxStop)
+      {
+        primes_.resize(1);
+        primes_[0] = ~0u;
+        i_ = 0;
+        last_idx_ = 0;
+        return;
+      }
+
       IteratorHelper::next(&start_, &stop_, stop_hint_, &dist_);
+      // primes > 2^32 do not fit into 32 bits
+      stop_ = std::min(stop_, maxStop);
       auto p = new PrimeGenerator(start_, stop_);
       primeGenerator_.reset(p);
       primes_.resize(64);
@@ -76,20 +516,51 @@ void iterator::generate_next_primes()
 
 void iterator::generate_prev_primes()
 {
-  if (primeGenerator_)
+  // the background thread's block is ahead of
+  // the primes the caller has consumed
+  if (async_ &&
+      async_->future.valid())
+  {
+    async_->future.get();
+    async_->primes.clear();
+  }
+
+  bool asyncPrimes = async_ &&
+                     async_->enabled &&
+                     !primes_.empty();
+
+  if (primeGenerator_ || asyncPrimes)
     start_ = primes_.front();
 
   primes_.clear();
+  clear(primeGenerator_);
+
+  if (!blockCache_)
+    blockCache_.reset(new BlockCache());
 
   while (primes_.empty())
   {
     IteratorHelper::prev(&start_, &stop_, stop_hint_, &dist_);
     if (start_ <= 2)
       primes_.push_back(0);
-    auto p = new PrimeGenerator(start_, stop_);
-    primeGenerator_.reset(p);
-    primeGenerator_->fill(primes_);
-    clear(primeGenerator_);
+
+    std::size_t size = primes_.size();
+    if (!blockCache_->find(start_, stop_, primes_))
+    {
+      // backward blocks start small (see IteratorHelper.cpp),
+      // they are only affordable because the sieving primes
+      // come from the process-wide cache instead of being
+      // regenerated for each block
+      uint64_t sqrtStop = isqrt(stop_);
+      if (sqrtStop >= 7 &&
+          sievingPrimesLimit_ < sqrtStop)
+        sievingPrimes_ = SievingPrimesCache::getInstance().get(sqrtStop, &sievingPrimesLimit_);
+
+      fillBlock(start_, stop_, primes_, sievingPrimes_.get());
+      blockCache_->insert(start_, stop_,
+                          primes_.data() + size,
+                          primes_.data() + primes_.size());
+    }
   }
 
   last_idx_ = primes_.size() - 1;
@@ -7,8 +7,10 @@
 /// file in the top level directory.
 ///
 
-#include <primesieve/iterator.hpp>
+#include <primesieve.hpp>
+#include <primesieve/PrimeGenerator.hpp>
 #include <primesieve/PrimeSieve.hpp>
+#include <primesieve/ThreadPool.hpp>
 #include <primesieve/pmath.hpp>
 #include <primesieve/primesieve_error.hpp>
 #include <primesieve/types.hpp>
@@ -18,6 +20,7 @@
 #include <cassert>
 #include <chrono>
 #include <cmath>
+#include <vector>
 
 using namespace std;
 using namespace primesieve;
@@ -58,42 +61,105 @@ uint64_t nthPrimeDist(int64_t n, int64_t count, uint64_t start)
   x = abs(x);
   x = max(x, 4.0);
 
-  // rough pi(x) approximation
-  double logx = log(x);
-  double loglogx = log(logx);
-  double pix = x * (logx + loglogx - 1);
+  double s = (double) start;
+  double guess;
 
-  // correct start if sieving backwards to
-  // get more accurate approximation
-  if (count >= n)
-  {
-    double st = start - pix;
-    st = max(0.0, st);
-    start = (uint64_t) st;
-  }
+  // guess the position of the nth prime past (or before)
+  // start using the inverse logarithmic integral
+  if (count <= n)
+    guess = liInverse(li(s) + x);
+  else
+    guess = liInverse(max(li(s) - x, 0.0));
+
+  double dist = abs(guess - s);
 
-  // approximate the nth prime using:
-  // start + n * log(start + pi(n) / loglog(n))
-  double startPix = start + pix / loglogx;
-  startPix = max(4.0, startPix);
-  double logStartPix = log(startPix);
-  double dist = max(pix, x * logStartPix);
+  // account for the error of the li(x) approximation,
+  // |li(x) - pi(x)| < sqrt(x) for all x <= 10^19
+  double padding = sqrt(guess) + maxPrimeGap(guess);
 
   // ensure start + dist <= nth prime
   if (count < n)
-    dist -= sqrt(dist) * log(logStartPix) * 2;
-  // ensure start + dist >= nth prime
+    dist -= padding;
+  // ensure start - dist <= nth prime
   if (count > n)
-    dist += sqrt(dist) * log(logStartPix) * 2;
+    dist += padding;
 
   // if n is very small:
-  // ensure start + dist >= nth prime
-  double primeGap = maxPrimeGap(startPix);
-  dist = max(dist, primeGap);
+  // ensure the interval contains the nth prime
+  dist = max(dist, maxPrimeGap(guess));
 
   return (uint64_t) dist;
 }
 
+/// Find the kth prime > start with k >= 1. The interval
+/// (start, stop] is split into equally sized subranges
+/// whose primes are counted in parallel, then only the
+/// subrange containing the kth prime is scanned. If the
+/// interval contains fewer than k primes (the nth prime
+/// approximation was too small) the scan simply continues
+/// past stop.
+///
+uint64_t findNthPrime(int64_t k,
+                      uint64_t start,
+                      uint64_t stop,
+                      int threads,
+                      int sieveSize)
+{
+  assert(k > 0);
+
+  uint64_t dist = stop - start;
+  uint64_t maxThreads = dist / get_tuning().minThreadDistance;
+  threads = (int) inBetween(1, maxThreads, threads);
+
+  if (threads > 1)
+  {
+    uint64_t chunk = dist / threads;
+    vector<uint64_t> counts(threads);
+
+    auto task = [&](int t)
+    {
+      uint64_t low = start + chunk * t;
+      uint64_t high = (t + 1 == threads) ? stop : low + chunk;
+      PrimeSieve ps;
+      ps.setSieveSize(sieveSize);
+      counts[t] = ps.countPrimes(low + 1, high);
+    };
+
+    ThreadPool::getInstance().execute(threads, task);
+
+    // skip the subranges before the one containing
+    // the kth prime, the last subrange is never
+    // skipped as it extends up to stop
+    for (int t = 0; t + 1 < threads; t++)
+    {
+      if ((int64_t) counts[t] >= k)
+        break;
+      k -= (int64_t) counts[t];
+      start += chunk;
+    }
+  }
+
+  // scan the remaining subrange with the popcount based
+  // PrimeGenerator::nthPrime() instead of decoding every
+  // prime through the one-at-a-time iterator
+  uint64_t remaining = (uint64_t) k;
+
+  while (true)
+  {
+    checkLimit(start);
+    PrimeGenerator primeGenerator(start + 1, stop);
+    uint64_t prime = primeGenerator.nthPrime(&remaining);
+
+    if (prime)
+      return prime;
+
+    // the interval contained fewer than k primes (the nth
+    // prime approximation was too small), extend it
+    start = stop;
+    stop = checkedAdd(stop, nthPrimeDist((int64_t) remaining, 0, stop));
+  }
+}
+
 } // namespace
 
 namespace primesieve {
@@ -156,13 +222,12 @@ uint64_t PrimeSieve::nthPrime(int64_t n, uint64_t start)
   dist = nthPrimeDist(n, count, start) * 2;
   start = checkedSub(start, 1);
   stop = checkedAdd(start, dist);
-  uint64_t prime = 0;
 
-  for (primesieve::iterator it(start, stop); count < n; count++)
-    prime = it.next_prime();
-
-  if (~prime == 0)
-    throw primesieve_error("nth prime > 2^64");
+  // the counting loop above is parallel (countPrimes
+  // dispatches to ParallelSieve::sieve), so the final
+  // window is searched with multiple threads too
+  uint64_t prime = findNthPrime(n - count, start, stop,
+                                getNumThreads(), getSieveSize());
 
   auto t2 = chrono::system_clock::now();
   chrono::duration<double> seconds = t2 - t1;
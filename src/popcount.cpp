@@ -1,7 +1,12 @@
 ///
 /// @file   popcount.cpp
-/// @brief  Fast algorithm to count the number of 1 bits in an
-///         array using only integer operations.
+/// @brief  Fast algorithms to count the number of 1 bits in an
+///         array: an AVX-512 VPOPCNTDQ implementation, an AVX2
+///         Harley-Seal implementation processing 256 bits per
+///         carry-save adder step, an ARM NEON implementation
+///         based on the vcnt instruction (all runtime dispatched
+///         using CpuInfo) and a scalar Harley-Seal fallback using
+///         only integer operations.
 ///
 /// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
 ///
@@ -9,10 +14,43 @@
 /// file in the top level directory.
 ///
 
+#include <primesieve/CpuInfo.hpp>
+
 #include <stdint.h>
 
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+  #define HAS_AVX2_POPCOUNT
+  // The AVX-512 VPOPCNTDQ intrinsics require GCC >= 9 or Clang
+  #if defined(__clang__) || \
+      (defined(__GNUC__) && __GNUC__ >= 9)
+    #define HAS_AVX512_POPCOUNT
+  #endif
+  #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+  #define HAS_NEON_POPCOUNT
+  #include <arm_neon.h>
+#endif
+
 namespace {
 
+/// Prefetch the cache line at addr with a non-temporal hint
+/// (prefetchnta on x86, PLDL1STRM on ARM). x86 has no true
+/// non-temporal loads from write-back memory, but the hint
+/// marks the fetched lines for early eviction so that
+/// scanning a buffer larger than the cache does not evict
+/// the sieving primes' working set. Prefetching past the
+/// end of the array is harmless.
+///
+void prefetchNta(const void* addr)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(addr, 0, 0);
+#else
+  (void) addr;
+#endif
+}
+
 /// This uses fewer arithmetic operations than any other known
 /// implementation on machines with fast multiplication.
 /// It uses 12 arithmetic operations, one of which is a multiply.
@@ -41,6 +79,195 @@ void CSA(uint64_t& h, uint64_t& l, uint64_t a, uint64_t b, uint64_t c)
   l = u ^ c;
 }
 
+#if defined(HAS_AVX2_POPCOUNT)
+
+/// The AVX2 kernels are compiled with the target attribute
+/// so that no -mavx2 compiler flag is required, popcount()
+/// only calls them if CpuInfo reports AVX2 support.
+
+__attribute__((target("avx2")))
+void CSA256(__m256i& h, __m256i& l, __m256i a, __m256i b, __m256i c)
+{
+  __m256i u = _mm256_xor_si256(a, b);
+  h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+  l = _mm256_xor_si256(u, c);
+}
+
+/// Count the 1 bits of each 64-bit word using an in-register
+/// nibble lookup table (vpshufb) and vpsadbw
+///
+__attribute__((target("avx2")))
+__m256i popcount256(__m256i v)
+{
+  __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+                                    1, 2, 2, 3, 2, 3, 3, 4,
+                                    0, 1, 1, 2, 1, 2, 2, 3,
+                                    1, 2, 2, 3, 2, 3, 3, 4);
+
+  __m256i lowMask = _mm256_set1_epi8(0x0f);
+  __m256i lo = _mm256_and_si256(v, lowMask);
+  __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+  __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                _mm256_shuffle_epi8(lookup, hi));
+
+  return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+}
+
+/// Harley-Seal popcount processing 256 bits per CSA step,
+/// same algorithm as the scalar version below but with 4
+/// 64-bit words per carry-save adder
+///
+__attribute__((target("avx2")))
+uint64_t popcountAVX2(const uint64_t* array, uint64_t size, bool nta)
+{
+  __m256i zero = _mm256_setzero_si256();
+  __m256i total = zero;
+  __m256i ones = zero, twos = zero, fours = zero;
+  __m256i eights = zero, sixteens = zero;
+  __m256i twosA, twosB, foursA, foursB, eightsA, eightsB;
+
+  const __m256i* data = (const __m256i*) array;
+  uint64_t vecSize = size / 4;
+  uint64_t limit = vecSize - vecSize % 16;
+  uint64_t i = 0;
+
+  for (; i < limit; i += 16)
+  {
+    // each iteration consumes 512 bytes (8 cache lines),
+    // prefetch them 2 iterations ahead
+    if (nta)
+      for (uint64_t line = 0; line < 512; line += 64)
+        prefetchNta((const char*) (data + i + 32) + line);
+
+    CSA256(twosA, ones, ones, _mm256_loadu_si256(data + i + 0), _mm256_loadu_si256(data + i + 1));
+    CSA256(twosB, ones, ones, _mm256_loadu_si256(data + i + 2), _mm256_loadu_si256(data + i + 3));
+    CSA256(foursA, twos, twos, twosA, twosB);
+    CSA256(twosA, ones, ones, _mm256_loadu_si256(data + i + 4), _mm256_loadu_si256(data + i + 5));
+    CSA256(twosB, ones, ones, _mm256_loadu_si256(data + i + 6), _mm256_loadu_si256(data + i + 7));
+    CSA256(foursB, twos, twos, twosA, twosB);
+    CSA256(eightsA, fours, fours, foursA, foursB);
+    CSA256(twosA, ones, ones, _mm256_loadu_si256(data + i + 8), _mm256_loadu_si256(data + i + 9));
+    CSA256(twosB, ones, ones, _mm256_loadu_si256(data + i + 10), _mm256_loadu_si256(data + i + 11));
+    CSA256(foursA, twos, twos, twosA, twosB);
+    CSA256(twosA, ones, ones, _mm256_loadu_si256(data + i + 12), _mm256_loadu_si256(data + i + 13));
+    CSA256(twosB, ones, ones, _mm256_loadu_si256(data + i + 14), _mm256_loadu_si256(data + i + 15));
+    CSA256(foursB, twos, twos, twosA, twosB);
+    CSA256(eightsB, fours, fours, foursA, foursB);
+    CSA256(sixteens, eights, eights, eightsA, eightsB);
+
+    total = _mm256_add_epi64(total, popcount256(sixteens));
+  }
+
+  total = _mm256_slli_epi64(total, 4);
+  total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(eights), 3));
+  total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(fours), 2));
+  total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(twos), 1));
+  total = _mm256_add_epi64(total, popcount256(ones));
+
+  uint64_t lanes[4];
+  _mm256_storeu_si256((__m256i*) lanes, total);
+  uint64_t count = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+  for (i *= 4; i < size; i++)
+    count += popcount64(array[i]);
+
+  return count;
+}
+
+#endif
+
+#if defined(HAS_AVX512_POPCOUNT)
+
+/// On CPUs with the VPOPCNTDQ extension (Ice Lake, Zen 4) the
+/// hardware vpopcntq instruction counts 8 64-bit words per cycle,
+/// no carry-save adder tree is needed. 4 accumulators hide the
+/// vpaddq latency.
+///
+__attribute__((target("avx512f,avx512vpopcntdq")))
+uint64_t popcountAVX512(const uint64_t* array, uint64_t size, bool nta)
+{
+  __m512i cnt0 = _mm512_setzero_si512();
+  __m512i cnt1 = _mm512_setzero_si512();
+  __m512i cnt2 = _mm512_setzero_si512();
+  __m512i cnt3 = _mm512_setzero_si512();
+
+  const __m512i* data = (const __m512i*) array;
+  uint64_t vecSize = size / 8;
+  uint64_t limit = vecSize - vecSize % 4;
+  uint64_t i = 0;
+
+  for (; i < limit; i += 4)
+  {
+    // each iteration consumes 256 bytes (4 cache lines),
+    // prefetch them 4 iterations ahead
+    if (nta)
+      for (uint64_t line = 0; line < 256; line += 64)
+        prefetchNta((const char*) (data + i + 16) + line);
+
+    cnt0 = _mm512_add_epi64(cnt0, _mm512_popcnt_epi64(_mm512_loadu_si512(data + i + 0)));
+    cnt1 = _mm512_add_epi64(cnt1, _mm512_popcnt_epi64(_mm512_loadu_si512(data + i + 1)));
+    cnt2 = _mm512_add_epi64(cnt2, _mm512_popcnt_epi64(_mm512_loadu_si512(data + i + 2)));
+    cnt3 = _mm512_add_epi64(cnt3, _mm512_popcnt_epi64(_mm512_loadu_si512(data + i + 3)));
+  }
+
+  for (; i < vecSize; i++)
+    cnt0 = _mm512_add_epi64(cnt0, _mm512_popcnt_epi64(_mm512_loadu_si512(data + i)));
+
+  cnt0 = _mm512_add_epi64(cnt0, cnt1);
+  cnt2 = _mm512_add_epi64(cnt2, cnt3);
+  cnt0 = _mm512_add_epi64(cnt0, cnt2);
+  uint64_t count = _mm512_reduce_add_epi64(cnt0);
+
+  for (i *= 8; i < size; i++)
+    count += popcount64(array[i]);
+
+  return count;
+}
+
+#endif
+
+#if defined(HAS_NEON_POPCOUNT)
+
+/// NEON popcount using the vcnt byte popcount instruction.
+/// The 8-bit partial counts are accumulated for up to 31
+/// vectors (31 * 8 < 256, no overflow) before being widened
+/// to 64-bit using the pairwise add instructions.
+///
+uint64_t popcountNEON(const uint64_t* array, uint64_t size, bool nta)
+{
+  const uint8_t* data = (const uint8_t*) array;
+  uint64_t bytes = size * 8;
+  uint64_t i = 0;
+  uint64x2_t total = vdupq_n_u64(0);
+
+  while (bytes - i >= 16)
+  {
+    uint64_t chunk = (bytes - i) / 16;
+    chunk = (chunk < 31) ? chunk : 31;
+    uint8x16_t counts = vdupq_n_u8(0);
+
+    for (uint64_t j = 0; j < chunk; j++, i += 16)
+    {
+      // prefetch 16 cache lines ahead, once per line
+      if (nta && i % 64 == 0)
+        prefetchNta(data + i + 1024);
+      counts = vaddq_u8(counts, vcntq_u8(vld1q_u8(data + i)));
+    }
+
+    total = vaddq_u64(total, vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(counts))));
+  }
+
+  uint64_t count = vgetq_lane_u64(total, 0) +
+                   vgetq_lane_u64(total, 1);
+
+  for (i /= 8; i < size; i++)
+    count += popcount64(array[i]);
+
+  return count;
+}
+
+#endif
+
 } // namespace
 
 namespace primesieve {
@@ -53,6 +280,35 @@ namespace primesieve {
 ///
 uint64_t popcount(const uint64_t* array, uint64_t size)
 {
+  // arrays larger than the L2 cache (e.g. very large sieve
+  // segments) are scanned with non-temporal prefetch hints,
+  // the same threshold PreSieve::copy() uses for its
+  // non-temporal stores. This keeps the sieving primes'
+  // working set cache resident while scanning a buffer that
+  // would not fit anyway.
+  bool nta = cpuInfo.hasL2Cache() &&
+             size * 8 > cpuInfo.l2CacheSize();
+
+#if defined(HAS_AVX512_POPCOUNT)
+  if (size >= 64 &&
+      cpuInfo.hasAVX512VPOPCNT())
+    return popcountAVX512(array, size, nta);
+#endif
+
+#if defined(HAS_AVX2_POPCOUNT)
+  // runtime dispatch, the sieve segments scanned by
+  // countPrimes() are large enough to amortize it
+  if (size >= 64 &&
+      cpuInfo.hasAVX2())
+    return popcountAVX2(array, size, nta);
+#endif
+
+#if defined(HAS_NEON_POPCOUNT)
+  if (size >= 64 &&
+      cpuInfo.hasNEON())
+    return popcountNEON(array, size, nta);
+#endif
+
   uint64_t total = 0;
   uint64_t ones = 0, twos = 0, fours = 0, eights = 0, sixteens = 0;
   uint64_t twosA, twosB, foursA, foursB, eightsA, eightsB;
@@ -61,6 +317,14 @@ uint64_t popcount(const uint64_t* array, uint64_t size)
 
   for(; i < limit; i += 16)
   {
+    // each iteration consumes 128 bytes (2 cache lines),
+    // prefetch them 8 iterations ahead
+    if (nta)
+    {
+      prefetchNta(&array[i + 128]);
+      prefetchNta(&array[i + 136]);
+    }
+
     CSA(twosA, ones, ones, array[i+0], array[i+1]);
     CSA(twosB, ones, ones, array[i+2], array[i+3]);
     CSA(foursA, twos, twos, twosA, twosB);
@@ -0,0 +1,117 @@
+///
+/// @file   tune.cpp
+/// @brief  Calibrate the runtime tuning parameters on the
+///         local CPU. calibrate_tuning() times single-threaded
+///         sieving runs for a set of sieve size and
+///         EratSmall/EratMedium crossover candidates and picks
+///         the fastest combination, so that a profile written
+///         with save_tuning() replaces hand-tuning the
+///         config.hpp constants per machine. The SIMD popcount
+///         and cross-off kernels need no calibration, they are
+///         already runtime dispatched using CpuInfo.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/PrimeSieve.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+/// The benchmark interval starts at 10^12 so that all three
+/// sub-sieves (EratSmall, EratMedium, EratBig) contribute to
+/// the measured time, like they do in large sieving runs
+const uint64_t benchStart = 1000000000000ull;
+
+/// Time one single-threaded sieving run
+double benchmark(uint64_t dist, int sieveSize)
+{
+  primesieve::PrimeSieve ps;
+  ps.setSieveSize(sieveSize);
+  ps.sieve(benchStart, benchStart + dist, primesieve::COUNT_PRIMES);
+  return ps.getSeconds();
+}
+
+/// Best of 2 runs to reduce scheduling noise
+double measure(const primesieve::Tuning& t,
+               uint64_t dist,
+               int sieveSize)
+{
+  primesieve::set_tuning(t);
+  double seconds = benchmark(dist, sieveSize);
+  seconds = min(seconds, benchmark(dist, sieveSize));
+  return seconds;
+}
+
+} // namespace
+
+namespace primesieve {
+
+Tuning calibrate_tuning(uint64_t dist)
+{
+  dist = max(dist, (uint64_t) 10000000);
+  Tuning saved = get_tuning();
+  Tuning best = saved;
+  double bestSeconds = numeric_limits<double>::max();
+
+  // 1st: find the best sieve size, it also shifts
+  // the crossover points measured below
+  int bestSieveSize = get_sieve_size();
+
+  for (int sieveSize : { 32, 64, 128, 256, 512 })
+  {
+    double seconds = measure(saved, dist, sieveSize);
+    if (seconds < bestSeconds)
+    {
+      bestSeconds = seconds;
+      bestSieveSize = sieveSize;
+    }
+  }
+
+  // 2nd: EratSmall crossover,
+  // sieving primes <= L1 size * factorEratSmall
+  bestSeconds = numeric_limits<double>::max();
+
+  for (double factor : { 0.3, 0.4, 0.5, 0.6, 0.8 })
+  {
+    Tuning t = best;
+    t.factorEratSmall = factor;
+    double seconds = measure(t, dist, bestSieveSize);
+    if (seconds < bestSeconds)
+    {
+      bestSeconds = seconds;
+      best.factorEratSmall = factor;
+    }
+  }
+
+  // 3rd: EratMedium crossover,
+  // sieving primes <= sieve size * factorEratMedium
+  bestSeconds = numeric_limits<double>::max();
+
+  for (double factor : { 1.5, 2.0, 2.5, 3.0, 4.0 })
+  {
+    Tuning t = best;
+    t.factorEratMedium = factor;
+    double seconds = measure(t, dist, bestSieveSize);
+    if (seconds < bestSeconds)
+    {
+      bestSeconds = seconds;
+      best.factorEratMedium = factor;
+    }
+  }
+
+  set_tuning(saved);
+  set_sieve_size(bestSieveSize);
+  return best;
+}
+
+} // namespace
@@ -0,0 +1,126 @@
+///
+/// @file   allocator.cpp
+/// @brief  Test the custom allocator hooks installed via
+///         primesieve::set_allocator(): the sieve arrays and
+///         bucket chunks must be allocated and freed through
+///         the hooks with matching sizes
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace primesieve;
+
+// the hooks run concurrently on the sieving threads
+atomic<uint64_t> allocCalls(0);
+atomic<uint64_t> deallocCalls(0);
+atomic<uint64_t> allocatedBytes(0);
+atomic<uint64_t> deallocatedBytes(0);
+
+void* poolAlloc(size_t bytes)
+{
+  allocCalls++;
+  allocatedBytes += bytes;
+  return malloc(bytes);
+}
+
+void poolDealloc(void* ptr, size_t bytes)
+{
+  deallocCalls++;
+  deallocatedBytes += bytes;
+  free(ptr);
+}
+
+/// The bucket pools retain chunks past main() and return
+/// them through the hooks during static destruction. This
+/// object is constructed before main() and hence destroyed
+/// after primesieve's internal statics, so its destructor
+/// can verify that by then every allocation has been paired
+/// with a matching deallocation
+///
+struct ExitCheck
+{
+  ~ExitCheck()
+  {
+    if (allocCalls != deallocCalls ||
+        allocatedBytes != deallocatedBytes)
+    {
+      printf("   ERROR: %llu of %llu allocated bytes returned "
+             "through the hooks at process exit\n",
+             (unsigned long long) deallocatedBytes,
+             (unsigned long long) allocatedBytes);
+      _Exit(1);
+    }
+  }
+};
+
+ExitCheck exitCheck;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  // must be installed before any sieving: the bucket pools
+  // keep chunks alive across calls and deallocations always
+  // go through the currently installed hooks
+  set_allocator(poolAlloc, poolDealloc);
+
+  uint64_t count = count_primes(0, 100000000);
+  cout << "PrimePi(10^8) = " << count;
+  check(count == 5761455);
+
+  cout << "Sieve arrays allocated through the hook: " << allocCalls;
+  check(allocCalls > 0);
+
+  // a range with large sqrt(stop) engages EratBig,
+  // its bucket chunks must also come from the hook
+  uint64_t allocCallsOld = allocCalls;
+  count = count_primes(100000000000000ull, 100000000000000ull + 10000000);
+  cout << "Bucket chunks allocated through the hook: "
+       << (allocCalls - allocCallsOld);
+  check(count > 0 && allocCalls > allocCallsOld);
+
+  // the sieve arrays are freed through the hook with the
+  // size they were allocated with; the bucket pools may
+  // legitimately keep chunks alive until process exit
+  // (the ExitCheck above verifies they are returned)
+  cout << "Deallocated " << deallocatedBytes << " of "
+       << allocatedBytes << " bytes";
+  check(deallocCalls > 0 &&
+        deallocatedBytes <= allocatedBytes);
+
+  // installing only one hook must throw
+  bool threw = false;
+  try
+  {
+    set_allocator(poolAlloc, nullptr);
+  }
+  catch (const primesieve_error&)
+  {
+    threw = true;
+  }
+  cout << "Installing only one hook throws: " << threw;
+  check(threw);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
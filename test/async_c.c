@@ -0,0 +1,89 @@
+///
+/// @file   async_c.c
+/// @brief  Test the asynchronous C API with completion
+///         callbacks and cancellation
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void check(int OK)
+{
+  if (OK)
+    printf("   OK\n");
+  else
+  {
+    printf("   ERROR\n");
+    exit(1);
+  }
+}
+
+/// Filled in by the completion callback. No atomics are
+/// needed: primesieve_async_wait() joins the background
+/// thread, the callback's writes happen before the join
+/// returns
+typedef struct
+{
+  uint64_t count;
+  int status;
+  int invoked;
+} result_t;
+
+void on_complete(uint64_t count, int status, void* user_data)
+{
+  result_t* result = (result_t*) user_data;
+  result->count = count;
+  result->status = status;
+  result->invoked++;
+}
+
+int main()
+{
+  result_t result = { 0, -1, 0 };
+  int status;
+
+  primesieve_async* async = primesieve_count_primes_async(0, 1000000000, on_complete, &result);
+  check(async != NULL);
+
+  status = primesieve_async_wait(async);
+  printf("PrimePi(10^9) = %" PRIu64, result.count);
+  check(status == 0 &&
+        result.status == 0 &&
+        result.count == 50847534 &&
+        result.invoked == 1);
+
+  // the callback is invoked with status = 2 after
+  // cancellation, the count is invalid then
+  result.count = 0;
+  result.status = -1;
+  result.invoked = 0;
+
+  async = primesieve_count_primes_async(0, 1000000000000ull, on_complete, &result);
+  check(async != NULL);
+  primesieve_async_cancel(async);
+
+  status = primesieve_async_wait(async);
+  printf("Cancelled count status = %d", status);
+  check(status == 2 &&
+        result.status == 2 &&
+        result.invoked == 1);
+
+  // a NULL callback must fail
+  async = primesieve_count_primes_async(0, 1000, NULL, &result);
+  printf("NULL callback fails: %d", async == NULL);
+  check(async == NULL);
+
+  printf("\n");
+  printf("All tests passed successfully!\n");
+
+  return 0;
+}
@@ -0,0 +1,78 @@
+///
+/// @file   calibrate_threads.cpp
+/// @brief  Test ParallelSieve thread-count selection:
+///         idealNumThreads() and calibrateNumThreads()
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/ParallelSieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  int maxThreads = ParallelSieve::getMaxThreads();
+
+  {
+    // tiny ranges must not be calibrated,
+    // a single thread is always fastest
+    ParallelSieve ps;
+    ps.setStart(100);
+    ps.setStop(200);
+    int threads = ps.calibrateNumThreads();
+    cout << "Tiny range threads: " << threads;
+    check(threads == 1);
+  }
+
+  {
+    ParallelSieve ps;
+    ps.setStart(0);
+    ps.setStop(2000000000ull);
+    int threads = ps.calibrateNumThreads();
+
+    cout << "Calibrated threads: " << threads;
+    check(threads >= 1 && threads <= maxThreads);
+
+    cout << "Calibration picks at most idealNumThreads()";
+    check(threads <= ps.idealNumThreads());
+
+    // the calibrated thread count must not
+    // change the sieving results
+    ps.sieve(0, 2000000000ull, COUNT_PRIMES);
+    cout << "Prime count: " << ps.getCount(0);
+    check(ps.getCount(0) == 98222287ull);
+  }
+
+  {
+    // an explicit setNumThreads() call is an
+    // upper bound for idealNumThreads()
+    ParallelSieve ps;
+    ps.setStart(0);
+    ps.setStop(1000000000000ull);
+    ps.setNumThreads(1);
+    cout << "setNumThreads(1) caps idealNumThreads()";
+    check(ps.idealNumThreads() == 1);
+  }
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
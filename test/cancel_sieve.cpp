@@ -0,0 +1,90 @@
+///
+/// @file   cancel_sieve.cpp
+/// @brief  Test cooperative cancellation and the time budget:
+///         PrimeSieve::cancelSieve(), setTimeBudget() and
+///         getStoppedAt()
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/ParallelSieve.hpp>
+#include <primesieve/PrimeSieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  {
+    // a completed run stops at stop
+    PrimeSieve ps;
+    uint64_t count = ps.countPrimes(0, 1000000);
+    cout << "getStoppedAt() = " << ps.getStoppedAt();
+    check(count == 78498 &&
+          ps.getStoppedAt() == 1000000 &&
+          !ps.isCanceled());
+  }
+
+  {
+    // cancellation is sticky: a cancel issued before
+    // sieve() starts is not lost, only the small primes
+    // (processed before the segment loop) are counted
+    PrimeSieve ps;
+    ps.cancelSieve();
+    ps.sieve(0, 1000000000, COUNT_PRIMES);
+    cout << "Cancelled before sieving, stopped at " << ps.getStoppedAt();
+    check(ps.isCanceled() &&
+          ps.getStoppedAt() == 6 &&
+          ps.getCount(0) == 3);
+  }
+
+  {
+    // the time budget stops sieving at the next segment
+    // boundary, the partial count is exact for
+    // [start, getStoppedAt()]
+    PrimeSieve ps;
+    ps.setTimeBudget(100);
+    ps.sieve(0, 100000000000ull, COUNT_PRIMES);
+    uint64_t stoppedAt = ps.getStoppedAt();
+    cout << "Time budget stopped at " << stoppedAt;
+    check(ps.isCanceled() &&
+          stoppedAt < 100000000000ull);
+
+    uint64_t count = count_primes(0, stoppedAt);
+    cout << "Partial count = " << ps.getCount(0);
+    check(ps.getCount(0) == count);
+  }
+
+  {
+    // multi-threaded time budget: the counts cover at
+    // least [start, getStoppedAt()]
+    ParallelSieve ps;
+    ps.setTimeBudget(100);
+    ps.sieve(0, 1000000000000ull, COUNT_PRIMES);
+    uint64_t stoppedAt = ps.getStoppedAt();
+    cout << "Parallel time budget stopped at " << stoppedAt;
+    check(ps.isCanceled() &&
+          stoppedAt < 1000000000000ull &&
+          ps.getCount(0) >= count_primes(0, stoppedAt));
+  }
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
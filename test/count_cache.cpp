@@ -0,0 +1,73 @@
+///
+/// @file   count_cache.cpp
+/// @brief  Test the block count memoization enabled via the
+///         PRIMESIEVE_COUNT_FILE environment variable: cached
+///         counting matches direct counting for aligned and
+///         unaligned ranges and the cache file is written.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+#if defined(_WIN32)
+  // setenv() is POSIX only
+  cout << "Skipped, no setenv() on Windows" << endl;
+#else
+  uint64_t dist = 1000000000ull;
+
+  // reference counts without memoization
+  uint64_t count1 = count_primes(dist, 2 * dist - 1);
+  uint64_t count2 = count_primes(dist - 12345, 2 * dist + 999);
+
+  string path = "primesieve_count_file.txt";
+  std::remove(path.c_str());
+  setenv("PRIMESIEVE_COUNT_FILE", path.c_str(), 1);
+
+  // counts one aligned block and memoizes it
+  cout << "count aligned block = " << count_primes(dist, 2 * dist - 1);
+  check(count_primes(dist, 2 * dist - 1) == count1);
+
+  ifstream file(path, ifstream::binary);
+  cout << "cache file has been written";
+  check(!!file);
+
+  // the unaligned query reuses the cached block,
+  // only the residuals are sieved
+  cout << "count unaligned range = " << count_primes(dist - 12345, 2 * dist + 999);
+  check(count_primes(dist - 12345, 2 * dist + 999) == count2);
+
+  // repeated query is answered from the cache
+  cout << "repeated query = " << count_primes(dist, 2 * dist - 1);
+  check(count_primes(dist, 2 * dist - 1) == count1);
+
+  std::remove(path.c_str());
+#endif
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
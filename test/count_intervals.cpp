@@ -0,0 +1,76 @@
+///
+/// @file   count_intervals.cpp
+/// @brief  Test bulk prime counting of many intervals
+///         using count_primes_intervals()
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/PrimeSieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  random_device rd;
+  mt19937 gen(rd());
+  uniform_int_distribution<uint64_t> dist(0, 20000000ull);
+
+  vector<pair<uint64_t, uint64_t>> intervals;
+
+  // random overlapping intervals, including
+  // empty ones and ones below 7
+  for (int i = 0; i < 300; i++)
+  {
+    uint64_t a = dist(gen);
+    uint64_t b = dist(gen);
+    intervals.emplace_back(a, b);
+  }
+
+  intervals.emplace_back(0, 0);
+  intervals.emplace_back(0, 1);
+  intervals.emplace_back(0, 3);
+  intervals.emplace_back(2, 3);
+  intervals.emplace_back(0, 8);
+  intervals.emplace_back(5, 5);
+  intervals.emplace_back(7, 8);
+  intervals.emplace_back(0, 20000000ull);
+
+  auto counts = count_primes_intervals(intervals);
+  check(counts.size() == intervals.size());
+
+  PrimeSieve ps;
+
+  for (size_t i = 0; i < intervals.size(); i++)
+  {
+    uint64_t a = intervals[i].first;
+    uint64_t b = intervals[i].second;
+    uint64_t count = (a < b) ? ps.countPrimes(a, b - 1) : 0;
+    cout << "Primes inside [" << a << ", " << b << "): " << counts[i];
+    check(counts[i] == count);
+  }
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
@@ -0,0 +1,64 @@
+///
+/// @file   count_primes_128.cpp
+/// @brief  Test count_primes_128() which counts the primes in
+///         windows with 128-bit bounds. The first prime above
+///         2^64 is 2^64 + 13, a window straddling 2^64 must
+///         count exactly one prime more than its part below
+///         2^64.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  // bounds < 2^64 are delegated to count_primes()
+  uint64_t count = count_primes_128(0, 0, 0, 1000000);
+  cout << "count_primes_128(0, 10^6) = " << count;
+  check(count == 78498);
+
+  count = count_primes_128(1, 100, 0, 200);
+  cout << "count_primes_128(start > stop) = " << count;
+  check(count == 0);
+
+#if defined(__SIZEOF_INT128__)
+
+  // the first prime above 2^64 is 2^64 + 13, a window
+  // straddling 2^64 contains exactly one prime more
+  // than its part below 2^64
+  uint64_t start = 18446744073709541616ull;
+  uint64_t below = count_primes(start, 18446744073709551615ull);
+  count = count_primes_128(0, start, 1, 13);
+  cout << "count_primes_128(2^64 - 10^4, 2^64 + 13) = " << count;
+  check(count == below + 1);
+
+  // [2^64, 2^64 + 12] contains no prime
+  count = count_primes_128(1, 0, 1, 12);
+  cout << "count_primes_128(2^64, 2^64 + 12) = " << count;
+  check(count == 0);
+
+#endif
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
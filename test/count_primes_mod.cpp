@@ -0,0 +1,115 @@
+///
+/// @file   count_primes_mod.cpp
+/// @brief  Test counting primes in arithmetic progressions:
+///         count_primes_mod() is cross-checked against
+///         filtering generated primes by modulus
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/primesieve_error.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+/// Count primes ≡ a (mod q) by filtering
+uint64_t countFiltered(const vector<uint64_t>& primes, uint64_t q, uint64_t a)
+{
+  uint64_t count = 0;
+  for (uint64_t prime : primes)
+    if (prime % q == a)
+      count++;
+  return count;
+}
+
+int main()
+{
+  uint64_t start = 0;
+  uint64_t stop = 2000000;
+  vector<uint64_t> primes;
+  generate_primes(start, stop, &primes);
+
+  // moduli coprime to the wheel, sharing factors
+  // with the wheel, and the wheel modulus itself
+  const uint64_t moduli[8] = { 1, 2, 3, 4, 7, 10, 30, 101 };
+
+  for (uint64_t q : moduli)
+  {
+    bool equal = true;
+    uint64_t sum = 0;
+    for (uint64_t a = 0; a < q; a++)
+    {
+      uint64_t count = count_primes_mod(start, stop, q, a);
+      equal &= (count == countFiltered(primes, q, a));
+      sum += count;
+    }
+    // every class matches the filtered count and the
+    // residue classes partition the primes
+    cout << "pi(x; " << q << ", a) for all residue classes a";
+    check(equal && sum == primes.size());
+  }
+
+  // interval with start > 0
+  primes.clear();
+  uint64_t low = 1000000000;
+  uint64_t high = 1001000000;
+  generate_primes(low, high, &primes);
+  uint64_t count = count_primes_mod(low, high, 4, 3);
+  cout << "pi(x; 4, 3) inside [10^9, 10^9+10^6] = " << count;
+  check(count == countFiltered(primes, 4, 3));
+
+  // large interval, split across threads. 2 is the
+  // only prime ≡ 0 (mod 2)
+  count = count_primes_mod(0, 100000000, 2, 1);
+  cout << "Odd primes <= 10^8 = " << count;
+  check(count == 5761455 - 1);
+
+  // large moduli fall back to filtering the generated
+  // primes instead of building q * 256 byte count tables
+  primes.clear();
+  generate_primes(start, stop, &primes);
+  count = count_primes_mod(start, stop, 1000003, 7);
+  cout << "pi(x; 1000003, 7) up to 2*10^6 = " << count;
+  check(count == countFiltered(primes, 1000003, 7));
+
+  // huge modulus: q * 256 would overflow uint64_t, only
+  // the prime p = 2^60 + 33 lies in the residue class
+  uint64_t q = 1ull << 60;
+  count = count_primes_mod(q, q + 100, q, 33);
+  cout << "pi(x; 2^60, 33) inside [2^60, 2^60+100] = " << count;
+  check(count == 1);
+
+  // q = 0 must throw
+  bool threw = false;
+  try
+  {
+    count_primes_mod(0, 1000, 0, 0);
+  }
+  catch (const primesieve_error&)
+  {
+    threw = true;
+  }
+  cout << "count_primes_mod(0, 1000, 0, 0) throws: " << threw;
+  check(threw);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
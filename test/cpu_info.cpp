@@ -49,5 +49,11 @@ int main()
       cout << "L2 cache: shared"  << endl;
   }
 
+  cout << "AVX2: "    << (cpuInfo.hasAVX2()   ? "yes" : "no") << endl;
+  cout << "AVX-512: " << (cpuInfo.hasAVX512() ? "yes" : "no") << endl;
+  cout << "BMI2: "    << (cpuInfo.hasBMI2()   ? "yes" : "no") << endl;
+  cout << "NEON: "    << (cpuInfo.hasNEON()   ? "yes" : "no") << endl;
+  cout << "Hybrid cores: " << (cpuInfo.hasHybridCores() ? "yes" : "no") << endl;
+
   return 0;
 }
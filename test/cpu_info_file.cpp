@@ -0,0 +1,82 @@
+///
+/// @file   cpu_info_file.cpp
+/// @brief  Test the per-host CPU topology cache file written
+///         to the path in the PRIMESIEVE_CPU_FILE environment
+///         variable: the file is created on first detection
+///         and a later load from it reproduces the same
+///         values as a live detection.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve/CpuInfo.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+#if defined(_WIN32)
+  // setenv() is POSIX only
+  cout << "Skipped, no setenv() on Windows" << endl;
+#else
+  string path = "primesieve_cpu_file.txt";
+  std::remove(path.c_str());
+  setenv("PRIMESIEVE_CPU_FILE", path.c_str(), 1);
+
+  // first query triggers the detection
+  // and writes the cache file
+  size_t l1CacheSize = cpuInfo.l1CacheSize();
+  size_t l2CacheSize = cpuInfo.l2CacheSize();
+
+  ifstream file(path);
+  cout << "CPU file has been written";
+  check(!!file);
+
+  size_t fileL1 = 0;
+  size_t fileL2 = 0;
+  bool hasL1Key = false;
+  bool hasL2Key = false;
+  string key;
+  string value;
+
+  while (file >> key >> value)
+  {
+    if (key == "l1CacheSize") { fileL1 = stoul(value); hasL1Key = true; }
+    if (key == "l2CacheSize") { fileL2 = stoul(value); hasL2Key = true; }
+  }
+
+  cout << "l1CacheSize key present";
+  check(hasL1Key);
+  cout << "l2CacheSize key present";
+  check(hasL2Key);
+
+  cout << "l1CacheSize = " << fileL1;
+  check(fileL1 == l1CacheSize);
+  cout << "l2CacheSize = " << fileL2;
+  check(fileL2 == l2CacheSize);
+
+  std::remove(path.c_str());
+#endif
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
@@ -0,0 +1,66 @@
+///
+/// @file   eratbig_super.cpp
+/// @brief  Test EratBig's 2-level supersegment bucket wheel:
+///         at large start numbers with small sieve sizes the
+///         segment count exceeds the lists_ window and distant
+///         sieving primes are parked at the supersegment
+///         level. The counts must agree across sieve sizes
+///         with very different window/supersegment geometries
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/PrimeSieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+uint64_t countPrimes(uint64_t start, uint64_t stop, int sieveSize)
+{
+  PrimeSieve ps;
+  ps.setSieveSize(sieveSize);
+  ps.sieve(start, stop, COUNT_PRIMES);
+  return ps.getCount(0);
+}
+
+int main()
+{
+  // small range, single-level bucket wheel
+  cout << "PrimeSieve(16 KB) count primes <= 10^8: " << countPrimes(0, 100000000, 16);
+  check(countPrimes(0, 100000000, 16) == 5761455);
+
+  // at start = 2*10^12 an 8 kilobyte sieve needs > 1000
+  // segment lists, far beyond the 2^23 index bit window,
+  // so the supersegment level is exercised
+  uint64_t start = 2000000000000ull;
+  uint64_t stop = start + 20000000;
+  uint64_t count = count_primes(start, stop);
+
+  cout << "Count primes inside [2*10^12, 2*10^12 + 2*10^7]: " << count << endl;
+
+  for (int sieveSize : { 8, 16, 32, 64, 128, 256 })
+  {
+    cout << "PrimeSieve(" << sieveSize << " KB) count: " << countPrimes(start, stop, sieveSize);
+    check(countPrimes(start, stop, sieveSize) == count);
+  }
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
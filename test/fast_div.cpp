@@ -0,0 +1,90 @@
+///
+/// @file   fast_div.cpp
+/// @brief  Test fastDiv(x, y): the double precision estimate
+///         plus correction must match the exact integer
+///         division for all magnitudes, including the
+///         boundary of the hardware division fallback.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve/pmath.hpp>
+
+#include <stdint.h>
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  uint64_t x;
+  uint64_t y;
+
+  for (x = 0; x < 10000; x++)
+    for (y = 1; y <= 100; y++)
+      if (fastDiv(x, y) != x / y)
+      {
+        cout << "fastDiv(" << x << ", " << y << ") = " << fastDiv(x, y);
+        check(false);
+      }
+
+  cout << "fastDiv(x, y) = x / y for small x, y";
+  check(true);
+
+  // pseudo random 64-bit test values (xorshift)
+  uint64_t seed = 0x9e3779b97f4a7c15ull;
+
+  for (int i = 0; i < 1000000; i++)
+  {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    x = seed;
+    y = (seed >> 32) | 1;
+
+    if (fastDiv(x, y) != x / y)
+    {
+      cout << "fastDiv(" << x << ", " << y << ") = " << fastDiv(x, y);
+      check(false);
+    }
+  }
+
+  cout << "fastDiv(x, y) = x / y for random x, y";
+  check(true);
+
+  // boundaries around the hardware division fallback
+  // and around the largest sieving prime quotients
+  for (uint64_t offset : { 0ull, 1ull, 2ull, 3ull })
+  {
+    x = ((1ull << 62) - 2) + offset;
+    for (y = 1; y <= 1000; y++)
+      if (fastDiv(x, y) != x / y)
+      {
+        cout << "fastDiv(" << x << ", " << y << ") = " << fastDiv(x, y);
+        check(false);
+      }
+  }
+
+  cout << "fastDiv(x, y) = x / y near 2^62";
+  check(true);
+
+  cout << "fastDiv(2^64 - 1, 7) = " << fastDiv(~0ull, 7);
+  check(fastDiv(~0ull, 7) == ~0ull / 7);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+///
+/// @file   generate_buffered.cpp
+/// @brief  Test allocation-free prime generation into a
+///         caller provided buffer using
+///         generate_primes_buffered()
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+void compare(uint64_t start, uint64_t stop, size_t capacity)
+{
+  vector<uint64_t> expected;
+  generate_primes(start, stop, &expected);
+
+  vector<uint64_t> buffer(capacity);
+  vector<uint64_t> primes;
+  bool overflow = false;
+
+  generate_primes_buffered(start, stop, buffer.data(), capacity,
+    [&](const uint64_t* block, size_t size)
+    {
+      overflow |= (size > capacity);
+      primes.insert(primes.end(), block, block + size);
+    });
+
+  cout << "Primes inside [" << start << ", " << stop << "]: " << primes.size();
+  check(!overflow && primes == expected);
+}
+
+int main()
+{
+  compare(0, 3000000, 64);
+  compare(0, 3000000, 1000);
+  compare(999000, 2000000, 4096);
+  compare(0, 310, 64);
+  compare(100, 100, 64);
+
+  // empty interval, the callback must not be invoked
+  uint64_t buffer[64];
+  bool invoked = false;
+  generate_primes_buffered(1000, 100, buffer, 64,
+    [&](const uint64_t*, size_t) { invoked = true; });
+  cout << "Empty interval, callback invoked: " << invoked;
+  check(!invoked);
+
+  // buffers below 64 primes are rejected
+  bool caught = false;
+  try { generate_primes_buffered(0, 100, buffer, 63,
+          [](const uint64_t*, size_t) { }); }
+  catch (primesieve_error&) { caught = true; }
+  cout << "Too small buffer throws: " << caught;
+  check(caught);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
@@ -0,0 +1,93 @@
+///
+/// @file   generate_ktuplets.cpp
+/// @brief  Test generate_ktuplets(): programmatic retrieval
+///         of the prime k-tuplet first members
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/PrimeSieve.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  uint64_t stop = 2000000;
+
+  // reference: twins computed from the primes themselves
+  vector<uint64_t> primes;
+  generate_primes(0, stop + 2, &primes);
+  vector<uint64_t> twinsRef;
+
+  for (size_t i = 0; i + 1 < primes.size(); i++)
+    if (primes[i + 1] - primes[i] == 2 &&
+        primes[i + 1] <= stop)
+      twinsRef.push_back(primes[i]);
+
+  vector<uint64_t> twins;
+  generate_ktuplets(2, 0, stop, &twins);
+
+  cout << "Twin primes <= " << stop << ": " << twins.size();
+  check(twins == twinsRef);
+
+  cout << "Twins below 10: ";
+  vector<uint64_t> smallTwins;
+  generate_ktuplets(2, 0, 10, &smallTwins);
+  check(smallTwins == vector<uint64_t>{ 3, 5 });
+
+  // the k-tuplet counts of PrimeSieve
+  // must match the generated vectors
+  for (int k = 2; k <= 6; k++)
+  {
+    vector<uint64_t> kTuplets;
+    generate_ktuplets(k, 0, stop, &kTuplets);
+
+    PrimeSieve ps;
+    ps.sieve(0, stop, COUNT_PRIMES << (k - 1));
+    cout << k << "-tuplets <= " << stop << ": " << kTuplets.size();
+    check(kTuplets.size() == ps.getCount(k - 1) &&
+          is_sorted(kTuplets.begin(), kTuplets.end()));
+  }
+
+  // subrange starts must not re-find tuplets
+  // below start or miss tuplets above it
+  {
+    vector<uint64_t> part1;
+    vector<uint64_t> part2;
+    generate_ktuplets(2, 0, 1000003, &part1);
+    generate_ktuplets(2, 1000004, stop, &part2);
+    part1.insert(part1.end(), part2.begin(), part2.end());
+
+    cout << "Split ranges match single range";
+    check(part1 == twinsRef);
+  }
+
+  bool caught = false;
+  try { vector<uint64_t> v; generate_ktuplets(7, 0, 100, &v); }
+  catch (primesieve_error&) { caught = true; }
+  cout << "Invalid k throws: " << caught;
+  check(caught);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
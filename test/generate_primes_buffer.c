@@ -0,0 +1,97 @@
+///
+/// @file   generate_primes_buffer.c
+/// @brief  Test zero-copy prime generation into a caller
+///         owned buffer using primesieve_generate_primes_buffer()
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void check(int OK)
+{
+  if (OK)
+    printf("   OK\n");
+  else
+  {
+    printf("   ERROR\n");
+    exit(1);
+  }
+}
+
+int main()
+{
+  uint64_t start = 0;
+  uint64_t stop = 1000000;
+  size_t size_ref;
+  size_t capacity;
+  size_t size;
+  size_t i;
+
+  uint64_t* primes_ref = (uint64_t*) primesieve_generate_primes(start, stop, &size_ref, UINT64_PRIMES);
+
+  capacity = primesieve_count_approx(start, stop);
+  printf("primesieve_count_approx(0, 10^6) = %zu", capacity);
+  check(capacity >= size_ref);
+
+  uint64_t* primes = (uint64_t*) malloc(capacity * sizeof(uint64_t));
+  size = primesieve_generate_primes_buffer(start, stop, primes, capacity, UINT64_PRIMES);
+  printf("Primes inside [0, 10^6] = %zu", size);
+  check(size == size_ref);
+
+  for (i = 0; i < size; i++)
+  {
+    if (primes[i] != primes_ref[i])
+    {
+      printf("primes[%zu] = %" PRIu64 "   ERROR", i, primes[i]);
+      exit(1);
+    }
+  }
+
+  printf("All primes match the primesieve_generate_primes() output");
+  check(1);
+
+  // int32_t primes into a caller owned buffer
+  int32_t* primes32 = (int32_t*) malloc(capacity * sizeof(int32_t));
+  size = primesieve_generate_primes_buffer(start, stop, primes32, capacity, INT32_PRIMES);
+  check(size == size_ref);
+
+  for (i = 0; i < size; i++)
+  {
+    if ((uint64_t) primes32[i] != primes_ref[i])
+    {
+      printf("primes32[%zu] = %d   ERROR", i, primes32[i]);
+      exit(1);
+    }
+  }
+
+  // a too small buffer must fail with errno = EDOM
+  errno = 0;
+  size = primesieve_generate_primes_buffer(start, stop, primes, 100, UINT64_PRIMES);
+  printf("Too small buffer fails: %d", errno == EDOM);
+  check(size == (size_t) ~((size_t) 0) && errno == EDOM);
+
+  // empty interval
+  size = primesieve_generate_primes_buffer(1000, 100, primes, capacity, UINT64_PRIMES);
+  printf("Primes inside [1000, 100] = %zu", size);
+  check(size == 0);
+
+  free(primes32);
+  free(primes);
+  primesieve_free(primes_ref);
+
+  printf("\n");
+  printf("All tests passed successfully!\n");
+
+  return 0;
+}
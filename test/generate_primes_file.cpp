@@ -0,0 +1,93 @@
+///
+/// @file   generate_primes_file.cpp
+/// @brief  Test generate_primes_file() which decodes primes
+///         directly into a memory-mapped file of raw 64-bit
+///         primes. The range is chosen so the file spans
+///         multiple 2^20 prime mapping windows, exercising
+///         the carry over of primes at the window tails.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+/// Read a file of raw 64-bit primes back into a vector
+vector<uint64_t> readFile(const string& filePath)
+{
+  ifstream file(filePath, ifstream::binary | ifstream::ate);
+  check(!!file);
+
+  size_t bytes = (size_t) file.tellg();
+  check(bytes % 8 == 0);
+
+  vector<uint64_t> primes(bytes / 8);
+  file.seekg(0);
+  file.read((char*) primes.data(), bytes);
+  return primes;
+}
+
+int main()
+{
+  const string filePath = "primes.raw";
+
+  // pi(4*10^7) = 2433654 > 2 * 2^20, the
+  // file spans 3 mapping windows
+  uint64_t start = 0;
+  uint64_t stop = 40000000;
+
+  vector<uint64_t> primes;
+  generate_primes(start, stop, &primes);
+
+  uint64_t count = generate_primes_file(start, stop, filePath);
+  cout << "generate_primes_file(" << start << ", " << stop << ") = " << count;
+  check(count == primes.size());
+
+  vector<uint64_t> filePrimes = readFile(filePath);
+  cout << "File size matches the prime count";
+  check(filePrimes.size() == count);
+  cout << "File primes match generate_primes()";
+  check(filePrimes == primes);
+
+  // subrange not starting at 0
+  primes.clear();
+  generate_primes(1000000ull, 2000000ull, &primes);
+  count = generate_primes_file(1000000, 2000000, filePath);
+  cout << "generate_primes_file(10^6, 2*10^6) = " << count;
+  check(count == primes.size());
+  cout << "File primes match generate_primes()";
+  check(readFile(filePath) == primes);
+
+  // empty interval
+  count = generate_primes_file(20, 10, filePath);
+  cout << "generate_primes_file(20, 10) = " << count;
+  check(count == 0);
+  cout << "File is empty";
+  check(readFile(filePath).empty());
+
+  remove(filePath.c_str());
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
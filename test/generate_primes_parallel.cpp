@@ -0,0 +1,73 @@
+///
+/// @file   generate_primes_parallel.cpp
+/// @brief  Test multi-threaded prime generation
+///         using generate_primes_parallel().
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  vector<uint64_t> primes1;
+  vector<uint64_t> primes2;
+
+  // must match the single-threaded generation
+  primesieve::generate_primes(0, 10000000, &primes1);
+  primesieve::generate_primes_parallel(0, 10000000, &primes2);
+
+  cout << "Primes below 10^7 = " << primes2.size();
+  check(primes2.size() == 664579);
+
+  cout << "primes == generate_primes(10^7)";
+  check(primes1 == primes2);
+
+  // results are appended to the vector
+  primesieve::generate_primes(10000000, 20000000, &primes1);
+  primesieve::generate_primes_parallel(10000000, 20000000, &primes2);
+
+  cout << "Primes below 2 * 10^7 = " << primes2.size();
+  check(primes2.size() == 1270607);
+
+  cout << "primes == generate_primes(2 * 10^7)";
+  check(primes1 == primes2);
+
+  // large start, small distance
+  primes1.clear();
+  primes2.clear();
+  uint64_t start = 1000000000000ull;
+  primesieve::generate_primes(start, start + 100000, &primes1);
+  primesieve::generate_primes_parallel(start, start + 100000, &primes2);
+
+  cout << "primes == generate_primes(10^12, 10^12 + 10^5)";
+  check(primes1 == primes2);
+
+  // empty interval
+  primesieve::generate_primes_parallel(20, 10, &primes2);
+
+  cout << "generate_primes_parallel(20, 10) generates no primes";
+  check(primes2 == primes1);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
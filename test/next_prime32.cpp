@@ -0,0 +1,73 @@
+///
+/// @file   next_prime32.cpp
+/// @brief  Test next_prime() of primesieve::iterator32.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  vector<uint64_t> primes;
+  primesieve::generate_primes(100000, &primes);
+  primesieve::iterator32 it;
+  uint64_t stop = primes.size() - 1;
+  uint32_t prime;
+
+  for (uint64_t i = 0; i < stop; i++)
+  {
+    it.skipto(primes[i] - 1);
+    prime = it.next_prime();
+    cout << "next_prime(" << primes[i] - 1 << ") = " << prime;
+    check(prime == primes[i]);
+  }
+
+  it.skipto(0);
+  prime = it.next_prime();
+  uint64_t sum = 0;
+
+  // iterate over the primes below 10^8
+  for (; prime < 100000000; prime = it.next_prime())
+    sum += prime;
+
+  cout << "Sum of the primes below 10^8 = " << sum;
+  check(sum == 279209790387276ull);
+
+  // largest prime < 2^32 is 4294967291
+  it.skipto(4294967290ull);
+  prime = it.next_prime();
+  cout << "next_prime(4294967290) = " << prime;
+  check(prime == 4294967291u);
+
+  // no more primes < 2^32
+  prime = it.next_prime();
+  cout << "next_prime(4294967291) = " << prime;
+  check(prime == ~0u);
+
+  prime = it.next_prime();
+  cout << "next_prime(2^32) = " << prime;
+  check(prime == ~0u);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
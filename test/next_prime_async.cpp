@@ -0,0 +1,65 @@
+///
+/// @file   next_prime_async.cpp
+/// @brief  Test the asynchronous (double buffered) mode
+///         of primesieve::iterator.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  primesieve::iterator it;
+  it.set_async();
+  uint64_t prime = it.next_prime();
+  uint64_t sum = 0;
+
+  // iterate over the primes below 10^8
+  for (; prime < 100000000; prime = it.next_prime())
+    sum += prime;
+
+  cout << "Sum of the primes below 10^8 = " << sum;
+  check(sum == 279209790387276ull);
+
+  // restarting must discard the primes
+  // sieved in the background
+  it.skipto(1000);
+  prime = it.next_prime();
+  cout << "next_prime(1000) = " << prime;
+  check(prime == 1009);
+
+  // switching to prev_prime() must also work
+  // while a background sieve is in flight
+  prime = it.prev_prime();
+  cout << "prev_prime(1009) = " << prime;
+  check(prime == 997);
+
+  // disabling async mode restarts from
+  // the last returned prime
+  it.set_async(false);
+  prime = it.next_prime();
+  cout << "next_prime(997) = " << prime;
+  check(prime == 1009);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
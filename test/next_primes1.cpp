@@ -0,0 +1,82 @@
+///
+/// @file   next_primes1.cpp
+/// @brief  Test the zero-copy block interface
+///         next_primes() of primesieve::iterator.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  primesieve::iterator it;
+  uint64_t sum = 0;
+  uint64_t n = 0;
+  bool done = false;
+
+  // sum the primes below 10^8 one block at a time
+  while (!done)
+  {
+    size_t size;
+    const uint64_t* primes = it.next_primes(&size);
+
+    for (size_t i = 0; i < size; i++)
+    {
+      if (primes[i] >= 100000000)
+      {
+        done = true;
+        break;
+      }
+      sum += primes[i];
+      n++;
+    }
+  }
+
+  cout << "Sum of the primes below 10^8 = " << sum;
+  check(sum == 279209790387276ull);
+
+  cout << "Count of the primes below 10^8 = " << n;
+  check(n == 5761455);
+
+  // next_primes() must return the unconsumed
+  // part of the current block
+  it.skipto(0);
+  uint64_t prime = it.next_prime();
+  cout << "next_prime(0) = " << prime;
+  check(prime == 2);
+
+  size_t size;
+  const uint64_t* primes = it.next_primes(&size);
+  cout << "next_primes()[0] = " << primes[0];
+  check(primes[0] == 3);
+
+  // mixing with next_prime() must continue
+  // after the returned block
+  uint64_t last = primes[size - 1];
+  prime = it.next_prime();
+  cout << "next_prime(" << last << ") > " << last;
+  check(prime > last);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file   next_primes2.c
+ * @brief  Test the block interface primesieve_next_primes()
+ *         of primesieve_iterator.
+ *
+ * Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+ *
+ * This file is distributed under the BSD License. See the COPYING
+ * file in the top level directory.
+ */
+
+#include <primesieve.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+
+void check(int OK)
+{
+  if (OK)
+    printf("   OK\n");
+  else
+  {
+    printf("   ERROR\n");
+    exit(1);
+  }
+}
+
+int main()
+{
+  primesieve_iterator it;
+  primesieve_init(&it);
+
+  uint64_t sum = 0;
+  uint64_t n = 0;
+  int done = 0;
+
+  /* sum the primes below 10^8 one block at a time */
+  while (!done)
+  {
+    size_t size;
+    size_t i;
+    const uint64_t* primes = primesieve_next_primes(&it, &size);
+
+    for (i = 0; i < size; i++)
+    {
+      if (primes[i] >= 100000000ull)
+      {
+        done = 1;
+        break;
+      }
+      sum += primes[i];
+      n++;
+    }
+  }
+
+  printf("Sum of the primes below 10^8 = %" PRIu64, sum);
+  check(sum == 279209790387276ull);
+
+  printf("Count of the primes below 10^8 = %" PRIu64, n);
+  check(n == 5761455);
+
+  /* mixing with primesieve_next_prime() must work */
+  primesieve_skipto(&it, 0, 1000);
+  uint64_t prime = primesieve_next_prime(&it);
+  printf("next_prime(0) = %" PRIu64, prime);
+  check(prime == 2);
+
+  size_t size;
+  const uint64_t* primes = primesieve_next_primes(&it, &size);
+  printf("next_primes()[0] = %" PRIu64, primes[0]);
+  check(primes[0] == 3);
+
+  uint64_t last = primes[size - 1];
+  prime = primesieve_next_prime(&it);
+  printf("next_prime(%" PRIu64 ") > %" PRIu64, last, last);
+  check(prime > last);
+
+  primesieve_free_iterator(&it);
+
+  printf("\nAll tests passed successfully!\n");
+
+  return 0;
+}
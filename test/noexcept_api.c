@@ -0,0 +1,91 @@
+///
+/// @file   noexcept_api.c
+/// @brief  Test the status code returning *_noexcept()
+///         variants of the C API
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void check(int OK)
+{
+  if (OK)
+    printf("   OK\n");
+  else
+  {
+    printf("   ERROR\n");
+    exit(1);
+  }
+}
+
+int main()
+{
+  uint64_t count = 0;
+  uint64_t prime = 0;
+  size_t size = 0;
+  size_t i;
+  int status;
+
+  status = primesieve_count_primes_noexcept(0, 1000000, &count);
+  printf("PrimePi(10^6) = %" PRIu64, count);
+  check(status == 0 && count == 78498);
+
+  status = primesieve_nth_prime_noexcept(78498, 0, &prime);
+  printf("nth_prime(78498) = %" PRIu64, prime);
+  check(status == 0 && prime == 999983);
+
+  size_t capacity = primesieve_count_approx(0, 100000);
+  uint64_t* primes = (uint64_t*) malloc(capacity * sizeof(uint64_t));
+  status = primesieve_generate_primes_buffer_noexcept(0, 100000, primes, capacity, UINT64_PRIMES, &size);
+  printf("Primes inside [0, 10^5] = %zu", size);
+  check(status == 0 && size == 9592);
+
+  // a too small buffer must fail with a non-zero status
+  status = primesieve_generate_primes_buffer_noexcept(0, 100000, primes, 100, UINT64_PRIMES, &size);
+  printf("Too small buffer fails: %d", status);
+  check(status != 0 && size == 0);
+
+  // block iteration via the status code variant
+  primesieve_iterator it;
+  primesieve_init(&it);
+  const uint64_t* block;
+  uint64_t sum = 0;
+  uint64_t n = 0;
+
+  while (n < 9592)
+  {
+    status = primesieve_next_primes_noexcept(&it, &block, &size);
+    if (status != 0)
+    {
+      printf("primesieve_next_primes_noexcept   ERROR\n");
+      exit(1);
+    }
+    for (i = 0; i < size && n < 9592; i++, n++)
+      sum += block[i];
+  }
+
+  status = primesieve_generate_primes_buffer_noexcept(0, 100000, primes, capacity, UINT64_PRIMES, &size);
+  uint64_t sum2 = 0;
+  for (i = 0; i < size; i++)
+    sum2 += primes[i];
+
+  printf("Sum of the primes below 10^5 = %" PRIu64, sum);
+  check(status == 0 && sum == sum2);
+
+  primesieve_free_iterator(&it);
+  free(primes);
+
+  printf("\n");
+  printf("All tests passed successfully!\n");
+
+  return 0;
+}
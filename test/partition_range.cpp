@@ -0,0 +1,126 @@
+///
+/// @file   partition_range.cpp
+/// @brief  Test the partition_range() API: the subranges
+///         must cover [start, stop] without gaps or overlap
+///         and sieving them independently must yield the
+///         same counts as a single run.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/ParallelSieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+/// Check that the ranges cover [start, stop]
+/// without gaps or overlap
+bool isCovered(const vector<pair<uint64_t, uint64_t>>& ranges,
+               uint64_t start,
+               uint64_t stop)
+{
+  if (ranges.empty())
+    return false;
+  if (ranges.front().first != start)
+    return false;
+  if (ranges.back().second != stop)
+    return false;
+
+  for (size_t i = 0; i < ranges.size(); i++)
+  {
+    if (ranges[i].first > ranges[i].second)
+      return false;
+    if (i > 0 && ranges[i].first != ranges[i - 1].second + 1)
+      return false;
+  }
+
+  return true;
+}
+
+int main()
+{
+  int flags = COUNT_PRIMES |
+              COUNT_TWINS |
+              COUNT_TRIPLETS |
+              COUNT_QUADRUPLETS |
+              COUNT_QUINTUPLETS |
+              COUNT_SEXTUPLETS;
+
+  {
+    // awkward (non-aligned) range borders
+    uint64_t start = 1000003;
+    uint64_t stop = 9999991;
+    auto ranges = partition_range(start, stop, 7);
+
+    cout << "Subranges cover [" << start << ", " << stop << "]";
+    check(isCovered(ranges, start, stop));
+
+    cout << "At most 7 subranges (" << ranges.size() << ")";
+    check(ranges.size() <= 7);
+
+    ParallelSieve ps;
+    ps.sieve(start, stop, flags);
+    auto total = ps.getCounts();
+
+    counts_t sums;
+    sums.fill(0);
+
+    for (auto& range : ranges)
+    {
+      ParallelSieve shard;
+      shard.sieve(range.first, range.second, flags);
+      for (size_t i = 0; i < sums.size(); i++)
+        sums[i] += shard.getCount((int) i);
+    }
+
+    for (size_t i = 0; i < sums.size(); i++)
+    {
+      cout << "Summed count " << i << ": " << sums[i]
+           << " = " << total[i];
+      check(sums[i] == total[i]);
+    }
+  }
+
+  {
+    // more parts than the distance allows,
+    // the coverage must still be exact
+    auto ranges = partition_range(100, 130, 50);
+    cout << "Tiny range is covered";
+    check(isCovered(ranges, 100, 130));
+  }
+
+  {
+    auto ranges = partition_range(0, 1000, 1);
+    cout << "1 part returns [start, stop]";
+    check(ranges.size() == 1 &&
+          isCovered(ranges, 0, 1000));
+  }
+
+  {
+    auto ranges = partition_range(1000, 0, 4);
+    cout << "start > stop returns no subranges";
+    check(ranges.empty());
+  }
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
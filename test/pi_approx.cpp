@@ -0,0 +1,116 @@
+///
+/// @file   pi_approx.cpp
+/// @brief  Test the pi(x) and nth prime approximations in
+///         pmath.hpp: li(x), liInverse(n), riemannR(x),
+///         riemannRInverse(n) and primeCountApprox() must
+///         stay within their documented error bounds and
+///         primeCountApprox() must not under-allocate.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/pmath.hpp>
+
+#include <stdint.h>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace primesieve;
+
+#if __cplusplus >= 201402L
+
+// the approximations must also work at compile time
+static_assert(ctSqrt(1e18) > 999999999.0, "ctSqrt(10^18) failed");
+static_assert(ctLog(2.718281828459045) > 0.999999, "ctLog(e) failed");
+static_assert(ctLog(2.718281828459045) < 1.000001, "ctLog(e) failed");
+static_assert(riemannR(100000000.0) > 5700000.0, "riemannR(10^8) failed");
+static_assert(primeCountApprox(100000000ull) >= 5761455, "primeCountApprox(10^8) failed");
+
+#endif
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  // known pi(10^i) values for i = 7, ..., 16
+  uint64_t pix[] =
+  {
+    664579ull,
+    5761455ull,
+    50847534ull,
+    455052511ull,
+    4118054813ull,
+    37607912018ull,
+    346065536839ull,
+    3204941750802ull,
+    29844570422669ull,
+    279238341033925ull
+  };
+
+  double x = 10000000.0;
+
+  for (uint64_t pi : pix)
+  {
+    double liError = abs(li(x) - (double) pi);
+    double rError = abs(riemannR(x) - (double) pi);
+
+    // |li(x) - pi(x)| < sqrt(x) for all x <= 10^19
+    cout << "|li(" << x << ") - pi(x)| = " << liError;
+    check(liError < sqrt(x));
+
+    // riemannR(x) approximates pi(x) more
+    // accurately than li(x)
+    cout << "|riemannR(" << x << ") - pi(x)| = " << rError;
+    check(rError < liError);
+
+    // the inverse functions must round trip onto their
+    // forward functions, the tolerance scales with n as
+    // li(x) carries a relative error of ~10^-15
+    double n = (double) pi;
+    double eps = 1 + n * 1e-14;
+
+    cout << "li(liInverse(" << n << ")) = " << li(liInverse(n));
+    check(abs(li(liInverse(n)) - n) < eps);
+
+    cout << "riemannR(riemannRInverse(" << n << ")) = " << riemannR(riemannRInverse(n));
+    check(abs(riemannR(riemannRInverse(n)) - n) < eps);
+
+    x *= 10;
+  }
+
+  // primeCountApprox() is used to size vectors upfront,
+  // it must not fall below the real prime count but also
+  // stay tight (the old formula over-allocated up to 10%)
+  uint64_t ranges[][2] =
+  {
+    { 0ull, 100000000ull },
+    { 1000000000000ull, 1000000000000ull + 100000000 }
+  };
+
+  for (auto& range : ranges)
+  {
+    uint64_t count = count_primes(range[0], range[1]);
+    uint64_t approx = primeCountApprox(range[0], range[1]);
+
+    cout << "primeCountApprox(" << range[0] << ", " << range[1] << ") = " << approx
+         << " (count = " << count << ")";
+    check(approx >= count &&
+          approx - count <= count / 100 + 2000);
+  }
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
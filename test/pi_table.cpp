@@ -0,0 +1,64 @@
+///
+/// @file   pi_table.cpp
+/// @brief  Test the pi(x) checkpoint table used by
+///         count_primes(0, stop)
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/PrimeSieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  // count_primes(0, stop) with stop >= 10^9 uses
+  // the pi(x) checkpoint table
+  uint64_t stop = 1200000000ull;
+
+  PrimeSieve ps;
+  uint64_t count1 = ps.countPrimes(0, stop);
+  uint64_t count2 = count_primes(0, stop);
+  cout << "pi(" << stop << ") = " << count2;
+  check(count2 == count1);
+
+  // 2nd query is answered from the table
+  uint64_t count3 = count_primes(0, stop);
+  cout << "pi(" << stop << ") = " << count3;
+  check(count3 == count1);
+
+  // residual subrange above the largest checkpoint
+  stop = 2500000000ull;
+  uint64_t count4 = count_primes(0, stop);
+  uint64_t count5 = ps.countPrimes(0, stop);
+  cout << "pi(" << stop << ") = " << count4;
+  check(count4 == count5);
+
+  // checkpoint boundary
+  stop = 2000000000ull;
+  uint64_t count6 = count_primes(0, stop);
+  uint64_t count7 = ps.countPrimes(0, stop);
+  cout << "pi(" << stop << ") = " << count6;
+  check(count6 == count7);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
@@ -0,0 +1,63 @@
+///
+/// @file   prev_prime3.cpp
+/// @brief  Test alternating next_prime() / prev_prime()
+///         direction changes which are served from the
+///         iterator's block cache.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  vector<uint64_t> primes;
+  primesieve::generate_primes(2000000, &primes);
+
+  // start in the middle of the range
+  uint64_t i = primes.size() / 2;
+  primesieve::iterator it(primes[i]);
+  uint64_t prime;
+
+  // alternate directions with growing stride, like a
+  // prime gap search does, each flip used to re-sieve
+  // an entire block
+  for (uint64_t stride = 1; stride < 5000; stride *= 3)
+  {
+    for (uint64_t j = 0; j < stride; j++)
+    {
+      prime = it.next_prime();
+      i++;
+      check(prime == primes[i]);
+    }
+
+    for (uint64_t j = 0; j < stride * 2; j++)
+    {
+      prime = it.prev_prime();
+      i--;
+      check(prime == primes[i]);
+    }
+  }
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
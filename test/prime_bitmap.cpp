@@ -0,0 +1,124 @@
+///
+/// @file   prime_bitmap.cpp
+/// @brief  Test the PrimeBitmap class: compressed prime
+///         indicator bitmaps built from the sieve array
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/PrimeBitmap.hpp>
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  uint64_t start = 0;
+  uint64_t stop = 2000000;
+
+  vector<uint64_t> primes;
+  generate_primes(start, stop, &primes);
+
+  PrimeBitmap bitmap = PrimeBitmap::sieve(start, stop);
+
+  cout << "Bitmap count: " << bitmap.count();
+  check(bitmap.count() == primes.size());
+
+  cout << "Bitmap is smaller than the uint64_t list";
+  check(bitmap.byteSize() < primes.size() * 8);
+
+  vector<uint64_t> decoded;
+  bitmap.decode(decoded);
+  cout << "Decoded primes match generate_primes()";
+  check(decoded == primes);
+
+  bool ok = true;
+  for (uint64_t n = 0; n < 1000; n++)
+  {
+    bool isPrime = binary_search(primes.begin(), primes.end(), n);
+    ok &= (bitmap.contains(n) == isPrime);
+  }
+  cout << "contains() matches for all n < 1000";
+  check(ok);
+
+  {
+    // intersecting with an overlapping bitmap keeps
+    // exactly the primes of the overlap
+    uint64_t low = 500000;
+    uint64_t high = 3000000;
+    PrimeBitmap other = PrimeBitmap::sieve(low, high);
+    PrimeBitmap overlap = bitmap;
+    overlap.intersect(other);
+
+    cout << "Intersection count: " << overlap.count();
+    check(overlap.count() == count_primes(low, stop));
+
+    cout << "Intersection bounds: [" << overlap.start()
+         << ", " << overlap.stop() << "]";
+    check(overlap.start() == low && overlap.stop() == stop);
+  }
+
+  {
+    const string filePath = "primes.bitmap";
+    bitmap.save(filePath);
+    PrimeBitmap loaded = PrimeBitmap::load(filePath);
+    remove(filePath.c_str());
+
+    vector<uint64_t> loadedPrimes;
+    loaded.decode(loadedPrimes);
+    cout << "Save/load roundtrip preserves the primes";
+    check(loadedPrimes == primes);
+  }
+
+  {
+    // a short interval fills its windows only sparsely,
+    // such windows use the compact array encoding
+    uint64_t n = 1000000000;
+    PrimeBitmap sparse = PrimeBitmap::sieve(n, n + 10000);
+    vector<uint64_t> sparsePrimes;
+    sparse.decode(sparsePrimes);
+
+    vector<uint64_t> expected;
+    generate_primes(n, n + 10000, &expected);
+
+    cout << "Sparse bitmap decodes correctly";
+    check(sparsePrimes == expected);
+
+    cout << "Sparse bitmap is compact (" << sparse.byteSize() << " bytes)";
+    check(sparse.byteSize() < expected.size() * 8);
+
+    // array container x bitmap container
+    PrimeBitmap dense = PrimeBitmap::sieve(n, n + 200000);
+    dense.intersect(sparse);
+    cout << "Array x bitmap intersection count: " << dense.count();
+    check(dense.count() == expected.size());
+
+    // array container x array container
+    PrimeBitmap shifted = PrimeBitmap::sieve(n + 5000, n + 20000);
+    shifted.intersect(sparse);
+    cout << "Array x array intersection count: " << shifted.count();
+    check(shifted.count() == count_primes(n + 5000, n + 10000));
+  }
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
@@ -0,0 +1,84 @@
+///
+/// @file   prime_file.cpp
+/// @brief  Test the on-disk prime store: store_primes_file()
+///         and the PrimeFile reader
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/PrimeFile.hpp>
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  const string filePath = "primes.store";
+  uint64_t start = 0;
+  uint64_t stop = 2000000;
+
+  vector<uint64_t> primes;
+  generate_primes(start, stop, &primes);
+  store_primes_file(start, stop, filePath);
+
+  PrimeFile file(filePath);
+  cout << "PrimeFile count = " << file.count();
+  check(file.count() == primes.size());
+  cout << "PrimeFile start = " << file.start();
+  check(file.start() == start);
+  cout << "PrimeFile stop = " << file.stop();
+  check(file.stop() == stop);
+
+  // read back the whole file
+  vector<uint64_t> primes2;
+  file.read(start, stop, primes2);
+  cout << "PrimeFile read [" << start << ", " << stop << "]";
+  check(primes2 == primes);
+
+  // random access subrange crossing block boundaries
+  vector<uint64_t> primes3;
+  vector<uint64_t> primes4;
+  file.read(1000003, 1500000, primes3);
+  generate_primes(1000003ull, 1500000ull, &primes4);
+  cout << "PrimeFile read [1000003, 1500000]";
+  check(primes3 == primes4);
+
+  // iterator-style access
+  file.jumpTo(999983);
+  uint64_t prime = file.nextPrime();
+  cout << "PrimeFile nextPrime() = " << prime;
+  check(prime == 999983);
+  prime = file.nextPrime();
+  cout << "PrimeFile nextPrime() = " << prime;
+  check(prime == 1000003);
+
+  // past the last prime
+  file.jumpTo(stop);
+  prime = file.nextPrime();
+  cout << "PrimeFile nextPrime() = " << prime;
+  check(prime == 0);
+
+  remove(filePath.c_str());
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
@@ -0,0 +1,122 @@
+///
+/// @file   prime_gaps.cpp
+/// @brief  Test prime_gaps() against a brute force
+///         implementation that iterates next_prime() and
+///         subtracts, including the parallel chunk boundary
+///         stitching.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+/// Brute force reference: iterate the
+/// primes and subtract
+PrimeGaps primeGapsSlow(uint64_t start, uint64_t stop)
+{
+  PrimeGaps result;
+  // iterator(n) generates primes > n
+  primesieve::iterator it(start - (start > 0), stop);
+  uint64_t prev = 0;
+
+  for (uint64_t prime = it.next_prime(); prime <= stop; prime = it.next_prime())
+  {
+    if (prev)
+    {
+      uint64_t gap = prime - prev;
+      if (gap >= result.histogram.size())
+        result.histogram.resize(gap + 1, 0);
+      result.histogram[gap]++;
+      if (gap > result.maxGap)
+      {
+        result.maxGap = gap;
+        result.maxGapStart = prev;
+        result.records.emplace_back(prev, gap);
+      }
+    }
+    prev = prime;
+  }
+
+  return result;
+}
+
+bool equal(const PrimeGaps& a, const PrimeGaps& b)
+{
+  return a.maxGap == b.maxGap &&
+         a.maxGapStart == b.maxGapStart &&
+         a.histogram == b.histogram &&
+         a.records == b.records;
+}
+
+int main()
+{
+  // the maximal gaps <= 1000 are well known:
+  // 1 (2), 2 (3), 4 (7), 6 (23), 8 (89),
+  // 14 (113), 18 (523), 20 (887)
+  PrimeGaps gaps = prime_gaps(0, 1000);
+  cout << "prime_gaps(0, 1000).maxGap = " << gaps.maxGap;
+  check(gaps.maxGap == 20);
+  cout << "prime_gaps(0, 1000).maxGapStart = " << gaps.maxGapStart;
+  check(gaps.maxGapStart == 887);
+  cout << "prime_gaps(0, 1000).records.size() = " << gaps.records.size();
+  check(gaps.records.size() == 8);
+  cout << "prime_gaps(0, 1000) == brute force";
+  check(equal(gaps, primeGapsSlow(0, 1000)));
+
+  gaps = prime_gaps(1000000, 2000000);
+  cout << "prime_gaps(10^6, 2*10^6) == brute force";
+  check(equal(gaps, primeGapsSlow(1000000, 2000000)));
+
+  // no primes, single prime: no gaps
+  gaps = prime_gaps(24, 28);
+  cout << "prime_gaps(24, 28) is empty";
+  check(gaps.maxGap == 0 && gaps.histogram.empty() && gaps.records.empty());
+  gaps = prime_gaps(89, 89);
+  cout << "prime_gaps(89, 89) is empty";
+  check(gaps.maxGap == 0 && gaps.histogram.empty() && gaps.records.empty());
+
+  // the parallel chunked run must stitch the chunk
+  // boundaries so that it exactly matches a serial run.
+  // The largest gap < 10^8 is 220, following 47326693
+  int threads = get_num_threads();
+  set_num_threads(1);
+  PrimeGaps serial = prime_gaps(0, 100000000);
+  set_num_threads(threads);
+  PrimeGaps parallel = prime_gaps(0, 100000000);
+  cout << "prime_gaps(0, 10^8).maxGap = " << parallel.maxGap;
+  check(parallel.maxGap == 220);
+  cout << "prime_gaps(0, 10^8).maxGapStart = " << parallel.maxGapStart;
+  check(parallel.maxGapStart == 47326693);
+  cout << "parallel run == serial run";
+  check(equal(parallel, serial));
+
+  uint64_t numGaps = 0;
+  for (uint64_t count : parallel.histogram)
+    numGaps += count;
+  cout << "number of gaps = PrimePi(10^8) - 1";
+  check(numGaps == count_primes(0, 100000000) - 1);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
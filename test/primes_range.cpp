@@ -0,0 +1,98 @@
+///
+/// @file   primes_range.cpp
+/// @brief  Test the primes_range lazy range: range-based for
+///         loops, standard algorithms and (when compiled as
+///         C++20) std::ranges pipelines must yield the same
+///         primes as generate_primes().
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#if defined(__cpp_lib_ranges)
+  #include <ranges>
+#endif
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  vector<uint64_t> primes1;
+  generate_primes(0, 1000000, &primes1);
+
+  // range-based for loop
+  vector<uint64_t> primes2;
+  for (uint64_t prime : primes(1000000))
+    primes2.push_back(prime);
+
+  cout << "primes(10^6) yields " << primes2.size() << " primes";
+  check(primes2 == primes1);
+
+  // standard algorithms over the input iterators
+  auto range = primes(100, 200);
+  cout << "std::distance(primes(100, 200)) = "
+       << distance(range.begin(), range.end());
+  check(distance(range.begin(), range.end()) == 21);
+
+  vector<uint64_t> primes3;
+  auto range2 = primes(1000000000000ull, 1000000001000ull);
+  copy(range2.begin(), range2.end(), back_inserter(primes3));
+  primes1.clear();
+  generate_primes(1000000000000ull, 1000000001000ull, &primes1);
+
+  cout << "std::copy(primes(10^12, 10^12 + 1000))";
+  check(primes3 == primes1);
+
+  // empty range
+  cout << "primes(24, 28) is empty";
+  check(primes(24, 28).begin() == primes(24, 28).end());
+
+#if defined(__cpp_lib_ranges)
+
+  static_assert(ranges::input_range<primes_range>,
+                "primes_range must model std::ranges::input_range");
+  static_assert(ranges::borrowed_range<primes_range>,
+                "primes_range iterators outlive the range");
+
+  // std::ranges pipeline over an rvalue range
+  uint64_t count = 0;
+  for (uint64_t prime : primes(0, 1000) | views::filter([](uint64_t p) { return p % 10 == 3; }))
+  {
+    (void) prime;
+    count++;
+  }
+
+  vector<uint64_t> primes4;
+  generate_primes(0, 1000, &primes4);
+  uint64_t count2 = count_if(primes4.begin(), primes4.end(),
+                             [](uint64_t p) { return p % 10 == 3; });
+
+  cout << "primes(0, 1000) | views::filter = " << count;
+  check(count == count2);
+
+#endif
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
@@ -0,0 +1,81 @@
+///
+/// @file   progress_callback.cpp
+/// @brief  Test the progress callback API
+///         PrimeSieve::setProgressCallback()
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve/ParallelSieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  {
+    // interval 0 invokes the callback on
+    // every status update
+    vector<double> percents;
+    ParallelSieve ps;
+    ps.setNumThreads(1);
+    ps.setProgressCallback([&](double percent) {
+      percents.push_back(percent);
+    }, 0);
+
+    uint64_t count = ps.countPrimes(0, 100000000);
+    cout << "Primes below 10^8: " << count;
+    check(count == 5761455);
+
+    cout << "Callback has been invoked";
+    check(!percents.empty());
+
+    cout << "Last reported status is 100%";
+    check(percents.back() == 100.0);
+
+    bool inRange = true;
+    for (double percent : percents)
+      inRange &= (percent >= 0.0 && percent <= 100.0);
+    cout << "All statuses are inside [0, 100]";
+    check(inRange);
+  }
+
+  {
+    // a rate limit (much) larger than the sieving
+    // time coalesces all chunk updates, only the
+    // first update and the final 100% remain
+    int invocations = 0;
+    ParallelSieve ps;
+    ps.setNumThreads(ParallelSieve::getMaxThreads());
+    ps.setProgressCallback([&](double) {
+      invocations++;
+    }, 3600000);
+
+    uint64_t count = ps.countPrimes(0, 100000000);
+    cout << "Primes below 10^8: " << count;
+    check(count == 5761455);
+
+    cout << "Rate limit coalesces the updates (" << invocations << " calls)";
+    check(invocations >= 1 && invocations <= 2);
+  }
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+///
+/// @file   query_batch.cpp
+/// @brief  Test the QueryBatch class: a batch of mixed
+///         count/nth-prime/generate queries over overlapping
+///         ranges must return the same answers as the
+///         corresponding single-query API calls
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/QueryBatch.hpp>
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  QueryBatch batch;
+
+  size_t count1 = batch.addCount(0, 1000000);
+  size_t count2 = batch.addCount(500000, 1500000);
+  size_t count3 = batch.addCount(0, 5);
+  size_t count4 = batch.addCount(100, 10);
+  size_t nth1 = batch.addNthPrime(78498);
+  size_t nth2 = batch.addNthPrime(1000, 1000000);
+  size_t nth3 = batch.addNthPrime(2);
+  size_t primes1 = batch.addPrimes(999000, 1001000);
+  size_t primes2 = batch.addPrimes(0, 100);
+
+  batch.run();
+
+  cout << "Count [0, 10^6]: " << batch.count(count1);
+  check(batch.count(count1) == count_primes(0, 1000000));
+
+  cout << "Count [5*10^5, 1.5*10^6]: " << batch.count(count2);
+  check(batch.count(count2) == count_primes(500000, 1500000));
+
+  cout << "Count [0, 5]: " << batch.count(count3);
+  check(batch.count(count3) == 3);
+
+  cout << "Count empty range: " << batch.count(count4);
+  check(batch.count(count4) == 0);
+
+  cout << "78498th prime: " << batch.nthPrime(nth1);
+  check(batch.nthPrime(nth1) == nth_prime(78498));
+
+  cout << "1000th prime > 10^6: " << batch.nthPrime(nth2);
+  check(batch.nthPrime(nth2) == nth_prime(1000, 1000000));
+
+  cout << "2nd prime: " << batch.nthPrime(nth3);
+  check(batch.nthPrime(nth3) == 3);
+
+  vector<uint64_t> ref;
+  generate_primes(999000, 1001000, &ref);
+  cout << "Primes [999000, 1001000]: " << batch.primes(primes1).size();
+  check(batch.primes(primes1) == ref);
+
+  ref.clear();
+  generate_primes(0, 100, &ref);
+  cout << "Primes [0, 100]: " << batch.primes(primes2).size();
+  check(batch.primes(primes2) == ref);
+
+  // reading a query id with the wrong accessor must throw
+  bool caught = false;
+  try { batch.nthPrime(count1); }
+  catch (primesieve_error&) { caught = true; }
+  cout << "Wrong accessor throws: " << caught;
+  check(caught);
+
+  // run() may only be called once
+  caught = false;
+  try { batch.run(); }
+  catch (primesieve_error&) { caught = true; }
+  cout << "Second run() throws: " << caught;
+  check(caught);
+
+  // reading results before run() must throw
+  {
+    QueryBatch batch2;
+    size_t id = batch2.addCount(0, 100);
+    caught = false;
+    try { batch2.count(id); }
+    catch (primesieve_error&) { caught = true; }
+    cout << "Access before run() throws: " << caught;
+    check(caught);
+  }
+
+  // an nth prime query whose range estimate falls short
+  // is completed by the extension passes: compare a large
+  // n against the single-query API
+  {
+    QueryBatch batch3;
+    size_t id = batch3.addNthPrime(100000, 2000000);
+    batch3.run();
+    cout << "100000th prime > 2*10^6: " << batch3.nthPrime(id);
+    check(batch3.nthPrime(id) == nth_prime(100000, 2000000));
+  }
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
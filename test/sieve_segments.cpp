@@ -0,0 +1,93 @@
+///
+/// @file   sieve_segments.cpp
+/// @brief  Test the streaming segment callback API
+///         sieve_segments(), the primes decoded from the raw
+///         sieve bitmaps must match generate_primes()
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+/// Number corresponding to the jth
+/// bit of a sieve byte
+const uint64_t bitValues[8] = { 7, 11, 13, 17, 19, 23, 29, 31 };
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+/// Decode the primes from the raw segment
+/// bitmaps of sieve_segments()
+vector<uint64_t> decodePrimes(uint64_t start, uint64_t stop)
+{
+  vector<uint64_t> primes;
+
+  sieve_segments(start, stop,
+    [&](uint64_t low, const uint8_t* sieve, size_t size)
+    {
+      for (size_t i = 0; i < size; i++)
+        for (int j = 0; j < 8; j++)
+          if (sieve[i] & (1 << j))
+            primes.push_back(low + i * 30 + bitValues[j]);
+    });
+
+  return primes;
+}
+
+void compare(uint64_t start, uint64_t stop)
+{
+  vector<uint64_t> primes;
+  // the sieve bitmap cannot represent 2, 3 and 5
+  generate_primes(max<uint64_t>(start, 7), stop, &primes);
+
+  vector<uint64_t> decoded = decodePrimes(start, stop);
+
+  cout << "Primes inside [" << start << ", " << stop << "] = " << decoded.size();
+  check(decoded == primes);
+}
+
+int main()
+{
+  random_device rd;
+  mt19937 gen(rd());
+  uniform_int_distribution<uint64_t> dist(0, 100000000ull);
+
+  // random intervals, including empty ones,
+  // ones below 7 and unaligned bounds
+  for (int i = 0; i < 30; i++)
+  {
+    uint64_t a = dist(gen);
+    uint64_t b = a + dist(gen) % 1000000;
+    compare(a, b);
+  }
+
+  compare(0, 1000000);
+  compare(0, 0);
+  compare(7, 7);
+  compare(1000003, 1000003);
+
+  // interval spanning multiple segments
+  compare(0, 20000000);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
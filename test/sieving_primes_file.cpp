@@ -0,0 +1,98 @@
+///
+/// @file   sieving_primes_file.cpp
+/// @brief  Test the sieving prime snapshot files:
+///         store_sieving_primes_file() and sieving with a
+///         snapshot installed via set_sieving_primes_file()
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/primesieve_error.hpp>
+#include <primesieve/SievingPrimesFile.hpp>
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  const string filePath = "sieving_primes.snapshot";
+  uint64_t stop = 100000000;
+
+  store_sieving_primes_file(stop, filePath);
+
+  // the file contains exactly the primes inside [7, sqrt(stop)]
+  vector<uint64_t> primes;
+  generate_primes(7, 10000, &primes);
+  SievingPrimesFile file(filePath);
+  cout << "SievingPrimesFile maxPrime = " << file.maxPrime();
+  check(file.maxPrime() == 10000);
+  cout << "SievingPrimesFile size = " << file.size();
+  check(file.size() == primes.size());
+  bool equal = true;
+  for (uint64_t i = 0; i < file.size(); i++)
+    equal &= (file.primes()[i] == primes[i]);
+  cout << "SievingPrimesFile primes match";
+  check(equal);
+
+  set_sieving_primes_file(filePath);
+
+  // multi-threaded, the snapshot covers sqrt(stop)
+  uint64_t count = count_primes(0, stop);
+  cout << "PrimePi(10^8) = " << count;
+  check(count == 5761455);
+
+  // the snapshot does not cover sqrt(10^9),
+  // falls back to generating the sieving primes
+  count = count_primes(0, 1000000000);
+  cout << "PrimePi(10^9) = " << count;
+  check(count == 50847534);
+
+  // single-threaded
+  set_num_threads(1);
+  count = count_primes(0, stop);
+  cout << "PrimePi(10^8) = " << count;
+  check(count == 5761455);
+
+  // stop using the snapshot
+  set_sieving_primes_file("");
+  count = count_primes(0, stop);
+  cout << "PrimePi(10^8) = " << count;
+  check(count == 5761455);
+
+  // an invalid snapshot file must throw
+  bool threw = false;
+  try
+  {
+    set_sieving_primes_file("does_not_exist.snapshot");
+  }
+  catch (const primesieve_error&)
+  {
+    threw = true;
+  }
+  cout << "Invalid snapshot file throws: " << threw;
+  check(threw);
+
+  remove(filePath.c_str());
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
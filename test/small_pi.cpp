@@ -0,0 +1,76 @@
+///
+/// @file   small_pi.cpp
+/// @brief  Test the SmallPi fast path of count_primes()
+///         for small stops
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/SmallPi.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  // naive sieve of Eratosthenes as an
+  // independent reference
+  uint64_t limit = 100000;
+  vector<char> isPrime(limit + 1, 1);
+  isPrime[0] = isPrime[1] = 0;
+  for (uint64_t i = 2; i * i <= limit; i++)
+    if (isPrime[i])
+      for (uint64_t j = i * i; j <= limit; j += i)
+        isPrime[j] = 0;
+
+  uint64_t count = 0;
+  bool ok = true;
+
+  for (uint64_t n = 0; n <= limit; n++)
+  {
+    count += isPrime[n];
+    // check every n below 1000 (covers the static
+    // table and its boundary), then a sparse sample
+    if (n < 1000 || n % 997 == 0)
+      ok &= (count_primes(0, n) == count);
+  }
+
+  cout << "count_primes(0, n) matches a naive sieve";
+  check(ok);
+
+  cout << "Primes below 10^6: " << count_primes(0, 1000000);
+  check(count_primes(0, 1000000) == 78498);
+
+  cout << "Primes below 10^7: " << count_primes(0, 10000000);
+  check(count_primes(0, 10000000) == 664579);
+
+  cout << "Primes inside [10^6, 2*10^6]: " << count_primes(1000000, 2000000);
+  check(count_primes(1000000, 2000000) == 148933 - 78498);
+
+  cout << "count_primes(5, 4): " << count_primes(5, 4);
+  check(count_primes(5, 4) == 0);
+
+  cout << "SmallPi::limit(): " << SmallPi::limit();
+  check(SmallPi::limit() == 10000000);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
@@ -0,0 +1,81 @@
+///
+/// @file   small_primes_cache.cpp
+/// @brief  Test the compile time table of the primes < 2^16
+///         that serves small ranges without constructing any
+///         sieve state: iteration, buffered generation, nth
+///         prime and prime sums across the table boundary.
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  // PrimePi(2^16) = 6542, the 6542nd prime is 65521
+  // and the next prime is 65537
+  uint64_t count = count_primes(0, 65536);
+  cout << "PrimePi(2^16) = " << count;
+  check(count == 6542);
+
+  cout << "nth_prime(6542) = " << nth_prime(6542);
+  check(nth_prime(6542) == 65521);
+  cout << "nth_prime(6543) = " << nth_prime(6543);
+  check(nth_prime(6543) == 65537);
+
+  // iterate across the table boundary
+  primesieve::iterator it(65000);
+  uint64_t prime = it.next_prime();
+  vector<uint64_t> primes;
+  for (; prime < 66000; prime = it.next_prime())
+    primes.push_back(prime);
+
+  vector<uint64_t> primes2;
+  generate_primes(65001, 65999, &primes2);
+  cout << "iterate across the table boundary";
+  check(primes == primes2);
+
+  // the table is served chunk-wise through buffers
+  // smaller than its 6542 entries
+  uint64_t sum = reduce_primes(0, 65536, 0,
+    [](uint64_t acc, const uint64_t* p, size_t size)
+    {
+      uint64_t s = acc;
+      for (size_t i = 0; i < size; i++)
+        s += p[i];
+      return s;
+    },
+    [](uint64_t a, uint64_t b) { return a + b; });
+
+  cout << "sum of the primes < 2^16";
+  check(sum == sum_primes(0, 65536));
+
+  // backwards iteration over the table
+  primesieve::iterator it2(1000);
+  uint64_t prev = it2.prev_prime();
+  cout << "prev_prime(1000) = " << prev;
+  check(prev == 997);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
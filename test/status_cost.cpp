@@ -0,0 +1,97 @@
+///
+/// @file   status_cost.cpp
+/// @brief  Test the sieving cost model used by
+///         PrimeSieve::updateStatus() to derive a time
+///         proportional status percent
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve/ParallelSieve.hpp>
+#include <primesieve/PrimeSieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  int sieveSizeKB = 256;
+  uint64_t stop = 10000000000000000ull;
+
+  cout << "sieveCost(start) = 0";
+  check(PrimeSieve::sieveCost(0, stop, 0, sieveSizeKB) == 0.0);
+
+  // the cost grows monotonically with the position
+  double prev = 0;
+  bool monotone = true;
+  for (uint64_t pos = stop / 10; pos <= stop; pos += stop / 10)
+  {
+    double cost = PrimeSieve::sieveCost(0, stop, pos, sieveSizeKB);
+    monotone &= (cost > prev);
+    prev = cost;
+  }
+  cout << "sieveCost() is monotone";
+  check(monotone);
+
+  // for large stop the sieving cost per segment grows toward
+  // stop (EratBig), so 90% of the distance must correspond
+  // to less than 90% of the cost but still more than the
+  // trivial lower bound of (0.9)^1.5 ~= 85.4%
+  double total = PrimeSieve::sieveCost(0, stop, stop, sieveSizeKB);
+  double done = PrimeSieve::sieveCost(0, stop, stop / 10 * 9, sieveSizeKB);
+  double percent = done * 100.0 / total;
+  cout << "90% of the distance = " << percent << "% of the cost";
+  check(percent > 85.0 && percent < 90.0);
+
+  // for small stop no EratBig is used
+  // and the cost model is linear
+  uint64_t smallStop = 100000000;
+  total = PrimeSieve::sieveCost(0, smallStop, smallStop, sieveSizeKB);
+  done = PrimeSieve::sieveCost(0, smallStop, smallStop / 2, sieveSizeKB);
+  cout << "Linear cost below maxEratMedium^2";
+  check(done * 2 == total);
+
+  {
+    // the status reported while sieving still covers
+    // [0, 100] and ends at exactly 100%
+    vector<double> percents;
+    ParallelSieve ps;
+    ps.setNumThreads(1);
+    ps.setProgressCallback([&](double percent) {
+      percents.push_back(percent);
+    }, 0);
+
+    uint64_t count = ps.countPrimes(0, 100000000);
+    cout << "Primes below 10^8: " << count;
+    check(count == 5761455);
+
+    bool inRange = true;
+    for (double p : percents)
+      inRange &= (p >= 0.0 && p <= 100.0);
+    cout << "All statuses are inside [0, 100]";
+    check(inRange);
+
+    cout << "Last reported status is 100%";
+    check(percents.back() == 100.0);
+  }
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+///
+/// @file   sum_primes.cpp
+/// @brief  Test the aggregate reduction APIs
+///         sum_primes() and reduce_primes()
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+/// Reference implementation using the iterator.
+/// The iterator generates primes > start whereas
+/// sum_primes() includes start, hence start - 1.
+///
+uint64_t iterSum(uint64_t start, uint64_t stop)
+{
+  primesieve::iterator it(start > 0 ? start - 1 : 0);
+  uint64_t sum = 0;
+  uint64_t prime = it.next_prime();
+
+  for (; prime <= stop; prime = it.next_prime())
+    sum += prime;
+
+  return sum;
+}
+
+int main()
+{
+  {
+    uint64_t sum = sum_primes(0, 10);
+    cout << "Sum of the primes <= 10: " << sum;
+    check(sum == 17);
+  }
+
+  {
+    // Project Euler problem 10
+    uint64_t sum = sum_primes(0, 1999999);
+    cout << "Sum of the primes below 2*10^6: " << sum;
+    check(sum == 142913828922ull);
+  }
+
+  {
+    // large enough distance for multi-threading,
+    // awkward (non-aligned) range borders
+    uint64_t start = 1000000007;
+    uint64_t stop = 1100000009;
+    uint64_t sum = sum_primes(start, stop);
+    uint64_t expected = iterSum(start, stop);
+    cout << "Multi-threaded prime sum: " << sum << " = " << expected;
+    check(sum == expected);
+  }
+
+  {
+    // counting via the generic fold must
+    // match count_primes()
+    uint64_t count = reduce_primes(0, 100000000, 0,
+      [](uint64_t acc, const uint64_t*, size_t size) {
+        return acc + size;
+      },
+      [](uint64_t a, uint64_t b) {
+        return a + b;
+      });
+
+    cout << "Fold prime count below 10^8: " << count;
+    check(count == count_primes(0, 100000000));
+  }
+
+  {
+    // sum of p % m, a reduction that the
+    // aggregate sum API cannot express
+    uint64_t m = 1000003;
+    uint64_t start = 0;
+    uint64_t stop = 50000000;
+
+    uint64_t folded = reduce_primes(start, stop, 0,
+      [&](uint64_t acc, const uint64_t* primes, size_t size) {
+        for (size_t i = 0; i < size; i++)
+          acc += primes[i] % m;
+        return acc;
+      },
+      [](uint64_t a, uint64_t b) {
+        return a + b;
+      });
+
+    primesieve::iterator it(start);
+    uint64_t expected = 0;
+    uint64_t prime = it.next_prime();
+    for (; prime <= stop; prime = it.next_prime())
+      expected += prime % m;
+
+    cout << "Fold sum of p % m: " << folded << " = " << expected;
+    check(folded == expected);
+  }
+
+  {
+    uint64_t sum = sum_primes(10, 2);
+    cout << "start > stop returns 0: " << sum;
+    check(sum == 0);
+  }
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
@@ -0,0 +1,85 @@
+///
+/// @file   tune_profile.cpp
+/// @brief  Test calibrate_tuning() and save_tuning(): the
+///         calibrated parameters must be valid (accepted by
+///         set_tuning), sieving with them must stay correct
+///         and the written profile file must contain the
+///         current parameters
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  // use the smallest measurement distance,
+  // accuracy does not matter for this test
+  Tuning tuning = calibrate_tuning(1);
+
+  cout << "factorEratSmall = " << tuning.factorEratSmall;
+  check(tuning.factorEratSmall >= 0 && tuning.factorEratSmall <= 3);
+
+  cout << "factorEratMedium = " << tuning.factorEratMedium;
+  check(tuning.factorEratMedium >= 0 && tuning.factorEratMedium <= 5);
+
+  cout << "Sieve size = " << get_sieve_size() << " kilobytes";
+  check(get_sieve_size() >= 8 && get_sieve_size() <= 4096);
+
+  // the calibrated parameters must be accepted
+  // by set_tuning() and sieve correctly
+  set_tuning(tuning);
+  cout << "Count primes <= 10^8: " << count_primes(0, 100000000);
+  check(count_primes(0, 100000000) == 5761455);
+
+  // the profile file must contain the
+  // current tuning parameters
+  string filePath = "tune_profile.test";
+  save_tuning(filePath);
+
+  map<string, double> profile;
+  ifstream file(filePath);
+  string key;
+  double value;
+  while (file >> key >> value)
+    profile[key] = value;
+  file.close();
+  remove(filePath.c_str());
+
+  cout << "Profile file entries: " << profile.size();
+  check(profile.size() == 8);
+
+  cout << "Profile factorEratSmall: " << profile["factorEratSmall"];
+  check(profile["factorEratSmall"] == tuning.factorEratSmall);
+
+  cout << "Profile factorEratMedium: " << profile["factorEratMedium"];
+  check(profile["factorEratMedium"] == tuning.factorEratMedium);
+
+  cout << "Profile sieveSize: " << profile["sieveSize"];
+  check(profile["sieveSize"] == get_sieve_size());
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
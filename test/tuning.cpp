@@ -0,0 +1,103 @@
+///
+/// @file   tuning.cpp
+/// @brief  Test the runtime tuning API set_tuning()
+///         and get_tuning()
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/config.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  Tuning tuning = get_tuning();
+
+  cout << "Default tuning matches config.hpp";
+  check(tuning.factorEratSmall == config::FACTOR_ERATSMALL &&
+        tuning.factorEratMedium == config::FACTOR_ERATMEDIUM &&
+        tuning.bytesPerAlloc == (uint64_t) config::BYTES_PER_ALLOC &&
+        tuning.minCacheIterator == (uint64_t) config::MIN_CACHE_ITERATOR &&
+        tuning.maxCacheIterator == (uint64_t) config::MAX_CACHE_ITERATOR &&
+        tuning.minThreadDistance == config::MIN_THREAD_DISTANCE &&
+        tuning.threadsPerSegment == config::THREADS_PER_SEGMENT);
+
+  // sieving must stay correct with
+  // non-default cross-off thresholds
+  tuning.factorEratSmall = 0.8;
+  tuning.factorEratMedium = 2.0;
+  tuning.minThreadDistance = 1000000;
+  set_tuning(tuning);
+
+  Tuning tuning2 = get_tuning();
+  cout << "set_tuning() applies the new values";
+  check(tuning2.factorEratSmall == 0.8 &&
+        tuning2.factorEratMedium == 2.0 &&
+        tuning2.minThreadDistance == 1000000);
+
+  uint64_t count = count_primes(0, 100000000);
+  cout << "Primes below 10^8: " << count;
+  check(count == 5761455);
+
+  // experimental 2-thread pipelined cross-off,
+  // single-threaded and multi-threaded sieving as
+  // well as the iterator must stay correct
+  tuning.threadsPerSegment = 2;
+  set_tuning(tuning);
+
+  count = count_primes(0, 100000000);
+  cout << "Pipelined primes below 10^8: " << count;
+  check(count == 5761455);
+
+  {
+    primesieve::iterator it(99999900);
+    uint64_t prime = it.next_prime();
+    vector<uint64_t> primes;
+    generate_n_primes(1, 99999901, &primes);
+    cout << "Pipelined next_prime(99999900): " << prime;
+    check(prime == primes.at(0));
+  }
+
+  tuning.threadsPerSegment = 1;
+  set_tuning(tuning);
+
+  // invalid values must throw and
+  // leave the tuning unchanged
+  tuning.threadsPerSegment = 3;
+  bool caught2 = false;
+  try { set_tuning(tuning); }
+  catch (primesieve_error&) { caught2 = true; }
+  cout << "Invalid threadsPerSegment throws: " << caught2;
+  check(caught2 && get_tuning().threadsPerSegment == 1);
+
+  tuning.threadsPerSegment = 1;
+  tuning.factorEratSmall = 7.0;
+  bool caught = false;
+  try { set_tuning(tuning); }
+  catch (primesieve_error&) { caught = true; }
+  cout << "Invalid tuning throws: " << caught;
+  check(caught && get_tuning().factorEratSmall == 0.8);
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
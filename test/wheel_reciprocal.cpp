@@ -0,0 +1,81 @@
+///
+/// @file   wheel_reciprocal.cpp
+/// @brief  Test PrimeReciprocal: the precomputed per prime
+///         reciprocals used by Wheel::addSievingPrime() must
+///         compute floor(x / prime) exactly for x < 2^63
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/Wheel.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  vector<uint64_t> primes;
+  generate_primes(7, 100000, &primes);
+
+  // xorshift pseudo random numbers,
+  // reproducible across runs
+  uint64_t rng = 0x9e3779b97f4a7c15ull;
+  uint64_t errors = 0;
+
+  for (uint64_t prime : primes)
+  {
+    PrimeReciprocal recip;
+    recip.init(prime);
+
+    // random x < 2^63 plus the values around multiples
+    // of prime where an off by one estimate would show
+    uint64_t testValues[8];
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    uint64_t x = rng >> 1;
+    uint64_t multiple = x - x % prime;
+    testValues[0] = x;
+    testValues[1] = multiple;
+    testValues[2] = multiple - 1;
+    testValues[3] = multiple + 1;
+    testValues[4] = prime;
+    testValues[5] = prime - 1;
+    testValues[6] = prime * prime;
+    testValues[7] = (1ull << 63) - 1;
+
+    for (uint64_t t : testValues)
+      if (recip.divide(t) != t / prime)
+        errors++;
+  }
+
+  cout << "PrimeReciprocal division errors = " << errors;
+  check(errors == 0);
+
+  {
+    // the reciprocals are shared across the ParallelSieve
+    // workers, a multi-threaded count exercises them
+    uint64_t count = count_primes(1000000000, 2000000000);
+    cout << "PrimePi(2*10^9) - PrimePi(10^9) = " << count;
+    check(count == 47374753);
+  }
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}
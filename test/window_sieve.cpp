@@ -0,0 +1,82 @@
+///
+/// @file   window_sieve.cpp
+/// @brief  Test PrimeSieve::advance(): incremental prime
+///         counting in consecutive windows
+///
+/// Copyright (C) 2018 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primesieve.hpp>
+#include <primesieve/PrimeSieve.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace primesieve;
+
+void check(bool OK)
+{
+  cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    exit(1);
+}
+
+int main()
+{
+  {
+    // consecutive windows starting at 0, the window sizes
+    // force both same-segment boundaries and horizon growth
+    PrimeSieve ps;
+    ps.setStart(0);
+    uint64_t prev = 0;
+    bool ok = true;
+
+    for (uint64_t stop : { 10ull, 100ull, 101ull, 1000ull,
+                           100000ull, 10000000ull, 50000000ull })
+    {
+      uint64_t count = ps.advance(stop);
+      ok &= (count == count_primes(prev + 1, stop));
+      prev = stop;
+    }
+
+    cout << "Window counts match count_primes()";
+    check(ok);
+
+    cout << "Cumulative count: " << ps.getCount(0);
+    check(ps.getCount(0) == count_primes(0, prev));
+  }
+
+  {
+    // windows anchored at a large start
+    uint64_t start = 1000000000ull;
+    PrimeSieve ps;
+    ps.setStart(start);
+    uint64_t prev = start - 1;
+    bool ok = true;
+
+    for (int i = 1; i <= 5; i++)
+    {
+      uint64_t stop = start + i * 3000000ull;
+      uint64_t count = ps.advance(stop);
+      ok &= (count == count_primes(prev + 1, stop));
+      prev = stop;
+    }
+
+    cout << "Windows at large start match count_primes()";
+    check(ok);
+
+    // an unchanged stop adds an empty window
+    cout << "Empty window count: " << ps.advance(prev);
+    check(ps.advance(prev) == 0);
+  }
+
+  cout << endl;
+  cout << "All tests passed successfully!" << endl;
+
+  return 0;
+}